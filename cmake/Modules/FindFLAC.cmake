@@ -0,0 +1,41 @@
+# - Try to find libFLAC
+#
+# FLAC_FOUND - system has libFLAC
+# FLAC_LIBRARY - location of the library for libFLAC
+# FLAC_INCLUDE_DIR - location of the include files for libFLAC
+
+set(FLAC_FOUND FALSE)
+
+find_path(FLAC_INCLUDE_DIR
+	NAMES FLAC/stream_encoder.h
+	PATHS
+		/usr/include
+		/usr/local/include
+		/opt/local/include
+)
+
+find_library(FLAC_LIBRARY
+	NAMES FLAC libFLAC
+	PATHS
+		/usr/lib64
+		/usr/lib
+		/usr/local/lib64
+		/usr/local/lib
+		/opt/local/lib
+)
+
+if(FLAC_INCLUDE_DIR AND FLAC_LIBRARY)
+	set(FLAC_FOUND TRUE)
+	message(STATUS "Found libFLAC library at: ${FLAC_LIBRARY}")
+	message(STATUS "Found libFLAC include directory at: ${FLAC_INCLUDE_DIR}")
+endif(FLAC_INCLUDE_DIR AND FLAC_LIBRARY)
+
+IF(NOT FLAC_FOUND)
+  IF(NOT FLAC_FIND_QUIETLY)
+    MESSAGE(STATUS "libFLAC was not found.")
+  ELSE(NOT FLAC_FIND_QUIETLY)
+    IF(FLAC_FIND_REQUIRED)
+      MESSAGE(FATAL_ERROR "libFLAC was not found.")
+    ENDIF(FLAC_FIND_REQUIRED)
+  ENDIF(NOT FLAC_FIND_QUIETLY)
+ENDIF(NOT FLAC_FOUND)
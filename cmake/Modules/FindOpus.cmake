@@ -0,0 +1,41 @@
+# - Try to find libopus
+#
+# OPUS_FOUND - system has libopus
+# OPUS_LIBRARY - location of the library for libopus
+# OPUS_INCLUDE_DIR - location of the include files for libopus
+
+set(OPUS_FOUND FALSE)
+
+find_path(OPUS_INCLUDE_DIR
+	NAMES opus/opus.h
+	PATHS
+		/usr/include
+		/usr/local/include
+		/opt/local/include
+)
+
+find_library(OPUS_LIBRARY
+	NAMES opus libopus
+	PATHS
+		/usr/lib64
+		/usr/lib
+		/usr/local/lib64
+		/usr/local/lib
+		/opt/local/lib
+)
+
+if(OPUS_INCLUDE_DIR AND OPUS_LIBRARY)
+	set(OPUS_FOUND TRUE)
+	message(STATUS "Found libopus library at: ${OPUS_LIBRARY}")
+	message(STATUS "Found libopus include directory at: ${OPUS_INCLUDE_DIR}")
+endif(OPUS_INCLUDE_DIR AND OPUS_LIBRARY)
+
+IF(NOT OPUS_FOUND)
+  IF(NOT Opus_FIND_QUIETLY)
+    MESSAGE(STATUS "libopus was not found.")
+  ELSE(NOT Opus_FIND_QUIETLY)
+    IF(Opus_FIND_REQUIRED)
+      MESSAGE(FATAL_ERROR "libopus was not found.")
+    ENDIF(Opus_FIND_REQUIRED)
+  ENDIF(NOT Opus_FIND_QUIETLY)
+ENDIF(NOT OPUS_FOUND)
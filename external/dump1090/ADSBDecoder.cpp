@@ -3,6 +3,13 @@
 
 #include "ADSBDecoder.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ADSB_PREAMBLE_SSE 1
+#else
+#define ADSB_PREAMBLE_SSE 0
+#endif
+
 namespace adsb_decoder {
 
 // Borrowed from "dump1090" project
@@ -88,6 +95,67 @@ check_preamble_levels(const float* buffer)
            buffer[14] < high;
 }
 
+void
+find_preamble_candidates(const float* buffer, size_t count, std::vector<unsigned int>& candidates)
+{
+    size_t i = 0;
+
+#if ADSB_PREAMBLE_SSE
+    // the same checks as check_preamble_relations() and check_preamble_levels(),
+    // evaluated for 4 consecutive offsets at once: lane k of bN holds buffer[i + k + N].
+    const __m128 six = _mm_set1_ps(6.f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const float *p = buffer + i;
+
+        const __m128 b0 = _mm_loadu_ps(p);
+        const __m128 b1 = _mm_loadu_ps(p + 1);
+        const __m128 b2 = _mm_loadu_ps(p + 2);
+        const __m128 b3 = _mm_loadu_ps(p + 3);
+        const __m128 b4 = _mm_loadu_ps(p + 4);
+        const __m128 b5 = _mm_loadu_ps(p + 5);
+        const __m128 b6 = _mm_loadu_ps(p + 6);
+        const __m128 b7 = _mm_loadu_ps(p + 7);
+        const __m128 b8 = _mm_loadu_ps(p + 8);
+        const __m128 b9 = _mm_loadu_ps(p + 9);
+
+        __m128 m = _mm_and_ps(_mm_cmpgt_ps(b0, b1), _mm_cmplt_ps(b1, b2));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmpgt_ps(b2, b3), _mm_cmplt_ps(b3, b0)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmplt_ps(b4, b0), _mm_cmplt_ps(b5, b0)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmplt_ps(b6, b0), _mm_cmpgt_ps(b7, b8)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmplt_ps(b8, b9), _mm_cmpgt_ps(b9, b6)));
+
+        // almost always, nothing looks like a preamble
+        if (_mm_movemask_ps(m) == 0) {
+            continue;
+        }
+
+        // same summation order as the scalar check, for identical results
+        const __m128 high = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(b0, b2), b7), b9), six);
+
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmplt_ps(b4, high), _mm_cmplt_ps(b5, high)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(p + 11), high), _mm_cmplt_ps(_mm_loadu_ps(p + 12), high)));
+        m = _mm_and_ps(m, _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(p + 13), high), _mm_cmplt_ps(_mm_loadu_ps(p + 14), high)));
+
+        const int mask = _mm_movemask_ps(m);
+
+        for (int k = 0; k < 4; k++) {
+            if (mask & (1 << k)) {
+                candidates.push_back(static_cast<unsigned int>(i + k));
+            }
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (check_preamble_relations(&buffer[i]) and check_preamble_levels(&buffer[i])) {
+            candidates.push_back(static_cast<unsigned int>(i));
+        }
+    }
+}
+
 BitVector
 extract_bitvector(const float *buffer)
 {
@@ -3,6 +3,9 @@
 
 #include <array>
 #include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
 
 namespace adsb_decoder {
 
@@ -68,6 +71,11 @@ check_preamble_relations(const float* buffer);
 bool
 check_preamble_levels(const float* buffer);
 
+// append to candidates every offset i < count where both preamble checks above pass,
+// in increasing order. buffer must hold at least count + SAMPLES_PER_PREAMBLE samples.
+void
+find_preamble_candidates(const float* buffer, size_t count, std::vector<unsigned int>& candidates);
+
 BitVector
 extract_bitvector(const float *buffer);
 
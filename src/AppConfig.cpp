@@ -2,7 +2,6 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "AppConfig.h"
-#include "CubicSDR.h"
 
 #include <wx/msgdlg.h>
 
@@ -475,6 +474,14 @@ std::vector<SDRManualDef> AppConfig::getManualDevices() {
     return manualDevices;
 }
 
+void AppConfig::setReceivers(std::vector<SDRReceiverDef> receivers_in) {
+    receivers = receivers_in;
+}
+
+std::vector<SDRReceiverDef> AppConfig::getReceivers() {
+    return receivers;
+}
+
 void AppConfig::setMainSplit(float value) {
     mainSplit.store(value);
 }
@@ -516,7 +523,7 @@ std::string AppConfig::getRecordingPath() {
 }
 
 bool AppConfig::verifyRecordingPath() {
-    string recPathStr = wxGetApp().getConfig()->getRecordingPath();
+    string recPathStr = getRecordingPath();
     
     if (recPathStr.empty()) {
         wxMessageBox( wxT("Recording path is not set.  Please use 'Set Recording Path' from the 'Recording' Menu."), wxT("Recording Path Error"), wxICON_INFORMATION);
@@ -552,6 +559,110 @@ int  AppConfig::getRecordingFileTimeLimit() {
 	return recordingFileTimeLimitSeconds;
 }
 
+void  AppConfig::setRecordingFileFormat(int enumChoice) {
+	recordingFileFormat = enumChoice;
+}
+
+int  AppConfig::getRecordingFileFormat() {
+	return recordingFileFormat;
+}
+
+void  AppConfig::setRecordingPreRoll(int nbMilliseconds) {
+	recordingPreRollMilliseconds = nbMilliseconds;
+}
+
+int  AppConfig::getRecordingPreRoll() {
+	return recordingPreRollMilliseconds;
+}
+
+void  AppConfig::setRecordingHangTime(int nbMilliseconds) {
+	recordingHangTimeMilliseconds = nbMilliseconds;
+}
+
+int  AppConfig::getRecordingHangTime() {
+	return recordingHangTimeMilliseconds;
+}
+
+void AppConfig::setIQServerPort(int port) {
+    iqServerPort = port;
+}
+
+int AppConfig::getIQServerPort() {
+    return iqServerPort;
+}
+
+void AppConfig::setIQServerAddress(std::string address) {
+    iqServerAddress = address;
+}
+
+std::string AppConfig::getIQServerAddress() {
+    return iqServerAddress;
+}
+
+void AppConfig::setAudioStreamAddress(std::string address) {
+    audioStreamAddress = address;
+}
+
+std::string AppConfig::getAudioStreamAddress() {
+    return audioStreamAddress;
+}
+
+void AppConfig::setAudioStreamPort(int port) {
+    audioStreamPort = port;
+}
+
+int AppConfig::getAudioStreamPort() {
+    return audioStreamPort;
+}
+
+void AppConfig::setAudioStreamCodec(int enumChoice) {
+    audioStreamCodec = enumChoice;
+}
+
+int AppConfig::getAudioStreamCodec() {
+    return audioStreamCodec;
+}
+
+void AppConfig::setSignalDetectorEnabled(bool enabled) {
+    signalDetectorEnabled = enabled;
+}
+
+bool AppConfig::getSignalDetectorEnabled() {
+    return signalDetectorEnabled;
+}
+
+void AppConfig::setSignalDetectorFFTSize(int fftSize) {
+    signalDetectorFFTSize = fftSize;
+}
+
+int AppConfig::getSignalDetectorFFTSize() {
+    return signalDetectorFFTSize;
+}
+
+void AppConfig::setSignalDetectorThreshold(float thresholdDb) {
+    signalDetectorThreshold = thresholdDb;
+}
+
+float AppConfig::getSignalDetectorThreshold() {
+    return signalDetectorThreshold;
+}
+
+void AppConfig::setOccupancyBucketWidth(long long bucketWidth) {
+    occupancyBucketWidth = bucketWidth;
+}
+
+long long AppConfig::getOccupancyBucketWidth() {
+    return occupancyBucketWidth;
+}
+
+void AppConfig::setOccupancyWindow(int seconds) {
+    occupancyWindow = seconds;
+}
+
+int AppConfig::getOccupancyWindow() {
+    return occupancyWindow;
+}
+
 
 void AppConfig::setConfigName(std::string configName) {
     this->configName = configName;
@@ -611,6 +722,25 @@ bool AppConfig::save() {
     *rec_node->newChild("path") = recordingPath;
 	*rec_node->newChild("squelch") = recordingSquelchOption;
 	*rec_node->newChild("file_time_limit") = recordingFileTimeLimitSeconds;
+	*rec_node->newChild("file_format") = recordingFileFormat;
+	*rec_node->newChild("pre_roll") = recordingPreRollMilliseconds;
+	*rec_node->newChild("hang_time") = recordingHangTimeMilliseconds;
+
+    DataNode *iq_server_node = cfg.rootNode()->newChild("iq_server");
+    *iq_server_node->newChild("port") = iqServerPort;
+    *iq_server_node->newChild("address") = iqServerAddress;
+
+    DataNode *audio_stream_node = cfg.rootNode()->newChild("audio_stream");
+    *audio_stream_node->newChild("address") = audioStreamAddress;
+    *audio_stream_node->newChild("port") = audioStreamPort;
+    *audio_stream_node->newChild("codec") = audioStreamCodec;
+
+    DataNode *detector_node = cfg.rootNode()->newChild("signal_detector");
+    *detector_node->newChild("enabled") = signalDetectorEnabled ? 1 : 0;
+    *detector_node->newChild("fft_size") = signalDetectorFFTSize;
+    *detector_node->newChild("threshold") = signalDetectorThreshold;
+    *detector_node->newChild("bucket_width") = occupancyBucketWidth;
+    *detector_node->newChild("occupancy_window") = occupancyWindow;
     
     DataNode *devices_node = cfg.rootNode()->newChild("devices");
 
@@ -628,6 +758,15 @@ bool AppConfig::save() {
             *rig_node->newChild("params") = i->params;
         }
     }
+
+    if (receivers.size()) {
+        DataNode *receivers_node = cfg.rootNode()->newChild("receivers");
+        for (std::vector<SDRReceiverDef>::const_iterator i = receivers.begin(); i != receivers.end(); i++) {
+            DataNode *receiver_node = receivers_node->newChild("receiver");
+            *receiver_node->newChild("device_id") = i->deviceId;
+            *receiver_node->newChild("frequency") = i->frequency;
+        }
+    }
     
 #ifdef USE_HAMLIB
     DataNode *rig_node = cfg.rootNode()->newChild("rig");
@@ -820,6 +959,75 @@ bool AppConfig::load() {
 			DataNode *rec_file_time_limit = rec_node->getNext("file_time_limit");
 			rec_file_time_limit->element()->get(recordingFileTimeLimitSeconds);
 		}
+
+		if (rec_node->hasAnother("file_format")) {
+			DataNode *rec_file_format = rec_node->getNext("file_format");
+			rec_file_format->element()->get(recordingFileFormat);
+		}
+
+		if (rec_node->hasAnother("pre_roll")) {
+			DataNode *rec_pre_roll = rec_node->getNext("pre_roll");
+			rec_pre_roll->element()->get(recordingPreRollMilliseconds);
+		}
+
+		if (rec_node->hasAnother("hang_time")) {
+			DataNode *rec_hang_time = rec_node->getNext("hang_time");
+			rec_hang_time->element()->get(recordingHangTimeMilliseconds);
+		}
+    }
+
+    if (cfg.rootNode()->hasAnother("iq_server")) {
+        DataNode *iq_server_node = cfg.rootNode()->getNext("iq_server");
+
+        if (iq_server_node->hasAnother("port")) {
+            iq_server_node->getNext("port")->element()->get(iqServerPort);
+        }
+
+        if (iq_server_node->hasAnother("address")) {
+            iqServerAddress = iq_server_node->getNext("address")->element()->toString();
+        }
+    }
+
+    if (cfg.rootNode()->hasAnother("audio_stream")) {
+        DataNode *audio_stream_node = cfg.rootNode()->getNext("audio_stream");
+
+        if (audio_stream_node->hasAnother("address")) {
+            audioStreamAddress = audio_stream_node->getNext("address")->element()->toString();
+        }
+
+        if (audio_stream_node->hasAnother("port")) {
+            audio_stream_node->getNext("port")->element()->get(audioStreamPort);
+        }
+
+        if (audio_stream_node->hasAnother("codec")) {
+            audio_stream_node->getNext("codec")->element()->get(audioStreamCodec);
+        }
+    }
+
+    if (cfg.rootNode()->hasAnother("signal_detector")) {
+        DataNode *detector_node = cfg.rootNode()->getNext("signal_detector");
+
+        if (detector_node->hasAnother("enabled")) {
+            int enabledVal;
+            detector_node->getNext("enabled")->element()->get(enabledVal);
+            signalDetectorEnabled = (enabledVal != 0);
+        }
+
+        if (detector_node->hasAnother("fft_size")) {
+            detector_node->getNext("fft_size")->element()->get(signalDetectorFFTSize);
+        }
+
+        if (detector_node->hasAnother("threshold")) {
+            detector_node->getNext("threshold")->element()->get(signalDetectorThreshold);
+        }
+
+        if (detector_node->hasAnother("bucket_width")) {
+            detector_node->getNext("bucket_width")->element()->get(occupancyBucketWidth);
+        }
+
+        if (detector_node->hasAnother("occupancy_window")) {
+            detector_node->getNext("occupancy_window")->element()->get(occupancyWindow);
+        }
     }
     
     if (cfg.rootNode()->hasAnother("devices")) {
@@ -850,6 +1058,22 @@ bool AppConfig::load() {
             }
         }
     }
+
+    if (cfg.rootNode()->hasAnother("receivers")) {
+        DataNode *receivers_node = cfg.rootNode()->getNext("receivers");
+
+        while (receivers_node->hasAnother("receiver")) {
+            DataNode *receiver_node = receivers_node->getNext("receiver");
+            if (receiver_node->hasAnother("device_id") && receiver_node->hasAnother("frequency")) {
+                SDRReceiverDef rdef;
+
+                rdef.deviceId = receiver_node->getNext("device_id")->element()->toString();
+                receiver_node->getNext("frequency")->element()->get(rdef.frequency);
+
+                receivers.push_back(rdef);
+            }
+        }
+    }
     
 #ifdef USE_HAMLIB
     if (cfg.rootNode()->hasAnother("rig")) {
@@ -13,6 +13,7 @@
 #include "DataTree.h"
 #include "CubicSDRDefs.h"
 #include "SDRDeviceInfo.h"
+#include "SignalDetector.h"
 
 typedef std::map<std::string, std::string> ConfigSettings;
 typedef std::map<std::string, float> ConfigGains;
@@ -133,6 +134,10 @@ public:
     
     void setManualDevices(std::vector<SDRManualDef> manuals);
     std::vector<SDRManualDef> getManualDevices();
+
+    //additional receivers, run alongside the main device.
+    void setReceivers(std::vector<SDRReceiverDef> receivers_in);
+    std::vector<SDRReceiverDef> getReceivers();
     
     void setMainSplit(float value);
     float getMainSplit();
@@ -156,6 +161,48 @@ public:
     
 	void setRecordingFileTimeLimit(int nbSeconds);
 	int getRecordingFileTimeLimit();
+
+	void setRecordingFileFormat(int enumChoice);
+	int getRecordingFileFormat();
+
+	void setRecordingPreRoll(int nbMilliseconds);
+	int getRecordingPreRoll();
+
+	void setRecordingHangTime(int nbMilliseconds);
+	int getRecordingHangTime();
+
+    //IQ stream server, 0 for none.
+    void setIQServerPort(int port);
+    int getIQServerPort();
+
+    void setIQServerAddress(std::string address);
+    std::string getIQServerAddress();
+
+    //RTP audio streams of the demodulators
+    void setAudioStreamAddress(std::string address);
+    std::string getAudioStreamAddress();
+
+    void setAudioStreamPort(int port);
+    int getAudioStreamPort();
+
+    void setAudioStreamCodec(int enumChoice);
+    int getAudioStreamCodec();
+
+    //signal detection and channel occupancy on the main device
+    void setSignalDetectorEnabled(bool enabled);
+    bool getSignalDetectorEnabled();
+
+    void setSignalDetectorFFTSize(int fftSize);
+    int getSignalDetectorFFTSize();
+
+    void setSignalDetectorThreshold(float thresholdDb);
+    float getSignalDetectorThreshold();
+
+    void setOccupancyBucketWidth(long long bucketWidth);
+    long long getOccupancyBucketWidth();
+
+    void setOccupancyWindow(int seconds);
+    int getOccupancyWindow();
     
 #if USE_HAMLIB
     int getRigModel();
@@ -202,6 +249,7 @@ private:
     std::atomic<float> spectrumAvgSpeed, mainSplit, visSplit, bookmarkSplit;
     std::atomic_int dbOffset;
     std::vector<SDRManualDef> manualDevices;
+    std::vector<SDRReceiverDef> receivers;
     std::atomic_bool bookmarksVisible;
 
     std::atomic<PerfModeEnum> perfMode;
@@ -209,6 +257,23 @@ private:
     std::string recordingPath = "";
 	int recordingSquelchOption = 0;
 	int recordingFileTimeLimitSeconds = 0;
+	int recordingFileFormat = 0;
+	int recordingPreRollMilliseconds = 500;
+	int recordingHangTimeMilliseconds = 2000;
+
+    int iqServerPort = 0;
+    //local only by default.
+    std::string iqServerAddress = "127.0.0.1";
+
+    std::string audioStreamAddress = "127.0.0.1";
+    int audioStreamPort = 5004;
+    int audioStreamCodec = 0;
+
+    bool signalDetectorEnabled = false;
+    int signalDetectorFFTSize = SIGNAL_DETECTOR_DEFAULT_FFT_SIZE;
+    float signalDetectorThreshold = SIGNAL_DETECTOR_DEFAULT_THRESHOLD_DB;
+    long long occupancyBucketWidth = SIGNAL_DETECTOR_DEFAULT_BUCKET_WIDTH;
+    int occupancyWindow = SIGNAL_DETECTOR_DEFAULT_OCCUPANCY_WINDOW;
 #if USE_HAMLIB
     std::atomic_int rigModel, rigRate;
     std::string rigPort;
@@ -42,7 +42,6 @@ wxBEGIN_EVENT_TABLE(AppFrame, wxFrame)
 //EVT_MENU(wxID_NEW, AppFrame::OnNewWindow)
 EVT_CLOSE(AppFrame::OnClose)
 EVT_MENU(wxID_ANY, AppFrame::OnMenu)
-EVT_IDLE(AppFrame::OnIdle)
 EVT_SPLITTER_DCLICK(wxID_ANY, AppFrame::OnDoubleClickSash)
 EVT_SPLITTER_UNSPLIT(wxID_ANY, AppFrame::OnUnSplit)
 wxEND_EVENT_TABLE()
@@ -238,7 +237,7 @@ AppFrame::AppFrame() :
     spectrumCanvas = makeSpectrumCanvas(spectrumPanel, attribList);
 
     wxGetApp().getSpectrumProcessor()->setup(DEFAULT_FFT_SIZE);
-    wxGetApp().getSpectrumProcessor()->attachOutput(spectrumCanvas->getVisualDataQueue());
+    wxGetApp().getSpectrumStitcher()->attachOutput(spectrumCanvas->getVisualDataQueue());
 
     spectrumSizer->Add(spectrumCanvas, 63, wxEXPAND | wxALL, 0);
     spectrumSizer->AddSpacer(1);
@@ -317,6 +316,10 @@ AppFrame::AppFrame() :
     // Force refresh of all
     Refresh();
 
+    // Start drawing frames
+    renderScheduler = new RenderScheduler(this);
+    renderScheduler->start();
+
     // Pop up the device selector
     wxGetApp().deviceSelector();
 }
@@ -832,6 +835,8 @@ ModeSelectorCanvas *AppFrame::makeModemSelectorPanel(wxWindow *parent, const wxG
 
 AppFrame::~AppFrame() {
 
+    delete renderScheduler;
+
     waterfallDataThread->terminate();
     t_FFTData->join();
 }
@@ -847,6 +852,14 @@ wxMenu *AppFrame::makeFileMenu() {
     menu->Append(wxID_SDR_DEVICES, "SDR Devices");
     menu->AppendSeparator();
     menu->Append(wxID_SDR_START_STOP, "Stop / Start Device");
+    menu->Append(wxID_SDR_ADD_RECEIVER, "Add Receiver...");
+    menu->Append(wxID_SDR_REMOVE_RECEIVERS, "Remove Receivers");
+    menu->Append(wxID_DIAGNOSTICS, "Pipeline Diagnostics");
+    menu->AppendSeparator();
+
+    menu->AppendCheckItem(wxID_SIGNAL_DETECTION, "Signal Detection")->Check(wxGetApp().getConfig()->getSignalDetectorEnabled());
+    menu->Append(wxID_EXPORT_SIGNALS, "Export Signals...");
+    menu->Append(wxID_EXPORT_OCCUPANCY, "Export Channel Occupancy...");
     menu->AppendSeparator();
 
     wxMenu *sessionMenu = new wxMenu;
@@ -907,11 +920,31 @@ wxMenu *AppFrame::makeRecordingMenu() {
 		"Do not record below squelch-break audio, i.e squelch-break audio parts are packed together.");
 	recordingMenuItems[wxID_RECORDING_SQUELCH_ALWAYS] = subMenu->AppendRadioItem(wxID_RECORDING_SQUELCH_ALWAYS, "Record Always", 
 		"Record everything irrespective of the squelch level.");
+	recordingMenuItems[wxID_RECORDING_SQUELCH_TRANSMISSIONS] = subMenu->AppendRadioItem(wxID_RECORDING_SQUELCH_TRANSMISSIONS, "Record Transmissions",
+		"Record each squelch-break in its own file, including the pre-roll and hang time, and list them in a session index.");
 	
 	recordingMenuItems[wxID_RECORDING_FILE_TIME_LIMIT] = menu->Append(wxID_RECORDING_FILE_TIME_LIMIT, getSettingsLabel("File time limit", "<Not Set>"), 
 		"Creates a new file automatically, each time the recording lasts longer than the limit, named according to the current time.");
 
+	recordingMenuItems[wxID_RECORDING_PRE_ROLL] = menu->Append(wxID_RECORDING_PRE_ROLL, getSettingsLabel("Pre-roll", "<Not Set>"),
+		"Record Transmissions: audio kept from before the squelch-break, so that the start of a transmission is not lost.");
+
+	recordingMenuItems[wxID_RECORDING_HANG_TIME] = menu->Append(wxID_RECORDING_HANG_TIME, getSettingsLabel("Hang time", "<Not Set>"),
+		"Record Transmissions: how long to keep recording after the squelch closed before ending the transmission file.");
+
+	//File format options as sub-menu:
+	wxMenu *formatMenu = new wxMenu;
+	recordingMenuItems[wxID_RECORDING_FILE_FORMAT_BASE] = menu->AppendSubMenu(formatMenu, "File format");
+
+	recordingMenuItems[wxID_RECORDING_FILE_FORMAT_WAV] = formatMenu->AppendRadioItem(wxID_RECORDING_FILE_FORMAT_WAV, "WAV",
+		"Record uncompressed 16-bit WAV files.");
+#if USE_FLAC
+	recordingMenuItems[wxID_RECORDING_FILE_FORMAT_FLAC] = formatMenu->AppendRadioItem(wxID_RECORDING_FILE_FORMAT_FLAC, "FLAC",
+		"Record losslessly compressed 16-bit FLAC files, for long recordings.");
+#endif
+
 	recordingMenuItems[wxID_RECORDING_SQUELCH_SILENCE]->Check(true);
+	recordingMenuItems[wxID_RECORDING_FILE_FORMAT_WAV]->Check(true);
 
 	return menu;
 }
@@ -943,6 +976,11 @@ void AppFrame::updateRecordingMenu() {
 
 		recordingMenuItems[wxID_RECORDING_SQUELCH_ALWAYS]->Check(true);
 		recordingMenuItems[wxID_RECORDING_SQUELCH_BASE]->SetItemLabel(getSettingsLabel("Squelch", "Record Always"));
+
+	} else if (squelchEnumValue == AudioSinkFileThread::SQUELCH_RECORD_TRANSMISSIONS) {
+
+		recordingMenuItems[wxID_RECORDING_SQUELCH_TRANSMISSIONS]->Check(true);
+		recordingMenuItems[wxID_RECORDING_SQUELCH_BASE]->SetItemLabel(getSettingsLabel("Squelch", "Record Transmissions"));
 	}
 	else {
 		recordingMenuItems[wxID_RECORDING_SQUELCH_SILENCE]->Check(true);
@@ -961,6 +999,26 @@ void AppFrame::updateRecordingMenu() {
 		recordingMenuItems[wxID_RECORDING_FILE_TIME_LIMIT]->SetItemLabel(getSettingsLabel("File time limit",
 			std::to_string(fileTimeLimitSeconds), "s"));
 	}
+
+	//Pre-roll and hang time:
+	recordingMenuItems[wxID_RECORDING_PRE_ROLL]->SetItemLabel(getSettingsLabel("Pre-roll",
+		std::to_string(wxGetApp().getConfig()->getRecordingPreRoll()), "ms"));
+	recordingMenuItems[wxID_RECORDING_HANG_TIME]->SetItemLabel(getSettingsLabel("Hang time",
+		std::to_string(wxGetApp().getConfig()->getRecordingHangTime()), "ms"));
+
+	//File format:
+#if USE_FLAC
+	if (wxGetApp().getConfig()->getRecordingFileFormat() == AudioFile::AUDIO_FILE_FORMAT_FLAC) {
+
+		recordingMenuItems[wxID_RECORDING_FILE_FORMAT_FLAC]->Check(true);
+		recordingMenuItems[wxID_RECORDING_FILE_FORMAT_BASE]->SetItemLabel(getSettingsLabel("File format", "FLAC"));
+	}
+	else
+#endif
+	{
+		recordingMenuItems[wxID_RECORDING_FILE_FORMAT_WAV]->Check(true);
+		recordingMenuItems[wxID_RECORDING_FILE_FORMAT_BASE]->SetItemLabel(getSettingsLabel("File format", "WAV"));
+	}
 }
 
 void AppFrame::initDeviceParams(SDRDeviceInfo *devInfo) {
@@ -970,6 +1028,7 @@ void AppFrame::initDeviceParams(SDRDeviceInfo *devInfo) {
 
 void AppFrame::notifyDeviceChanged() {
     deviceChanged.store(true);
+    RenderScheduler::wake();
 }
 
 void AppFrame::handleUpdateDeviceParams() {
@@ -1292,7 +1351,10 @@ void AppFrame::dismissRigControlPortDialog() {
 
 void AppFrame::OnMenu(wxCommandEvent &event) {
     actionOnMenuAbout(event)
+    || actionOnMenuDiagnostics(event)
     || actionOnMenuSDRStartStop(event)
+    || actionOnMenuReceivers(event)
+    || actionOnMenuSignalDetection(event)
     || actionOnMenuPerformance(event)
     || actionOnMenuTips(event)
     || actionOnMenuIQSwap(event)
@@ -1814,6 +1876,71 @@ bool AppFrame::actionOnMenuRecording(wxCommandEvent& event) {
 		updateRecordingMenu();
 		return true;
 	}
+	else if (event.GetId() == wxID_RECORDING_SQUELCH_TRANSMISSIONS) {
+
+		wxGetApp().getConfig()->setRecordingSquelchOption(AudioSinkFileThread::SQUELCH_RECORD_TRANSMISSIONS);
+
+		updateRecordingMenu();
+		return true;
+	}
+	else if (event.GetId() == wxID_RECORDING_PRE_ROLL) {
+
+		long newPreRoll = wxGetNumberFromUser(wxString("\nPre-roll:\n") +
+			"\nRecord Transmissions: audio kept from before the squelch-break, so that the start of a transmission is not lost.\n\n  " +
+			+ "min: 0 ms"
+			+ ", max: 5000 ms\n",
+			"Time in milliseconds",
+			"Pre-roll",
+			wxGetApp().getConfig()->getRecordingPreRoll(),
+			0,
+			5000,
+			this);
+
+		if (newPreRoll != -1) {
+
+			wxGetApp().getConfig()->setRecordingPreRoll((int)newPreRoll);
+
+			updateRecordingMenu();
+		}
+
+		return true;
+	}
+	else if (event.GetId() == wxID_RECORDING_HANG_TIME) {
+
+		long newHangTime = wxGetNumberFromUser(wxString("\nHang time:\n") +
+			"\nRecord Transmissions: how long to keep recording after the squelch closed before ending the transmission file.\n\n  " +
+			+ "min: 0 ms"
+			+ ", max: 60000 ms\n",
+			"Time in milliseconds",
+			"Hang Time",
+			wxGetApp().getConfig()->getRecordingHangTime(),
+			0,
+			60000,
+			this);
+
+		if (newHangTime != -1) {
+
+			wxGetApp().getConfig()->setRecordingHangTime((int)newHangTime);
+
+			updateRecordingMenu();
+		}
+
+		return true;
+	}
+	else if (event.GetId() == wxID_RECORDING_FILE_FORMAT_WAV) {
+
+		wxGetApp().getConfig()->setRecordingFileFormat(AudioFile::AUDIO_FILE_FORMAT_WAV);
+
+		updateRecordingMenu();
+		return true;
+	}
+	else if (event.GetId() == wxID_RECORDING_FILE_FORMAT_FLAC) {
+
+		wxGetApp().getConfig()->setRecordingFileFormat(AudioFile::AUDIO_FILE_FORMAT_FLAC);
+
+		updateRecordingMenu();
+		return true;
+	}
 	else if (event.GetId() == wxID_RECORDING_FILE_TIME_LIMIT) {
 
 		int currentFileLimitSeconds = wxGetApp().getConfig()->getRecordingFileTimeLimit();
@@ -2013,6 +2140,22 @@ bool AppFrame::actionOnMenuSetPPM(wxCommandEvent &event) {
     return false;
 }
 
+bool AppFrame::actionOnMenuDiagnostics(wxCommandEvent &event) {
+    if (event.GetId() == wxID_DIAGNOSTICS) {
+        if (diagnosticsDlg != nullptr) {
+            diagnosticsDlg->Raise();
+            diagnosticsDlg->SetFocus();
+        } else {
+            diagnosticsDlg = new DiagnosticsDialog(this);
+            diagnosticsDlg->Connect(wxEVT_CLOSE_WINDOW, wxCommandEventHandler(AppFrame::OnDiagnosticsDialogClose), NULL, this);
+
+            diagnosticsDlg->Show();
+        }
+        return true;
+    }
+    return false;
+}
+
 bool AppFrame::actionOnMenuSDRDevices(wxCommandEvent &event) {
     if (event.GetId() == wxID_SDR_DEVICES) {
         wxGetApp().deviceSelector();
@@ -2116,17 +2259,109 @@ bool AppFrame::actionOnMenuSDRStartStop(wxCommandEvent &event) {
     return false;
 }
 
+bool AppFrame::actionOnMenuReceivers(wxCommandEvent &event) {
+    if (event.GetId() == wxID_SDR_REMOVE_RECEIVERS) {
+        wxGetApp().removeReceivers();
+        return true;
+    }
+
+    if (event.GetId() != wxID_SDR_ADD_RECEIVER) {
+        return false;
+    }
+
+    SDRDeviceInfo *mainDev = wxGetApp().getDevice();
+    std::vector<SDRDeviceInfo *> *devs = wxGetApp().getDevices();
+
+    if (!mainDev || !devs) {
+        wxMessageBox("Start a device first, the receivers are added to it.", "Add Receiver", wxOK | wxICON_INFORMATION, this);
+        return true;
+    }
+
+    //the available devices, but the main one and the running receivers.
+    std::vector<SDRDeviceInfo *> candidates;
+    wxArrayString choices;
+
+    for (SDRDeviceInfo *dev : *devs) {
+        if (!dev->isAvailable() || dev->isActive() || dev->getDeviceId() == mainDev->getDeviceId()) {
+            continue;
+        }
+        candidates.push_back(dev);
+        choices.Add(dev->getName());
+    }
+
+    if (candidates.empty()) {
+        wxMessageBox("No other available device to add as a receiver.", "Add Receiver", wxOK | wxICON_INFORMATION, this);
+        return true;
+    }
+
+    int choice = wxGetSingleChoiceIndex("Device of the receiver:", "Add Receiver", choices, this);
+
+    if (choice < 0) {
+        return true;
+    }
+
+    //next to the main band by default.
+    long long defaultFreq = wxGetApp().getFrequency() + wxGetApp().getSampleRate();
+
+    wxString freqStr = wxGetTextFromUser("Center frequency of the receiver, i.e. 101.1M", "Add Receiver", frequencyToStr(defaultFreq), this);
+
+    if (freqStr.IsEmpty()) {
+        return true;
+    }
+
+    long long freq = strToFrequency(freqStr.ToStdString());
+
+    if (freq <= 0 || !wxGetApp().addReceiver(candidates[choice], freq)) {
+        wxMessageBox("The receiver could not be started.", "Add Receiver", wxOK | wxICON_ERROR, this);
+    }
+
+    return true;
+}
+
+bool AppFrame::actionOnMenuSignalDetection(wxCommandEvent &event) {
+    if (event.GetId() == wxID_SIGNAL_DETECTION) {
+        wxGetApp().setSignalDetectorEnabled(event.IsChecked());
+        return true;
+    }
+
+    bool exportSignals = (event.GetId() == wxID_EXPORT_SIGNALS);
+
+    if (!exportSignals && event.GetId() != wxID_EXPORT_OCCUPANCY) {
+        return false;
+    }
+
+    SignalDetector *detector = wxGetApp().getSignalDetectorThread()->getDetector();
+
+    wxFileDialog saveFileDialog(this, exportSignals ? _("Export detected signals") : _("Export channel occupancy"), "",
+                                exportSignals ? "signals.csv" : "occupancy.csv", "CSV files (*.csv)|*.csv", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+        return true;
+    }
+
+    std::string fileName = saveFileDialog.GetPath().ToStdString();
+    bool written = exportSignals ? detector->exportSignals(fileName) : detector->exportOccupancy(fileName);
+
+    if (!written) {
+        wxMessageBox("Unable to write " + fileName, "Export", wxOK | wxICON_ERROR, this);
+    }
+
+    return true;
+}
+
 void AppFrame::OnClose(wxCloseEvent& event) {
     wxGetApp().closeDeviceSelector();
     if (aboutDlg) {
         aboutDlg->Destroy();
     }
+    if (diagnosticsDlg) {
+        diagnosticsDlg->Destroy();
+    }
 
     if (wxGetApp().getDemodSpectrumProcessor()) {
         wxGetApp().getDemodSpectrumProcessor()->removeOutput(demodSpectrumCanvas->getVisualDataQueue());
         wxGetApp().getDemodSpectrumProcessor()->removeOutput(demodWaterfallCanvas->getVisualDataQueue());
     }
-    wxGetApp().getSpectrumProcessor()->removeOutput(spectrumCanvas->getVisualDataQueue());
+    wxGetApp().getSpectrumStitcher()->removeOutput(spectrumCanvas->getVisualDataQueue());
 
     if (saveDisabled) {
         event.Skip();
@@ -2173,7 +2408,7 @@ void AppFrame::OnNewWindow(wxCommandEvent& WXUNUSED(event)) {
     new AppFrame();
 }
 
-void AppFrame::OnIdle(wxIdleEvent &event) {
+void AppFrame::onRenderFrame() {
 
     handleUpdateDeviceParams();
 
@@ -2197,6 +2432,7 @@ void AppFrame::OnIdle(wxIdleEvent &event) {
     handleScopeSpectrumProcessors();
     handleModemProperties();
     handlePeakHold();
+    handleFailedReceivers();
 
 #if USE_HAMLIB
     handleRigMenu();
@@ -2207,18 +2443,10 @@ void AppFrame::OnIdle(wxIdleEvent &event) {
         waterfallCanvas->SetFocus();
     }
 #endif
+}
 
-    if (!this->IsActive()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(30));
-    } else {
-        if (wxGetApp().getConfig()->getPerfMode() == AppConfig::PERF_LOW) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(30));
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-    }
-
-    event.RequestMore();
+RenderScheduler *AppFrame::getRenderScheduler() {
+    return renderScheduler;
 }
 
 void AppFrame::handleTXAntennaChange() {//Refresh the current TX antenna on, if any:
@@ -2258,6 +2486,13 @@ void AppFrame::handlePeakHold() {
     }
 }
 
+void AppFrame::handleFailedReceivers() {
+    //on the status bar rather than in a modal dialog, being called from the render timer.
+    for (const std::string& deviceName : wxGetApp().removeFailedReceivers()) {
+        GetStatusBar()->SetStatusText("Receiver " + deviceName + " failed to start its stream and was stopped.");
+    }
+}
+
 void AppFrame::handleModemProperties() {
     DemodulatorInstancePtr demod = wxGetApp().getDemodMgr().getCurrentModem();
 
@@ -2648,6 +2883,11 @@ void AppFrame::OnAboutDialogClose(wxCommandEvent& /* event */) {
     aboutDlg = nullptr;
 }
 
+void AppFrame::OnDiagnosticsDialogClose(wxCommandEvent& /* event */) {
+    diagnosticsDlg->Destroy();
+    diagnosticsDlg = nullptr;
+}
+
 void AppFrame::saveSession(std::string fileName) {
     wxGetApp().getSessionMgr().saveSession(fileName);
 
@@ -2724,6 +2964,7 @@ SpectrumCanvas *AppFrame::getSpectrumCanvas() {
 void AppFrame::notifyUpdateModemProperties() {
    
     modemPropertiesUpdated.store(true);
+    RenderScheduler::wake();
 }
 
 void AppFrame::setMainWaterfallFFTSize(int fftSize) {
@@ -2891,6 +3132,7 @@ int AppFrame::OnGlobalKeyDown(wxKeyEvent &event) {
         case 'P':
         case 'M':
         case 'R':
+        case 'N':
             return 1;
         case WXK_NUMPAD0:
         case WXK_NUMPAD1:
@@ -3050,6 +3292,9 @@ int AppFrame::OnGlobalKeyUp(wxKeyEvent &event) {
                 toggleActiveDemodRecording();
             }
             break;
+        case 'N':
+            toggleActiveDemodStreaming();
+            break;
         case 'P':
             wxGetApp().getSpectrumProcessor()->setPeakHold(!wxGetApp().getSpectrumProcessor()->getPeakHold());
             if (wxGetApp().getDemodSpectrumProcessor()) {
@@ -3134,6 +3379,14 @@ void AppFrame::toggleAllActiveDemodRecording() {
     wxGetApp().getBookmarkMgr().updateActiveList();
 }
 
+void AppFrame::toggleActiveDemodStreaming() {
+    DemodulatorInstancePtr activeDemod = wxGetApp().getDemodMgr().getActiveContextModem();
+
+    if (activeDemod) {
+        activeDemod->setStreaming(!activeDemod->isStreaming());
+    }
+}
+
 void AppFrame::setWaterfallLinesPerSecond(int lps) {
     waterfallSpeedMeter->setUserInputValue(sqrt(lps));
 }
@@ -27,8 +27,10 @@
 #include "FrequencyDialog.h"
 #include "BookmarkView.h"
 #include "AboutDialog.h"
+#include "DiagnosticsDialog.h"
 #include "DemodulatorInstance.h"
 #include "DemodulatorThread.h"
+#include "RenderScheduler.h"
 #include <map>
 
 
@@ -70,6 +72,11 @@ public:
     BookmarkView *getBookmarkView();
     void disableSave(bool state);
 
+    RenderScheduler *getRenderScheduler();
+
+    //called by the RenderScheduler on every frame, before the canvases are redrawn.
+    void onRenderFrame();
+
     //call this in case the main UI is not 
     //the origin of device changes / sample rate by operator,
     //and must be notified back to update its UI elements
@@ -171,8 +178,11 @@ private:
     std::string currentTXantennaName;
 
     AboutDialog *aboutDlg = nullptr;
+    DiagnosticsDialog *diagnosticsDlg = nullptr;
     std::string lastToolTip;
 
+    RenderScheduler *renderScheduler = nullptr;
+
 #ifdef ENABLE_DIGITAL_LAB
     ModeSelectorCanvas *demodModeSelectorAdv;
 #endif
@@ -183,10 +193,10 @@ private:
      */
     void OnMenu(wxCommandEvent& event);
     void OnClose(wxCloseEvent& event);
-    void OnIdle(wxIdleEvent& event);
     void OnDoubleClickSash(wxSplitterEvent& event);
     void OnUnSplit(wxSplitterEvent& event);
     void OnAboutDialogClose(wxCommandEvent& event);
+    void OnDiagnosticsDialogClose(wxCommandEvent& event);
 	void OnNewWindow(wxCommandEvent& event);
 
     /**
@@ -202,6 +212,7 @@ private:
 
 	void toggleActiveDemodRecording();
 	void toggleAllActiveDemodRecording();
+	void toggleActiveDemodStreaming();
 
 	/**
 	 * UI init functions
@@ -245,6 +256,7 @@ private:
 	//actionXXXX manage menu actions, return true if the event has been
 	//treated.
 	bool actionOnMenuAbout(wxCommandEvent& event);
+	bool actionOnMenuDiagnostics(wxCommandEvent& event);
 	bool actionOnMenuReset(wxCommandEvent& event);
 	bool actionOnMenuSettings(wxCommandEvent& event);
 	bool actionOnMenuAGC(wxCommandEvent& event);
@@ -255,6 +267,8 @@ private:
 	bool actionOnMenuRecording(wxCommandEvent& event);
 	bool actionOnMenuRig(wxCommandEvent& event);
 	bool actionOnMenuSDRStartStop(wxCommandEvent &event);
+	bool actionOnMenuReceivers(wxCommandEvent &event);
+	bool actionOnMenuSignalDetection(wxCommandEvent &event);
 	bool actionOnMenuPerformance(wxCommandEvent &event);
 	bool actionOnMenuTips(wxCommandEvent &event);
 	bool actionOnMenuIQSwap(wxCommandEvent &event);
@@ -280,6 +294,7 @@ private:
     void handleScopeSpectrumProcessors();
     void handleModemProperties();
     void handlePeakHold();
+    void handleFailedReceivers();
 
 
     /**
@@ -328,6 +343,12 @@ private:
 #define wxID_SDR_START_STOP 2010
 #define wxID_SET_DB_OFFSET 2012
 #define wxID_ABOUT_CUBICSDR 2013
+#define wxID_DIAGNOSTICS 2014
+#define wxID_SDR_ADD_RECEIVER 2015
+#define wxID_SDR_REMOVE_RECEIVERS 2016
+#define wxID_SIGNAL_DETECTION 2017
+#define wxID_EXPORT_SIGNALS 2018
+#define wxID_EXPORT_OCCUPANCY 2019
 
 #define wxID_OPEN_BOOKMARKS 2020
 #define wxID_SAVE_BOOKMARKS 2021
@@ -372,6 +393,12 @@ private:
 #define  wxID_RECORDING_SQUELCH_SKIP 8503
 #define  wxID_RECORDING_SQUELCH_ALWAYS 8504
 #define  wxID_RECORDING_FILE_TIME_LIMIT 8505
+#define  wxID_RECORDING_FILE_FORMAT_BASE 8506
+#define  wxID_RECORDING_FILE_FORMAT_WAV 8507
+#define  wxID_RECORDING_FILE_FORMAT_FLAC 8508
+#define  wxID_RECORDING_SQUELCH_TRANSMISSIONS 8509
+#define  wxID_RECORDING_PRE_ROLL 8510
+#define  wxID_RECORDING_HANG_TIME 8511
 
 #define wxID_AUDIO_BANDWIDTH_BASE 9000
 #define wxID_AUDIO_DEVICE_MULTIPLIER 50
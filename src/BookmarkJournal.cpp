@@ -0,0 +1,228 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "BookmarkJournal.h"
+#include <cstdint>
+#include <iostream>
+
+//50 ms
+#define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000)
+
+BookmarkJournal::BookmarkJournal(const std::string& bookmarkPath) : IOThread(), bookmarkPath(bookmarkPath), journalFile(nullptr) {
+    journalPath = getJournalPath(bookmarkPath);
+
+    requestQueue = std::make_shared<BookmarkJournalRequestQueue>();
+    requestQueue->set_max_num_items(BOOKMARK_JOURNAL_QUEUE_SIZE);
+    requestQueue->set_stats_name("BookmarkJournalRequests");
+}
+
+BookmarkJournal::~BookmarkJournal() {
+    if (journalFile) {
+        fclose(journalFile);
+    }
+}
+
+std::string BookmarkJournal::getJournalPath(const std::string& bookmarkPath) {
+    return bookmarkPath + ".journal";
+}
+
+void BookmarkJournal::append(DataTree &operation) {
+
+    BookmarkJournalRequest request;
+    request.cmd = BookmarkJournalRequest::BOOKMARK_JOURNAL_APPEND;
+    operation.toBinary(request.record);
+
+    //blocking push: never lose an edit.
+    requestQueue->push(request);
+}
+
+void BookmarkJournal::compact(DataTreePtr tree, int generation) {
+
+    BookmarkJournalRequest request;
+    request.cmd = BookmarkJournalRequest::BOOKMARK_JOURNAL_COMPACT;
+    request.tree = tree;
+    request.generation = generation;
+
+    requestQueue->push(request);
+}
+
+void BookmarkJournal::run() {
+
+    BookmarkJournalRequest request;
+
+    //on termination, keep going until every pending request is done.
+    while (!stopping || !requestQueue->empty()) {
+
+        if (!requestQueue->pop(request, HEARTBEAT_CHECK_PERIOD_MICROS)) {
+            continue;
+        }
+
+        process(request);
+
+        request = BookmarkJournalRequest();
+    }
+
+    if (journalFile) {
+        fclose(journalFile);
+        journalFile = nullptr;
+    }
+}
+
+void BookmarkJournal::terminate() {
+    IOThread::terminate();
+}
+
+void BookmarkJournal::process(BookmarkJournalRequest &request) {
+
+    switch (request.cmd) {
+        case BookmarkJournalRequest::BOOKMARK_JOURNAL_APPEND:
+            if (journalFile == nullptr) {
+                std::cout << "BookmarkJournal: no journal open, edit not recorded." << std::endl;
+                break;
+            }
+            writeRecord(request.record);
+            break;
+
+        case BookmarkJournalRequest::BOOKMARK_JOURNAL_COMPACT:
+        {
+            if (request.tree && !writeBookmarkFile(request.tree)) {
+                //keep the current journal, still matching the current file.
+                break;
+            }
+
+            if (journalFile) {
+                fclose(journalFile);
+            }
+
+            journalFile = fopen(journalPath.c_str(), "wb");
+
+            if (journalFile == nullptr) {
+                std::cout << "BookmarkJournal: unable to open '" << journalPath << "' for writing." << std::endl;
+                break;
+            }
+
+            DataTree header("journal");
+            *header.rootNode()->newChild("generation") = request.generation;
+
+            std::vector<unsigned char> record;
+            header.toBinary(record);
+
+            writeRecord(record);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+bool BookmarkJournal::writeRecord(const std::vector<unsigned char> &record) {
+
+    uint32_t recordSize = (uint32_t)record.size();
+
+    //a record is complete on disk before the next edit.
+    if (fwrite(&recordSize, sizeof(uint32_t), 1, journalFile) != 1 ||
+        fwrite(&record[0], 1, record.size(), journalFile) != record.size() ||
+        fflush(journalFile) != 0) {
+
+        //the records after a partial one would be misread: the journal stops there, until the next compaction.
+        std::cout << "BookmarkJournal: unable to write to '" << journalPath << "', edits are no longer recorded." << std::endl;
+        fclose(journalFile);
+        journalFile = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+bool BookmarkJournal::writeBookmarkFile(DataTreePtr tree) {
+
+    std::string tmpPath = bookmarkPath + ".tmp";
+    std::string backupPath = bookmarkPath + ".backup";
+
+    if (!tree->SaveToFileXML(tmpPath)) {
+        std::cout << "BookmarkJournal: unable to write '" << tmpPath << "'." << std::endl;
+        return false;
+    }
+
+    //the binary copy goes first: a crash from here on must not leave it to pass for the new file.
+    std::remove((bookmarkPath + BOOKMARK_BINARY_CACHE_SUFFIX).c_str());
+
+    //the previous file becomes the backup, then the new one takes its place.
+    std::remove(backupPath.c_str());
+    std::rename(bookmarkPath.c_str(), backupPath.c_str());
+
+    if (std::rename(tmpPath.c_str(), bookmarkPath.c_str()) != 0) {
+        std::cout << "BookmarkJournal: unable to replace '" << bookmarkPath << "'." << std::endl;
+        std::rename(backupPath.c_str(), bookmarkPath.c_str());
+        return false;
+    }
+
+    tree->SaveToFileBinary(bookmarkPath + BOOKMARK_BINARY_CACHE_SUFFIX);
+
+    return true;
+}
+
+bool BookmarkJournal::readOperations(const std::string& bookmarkPath, int generation, std::vector<DataTreePtr> &operations_out) {
+
+    FILE *fp = fopen(getJournalPath(bookmarkPath).c_str(), "rb");
+
+    if (fp == nullptr) {
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long remaining = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    std::vector<unsigned char> record;
+    uint32_t recordSize;
+    bool first = true;
+
+    while (remaining >= (long)sizeof(uint32_t) && fread(&recordSize, sizeof(uint32_t), 1, fp) == 1) {
+
+        remaining -= sizeof(uint32_t);
+
+        //a record cut short by a crash, or a corrupt size, ends the journal.
+        if (recordSize == 0 || (unsigned long)recordSize > (unsigned long)remaining) {
+            break;
+        }
+
+        record.resize(recordSize);
+
+        if (fread(&record[0], 1, recordSize, fp) != recordSize) {
+            break;
+        }
+
+        remaining -= recordSize;
+
+        DataTreePtr operation = std::make_shared<DataTree>();
+
+        if (!operation->fromBinary(&record[0], record.size())) {
+            break;
+        }
+
+        if (first) {
+            int journalGeneration = -1;
+
+            if (operation->rootNode()->getName() == "journal" && operation->rootNode()->hasAnother("generation")) {
+                operation->rootNode()->getNext("generation")->element()->get(journalGeneration);
+            }
+
+            //a journal of another file generation has already been compacted.
+            if (journalGeneration != generation) {
+                fclose(fp);
+                return false;
+            }
+
+            first = false;
+            continue;
+        }
+
+        operations_out.push_back(operation);
+    }
+
+    fclose(fp);
+
+    return !first;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include "IOThread.h"
+#include "ThreadBlockingQueue.h"
+#include "DataTree.h"
+
+//binary copy of the bookmark file, faster to load than the XML.
+#define BOOKMARK_BINARY_CACHE_SUFFIX ".bin"
+
+//max number of pending requests before the editing thread blocks.
+#define BOOKMARK_JOURNAL_QUEUE_SIZE (1024)
+
+typedef std::shared_ptr<DataTree> DataTreePtr;
+
+class BookmarkJournalRequest {
+public:
+    enum BookmarkJournalRequestEnum {
+        BOOKMARK_JOURNAL_NULL, BOOKMARK_JOURNAL_APPEND, BOOKMARK_JOURNAL_COMPACT
+    };
+
+    BookmarkJournalRequest() : cmd(BOOKMARK_JOURNAL_NULL), generation(0) {
+    }
+
+    BookmarkJournalRequestEnum cmd;
+    //BOOKMARK_JOURNAL_APPEND: one encoded operation.
+    std::vector<unsigned char> record;
+    //BOOKMARK_JOURNAL_COMPACT: the whole bookmarks, or nullptr to only restart the journal.
+    DataTreePtr tree;
+    int generation;
+};
+
+typedef ThreadBlockingQueue<BookmarkJournalRequest> BookmarkJournalRequestQueue;
+typedef std::shared_ptr<BookmarkJournalRequestQueue> BookmarkJournalRequestQueuePtr;
+
+/**
+ * Append-only log of the bookmark edits made since the bookmark file was last written,
+ * so that an edit costs a single record instead of a rewrite of every bookmark.
+ * The file and the journal both carry a generation number: a compaction writes the whole
+ * bookmarks as the file of the next generation, then restarts the journal for it.
+ * A journal is only replayed onto the file of the same generation.
+ */
+class BookmarkJournal : public IOThread {
+
+public:
+    BookmarkJournal(const std::string& bookmarkPath);
+    virtual ~BookmarkJournal();
+
+    virtual void run();
+    virtual void terminate();
+
+    void append(DataTree &operation);
+
+    //write 'tree' as the bookmark file of 'generation', if any, then start a new journal of 'generation'.
+    void compact(DataTreePtr tree, int generation);
+
+    //the operations of the journal of bookmarkPath, if it follows the bookmark file of 'generation'.
+    static bool readOperations(const std::string& bookmarkPath, int generation, std::vector<DataTreePtr> &operations_out);
+
+    static std::string getJournalPath(const std::string& bookmarkPath);
+
+private:
+    void process(BookmarkJournalRequest &request);
+    //false if the record could not be written, the journal is then closed.
+    bool writeRecord(const std::vector<unsigned char> &record);
+    bool writeBookmarkFile(DataTreePtr tree);
+
+    std::string bookmarkPath;
+    std::string journalPath;
+    FILE *journalFile;
+
+    BookmarkJournalRequestQueuePtr requestQueue;
+};
@@ -5,24 +5,87 @@
 #include "CubicSDR.h"
 #include "DataTree.h"
 #include <wx/string.h>
+#include <algorithm>
+#include <cwctype>
 
 #define BOOKMARK_RECENTS_MAX 25
 
+//journal records before the bookmark file is rewritten as a whole.
+#define BOOKMARK_JOURNAL_COMPACT_RECORDS 500
+
 BookmarkEntry::~BookmarkEntry() {
     delete node;
 }
 
-BookmarkMgr::BookmarkMgr() {
+BookmarkMgr::BookmarkMgr() : journal(nullptr), journalThread(nullptr), journalGeneration(0), journalRecords(0), journalSuspended(false), bmIndexVersion(0) {
     rangesSorted = false;
 }
+
+BookmarkMgr::~BookmarkMgr() {
+    stopJournal();
+}
 //
 void BookmarkMgr::saveToFile(std::string bookmarkFn, bool backup, bool useFullpath) {
 
 	std::lock_guard < std::recursive_mutex > lock(busy_lock);
 
+    //the bookmark file of the config dir, written as a whole: the next generation, the journal restarts.
+    bool journaled = (backup && !useFullpath);
+    bool journalRunning = (journal != nullptr);
+
+    if (journaled) {
+        stopJournal();
+        journalGeneration++;
+    }
+
     DataTree s("cubicsdr_bookmarks");
+
+    saveToTree(s);
+
+	wxFileName saveFile;
+	wxFileName saveFileBackup;
+
+	if (useFullpath) {
+		saveFile.Assign(bookmarkFn);
+		saveFileBackup.Assign(bookmarkFn + ".backup");
+	}
+	else {
+		saveFile.Assign(wxGetApp().getConfig()->getConfigDir(), bookmarkFn);
+		saveFileBackup.Assign(wxGetApp().getConfig()->getConfigDir(), bookmarkFn + ".backup");
+	}
+
+    if (saveFile.IsDirWritable()) {
+        // Hopefully leave at least a readable backup in case of failure..
+        if (backup && saveFile.FileExists() && (!saveFileBackup.FileExists() || saveFileBackup.IsFileWritable())) {
+            wxCopyFile(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString(), saveFileBackup.GetFullPath(wxPATH_NATIVE).ToStdString());
+        }
+
+        //the binary copy of the previous file must not outlive it, in case of failure below.
+        wxFileName binaryFile(saveFile.GetFullPath() + BOOKMARK_BINARY_CACHE_SUFFIX);
+        if (!useFullpath && binaryFile.FileExists()) {
+            wxRemoveFile(binaryFile.GetFullPath(wxPATH_NATIVE));
+        }
+        s.SaveToFileXML(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString());
+
+        //binary copy of the bookmarks of the config dir, faster to load than the XML.
+        if (!useFullpath) {
+            s.SaveToFileBinary(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString() + BOOKMARK_BINARY_CACHE_SUFFIX);
+        }
+    }
+
+    if (journaled && journalRunning) {
+        startJournal(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString(), false);
+    } else if (journaled) {
+        //a journal left from a file that could not be loaded must never be replayed on this one.
+        wxRemoveFile(BookmarkJournal::getJournalPath(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString()));
+    }
+}
+
+void BookmarkMgr::saveToTree(DataTree &s) {
+
     DataNode *header = s.rootNode()->newChild("header");
     header->newChild("version")->element()->set(wxString(CUBICSDR_VERSION).ToStdWstring());
+    *header->newChild("journal_generation") = journalGeneration;
 
     DataNode *branches = s.rootNode()->newChild("branches");
     
@@ -76,26 +139,6 @@ void BookmarkMgr::saveToFile(std::string bookmarkFn, bool backup, bool useFullpa
     for (auto &r_i : this->recents) {
         recent_modems->newChildCloneFrom("modem", r_i->node);
     }
-
-	wxFileName saveFile;
-	wxFileName saveFileBackup;
-
-	if (useFullpath) {
-		saveFile.Assign(bookmarkFn);
-		saveFileBackup.Assign(bookmarkFn + ".backup");
-	}
-	else {
-		saveFile.Assign(wxGetApp().getConfig()->getConfigDir(), bookmarkFn);
-		saveFileBackup.Assign(wxGetApp().getConfig()->getConfigDir(), bookmarkFn + ".backup");
-	}
-
-    if (saveFile.IsDirWritable()) {
-        // Hopefully leave at least a readable backup in case of failure..
-        if (backup && saveFile.FileExists() && (!saveFileBackup.FileExists() || saveFileBackup.IsFileWritable())) {
-            wxCopyFile(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString(), saveFileBackup.GetFullPath(wxPATH_NATIVE).ToStdString());
-        }
-        s.SaveToFileXML(saveFile.GetFullPath(wxPATH_NATIVE).ToStdString());
-    }
 }
 
 bool BookmarkMgr::loadFromFile(std::string bookmarkFn, bool backup, bool useFullpath) {
@@ -120,7 +163,7 @@ bool BookmarkMgr::loadFromFile(std::string bookmarkFn, bool backup, bool useFull
 		backupFile.Assign(wxGetApp().getConfig()->getConfigDir(), bookmarkFn + ".backup");
 	}
 
-    DataTree s;
+    DataTree binaryTree, xmlTree;
     bool loadStatusOk = true;
     
     // File exists but is not readable
@@ -131,24 +174,48 @@ bool BookmarkMgr::loadFromFile(std::string bookmarkFn, bool backup, bool useFull
     // New instance of bookmark savefiles
     if (backup && !loadFile.FileExists() && !lastLoaded.FileExists() && !backupFile.FileExists()) {
         loadDefaultRanges();
+        if (!useFullpath) {
+            startJournal(loadFile.GetFullPath(wxPATH_NATIVE).ToStdString(), true);
+        }
         return true;
     }
     
-    // Attempt to load file
-    if (!s.LoadFromFileXML(loadFile.GetFullPath(wxPATH_NATIVE).ToStdString())) {
+    // Attempt to load file, from the binary copy unless the XML has been modified since.
+    wxFileName binaryFile(loadFile.GetFullPath() + BOOKMARK_BINARY_CACHE_SUFFIX);
+    bool binaryLoaded = false;
+
+    if (!useFullpath && loadFile.FileExists() && binaryFile.FileExists() &&
+        binaryFile.GetModificationTime().IsLaterThan(loadFile.GetModificationTime() - wxTimeSpan::Seconds(1))) {
+        binaryLoaded = binaryTree.LoadFromFileBinary(binaryFile.GetFullPath(wxPATH_NATIVE).ToStdString()) &&
+            (binaryTree.rootNode()->getName() == "cubicsdr_bookmarks");
+    }
+
+    if (!binaryLoaded && !xmlTree.LoadFromFileXMLStream(loadFile.GetFullPath(wxPATH_NATIVE).ToStdString())) {
         return false;
     }
 
+    DataTree &s = binaryLoaded ? binaryTree : xmlTree;
+
 	//Check if it is a bookmark file, read the root node.
 	if (s.rootNode()->getName() != "cubicsdr_bookmarks") {
 		return false;
 	}
 	
+	int fileGeneration = 0;
+
+	if (s.rootNode()->hasAnother("header")) {
+		DataNode *header = s.rootNode()->getNext("header");
+		if (header->hasAnother("journal_generation")) header->getNext("journal_generation")->element()->get(fileGeneration);
+	}
+
+	journalSuspended = true;
+
 	// Clear any active data
 	bmData.clear();
 	recents.clear();
 	ranges.clear();
 	bmDataSorted.clear();
+	clearIndex();
     
     if (s.rootNode()->hasAnother("branches")) {
         DataNode *branches = s.rootNode()->getNext("branches");
@@ -166,16 +233,7 @@ bool BookmarkMgr::loadFromFile(std::string bookmarkFn, bool backup, bool useFull
     if (s.rootNode()->hasAnother("ranges")) {
         DataNode *view_ranges = s.rootNode()->getNext("ranges");
         while (view_ranges->hasAnother("range")) {
-            DataNode *range = view_ranges->getNext("range");
-            
-            BookmarkRangeEntryPtr re(new BookmarkRangeEntry);
-            
-            if (range->hasAnother("label")) range->getNext("label")->element()->get(re->label);
-            if (range->hasAnother("freq")) range->getNext("freq")->element()->get(re->freq);
-            if (range->hasAnother("start")) range->getNext("start")->element()->get(re->startFreq);
-            if (range->hasAnother("end")) range->getNext("end")->element()->get(re->endFreq);
-            
-            addRange(re);
+            addRange(nodeToRange(view_ranges->getNext("range")));
         }
     }
  
@@ -220,6 +278,19 @@ bool BookmarkMgr::loadFromFile(std::string bookmarkFn, bool backup, bool useFull
         }
     }
 
+    int replayed = 0;
+
+    //edits made since the file was written, if it was not written at exit.
+    if (!useFullpath) {
+        replayed = replayJournal(loadFile.GetFullPath(wxPATH_NATIVE).ToStdString(), fileGeneration);
+
+        if (replayed > 0) {
+            std::cout << "Replayed " << replayed << " bookmark edits from the journal." << std::endl;
+        }
+    }
+
+    journalSuspended = false;
+
     if (backup) {
         if (loadStatusOk) {  // Loaded OK; keep a copy
             if (loadFile.IsDirWritable()) {
@@ -235,6 +306,17 @@ bool BookmarkMgr::loadFromFile(std::string bookmarkFn, bool backup, bool useFull
             }
         }
     }
+
+    //after the copies above, as a compaction moves the file.
+    if (backup && !useFullpath) {
+        journalGeneration = fileGeneration;
+
+        //fold the replayed edits into the file right away.
+        startJournal(loadFile.GetFullPath(wxPATH_NATIVE).ToStdString(), replayed > 0);
+    } else if (journal != nullptr) {
+        //every bookmark has been replaced.
+        compactJournal();
+    }
     
     return loadStatusOk;
 }
@@ -268,14 +350,23 @@ void BookmarkMgr::resetBookmarks() {
 
 	std::lock_guard < std::recursive_mutex > lock(busy_lock);
 
+	journalSuspended = true;
+
 	// Clear any active data
 	bmData.clear();
 	recents.clear();
 	ranges.clear();
 	bmDataSorted.clear();
+	clearIndex();
 
 	loadDefaultRanges();
 
+	journalSuspended = false;
+
+	if (journal != nullptr) {
+		compactJournal();
+	}
+
 }
 
 bool BookmarkMgr::hasLastLoad(std::string bookmarkFn) {
@@ -297,6 +388,12 @@ void BookmarkMgr::addBookmark(std::string group, DemodulatorInstancePtr demod) {
      
     bmData[group].push_back(be);
     bmDataSorted[group] = false;
+    indexBookmark(group, be);
+
+    DataTree operation("add_bookmark");
+    *operation.rootNode()->newChild("group") = group;
+    operation.rootNode()->newChildCloneFrom("modem", be->node);
+    journalOperation(operation);
 }
 
 void BookmarkMgr::addBookmark(std::string group, BookmarkEntryPtr be) {
@@ -304,6 +401,15 @@ void BookmarkMgr::addBookmark(std::string group, BookmarkEntryPtr be) {
     
     bmData[group].push_back(be);
     bmDataSorted[group] = false;
+    indexBookmark(group, be);
+
+    //no record to build while loading.
+    if (journal != nullptr && !journalSuspended) {
+        DataTree operation("add_bookmark");
+        *operation.rootNode()->newChild("group") = group;
+        operation.rootNode()->newChildCloneFrom("modem", be->node);
+        journalOperation(operation);
+    }
 }
 
 
@@ -319,18 +425,35 @@ void BookmarkMgr::removeBookmark(std::string group, BookmarkEntryPtr be) {
     if (i != bmData[group].end()) {
 
         bmData[group].erase(i);
+        unindexBookmark(be);
+
+        DataTree operation("remove_bookmark");
+        *operation.rootNode()->newChild("group") = group;
+        bookmarkKeyToNode(operation.rootNode()->newChild("key"), be);
+        journalOperation(operation);
     }
 }
 
 void BookmarkMgr::removeBookmark(BookmarkEntryPtr be) {
     std::lock_guard < std::recursive_mutex > lock(busy_lock);
     
+    bool removed = false;
+
     for (auto &bmd_i : bmData) {
         BookmarkList::iterator i = std::find(bmd_i.second.begin(), bmd_i.second.end(), be);
         if (i != bmd_i.second.end()) {
             bmd_i.second.erase(i);
+            removed = true;
         }
     }
+
+    if (removed) {
+        unindexBookmark(be);
+
+        DataTree operation("remove_bookmark");
+        bookmarkKeyToNode(operation.rootNode()->newChild("key"), be);
+        journalOperation(operation);
+    }
 }
 
 void BookmarkMgr::moveBookmark(BookmarkEntryPtr be, std::string group) {
@@ -346,17 +469,49 @@ void BookmarkMgr::moveBookmark(BookmarkEntryPtr be, std::string group) {
             bmd_i.second.erase(i);
             bmDataSorted[group] = false;
             bmDataSorted[bmd_i.first] = false;
+            indexBookmark(group, be);
+
+            DataTree operation("move_bookmark");
+            *operation.rootNode()->newChild("group") = group;
+            bookmarkKeyToNode(operation.rootNode()->newChild("key"), be);
+            journalOperation(operation);
             return;
         }
     }
 }
 
+void BookmarkMgr::setBookmarkLabel(BookmarkEntryPtr be, const std::wstring& label) {
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    DataTree operation("relabel_bookmark");
+    bookmarkKeyToNode(operation.rootNode()->newChild("key"), be);
+    *operation.rootNode()->newChild("user_label") = label;
+
+    be->label = label;
+    if (be->node->hasAnother("user_label")) {
+        be->node->child("user_label")->element()->set(label);
+    } else {
+        be->node->newChild("user_label")->element()->set(label);
+    }
+
+    BookmarkIndexEntries::iterator ie = bmIndexEntries.find(be.get());
+
+    //recents are not indexed
+    if (ie != bmIndexEntries.end()) {
+        indexBookmark(ie->second.group, be);
+        journalOperation(operation);
+    }
+}
 
 void BookmarkMgr::addGroup(std::string group) {
     std::lock_guard < std::recursive_mutex > lock(busy_lock);
     
     if (bmData.find(group) == bmData.end()) {
         BookmarkList dummy = bmData[group];
+
+        DataTree operation("add_group");
+        *operation.rootNode()->newChild("group") = group;
+        journalOperation(operation);
     }
 }
 
@@ -366,8 +521,16 @@ void BookmarkMgr::removeGroup(std::string group) {
     BookmarkMap::iterator i = bmData.find(group);
     
     if (i != bmData.end()) {
+
+        for (auto &bm_i : i->second) {
+            unindexBookmark(bm_i);
+        }
        
         bmData.erase(group);
+
+        DataTree operation("remove_group");
+        *operation.rootNode()->newChild("group") = group;
+        journalOperation(operation);
     }
 }
 
@@ -389,7 +552,19 @@ void BookmarkMgr::renameGroup(std::string group, std::string ngroup) {
     } else if (i != bmData.end()) {
         bmData[ngroup] = bmData[group];
         bmData.erase(group);
+    } else {
+        return;
     }
+
+    //the group name is one of the search words.
+    for (auto &bm_i : bmData[ngroup]) {
+        indexBookmark(ngroup, bm_i);
+    }
+
+    DataTree operation("rename_group");
+    *operation.rootNode()->newChild("group") = group;
+    *operation.rootNode()->newChild("new_group") = ngroup;
+    journalOperation(operation);
 }
 
 BookmarkList BookmarkMgr::getBookmarks(std::string group) {
@@ -531,6 +706,12 @@ void BookmarkMgr::addRange(BookmarkRangeEntryPtr re) {
     
     ranges.push_back(re);
     rangesSorted = false;
+
+    if (journal != nullptr && !journalSuspended) {
+        DataTree operation("add_range");
+        rangeToNode(operation.rootNode()->newChild("range"), re);
+        journalOperation(operation);
+    }
 }
 
 void BookmarkMgr::removeRange(BookmarkRangeEntryPtr re) {
@@ -541,9 +722,44 @@ void BookmarkMgr::removeRange(BookmarkRangeEntryPtr re) {
     if (re_i != ranges.end()) {
 
         ranges.erase(re_i);
+
+        DataTree operation("remove_range");
+        rangeToNode(operation.rootNode()->newChild("range"), re);
+        journalOperation(operation);
     }
 }
 
+void BookmarkMgr::setRangeLabel(BookmarkRangeEntryPtr re, const std::wstring& label) {
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    DataTree operation("relabel_range");
+    rangeToNode(operation.rootNode()->newChild("range"), re);
+    *operation.rootNode()->newChild("new_label") = label;
+
+    re->label = label;
+
+    if (std::find(ranges.begin(), ranges.end(), re) != ranges.end()) {
+        journalOperation(operation);
+    }
+}
+
+void BookmarkMgr::updateRange(BookmarkRangeEntryPtr re, long long freq, long long startFreq, long long endFreq) {
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    DataTree operation("update_range");
+    rangeToNode(operation.rootNode()->newChild("range"), re);
+
+    re->freq = freq;
+    re->startFreq = startFreq;
+    re->endFreq = endFreq;
+    rangesSorted = false;
+
+    rangeToNode(operation.rootNode()->newChild("new_range"), re);
+
+    if (std::find(ranges.begin(), ranges.end(), re) != ranges.end()) {
+        journalOperation(operation);
+    }
+}
 
 BookmarkRangeList BookmarkMgr::getRanges() {
     std::lock_guard < std::recursive_mutex > lock(busy_lock);
@@ -639,6 +855,401 @@ BookmarkEntryPtr BookmarkMgr::nodeToBookmark(DataNode *node) {
 }
 
 
+BookmarkRangeEntryPtr BookmarkMgr::nodeToRange(DataNode *node) {
+
+    BookmarkRangeEntryPtr re(new BookmarkRangeEntry);
+
+    if (node->hasAnother("label")) node->getNext("label")->element()->get(re->label);
+    if (node->hasAnother("freq")) node->getNext("freq")->element()->get(re->freq);
+    if (node->hasAnother("start")) node->getNext("start")->element()->get(re->startFreq);
+    if (node->hasAnother("end")) node->getNext("end")->element()->get(re->endFreq);
+
+    return re;
+}
+
+void BookmarkMgr::rangeToNode(DataNode *node, BookmarkRangeEntryPtr re) {
+    *node->newChild("label") = re->label;
+    *node->newChild("freq") = re->freq;
+    *node->newChild("start") = re->startFreq;
+    *node->newChild("end") = re->endFreq;
+}
+
+void BookmarkMgr::bookmarkKeyToNode(DataNode *node, BookmarkEntryPtr be) {
+    *node->newChild("type") = be->type;
+    *node->newChild("frequency") = be->frequency;
+    *node->newChild("bandwidth") = be->bandwidth;
+    *node->newChild("user_label") = be->label;
+}
+
+BookmarkRangeEntryPtr BookmarkMgr::findRange(DataNode *key) {
+
+    BookmarkRangeEntryPtr keyEntry = nodeToRange(key);
+
+    for (auto &re_i : ranges) {
+        if (re_i->label == keyEntry->label && re_i->freq == keyEntry->freq && re_i->startFreq == keyEntry->startFreq && re_i->endFreq == keyEntry->endFreq) {
+            return re_i;
+        }
+    }
+
+    return nullptr;
+}
+
+BookmarkEntryPtr BookmarkMgr::findBookmark(DataNode *key, const std::string& group) {
+
+    BookmarkEntryPtr keyEntry = nodeToBookmark(key);
+
+    if (!keyEntry) {
+        return nullptr;
+    }
+
+    for (auto &bmd_i : bmData) {
+        if (!group.empty() && bmd_i.first != group) {
+            continue;
+        }
+        for (auto &bm_i : bmd_i.second) {
+            if (bm_i->type == keyEntry->type && bm_i->frequency == keyEntry->frequency &&
+                bm_i->bandwidth == keyEntry->bandwidth && bm_i->label == keyEntry->label) {
+                return bm_i;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void BookmarkMgr::startJournal(const std::string& bookmarkPath, bool compactNow) {
+
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    if (journal == nullptr) {
+        journal = new BookmarkJournal(bookmarkPath);
+        journalThread = new std::thread(&BookmarkJournal::threadMain, journal);
+    }
+
+    journalRecords = 0;
+
+    if (compactNow) {
+        compactJournal();
+    } else {
+        journal->compact(nullptr, journalGeneration);
+    }
+}
+
+void BookmarkMgr::stopJournal() {
+
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    if (journal == nullptr) {
+        return;
+    }
+
+    journal->terminate();
+    journalThread->join();
+
+    delete journalThread;
+    delete journal;
+
+    journalThread = nullptr;
+    journal = nullptr;
+}
+
+void BookmarkMgr::compactJournal() {
+
+    //the tree is built here, the slow part of writing it out is left to the journal thread.
+    DataTreePtr tree = std::make_shared<DataTree>("cubicsdr_bookmarks");
+
+    journalGeneration++;
+    saveToTree(*tree);
+
+    journal->compact(tree, journalGeneration);
+    journalRecords = 0;
+}
+
+void BookmarkMgr::journalOperation(DataTree &operation) {
+
+    if (journal == nullptr || journalSuspended) {
+        return;
+    }
+
+    journal->append(operation);
+
+    if (++journalRecords >= BOOKMARK_JOURNAL_COMPACT_RECORDS) {
+        compactJournal();
+    }
+}
+
+int BookmarkMgr::replayJournal(const std::string& bookmarkPath, int generation) {
+
+    std::vector<DataTreePtr> operations;
+
+    if (!BookmarkJournal::readOperations(bookmarkPath, generation, operations)) {
+        return 0;
+    }
+
+    for (auto &operation : operations) {
+        replayOperation(*operation);
+    }
+
+    return (int)operations.size();
+}
+
+void BookmarkMgr::replayOperation(DataTree &operation) {
+
+    DataNode *op = operation.rootNode();
+    std::string opName = op->getName();
+    std::string group, newGroup;
+
+    if (op->hasAnother("group")) op->getNext("group")->element()->get(group);
+    if (op->hasAnother("new_group")) op->getNext("new_group")->element()->get(newGroup);
+
+    if (opName == "add_bookmark" && op->hasAnother("modem")) {
+        BookmarkEntryPtr be = nodeToBookmark(op->getNext("modem"));
+        if (be) {
+            addBookmark(group, be);
+        }
+    } else if (opName == "remove_bookmark" && op->hasAnother("key")) {
+        BookmarkEntryPtr be = findBookmark(op->getNext("key"), group);
+        if (be && group.empty()) {
+            removeBookmark(be);
+        } else if (be) {
+            removeBookmark(group, be);
+        }
+    } else if (opName == "move_bookmark" && op->hasAnother("key")) {
+        BookmarkEntryPtr be = findBookmark(op->getNext("key"), "");
+        if (be) {
+            moveBookmark(be, group);
+        }
+    } else if (opName == "relabel_bookmark" && op->hasAnother("key") && op->hasAnother("user_label")) {
+        BookmarkEntryPtr be = findBookmark(op->getNext("key"), "");
+        if (be) {
+            setBookmarkLabel(be, getSafeWstringValue(op, "user_label"));
+        }
+    } else if (opName == "add_group") {
+        addGroup(group);
+    } else if (opName == "remove_group") {
+        removeGroup(group);
+    } else if (opName == "rename_group") {
+        renameGroup(group, newGroup);
+    } else if (opName == "add_range" && op->hasAnother("range")) {
+        addRange(nodeToRange(op->getNext("range")));
+    } else if (opName == "remove_range" && op->hasAnother("range")) {
+        BookmarkRangeEntryPtr re = findRange(op->getNext("range"));
+        if (re) {
+            removeRange(re);
+        }
+    } else if (opName == "relabel_range" && op->hasAnother("range") && op->hasAnother("new_label")) {
+        BookmarkRangeEntryPtr re = findRange(op->getNext("range"));
+        if (re) {
+            setRangeLabel(re, getSafeWstringValue(op, "new_label"));
+        }
+    } else if (opName == "update_range" && op->hasAnother("range") && op->hasAnother("new_range")) {
+        BookmarkRangeEntryPtr re = findRange(op->getNext("range"));
+        if (re) {
+            BookmarkRangeEntryPtr newRange = nodeToRange(op->getNext("new_range"));
+            updateRange(re, newRange->freq, newRange->startFreq, newRange->endFreq);
+        }
+    } else {
+        std::cout << "Unknown bookmark journal operation: " << opName << std::endl;
+    }
+}
+
+void BookmarkMgr::indexBookmark(const std::string& group, BookmarkEntryPtr be) {
+
+    unindexBookmark(be);
+
+    BookmarkIndexEntry &entry = bmIndexEntries[be.get()];
+
+    entry.group = group;
+    entry.frequency = be->frequency;
+
+    //the same text BookmarkView used to search through.
+    std::wstring searchText = getBookmarkEntryDisplayName(be) +
+        L" " + be->label +
+        L" " + std::to_wstring(be->frequency) +
+        L" " + wxString(frequencyToStr(be->frequency)).ToStdWstring() +
+        L" " + wxString(frequencyToStr(be->bandwidth)).ToStdWstring() +
+        L" " + wxString(be->type).ToStdWstring() +
+        L" " + wxString(group).ToStdWstring();
+
+    getSearchTokens(searchText, entry.tokens);
+
+    for (auto &token : entry.tokens) {
+        bmTokenIndex[token].insert(be.get());
+    }
+
+    bmFrequencyIndex.insert(std::make_pair(entry.frequency, be));
+    bmIndexVersion++;
+}
+
+void BookmarkMgr::unindexBookmark(BookmarkEntryPtr be) {
+
+    BookmarkIndexEntries::iterator ie = bmIndexEntries.find(be.get());
+
+    if (ie == bmIndexEntries.end()) {
+        return;
+    }
+
+    for (auto &token : ie->second.tokens) {
+        BookmarkTokenIndex::iterator t_i = bmTokenIndex.find(token);
+
+        if (t_i != bmTokenIndex.end()) {
+            t_i->second.erase(be.get());
+            if (t_i->second.empty()) {
+                bmTokenIndex.erase(t_i);
+            }
+        }
+    }
+
+    auto range = bmFrequencyIndex.equal_range(ie->second.frequency);
+
+    for (auto f_i = range.first; f_i != range.second; ++f_i) {
+        if (f_i->second == be) {
+            bmFrequencyIndex.erase(f_i);
+            break;
+        }
+    }
+
+    bmIndexEntries.erase(ie);
+    bmIndexVersion++;
+}
+
+void BookmarkMgr::clearIndex() {
+    bmFrequencyIndex.clear();
+    bmTokenIndex.clear();
+    bmIndexEntries.clear();
+    bmIndexVersion++;
+}
+
+BookmarkList BookmarkMgr::getBookmarksInRange(long long startFreq, long long endFreq) {
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    BookmarkList found;
+
+    for (auto f_i = bmFrequencyIndex.lower_bound(startFreq); f_i != bmFrequencyIndex.end() && f_i->first <= endFreq; ++f_i) {
+        found.push_back(f_i->second);
+    }
+
+    return found;
+}
+
+BookmarkSearchResult BookmarkMgr::searchBookmarks(const std::vector<std::wstring>& keywords, const BookmarkSearchResult *within) {
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    BookmarkSearchResult found;
+    std::vector<BookmarkSearchPhrase> phrases;
+
+    getSearchPhrases(keywords, phrases);
+
+    if (phrases.empty()) {
+        return found;
+    }
+
+    if (within != nullptr) {
+        for (BookmarkEntry *be : *within) {
+            BookmarkIndexEntries::iterator ie = bmIndexEntries.find(be);
+
+            if (ie != bmIndexEntries.end() && isSearchMatch(ie->second.tokens, phrases)) {
+                found.insert(be);
+            }
+        }
+        return found;
+    }
+
+    //candidates from the tokens starting with the longest word, likely the fewest; then check the whole phrases.
+    const std::wstring *longest = &phrases[0][0];
+
+    for (auto &phrase : phrases) {
+        for (auto &word : phrase) {
+            if (word.length() > longest->length()) {
+                longest = &word;
+            }
+        }
+    }
+
+    for (auto t_i = bmTokenIndex.lower_bound(*longest); t_i != bmTokenIndex.end() && t_i->first.compare(0, longest->length(), *longest) == 0; ++t_i) {
+        for (BookmarkEntry *be : t_i->second) {
+            if (found.find(be) == found.end() && isSearchMatch(bmIndexEntries[be].tokens, phrases)) {
+                found.insert(be);
+            }
+        }
+    }
+
+    return found;
+}
+
+unsigned long long BookmarkMgr::getSearchIndexVersion() {
+    std::lock_guard < std::recursive_mutex > lock(busy_lock);
+
+    return bmIndexVersion;
+}
+
+void BookmarkMgr::getSearchTokens(const std::wstring& str, std::vector<std::wstring>& tokens_out) {
+
+    std::wstring token;
+
+    tokens_out.clear();
+
+    for (size_t i = 0; i <= str.length(); i++) {
+        wchar_t c = (i < str.length()) ? (wchar_t)towlower(str[i]) : L' ';
+        bool isWordChar = iswalnum(c) != 0;
+
+        //"100.500MHz" is found by "100", "500" and "mhz"
+        bool boundary = !isWordChar || (!token.empty() && (iswdigit(token.back()) != 0) != (iswdigit(c) != 0));
+
+        //kept in order, repeats included, for the phrases to be matched.
+        if (boundary && !token.empty()) {
+            tokens_out.push_back(token);
+            token.clear();
+        }
+
+        if (isWordChar) {
+            token.push_back(c);
+        }
+    }
+}
+
+void BookmarkMgr::getSearchPhrases(const std::vector<std::wstring>& keywords, std::vector<BookmarkSearchPhrase>& phrases_out) {
+
+    BookmarkSearchPhrase phrase;
+
+    phrases_out.clear();
+
+    for (auto &keyword : keywords) {
+        getSearchTokens(keyword, phrase);
+
+        if (!phrase.empty()) {
+            phrases_out.push_back(phrase);
+        }
+    }
+}
+
+bool BookmarkMgr::isSearchMatch(const std::vector<std::wstring>& tokens, const std::vector<BookmarkSearchPhrase>& phrases) {
+
+    for (auto &phrase : phrases) {
+        bool matched = false;
+        size_t last = phrase.size() - 1;
+
+        //"100.5" matches "100.500MHz" but not "5.000kHz" nor "100 kHz, 5 dB".
+        for (size_t i = 0; !matched && i + last < tokens.size(); i++) {
+            matched = true;
+
+            for (size_t j = 0; matched && j < last; j++) {
+                matched = (tokens[i + j] == phrase[j]);
+            }
+
+            if (matched) {
+                matched = (tokens[i + last].compare(0, phrase[last].length(), phrase[last]) == 0);
+            }
+        }
+
+        if (!matched) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 std::wstring BookmarkMgr::getBookmarkEntryDisplayName(BookmarkEntryPtr bmEnt) {
     std::wstring dispName = bmEnt->label;
     
@@ -7,9 +7,13 @@
 
 #include <vector>
 #include <set>
+#include <map>
+#include <unordered_set>
 #include <memory>
+#include <thread>
 
 #include "DemodulatorInstance.h"
+#include "BookmarkJournal.h"
 
 
 class DataNode;
@@ -55,9 +59,29 @@ typedef std::map<std::string, bool > BookmarkMapSorted;
 typedef std::vector<std::string> BookmarkNames;
 typedef std::map<std::string, bool> BookmarkExpandState;
 
+//Secondary index entry of a bookmark: its group, and what it is found by.
+class BookmarkIndexEntry {
+public:
+    BookmarkIndexEntry() : frequency(0) {
+    }
+
+    std::string group;
+    long long frequency;
+    //words of the name, label, frequency, bandwidth, type and group in order, see getSearchTokens().
+    std::vector<std::wstring> tokens;
+};
+
+typedef std::unordered_set<BookmarkEntry *> BookmarkSearchResult;
+//the words of one keyword, to be found next to each other: "100.5" is "100" then "5".
+typedef std::vector<std::wstring> BookmarkSearchPhrase;
+typedef std::multimap<long long, BookmarkEntryPtr> BookmarkFrequencyIndex;
+typedef std::map<std::wstring, std::unordered_set<BookmarkEntry *> > BookmarkTokenIndex;
+typedef std::map<BookmarkEntry *, BookmarkIndexEntry> BookmarkIndexEntries;
+
 class BookmarkMgr {
 public:
     BookmarkMgr();
+    ~BookmarkMgr();
     //if useFullpath = false, use the application config dir.
 	//else assume bookmarkFn is a full path and use it for location.
     void saveToFile(std::string bookmarkFn, bool backup = true, bool useFullpath = false);
@@ -73,6 +97,7 @@ public:
     void removeBookmark(std::string group, BookmarkEntryPtr be);
     void removeBookmark(BookmarkEntryPtr be);
     void moveBookmark(BookmarkEntryPtr be, std::string group);
+    void setBookmarkLabel(BookmarkEntryPtr be, const std::wstring& label);
     
     void addGroup(std::string group);
     void removeGroup(std::string group);
@@ -80,6 +105,23 @@ public:
 	//return an independent copy on purpose 
     BookmarkList getBookmarks(std::string group);
 
+    //bookmarks of all groups with startFreq <= frequency <= endFreq, by frequency.
+    BookmarkList getBookmarksInRange(long long startFreq, long long endFreq);
+
+    //bookmarks matching all the keywords (see isSearchMatch()), only among 'within' if given,
+    //to refine the result of a previous search as more is typed.
+    BookmarkSearchResult searchBookmarks(const std::vector<std::wstring>& keywords, const BookmarkSearchResult *within = nullptr);
+
+    //changes each time the bookmarks or their labels change, invalidating previous search results.
+    unsigned long long getSearchIndexVersion();
+
+    //lower case words of str in order, split at anything not alphanumeric and between digits and letters.
+    static void getSearchTokens(const std::wstring& str, std::vector<std::wstring>& tokens_out);
+    //the words of each keyword, keywords without any are left out.
+    static void getSearchPhrases(const std::vector<std::wstring>& keywords, std::vector<BookmarkSearchPhrase>& phrases_out);
+    //each phrase is found in the tokens: its words in a row, the last one starting a token, the others whole.
+    static bool isSearchMatch(const std::vector<std::wstring>& tokens, const std::vector<BookmarkSearchPhrase>& phrases);
+
     void getGroups(BookmarkNames &arr);
     void getGroups(wxArrayString &arr);
 
@@ -103,12 +145,18 @@ public:
 
     void addRange(BookmarkRangeEntryPtr re);
     void removeRange(BookmarkRangeEntryPtr re);
+    void setRangeLabel(BookmarkRangeEntryPtr re, const std::wstring& label);
+    //move 're' to the given frequencies, journaled so that later edits of it still find it.
+    void updateRange(BookmarkRangeEntryPtr re, long long freq, long long startFreq, long long endFreq);
 
 	//return an independent copy on purpose 
 	BookmarkRangeList getRanges();
     
 	void clearRanges();
 
+    //stop recording edits to the journal, once the pending ones are written.
+    void stopJournal();
+
     static std::wstring getBookmarkEntryDisplayName(BookmarkEntryPtr bmEnt);
     static std::wstring getActiveDisplayName(DemodulatorInstancePtr demod);
 
@@ -124,6 +172,28 @@ protected:
     
     BookmarkEntryPtr demodToBookmarkEntry(DemodulatorInstancePtr demod);
     BookmarkEntryPtr nodeToBookmark(DataNode *node);
+    BookmarkRangeEntryPtr nodeToRange(DataNode *node);
+
+    void saveToTree(DataTree &s);
+
+    //the journal of the config dir bookmark file at bookmarkPath, compacted at once if compactNow.
+    void startJournal(const std::string& bookmarkPath, bool compactNow);
+    void compactJournal();
+    void journalOperation(DataTree &operation);
+
+    //apply the journal of the bookmark file of 'generation', return the number of operations applied.
+    int replayJournal(const std::string& bookmarkPath, int generation);
+    void replayOperation(DataTree &operation);
+
+    //bookmarks have no identity on disk: a journaled bookmark is found again by type, frequency, bandwidth and label.
+    static void bookmarkKeyToNode(DataNode *node, BookmarkEntryPtr be);
+    static void rangeToNode(DataNode *node, BookmarkRangeEntryPtr re);
+    BookmarkRangeEntryPtr findRange(DataNode *key);
+    BookmarkEntryPtr findBookmark(DataNode *key, const std::string& group);
+
+    void indexBookmark(const std::string& group, BookmarkEntryPtr be);
+    void unindexBookmark(BookmarkEntryPtr be);
+    void clearIndex();
     
     BookmarkMap bmData;
     BookmarkMapSorted bmDataSorted;
@@ -131,7 +201,21 @@ protected:
     BookmarkRangeList ranges;
     bool rangesSorted;
 
+    //secondary indices, kept up to date by every change
+    BookmarkFrequencyIndex bmFrequencyIndex;
+    BookmarkTokenIndex bmTokenIndex;
+    BookmarkIndexEntries bmIndexEntries;
+    unsigned long long bmIndexVersion;
+
     std::recursive_mutex busy_lock;
+
+    BookmarkJournal *journal;
+    std::thread *journalThread;
+    //of the bookmark file of the config dir, incremented each time it is written as a whole.
+    int journalGeneration;
+    int journalRecords;
+    //while loading or replaying, changes are not journaled.
+    bool journalSuspended;
     
     BookmarkExpandState expandState;
 };
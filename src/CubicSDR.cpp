@@ -31,6 +31,7 @@ IMPLEMENT_APP(CubicSDR)
 #include <clocale>
 
 #include "ActionDialog.h"
+#include "AudioFileWriter.h"
 
 #include <memory>
 
@@ -214,6 +215,8 @@ CubicSDR::CubicSDR() : frequency(0), offset(0), ppm(0), snap(1), sampleRate(DEFA
 {
         config.load();
 
+        SDREngine::set(this);
+
         sampleRateInitialized.store(false);
         agcMode.store(true);
         soloMode.store(false);
@@ -302,30 +305,7 @@ bool CubicSDR::OnInit() {
     RigThread::enumerate();
 #endif
 
-    Modem::addModemFactory(ModemFM::factory, "FM", 200000);
-    Modem::addModemFactory(ModemNBFM::factory, "NBFM", 12500);
-    Modem::addModemFactory(ModemFMStereo::factory, "FMS", 200000);
-    Modem::addModemFactory(ModemAM::factory, "AM", 6000);
-    Modem::addModemFactory(ModemLSB::factory, "LSB", 5400);
-    Modem::addModemFactory(ModemUSB::factory, "USB", 5400);
-    Modem::addModemFactory(ModemDSB::factory, "DSB", 5400);
-    Modem::addModemFactory(ModemIQ::factory, "I/Q", 48000);
-
-#ifdef ENABLE_DIGITAL_LAB
-    Modem::addModemFactory(ModemAPSK::factory, "APSK", 200000);
-    Modem::addModemFactory(ModemASK::factory, "ASK", 200000);
-    Modem::addModemFactory(ModemBPSK::factory, "BPSK", 200000);
-    Modem::addModemFactory(ModemDPSK::factory, "DPSK", 200000);
-    Modem::addModemFactory(ModemFSK::factory, "FSK", 19200);
-    Modem::addModemFactory(ModemGMSK::factory, "GMSK", 19200);
-    Modem::addModemFactory(ModemOOK::factory, "OOK", 200000);
-    Modem::addModemFactory(ModemPSK::factory, "PSK", 200000);
-    Modem::addModemFactory(ModemQAM::factory, "QAM", 200000);
-    Modem::addModemFactory(ModemQPSK::factory, "QPSK", 200000);
-    Modem::addModemFactory(ModemSQAM::factory, "SQAM", 200000);
-    Modem::addModemFactory(ModemST::factory, "ST", 200000);
-    Modem::addModemFactory(ModemSAMMY::factory, "SAMMY", 200000);
-#endif
+    SDREngine::registerModems();
     
     frequency = wxGetApp().getConfig()->getCenterFreq();
     offset = 0;
@@ -338,12 +318,16 @@ bool CubicSDR::OnInit() {
 
     // Visual Data
     spectrumVisualThread = new SpectrumVisualDataThread();
+    //the additional receivers, if any, are stitched to the main spectrum.
+    spectrumVisualThread->enableStitching();
     
     pipeIQVisualData = std::make_shared<DemodulatorThreadInputQueue>();
     pipeIQVisualData->set_max_num_items(1);
+    pipeIQVisualData->set_stats_name("SpectrumIQVisualData");
     
     pipeWaterfallIQVisualData = std::make_shared<DemodulatorThreadInputQueue>();
     pipeWaterfallIQVisualData->set_max_num_items(128);
+    pipeWaterfallIQVisualData->set_stats_name("WaterfallIQVisualData");
     
     getSpectrumProcessor()->setInput(pipeIQVisualData);
     getSpectrumProcessor()->setHideDC(true);
@@ -351,6 +335,7 @@ bool CubicSDR::OnInit() {
     // I/Q Data
     pipeSDRIQData = std::make_shared<SDRThreadIQDataQueue>();
     pipeSDRIQData->set_max_num_items(100);
+    pipeSDRIQData->set_stats_name("SDRIQData");
     
     sdrThread = new SDRThread();
     sdrThread->setOutputQueue("IQDataOutput",pipeSDRIQData);
@@ -364,6 +349,7 @@ bool CubicSDR::OnInit() {
 #if CUBICSDR_ENABLE_VIEW_SCOPE
     pipeAudioVisualData = std::make_shared<DemodulatorThreadOutputQueue>();
     pipeAudioVisualData->set_max_num_items(1);
+    pipeAudioVisualData->set_stats_name("ScopeAudioVisualData");
     
     scopeProcessor.setInput(pipeAudioVisualData);
 #else
@@ -374,6 +360,7 @@ bool CubicSDR::OnInit() {
     demodVisualThread = new SpectrumVisualDataThread();
     pipeDemodIQVisualData = std::make_shared<DemodulatorThreadInputQueue>();
     pipeDemodIQVisualData->set_max_num_items(1);
+    pipeDemodIQVisualData->set_stats_name("DemodIQVisualData");
     
     if (getDemodSpectrumProcessor()) {
         getDemodSpectrumProcessor()->setInput(pipeDemodIQVisualData);
@@ -385,6 +372,31 @@ bool CubicSDR::OnInit() {
     t_DemodVisual = nullptr;
 #endif
 
+    //re-serve the device IQ to other tools, if asked.
+    int streamPort = iqServerPort ? iqServerPort : config.getIQServerPort();
+
+    if (streamPort > 0) {
+        iqStreamServer = new IQStreamServer();
+
+        if (iqStreamServer->listen(config.getIQServerAddress(), streamPort)) {
+            sdrPostThread->setOutputQueue("IQStreamOutput", iqStreamServer->getInputQueue("IQDataInput"));
+            t_IQStreamServer = new std::thread(&IQStreamServer::threadMain, iqStreamServer);
+        } else {
+            delete iqStreamServer;
+            iqStreamServer = nullptr;
+        }
+    }
+
+    //signal detection, in its own thread: idle until enabled.
+    signalDetectorThread = new SignalDetectorThread();
+    signalDetectorThread->setFFTSize(config.getSignalDetectorFFTSize());
+    signalDetectorThread->getDetector()->setThreshold(config.getSignalDetectorThreshold());
+    signalDetectorThread->getDetector()->setOccupancyBucketWidth(config.getOccupancyBucketWidth());
+    signalDetectorThread->getDetector()->setOccupancyWindow(config.getOccupancyWindow());
+    signalDetectorThread->setEnabled(config.getSignalDetectorEnabled());
+    sdrPostThread->setOutputQueue("IQDetectorOutput", signalDetectorThread->getInputQueue("IQDataInput"));
+    t_SignalDetector = new std::thread(&SignalDetectorThread::threadMain, signalDetectorThread);
+
     // Now that input/output queue plumbing is completely done, we can
     //safely starts all the threads:
     t_SpectrumVisual = new std::thread(&SpectrumVisualDataThread::threadMain, spectrumVisualThread);
@@ -467,6 +479,27 @@ int CubicSDR::OnExit() {
         ::exit(12);
     }
 
+    if (!receivers.empty()) {
+        std::cout << "Terminating receivers.." << std::endl << std::flush;
+        for (SDRReceiver *receiver : receivers) {
+            receiver->terminate();
+            delete receiver;
+        }
+        receivers.clear();
+    }
+
+    if (iqStreamServer) {
+        std::cout << "Terminating IQ stream server.." << std::endl << std::flush;
+        iqStreamServer->terminate();
+        iqStreamServer->isTerminated(1000);
+    }
+
+    if (signalDetectorThread) {
+        std::cout << "Terminating signal detector.." << std::endl << std::flush;
+        signalDetectorThread->terminate();
+        signalDetectorThread->isTerminated(1000);
+    }
+
     std::cout << "Terminating All Demodulators.." << std::endl << std::flush;
     demodMgr.terminateAll();
 
@@ -495,6 +528,14 @@ int CubicSDR::OnExit() {
     }
 
     t_PostSDR->join();
+
+    if (t_IQStreamServer) {
+        t_IQStreamServer->join();
+    }
+
+    if (t_SignalDetector) {
+        t_SignalDetector->join();
+    }
     
     if (t_DemodVisual) {
         t_DemodVisual->join();
@@ -515,6 +556,18 @@ int CubicSDR::OnExit() {
     delete t_PostSDR;
     t_PostSDR = nullptr;
 
+    delete t_IQStreamServer;
+    t_IQStreamServer = nullptr;
+
+    delete iqStreamServer;
+    iqStreamServer = nullptr;
+
+    delete t_SignalDetector;
+    t_SignalDetector = nullptr;
+
+    delete signalDetectorThread;
+    signalDetectorThread = nullptr;
+
     delete t_SpectrumVisual;
     t_SpectrumVisual = nullptr;
 
@@ -533,6 +586,11 @@ int CubicSDR::OnExit() {
     //
     AudioThread::deviceCleanup();
 
+    //recordings are closed by now, complete their pending writes.
+    AudioFileWriter::cleanup();
+
+    SDREnumerator::cleanup();
+
     std::cout << "Application termination complete." << std::endl << std::flush;
 
     return wxApp::OnExit();
@@ -559,6 +617,21 @@ void CubicSDR::OnInitCmdLine(wxCmdLineParser& parser) {
 }
 
 bool CubicSDR::OnCmdLineParsed(wxCmdLineParser& parser) {
+    wxString convertFrom;
+    if (parser.Found("x", &convertFrom)) {
+        std::string from = convertFrom.ToStdString();
+        std::string to = from + (DataTree::isBinaryFile(from) ? ".xml" : ".bin");
+
+        if (DataTree::convertFile(from, to)) {
+            std::cout << "Converted " << from << " to " << to << std::endl;
+        } else {
+            std::cout << "Conversion of " << from << " failed." << std::endl;
+        }
+
+        //nothing else to do.
+        return false;
+    }
+
     wxString *confName = new wxString;
     if (parser.Found("c",confName)) {
         if (confName) {
@@ -576,6 +649,11 @@ bool CubicSDR::OnCmdLineParsed(wxCmdLineParser& parser) {
     useLocalMod.store(true);
 #endif
 
+    long streamPort;
+    if (parser.Found("i", &streamPort)) {
+        iqServerPort = (int)streamPort;
+    }
+
     wxString *modPath = new wxString;
 
     if (parser.Found("m",modPath)) {
@@ -704,6 +782,9 @@ void CubicSDR::setChannelizerType(SDRPostThreadChannelizerType chType) {
     if (sdrPostThread && !sdrPostThread->isTerminated()) {
         sdrPostThread->setChannelizerType(chType);
     }
+    for (SDRReceiver *receiver : receivers) {
+        receiver->getSDRPostThread()->setChannelizerType(chType);
+    }
 }
 
 SDRPostThreadChannelizerType CubicSDR::getChannelizerType() {
@@ -805,6 +886,13 @@ void CubicSDR::setDevice(SDRDeviceInfo *dev, int waitMsForTermination) {
        t_SDR = nullptr;
     }
     
+    //the main device now, not a receiver anymore.
+    for (SDRReceiver *receiver : getReceivers()) {
+        if (receiver->getDevice()->getDeviceId() == dev->getDeviceId()) {
+            stopReceiver(receiver);
+        }
+    }
+
     for (SoapySDR::Kwargs::const_iterator i = settingArgs.begin(); i != settingArgs.end(); i++) {
         sdrThread->writeSetting(i->first, i->second);
     }
@@ -841,11 +929,125 @@ void CubicSDR::setDevice(SDRDeviceInfo *dev, int waitMsForTermination) {
         setAntennaName(devConfig->getAntennaName());
 
         t_SDR = new std::thread(&SDRThread::threadMain, sdrThread);
+
+        startReceivers();
 }
     
     stoppedDev = nullptr;
 }
 
+bool CubicSDR::addReceiver(SDRDeviceInfo *dev, long long freq) {
+    if (!startReceiver(dev, freq)) {
+        return false;
+    }
+
+    std::vector<SDRReceiverDef> receiverDefs = config.getReceivers();
+
+    SDRReceiverDef rdef;
+    rdef.deviceId = dev->getDeviceId();
+    rdef.frequency = freq;
+    receiverDefs.push_back(rdef);
+
+    config.setReceivers(receiverDefs);
+
+    return true;
+}
+
+void CubicSDR::removeReceivers() {
+    for (SDRReceiver *receiver : getReceivers()) {
+        stopReceiver(receiver);
+    }
+
+    config.setReceivers(std::vector<SDRReceiverDef>());
+}
+
+std::vector<SDRReceiver *> CubicSDR::getReceivers() {
+    return receivers;
+}
+
+std::vector<std::string> CubicSDR::removeFailedReceivers() {
+    std::vector<std::string> failedNames;
+
+    for (SDRReceiver *receiver : getReceivers()) {
+        if (receiver->hasFailed()) {
+            failedNames.push_back(receiver->getDevice()->getName());
+            stopReceiver(receiver);
+        }
+    }
+
+    return failedNames;
+}
+
+void CubicSDR::startReceivers() {
+    if (!devs) {
+        return;
+    }
+
+    std::vector<SDRReceiverDef> receiverDefs = config.getReceivers();
+
+    for (const SDRReceiverDef& rdef : receiverDefs) {
+        for (SDRDeviceInfo *dev : *devs) {
+            if (dev->getDeviceId() != rdef.deviceId || dev == sdrThread->getDevice() || !dev->isAvailable()) {
+                continue;
+            }
+
+            bool running = false;
+            for (SDRReceiver *receiver : receivers) {
+                running = running || (receiver->getDevice()->getDeviceId() == rdef.deviceId);
+            }
+
+            if (!running) {
+                startReceiver(dev, rdef.frequency);
+            }
+        }
+    }
+}
+
+SDRReceiver *CubicSDR::startReceiver(SDRDeviceInfo *dev, long long freq) {
+    //lowest free index, 0 is the main device.
+    int index = 0;
+
+    for (int i = SDR_MAX_RECEIVERS - 1; i > 0; i--) {
+        bool used = false;
+        for (SDRReceiver *receiver : receivers) {
+            used = used || (receiver->getIndex() == i);
+        }
+        if (!used) {
+            index = i;
+        }
+    }
+
+    if (!index || dev == sdrThread->getDevice() || dev->isActive()) {
+        std::cout << "Unable to start " << dev->getName() << " as a receiver." << std::endl;
+        return nullptr;
+    }
+
+    SDRReceiver *receiver = new SDRReceiver(index);
+    SDRPostThread *receiverPostThread = receiver->getSDRPostThread();
+
+    receiverPostThread->setOutputQueue("IQVisualDataOutput", getSpectrumStitcher()->addReceiver(index));
+    if (pipeDemodIQVisualData) {
+        receiverPostThread->setOutputQueue("IQActiveDemodVisualDataOutput", pipeDemodIQVisualData);
+    }
+    receiverPostThread->setChannelizerType(getChannelizerType());
+
+    receiver->start(dev, freq);
+    receivers.push_back(receiver);
+
+    return receiver;
+}
+
+void CubicSDR::stopReceiver(SDRReceiver *receiver) {
+    receiver->terminate();
+    getSpectrumStitcher()->removeReceiver(receiver->getIndex());
+
+    receivers.erase(std::find(receivers.begin(), receivers.end(), receiver));
+    delete receiver;
+
+    //re-route the demodulators of its band.
+    notifyDemodulatorsChanged();
+}
+
 SDRDeviceInfo *CubicSDR::getDevice() {
     if (!sdrThread->getDevice() && stoppedDev) {
         return stoppedDev;
@@ -862,6 +1064,22 @@ SpectrumVisualProcessor *CubicSDR::getSpectrumProcessor() {
     return spectrumVisualThread->getProcessor();
 }
 
+SpectrumStitchProcessor *CubicSDR::getSpectrumStitcher() {
+    return spectrumVisualThread->getStitcher();
+}
+
+SignalDetectorThread *CubicSDR::getSignalDetectorThread() {
+    return signalDetectorThread;
+}
+
+void CubicSDR::setSignalDetectorEnabled(bool enabled) {
+    config.setSignalDetectorEnabled(enabled);
+
+    if (signalDetectorThread) {
+        signalDetectorThread->setEnabled(enabled);
+    }
+}
+
 SpectrumVisualProcessor *CubicSDR::getDemodSpectrumProcessor() {
     if (demodVisualThread) {
         return demodVisualThread->getProcessor();
@@ -1028,6 +1246,36 @@ void CubicSDR::notifyMainUIOfDeviceChange(bool forceRefreshOfGains) {
 	}
 }
 
+void CubicSDR::notifyModemPropertiesChanged() {
+    appframe->notifyUpdateModemProperties();
+}
+
+void CubicSDR::notifyDemodulatorsUpdated() {
+    bookmarkMgr.updateActiveList();
+}
+
+void CubicSDR::notifyDemodulatorDeleted(DemodulatorInstancePtr demod) {
+    bookmarkMgr.addRecent(demod);
+}
+
+void CubicSDR::notifyModemFrequency(long long freq) {
+#ifdef USE_HAMLIB
+    if (rigIsActive() && rigThread->getFollowModem()) {
+        rigThread->setFrequency(freq, true);
+    }
+#else
+    (void)freq;
+#endif
+}
+
+bool CubicSDR::isUserDemodBusy() {
+    return appframe && appframe->isUserDemodBusy();
+}
+
+bool CubicSDR::isAudioVisualConsuming() {
+    return scopeProcessor.isConsuming();
+}
+
 bool CubicSDR::areDevicesEnumerating() {
     return !sdrEnum->isTerminated();
 }
@@ -16,6 +16,9 @@
 #include "SoapySDRThread.h"
 #include "SDREnumerator.h"
 #include "SDRPostThread.h"
+#include "SDRReceiver.h"
+#include "IQStreamServer.h"
+#include "SignalDetectorThread.h"
 #include "AudioThread.h"
 #include "DemodulatorMgr.h"
 #include "AppConfig.h"
@@ -24,6 +27,7 @@
 #include "DemodLabelDialog.h"
 #include "BookmarkMgr.h"
 #include "SessionMgr.h"
+#include "SDREngine.h"
 
 #include "ScopeVisualProcessor.h"
 #include "SpectrumVisualProcessor.h"
@@ -68,7 +72,7 @@ std::string& filterChars(std::string& s, const std::string& allowed);
 std::string frequencyToStr(long long freq);
 long long strToFrequency(std::string freqStr);
 
-class CubicSDR: public wxApp {
+class CubicSDR: public wxApp, public SDREngine {
 public:
     CubicSDR();
 
@@ -111,9 +115,22 @@ public:
     void stopDevice(bool store, int waitMsForTermination);
     SDRDeviceInfo * getDevice();
 
+    //additional receivers, besides the main device: started, and kept in the configuration.
+    bool addReceiver(SDRDeviceInfo *dev, long long freq);
+    void removeReceivers();
+    std::vector<SDRReceiver *> getReceivers();
+    //stop the receivers whose device stream failed, and return their device names; they stay configured.
+    std::vector<std::string> removeFailedReceivers();
+
     ScopeVisualProcessor *getScopeProcessor();
     SpectrumVisualProcessor *getSpectrumProcessor();
+    //the main spectrum as shown, stitched with the receivers ones.
+    SpectrumStitchProcessor *getSpectrumStitcher();
     SpectrumVisualProcessor *getDemodSpectrumProcessor();
+
+    //signal detection and channel occupancy on the full band of the main device.
+    SignalDetectorThread *getSignalDetectorThread();
+    void setSignalDetectorEnabled(bool enabled);
     
     DemodulatorThreadOutputQueuePtr getAudioVisualQueue();
     DemodulatorThreadInputQueuePtr getIQVisualQueue();
@@ -149,6 +166,14 @@ public:
     std::string getNotification();
 
     void notifyMainUIOfDeviceChange(bool forceRefreshOfGains = false);
+
+    //SDREngine notifications, to the UI
+    void notifyModemPropertiesChanged();
+    void notifyDemodulatorsUpdated();
+    void notifyDemodulatorDeleted(DemodulatorInstancePtr demod);
+    void notifyModemFrequency(long long freq);
+    bool isUserDemodBusy();
+    bool isAudioVisualConsuming();
     
     void addRemote(std::string remoteAddr);
     void removeRemote(std::string remoteAddr);
@@ -210,6 +235,9 @@ private:
     SDRThread *sdrThread = nullptr;
     SDREnumerator *sdrEnum = nullptr;
     SDRPostThread *sdrPostThread = nullptr;
+    std::vector<SDRReceiver *> receivers;
+    IQStreamServer *iqStreamServer = nullptr;
+    SignalDetectorThread *signalDetectorThread = nullptr;
     SpectrumVisualDataThread *spectrumVisualThread = nullptr;
     SpectrumVisualDataThread *demodVisualThread = nullptr;
 
@@ -230,6 +258,8 @@ private:
     std::thread *t_SDR = nullptr;
     std::thread *t_SDREnum = nullptr;
     std::thread *t_PostSDR = nullptr;
+    std::thread *t_IQStreamServer = nullptr;
+    std::thread *t_SignalDetector = nullptr;
     std::thread *t_SpectrumVisual = nullptr;
     std::thread *t_DemodVisual = nullptr;
     std::atomic_bool devicesReady;
@@ -239,6 +269,8 @@ private:
     std::atomic_bool useLocalMod;
     std::string notifyMessage;
     std::string modulePath;
+    //from the command line, 0 for the configured one.
+    int iqServerPort = 0;
     
     std::mutex notify_busy;
     
@@ -254,12 +286,19 @@ private:
 #endif
 
     void initAudioDevices() const;
+
+    //the configured receivers not running yet, but the main device.
+    void startReceivers();
+    SDRReceiver *startReceiver(SDRDeviceInfo *dev, long long freq);
+    void stopReceiver(SDRReceiver *receiver);
 };
 
 static const wxCmdLineEntryDesc commandLineInfo [] =
 {
     { wxCMD_LINE_SWITCH, "h", "help", "Command line parameter help", wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
     { wxCMD_LINE_OPTION, "c", "config", "Specify a named configuration to use, i.e. '-c ham'", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "x", "convert", "Convert a session or bookmark file between XML and binary and exit, i.e. '-x bookmarks.xml' writes bookmarks.xml.bin", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "i", "iq-server", "Re-serve the device IQ over TCP in the rtl_tcp protocol on this port, i.e. '-i 1234'", wxCMD_LINE_VAL_NUMBER, 0 },
     { wxCMD_LINE_OPTION, "m", "modpath", "Load modules from suppplied path, i.e. '-m ~/SoapyMods/'", wxCMD_LINE_VAL_STRING, 0 },
 #ifdef BUNDLE_SOAPY_MODS
     { wxCMD_LINE_SWITCH, "b", "bundled", "Use bundled SoapySDR modules first instead of local.", wxCMD_LINE_VAL_NONE, 0 },
@@ -120,7 +120,8 @@ void FrequencyDialog::OnChar(wxKeyEvent& event) {
                 freq_ctr = wxGetApp().getFrequency();
                 range_bw = wxGetApp().getSampleRate();
 
-                if (freq_ctr - (range_bw / 2) > freq || freq_ctr + (range_bw / 2) < freq) {
+                //out of the main band but in a receiver one, it is demodulated there.
+                if ((freq_ctr - (range_bw / 2) > freq || freq_ctr + (range_bw / 2) < freq) && SDRCoverage::getReceiverAt(freq) < 0) {
                     wxGetApp().setFrequency(freq);
                 }
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "IOThread.h"
+#include "PipelineStats.h"
 #include <typeinfo>
 #include <memory>
 
@@ -10,6 +11,7 @@
 IOThread::IOThread() {
     terminated.store(false);
     stopping.store(false);
+    cpuTime.store(0);
 }
 
 IOThread::~IOThread() {
@@ -25,11 +27,14 @@ void *IOThread::threadMain() {
         run();
     }
     catch (...) {
+        cpuTime.store(PipelineStats::threadCPUTime());
         terminated.store(true);
         stopping.store(true);
         throw;
     }
 
+    cpuTime.store(PipelineStats::threadCPUTime());
+
     terminated.store(true);
     stopping.store(true);
     return this;
@@ -46,16 +51,23 @@ void IOThread::threadMain() {
         run();
     }
     catch (...) {
+        cpuTime.store(PipelineStats::threadCPUTime());
         terminated.store(true);
         stopping.store(true);
         throw;
     }
+
+    cpuTime.store(PipelineStats::threadCPUTime());
   
     terminated.store(true);
     stopping.store(true);
 };
 #endif
 
+long long IOThread::getCPUTime() {
+    return cpuTime.load();
+}
+
 void IOThread::setup() {
     //redefined in subclasses
 };
@@ -80,6 +92,10 @@ void IOThread::onBindInput(std::string /* name */, ThreadQueueBasePtr /* threadQ
 void IOThread::setInputQueue(std::string qname, ThreadQueueBasePtr threadQueue) {
     std::lock_guard < std::mutex > lock(m_queue_bindings_mutex);
     input_queues[qname] = threadQueue;
+    //unless named at creation, a queue is known in the telemetry by its first binding.
+    if (threadQueue) {
+        threadQueue->set_stats_name(qname);
+    }
     this->onBindInput(qname, threadQueue);
 };
 
@@ -91,6 +107,9 @@ ThreadQueueBasePtr IOThread::getInputQueue(std::string qname) {
 void IOThread::setOutputQueue(std::string qname, ThreadQueueBasePtr threadQueue) {
     std::lock_guard < std::mutex > lock(m_queue_bindings_mutex);
     output_queues[qname] = threadQueue;
+    if (threadQueue) {
+        threadQueue->set_stats_name(qname);
+    }
     this->onBindOutput(qname, threadQueue);
 };
 
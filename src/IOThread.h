@@ -9,6 +9,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <thread>
 #include <memory>
@@ -56,9 +57,58 @@ public:
 	}
 
 	//constructor
-    ReBuffer(std::string bufferId) : bufferId(bufferId) {
+    ReBuffer(std::string bufferId) : bufferId(bufferId), reservedCount(0) {
 		//nothing
     }
+
+    /// Allocate at least 'count' buffers now, and never garbage collect below 'count':
+    /// as long as at most 'count' buffers are in use at once, getBuffer() does not allocate.
+    void reserve(size_t count) {
+        reserve(count, [](BufferType&) {});
+    }
+
+    /// Same, then 'prepare' the buffers not in use, i.e. to reserve the capacity of their data
+    /// once for all, from the sizes known when a kit is built.
+    template <typename PrepareFn>
+    void reserve(size_t count, PrepareFn prepare) {
+
+        //the buffers not in use, held here so that getBuffer() leaves them alone meanwhile,
+        //then the new ones: all allocated and prepared without holding the lock.
+        std::vector<ReBufferPtr> idleBuffers;
+        std::vector<ReBufferPtr> newBuffers;
+
+        {
+            std::lock_guard < SpinMutex > lock(m_mutex);
+
+            reservedCount = count;
+
+            for (outputBuffersI it = outputBuffers.begin(); it != outputBuffers.end(); it++) {
+                //the ones in use belong to their users for now.
+                if (it->ptr.use_count() == 1) {
+                    idleBuffers.push_back(it->ptr);
+                }
+            }
+
+            if (outputBuffers.size() < count) {
+                newBuffers.resize(count - outputBuffers.size());
+            }
+        }
+
+        for (ReBufferPtr &buf : newBuffers) {
+            buf = std::make_shared<BufferType>();
+            prepare(*buf);
+        }
+
+        for (ReBufferPtr &buf : idleBuffers) {
+            prepare(*buf);
+        }
+
+        std::lock_guard < SpinMutex > lock(m_mutex);
+
+        for (ReBufferPtr &buf : newBuffers) {
+            outputBuffers.push_back(ReBufferAge < ReBufferPtr >(buf, 1));
+        }
+    }
     
     /// Return a new ReBuffer_ptr usable by the application.
     ReBufferPtr getBuffer() {
@@ -109,7 +159,7 @@ public:
        //2.1 Garbage collect the oldest (last element) if it aged too much, and return the buffer
        if (buf != nullptr) {
             
-           if (outputBuffers.back().age < -REBUFFER_GC_LIMIT) {
+           if (outputBuffers.size() > reservedCount && outputBuffers.back().age < -REBUFFER_GC_LIMIT) {
                 //by the nature of the shared_ptr, memory will ne deallocated automatically.           
                 outputBuffers.pop_back();
                 //std::cout << "--" << std::flush;
@@ -152,6 +202,9 @@ private:
 
     typedef typename std::deque< ReBufferAge < ReBufferPtr > >::iterator outputBuffersI;
 
+    //buffers kept out of the garbage collection, see reserve().
+    size_t reservedCount;
+
     //mutex protecting access to outputBuffers.
     SpinMutex m_mutex;
 };
@@ -183,6 +236,9 @@ public:
     //If wait > 0 ms, the call is blocking at most 'waitMs' milliseconds for the thread to die, then returns.
     //If wait < 0, the wait in infinite until the thread dies.
     bool isTerminated(int waitMs = 0);
+
+    //CPU time used by the thread, in microseconds: known once terminated, 0 before.
+    long long getCPUTime();
     
     virtual void onBindOutput(std::string name, ThreadQueueBasePtr threadQueue);
     virtual void onBindInput(std::string name, ThreadQueueBasePtr threadQueue);
@@ -207,5 +263,7 @@ private:
     //true when the thread has really ended, i.e run() from threadMain() has returned.
     std::atomic_bool terminated;
 
+    std::atomic_llong cpuTime;
+
    
 };
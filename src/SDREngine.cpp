@@ -0,0 +1,99 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "SDREngine.h"
+
+#include "ModemFM.h"
+#include "ModemNBFM.h"
+#include "ModemFMStereo.h"
+#include "ModemAM.h"
+#include "ModemUSB.h"
+#include "ModemLSB.h"
+#include "ModemDSB.h"
+#include "ModemIQ.h"
+
+#ifdef ENABLE_DIGITAL_LAB
+#include "ModemAPSK.h"
+#include "ModemASK.h"
+#include "ModemBPSK.h"
+#include "ModemDPSK.h"
+#include "ModemFSK.h"
+#include "ModemGMSK.h"
+#include "ModemOOK.h"
+#include "ModemPSK.h"
+#include "ModemQAM.h"
+#include "ModemQPSK.h"
+#include "ModemSQAM.h"
+#include "ModemST.h"
+#include "ModemSAMMY.hpp"
+#endif
+
+SDREngine *SDREngine::instance = nullptr;
+
+SDREngine::~SDREngine() {
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+SDREngine *SDREngine::get() {
+    return instance;
+}
+
+void SDREngine::set(SDREngine *engine) {
+    instance = engine;
+}
+
+void SDREngine::registerModems() {
+    Modem::addModemFactory(ModemFM::factory, "FM", 200000);
+    Modem::addModemFactory(ModemNBFM::factory, "NBFM", 12500);
+    Modem::addModemFactory(ModemFMStereo::factory, "FMS", 200000);
+    Modem::addModemFactory(ModemAM::factory, "AM", 6000);
+    Modem::addModemFactory(ModemLSB::factory, "LSB", 5400);
+    Modem::addModemFactory(ModemUSB::factory, "USB", 5400);
+    Modem::addModemFactory(ModemDSB::factory, "DSB", 5400);
+    Modem::addModemFactory(ModemIQ::factory, "I/Q", 48000);
+
+#ifdef ENABLE_DIGITAL_LAB
+    Modem::addModemFactory(ModemAPSK::factory, "APSK", 200000);
+    Modem::addModemFactory(ModemASK::factory, "ASK", 200000);
+    Modem::addModemFactory(ModemBPSK::factory, "BPSK", 200000);
+    Modem::addModemFactory(ModemDPSK::factory, "DPSK", 200000);
+    Modem::addModemFactory(ModemFSK::factory, "FSK", 19200);
+    Modem::addModemFactory(ModemGMSK::factory, "GMSK", 19200);
+    Modem::addModemFactory(ModemOOK::factory, "OOK", 200000);
+    Modem::addModemFactory(ModemPSK::factory, "PSK", 200000);
+    Modem::addModemFactory(ModemQAM::factory, "QAM", 200000);
+    Modem::addModemFactory(ModemQPSK::factory, "QPSK", 200000);
+    Modem::addModemFactory(ModemSQAM::factory, "SQAM", 200000);
+    Modem::addModemFactory(ModemST::factory, "ST", 200000);
+    Modem::addModemFactory(ModemSAMMY::factory, "SAMMY", 200000);
+#endif
+}
+
+void SDREngine::notifyMainUIOfDeviceChange(bool /* forceRefreshOfGains */) {
+}
+
+void SDREngine::notifyModemPropertiesChanged() {
+}
+
+void SDREngine::notifyDemodulatorsUpdated() {
+}
+
+void SDREngine::notifyDemodulatorDeleted(DemodulatorInstancePtr /* demod */) {
+}
+
+void SDREngine::notifyModemFrequency(long long /* freq */) {
+}
+
+bool SDREngine::isUserDemodBusy() {
+    return false;
+}
+
+DemodulatorThreadOutputQueuePtr SDREngine::getAudioVisualQueue() {
+    return nullptr;
+}
+
+bool SDREngine::isAudioVisualConsuming() {
+    return false;
+}
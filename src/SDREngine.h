@@ -0,0 +1,66 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <string>
+
+#include "SoapySDRThread.h"
+#include "SDREnumerator.h"
+#include "DemodulatorMgr.h"
+#include "AppConfig.h"
+
+/**
+ * What the SDR, demodulator and audio threads need from the application running them:
+ * the CubicSDR GUI, or the headless server. The threads only ever talk to SDREngine::get(),
+ * so that they can run without any window.
+ * The notifications default to nothing, for an engine without anyone to notify.
+ */
+class SDREngine {
+public:
+    virtual ~SDREngine();
+
+    static SDREngine *get();
+    static void set(SDREngine *engine);
+
+    //register the built-in modems, once before any demodulator is made.
+    static void registerModems();
+
+    virtual AppConfig *getConfig() = 0;
+    virtual DemodulatorMgr &getDemodMgr() = 0;
+
+    virtual void setFrequency(long long freq) = 0;
+    virtual long long getFrequency() = 0;
+    virtual long long getSampleRate() = 0;
+    virtual bool getSoloMode() = 0;
+
+    virtual bool getUseLocalMod() = 0;
+    virtual std::string getModulePath() = 0;
+
+    virtual void sdrThreadNotify(SDRThread::SDRThreadState state, std::string message) = 0;
+    virtual void sdrEnumThreadNotify(SDREnumerator::SDREnumState state, std::string message) = 0;
+
+    virtual void notifyMainUIOfDeviceChange(bool forceRefreshOfGains = false);
+
+    //a modem was rebuilt, its settings may have changed.
+    virtual void notifyModemPropertiesChanged();
+
+    //the activity, frequency or label of a demodulator changed.
+    virtual void notifyDemodulatorsUpdated();
+
+    //a demodulator is being deleted, to keep it among the recent ones.
+    virtual void notifyDemodulatorDeleted(DemodulatorInstancePtr demod);
+
+    //the current modem is tuned to 'freq', for a rig following it.
+    virtual void notifyModemFrequency(long long freq);
+
+    //true while the user interacts with a demodulator: the solo mode does not switch demodulators then.
+    virtual bool isUserDemodBusy();
+
+    //the audio visualization input, if something shows it.
+    virtual DemodulatorThreadOutputQueuePtr getAudioVisualQueue();
+    virtual bool isAudioVisualConsuming();
+
+private:
+    static SDREngine *instance;
+};
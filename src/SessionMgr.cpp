@@ -48,7 +48,7 @@ void SessionMgr::saveSession(std::string fileName) {
 bool SessionMgr::loadSession(std::string fileName) {
 
     DataTree l;
-    if (!l.LoadFromFileXML(fileName)) {
+    if (!l.LoadFromFile(fileName)) {
         return false;
     }
 
@@ -2,8 +2,16 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "AudioFile.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include <sstream>
+#include <cerrno>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_FILE_SSE 1
+#else
+#define AUDIO_FILE_SSE 0
+#endif
 
 AudioFile::AudioFile() {
 
@@ -19,7 +27,7 @@ void AudioFile::setOutputFileName(std::string filename) {
 
 std::string AudioFile::getOutputFileName() {
 
-    std::string recPath = wxGetApp().getConfig()->getRecordingPath();
+    std::string recPath = SDREngine::get()->getConfig()->getRecordingPath();
 
     // Strip any invalid characters from the name
     std::string stripChars("<>:\"/\\|?*");
@@ -37,14 +45,59 @@ std::string AudioFile::getOutputFileName() {
 
     int idx = 0;
 
-    // If the file exists; then find the next non-existing file in sequence.
+    // If the file exists; then find the next non-existing file in sequence, created right away.
 	std::string fileNameCandidate = outputFileName.str();
 
-    while (FILE *file = fopen((fileNameCandidate + "." + getExtension()).c_str(), "r")) {
-        fclose(file);
+    while (!claimFileName(fileNameCandidate + "." + getExtension())) {
 		fileNameCandidate = outputFileName.str() +  "-" + std::to_string(++idx);
     }
 
     return fileNameCandidate + "." + getExtension();
 }
 
+bool AudioFile::claimFileName(const std::string& path) {
+
+    FILE *file = fopen(path.c_str(), "wx");
+
+    if (file != nullptr) {
+        fclose(file);
+        return true;
+    }
+
+    //any other failure is for the writer to report, when it opens the file.
+    return (errno != EEXIST);
+}
+
+std::string AudioFile::getCurrentFileName() {
+    return currentFileName;
+}
+
+void AudioFile::convertToInt16(const float *input, int16_t *output, size_t count, float scale) {
+    size_t i = 0;
+
+#if AUDIO_FILE_SSE
+    __m128 vScale = _mm_set1_ps(scale);
+    //clamp before the int32 conversion, the int16 packing then saturates.
+    __m128 vMax = _mm_set1_ps(32767.0f), vMin = _mm_set1_ps(-32768.0f);
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(input + i), vScale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(input + i + 4), vScale);
+        a = _mm_min_ps(_mm_max_ps(a, vMin), vMax);
+        b = _mm_min_ps(_mm_max_ps(b, vMin), vMax);
+        //truncation, as the former int() cast.
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+        _mm_storeu_si128((__m128i *)(output + i), packed);
+    }
+#endif
+
+    for (; i < count; i++) {
+        float v = input[i] * scale;
+        if (v > 32767.0f) {
+            v = 32767.0f;
+        } else if (v < -32768.0f) {
+            v = -32768.0f;
+        }
+        output[i] = (int16_t)v;
+    }
+}
@@ -4,11 +4,18 @@
 #pragma once
 
 #include "AudioThread.h"
+#include <cstdint>
 
 class AudioFile
 {
 
 public:
+    enum AudioFileFormat {
+        AUDIO_FILE_FORMAT_WAV = 0, // default value
+        AUDIO_FILE_FORMAT_FLAC = 1, // only available when built with USE_FLAC
+        AUDIO_FILE_FORMAT_MAX
+    };
+
     AudioFile();
     virtual ~AudioFile();
 
@@ -16,10 +23,21 @@ public:
     virtual std::string getExtension() = 0;
     virtual std::string getOutputFileName();
 
+    //full path of the file currently (or last) written, empty if none yet.
+    std::string getCurrentFileName();
+
     virtual bool writeToFile(AudioThreadInputPtr input) = 0;
     virtual bool closeFile() = 0;
 
+    //Scale then convert 'count' float samples to 16-bit integers, clipping to the int16 range.
+    static void convertToInt16(const float *input, int16_t *output, size_t count, float scale);
+
 protected:
+    //create 'path' if it does not exist yet, false if it does: the file itself is only opened later
+    //by the AudioFileWriter, the name must be taken now from another recording starting meanwhile.
+    static bool claimFileName(const std::string& path);
+
     std::string filenameBase;
+    std::string currentFileName;
 
 };
\ No newline at end of file
@@ -0,0 +1,174 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "AudioFileFLAC.h"
+#include <iostream>
+
+//libFLAC default trade-off between speed and size, in [0..8].
+#define FLAC_COMPRESSION_LEVEL (5)
+
+//the STREAMINFO block follows the "fLaC" marker and its own 4 bytes metadata header.
+#define FLAC_STREAMINFO_OFFSET (8)
+
+AudioFileFLAC::AudioFileFLAC() : AudioFile() {
+}
+
+AudioFileFLAC::~AudioFileFLAC() {
+    closeFile();
+}
+
+std::string AudioFileFLAC::getExtension()
+{
+    return "flac";
+}
+
+bool AudioFileFLAC::openEncoder(AudioThreadInputPtr input) {
+
+    encoder = FLAC__stream_encoder_new();
+
+    if (encoder == nullptr) {
+        return false;
+    }
+
+    FLAC__stream_encoder_set_channels(encoder, input->channels);
+    FLAC__stream_encoder_set_bits_per_sample(encoder, 16);
+    FLAC__stream_encoder_set_sample_rate(encoder, input->sampleRate);
+    FLAC__stream_encoder_set_compression_level(encoder, FLAC_COMPRESSION_LEVEL);
+
+    currentFileName = getOutputFileName();
+    outputStream = AudioFileWriter::getInstance()->open(currentFileName);
+
+    //no seek callback: the writer is asynchronous, the final STREAMINFO is patched from metadataCallback() instead.
+    FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_stream(encoder, &AudioFileFLAC::writeCallback, nullptr, nullptr,
+        &AudioFileFLAC::metadataCallback, this);
+
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+        std::cout << "AudioFileFLAC: unable to initialize the FLAC encoder: " << FLAC__StreamEncoderInitStatusString[status] << std::endl << std::flush;
+
+        FLAC__stream_encoder_delete(encoder);
+        encoder = nullptr;
+
+        AudioFileWriter::getInstance()->close(outputStream);
+        outputStream = nullptr;
+        return false;
+    }
+
+    submitPending();
+    return true;
+}
+
+bool AudioFileFLAC::writeToFile(AudioThreadInputPtr input)
+{
+    if (!encoder && !openEncoder(input)) {
+        return false;
+    }
+
+    size_t nbFrames = input->data.size() / input->channels;
+    size_t nbSamples = nbFrames * input->channels;
+
+    if (!nbFrames) {
+        return true;
+    }
+
+    // Prevent clipping
+    float intScale = (input->peak < 1.0) ? 32767.0f : (32767.0f / input->peak);
+
+    int16Samples.resize(nbSamples);
+    flacSamples.resize(nbSamples);
+
+    convertToInt16(&input->data[0], &int16Samples[0], nbSamples, intScale);
+
+    for (size_t i = 0; i < nbSamples; i++) {
+        flacSamples[i] = int16Samples[i];
+    }
+
+    if (!FLAC__stream_encoder_process_interleaved(encoder, &flacSamples[0], (unsigned)nbFrames)) {
+        std::cout << "AudioFileFLAC: encoding error: " << FLAC__stream_encoder_get_resolved_state_string(encoder) << std::endl << std::flush;
+    }
+
+    submitPending();
+
+    return true;
+}
+
+bool AudioFileFLAC::closeFile()
+{
+    if (encoder) {
+        //flushes the last frame through writeCallback(), then calls metadataCallback().
+        FLAC__stream_encoder_finish(encoder);
+        FLAC__stream_encoder_delete(encoder);
+        encoder = nullptr;
+
+        submitPending();
+        AudioFileWriter::getInstance()->close(outputStream);
+        outputStream = nullptr;
+    }
+
+    return true;
+}
+
+void AudioFileFLAC::submitPending() {
+
+    if (pendingData && pendingData->bytes.size()) {
+        AudioFileWriter::getInstance()->append(outputStream, pendingData);
+    }
+    pendingData = nullptr;
+}
+
+FLAC__StreamEncoderWriteStatus AudioFileFLAC::writeCallback(const FLAC__StreamEncoder * /* encoder */, const FLAC__byte buffer[], size_t bytes,
+    unsigned /* samples */, unsigned /* current_frame */, void *client_data) {
+
+    AudioFileFLAC *self = (AudioFileFLAC *)client_data;
+
+    if (!self->pendingData) {
+        self->pendingData = AudioFileWriter::getInstance()->getBuffer();
+    }
+
+    self->pendingData->bytes.insert(self->pendingData->bytes.end(), (const char *)buffer, (const char *)buffer + bytes);
+
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+void AudioFileFLAC::metadataCallback(const FLAC__StreamEncoder * /* encoder */, const FLAC__StreamMetadata *metadata, void *client_data) {
+
+    AudioFileFLAC *self = (AudioFileFLAC *)client_data;
+
+    if (metadata->type != FLAC__METADATA_TYPE_STREAMINFO) {
+        return;
+    }
+
+    //everything encoded so far must reach the file before the patch.
+    self->submitPending();
+
+    const FLAC__StreamMetadata_StreamInfo &info = metadata->data.stream_info;
+
+    AudioFileWriter *writer = AudioFileWriter::getInstance();
+    AudioFileWriteDataPtr streamInfo = writer->getBuffer();
+    std::vector<char> &b = streamInfo->bytes;
+
+    //STREAMINFO layout, big endian: 16 + 16 + 24 + 24 bits of block and frame sizes, then
+    //20 bits sample rate, 3 bits channels - 1, 5 bits bits per sample - 1, 36 bits total samples, then the MD5.
+    b.push_back((char)(info.min_blocksize >> 8));
+    b.push_back((char)(info.min_blocksize));
+    b.push_back((char)(info.max_blocksize >> 8));
+    b.push_back((char)(info.max_blocksize));
+    b.push_back((char)(info.min_framesize >> 16));
+    b.push_back((char)(info.min_framesize >> 8));
+    b.push_back((char)(info.min_framesize));
+    b.push_back((char)(info.max_framesize >> 16));
+    b.push_back((char)(info.max_framesize >> 8));
+    b.push_back((char)(info.max_framesize));
+
+    unsigned long long packed = ((unsigned long long)info.sample_rate << 44) |
+        ((unsigned long long)(info.channels - 1) << 41) |
+        ((unsigned long long)(info.bits_per_sample - 1) << 36) |
+        ((unsigned long long)info.total_samples & 0xFFFFFFFFFULL);
+
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        b.push_back((char)(packed >> shift));
+    }
+
+    b.insert(b.end(), (const char *)info.md5sum, (const char *)info.md5sum + 16);
+
+    writer->patch(self->outputStream, FLAC_STREAMINFO_OFFSET, streamInfo);
+}
@@ -0,0 +1,42 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include "AudioFile.h"
+#include "AudioFileWriter.h"
+
+#include "FLAC/stream_encoder.h"
+
+class AudioFileFLAC : public AudioFile {
+
+public:
+    AudioFileFLAC();
+    ~AudioFileFLAC();
+
+    virtual std::string getExtension();
+
+    virtual bool writeToFile(AudioThreadInputPtr input);
+    virtual bool closeFile();
+
+protected:
+    FLAC__StreamEncoder *encoder = nullptr;
+
+    //the file being written through the shared AudioFileWriter
+    AudioFileStreamPtr outputStream;
+
+    //encoded bytes collected from the encoder callbacks, submitted as one block per input.
+    AudioFileWriteDataPtr pendingData;
+
+    std::vector<int16_t> int16Samples;
+    std::vector<FLAC__int32> flacSamples;
+
+private:
+    bool openEncoder(AudioThreadInputPtr input);
+    void submitPending();
+
+    static FLAC__StreamEncoderWriteStatus writeCallback(const FLAC__StreamEncoder *encoder, const FLAC__byte buffer[], size_t bytes,
+        unsigned samples, unsigned current_frame, void *client_data);
+
+    static void metadataCallback(const FLAC__StreamEncoder *encoder, const FLAC__StreamMetadata *metadata, void *client_data);
+};
@@ -2,54 +2,24 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "AudioFileWAV.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include <iomanip>
+#include <cstring>
 
 //limit file size to 2GB (- margin) for maximum compatibility.
 #define MAX_WAV_FILE_SIZE (0x7FFFFFFF - 1024)
 
-// Simple endian io read/write handling from 
-// http://www.cplusplus.com/forum/beginner/31584/#msg171056
-namespace little_endian_io
-{
-    template <typename Word>
-    std::ostream& write_word(std::ostream& outs, Word value, unsigned size = sizeof(Word)) {
-        for (; size; --size, value >>= 8) {
-            outs.put(static_cast <char> (value & 0xFF));
-        }
-        return outs;
-    }
-
-    template <typename Word>
-    std::istream& read_word(std::istream& ins, Word& value, unsigned size = sizeof(Word)) {
-        for (unsigned n = 0, value = 0; n < size; ++n) {
-            value |= ins.get() << (8 * n);
-        }
-        return ins;
+// Append 'size' bytes of value to a byte block, in little endian order
+static void write_word(std::vector<char>& outs, unsigned long value, unsigned size) {
+    for (; size; --size, value >>= 8) {
+        outs.push_back(static_cast <char> (value & 0xFF));
     }
 }
 
-namespace big_endian_io
-{
-    template <typename Word>
-    std::ostream& write_word(std::ostream& outs, Word value, unsigned size = sizeof(Word)) {
-        while (size) {
-            outs.put(static_cast <char> ((value >> (8 * --size)) & 0xFF));
-        }
-        return outs;
-    }
-
-    template <typename Word>
-    std::istream& read_word(std::istream& ins, Word& value, unsigned size = sizeof(Word)) {
-        for (value = 0; size; --size) {
-            value = (value << 8) | ins.get();
-        }
-        return ins;
-    }
+static void write_string(std::vector<char>& outs, const char *str) {
+    outs.insert(outs.end(), str, str + strlen(str));
 }
 
-using namespace little_endian_io;
-
 AudioFileWAV::AudioFileWAV() : AudioFile() {
 }
 
@@ -64,14 +34,8 @@ std::string AudioFileWAV::getExtension()
 
 bool AudioFileWAV::writeToFile(AudioThreadInputPtr input)
 {
-    if (!outputFileStream.is_open()) {
-
-        std::string ofName = getOutputFileName();
-                
-        outputFileStream.open(ofName.c_str(), std::ios::binary);
-		currentFileSize = 0;
-
-		writeHeaderToFileStream(input);
+    if (!outputStream) {
+		openFileStream(input);
     }
 
 	size_t maxRoomInCurrentFileInSamples = getMaxWritableNumberOfSamples(input);
@@ -87,12 +51,8 @@ bool AudioFileWAV::writeToFile(AudioThreadInputPtr input)
 
 		// Open a new file with the next sequence number, and dump the rest of samples in it.
 		currentSequenceNumber++;
-		currentFileSize = 0;
 
-		std::string ofName = getOutputFileName();
-		outputFileStream.open(ofName.c_str(), std::ios::binary);
-		
-		writeHeaderToFileStream(input);
+		openFileStream(input);
 		writePayloadToFileStream(input, maxRoomInCurrentFileInSamples, input->data.size());
 	}
 
@@ -101,74 +61,100 @@ bool AudioFileWAV::writeToFile(AudioThreadInputPtr input)
 
 bool AudioFileWAV::closeFile()
 {
-    if (outputFileStream.is_open()) {
-        size_t file_length = outputFileStream.tellp();
+    if (outputStream) {
+        AudioFileWriter *writer = AudioFileWriter::getInstance();
+        size_t file_length = (size_t)currentFileSize;
 
         // Fix the data chunk header to contain the data size
-        outputFileStream.seekp(dataChunkPos + 4);
-        write_word(outputFileStream, file_length - (dataChunkPos + 8), 4);
+        AudioFileWriteDataPtr dataSize = writer->getBuffer();
+        write_word(dataSize->bytes, file_length - (dataChunkPos + 8), 4);
+        writer->patch(outputStream, (long)(dataChunkPos + 4), dataSize);
 
         // Fix the file header to contain the proper RIFF chunk size, which is (file size - 8) bytes
-        outputFileStream.seekp(0 + 4);
-        write_word(outputFileStream, file_length - 8, 4);
+        AudioFileWriteDataPtr riffSize = writer->getBuffer();
+        write_word(riffSize->bytes, file_length - 8, 4);
+        writer->patch(outputStream, 4, riffSize);
+
+        writer->close(outputStream);
 
-        outputFileStream.close();
+        outputStream = nullptr;
 		currentFileSize = 0;
     }
 
     return true;
 }
 
+void AudioFileWAV::openFileStream(AudioThreadInputPtr input) {
+
+	currentFileName = getOutputFileName();
+	outputStream = AudioFileWriter::getInstance()->open(currentFileName);
+	currentFileSize = 0;
+
+	writeHeaderToFileStream(input);
+}
+
 void AudioFileWAV::writeHeaderToFileStream(AudioThreadInputPtr input) {
 
 	// Based on simple wav file output code from
 	// http://www.cplusplus.com/forum/beginner/166954/
+	AudioFileWriter *writer = AudioFileWriter::getInstance();
+	AudioFileWriteDataPtr header = writer->getBuffer();
 
 	// Write the wav file headers
-	outputFileStream << "RIFF----WAVEfmt "; // (chunk size to be filled in later)
-	write_word(outputFileStream, 16, 4); // no extension data
-	write_word(outputFileStream, 1, 2); // PCM - integer samples
-	write_word(outputFileStream, input->channels, 2); // channels
-	write_word(outputFileStream, input->sampleRate, 4); // samples per second (Hz)
-	write_word(outputFileStream, (input->sampleRate * 16 * input->channels) / 8, 4); // (Sample Rate * BitsPerSample * Channels) / 8
-	write_word(outputFileStream, input->channels * 2, 2); // data block size (size of integer samples, one for each channel, in bytes)
-	write_word(outputFileStream, 16, 2); // number of bits per sample (use a multiple of 8)
+	write_string(header->bytes, "RIFF----WAVEfmt "); // (chunk size to be filled in later)
+	write_word(header->bytes, 16, 4); // no extension data
+	write_word(header->bytes, 1, 2); // PCM - integer samples
+	write_word(header->bytes, input->channels, 2); // channels
+	write_word(header->bytes, input->sampleRate, 4); // samples per second (Hz)
+	write_word(header->bytes, (input->sampleRate * 16 * input->channels) / 8, 4); // (Sample Rate * BitsPerSample * Channels) / 8
+	write_word(header->bytes, input->channels * 2, 2); // data block size (size of integer samples, one for each channel, in bytes)
+	write_word(header->bytes, 16, 2); // number of bits per sample (use a multiple of 8)
 
 										 // Write the data chunk header
-	dataChunkPos = outputFileStream.tellp();
-	currentFileSize = dataChunkPos;
-	outputFileStream << "data----";  // (chunk size to be filled in later)
+	dataChunkPos = header->bytes.size();
+	write_string(header->bytes, "data----");  // (chunk size to be filled in later)
+
+	currentFileSize = header->bytes.size();
+	writer->append(outputStream, header);
 }
 
 void AudioFileWAV::writePayloadToFileStream(AudioThreadInputPtr input, size_t startInputPosition, size_t endInputPosition) {
 
+	if (endInputPosition <= startInputPosition) {
+		return;
+	}
+
 	// Prevent clipping
 	float intScale = (input->peak < 1.0) ? 32767.0f : (32767.0f / input->peak);
 
-	if (input->channels == 1) {
-		for (size_t i = startInputPosition, iMax = endInputPosition; i < iMax; i++) {
+	size_t nbSamples = endInputPosition - startInputPosition;
 
-			write_word(outputFileStream, int(input->data[i] * intScale), 2);
-			
-			currentFileSize += 2;
-		}
-	}
-	else if (input->channels == 2) {
-		for (size_t i = startInputPosition, iMax = endInputPosition / 2; i < iMax; i++) {
+	AudioFileWriter *writer = AudioFileWriter::getInstance();
+	AudioFileWriteDataPtr payload = writer->getBuffer();
 
-			write_word(outputFileStream, int(input->data[i * 2] * intScale), 2);
-			write_word(outputFileStream, int(input->data[i * 2 + 1] * intScale), 2);
+	payload->bytes.resize(nbSamples * sizeof(int16_t));
+	int16_t *samples = (int16_t *)&payload->bytes[0];
 
-			currentFileSize += 4;
-		}
+	convertToInt16(&input->data[startInputPosition], samples, nbSamples, intScale);
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	//WAV samples are little endian
+	for (size_t i = 0; i < nbSamples; i++) {
+		uint16_t v = (uint16_t)samples[i];
+		samples[i] = (int16_t)((v >> 8) | (v << 8));
 	}
+#endif
+
+	currentFileSize += payload->bytes.size();
+	writer->append(outputStream, payload);
 }
 
 size_t AudioFileWAV::getMaxWritableNumberOfSamples(AudioThreadInputPtr input) {
 
 	long long remainingBytesInFile = (long long)(MAX_WAV_FILE_SIZE) - currentFileSize;
 
-    return (size_t)(remainingBytesInFile / (input->channels * 2));
+    //whole frames only, expressed in samples
+    return (size_t)(remainingBytesInFile / (input->channels * 2)) * input->channels;
 	
 }
 
@@ -184,7 +170,7 @@ void AudioFileWAV::setOutputFileName(std::string filename) {
 
 std::string AudioFileWAV::getOutputFileName() {
 
-	std::string recPath = wxGetApp().getConfig()->getRecordingPath();
+	std::string recPath = SDREngine::get()->getConfig()->getRecordingPath();
 
 	// Strip any invalid characters from the name
 	std::string stripChars("<>:\"/\\|?*");
@@ -207,11 +193,10 @@ std::string AudioFileWAV::getOutputFileName() {
 
 	int idx = 0;
 
-	// If the file exists; then find the next non-existing file in sequence.
+	// If the file exists; then find the next non-existing file in sequence, created right away.
 	std::string fileNameCandidate = outputFileName.str();
 
-	while (FILE *file = fopen((fileNameCandidate + "." + getExtension()).c_str(), "r")) {
-		fclose(file);
+	while (!claimFileName(fileNameCandidate + "." + getExtension())) {
 		fileNameCandidate = outputFileName.str() + "-" + std::to_string(++idx);
 	}
 
@@ -4,8 +4,7 @@
 #pragma once
 
 #include "AudioFile.h"
-
-#include <fstream>
+#include "AudioFileWriter.h"
 
 class AudioFileWAV : public AudioFile {
 
@@ -26,7 +25,8 @@ public:
     virtual bool closeFile();
 
 protected:
-    std::ofstream outputFileStream;
+    //the file being written through the shared AudioFileWriter
+    AudioFileStreamPtr outputStream;
     size_t dataChunkPos;
 	long long currentFileSize = 0;
 	int currentSequenceNumber = 0;
@@ -35,8 +35,11 @@ private:
 
 	size_t getMaxWritableNumberOfSamples(AudioThreadInputPtr input);
 
+	void openFileStream(AudioThreadInputPtr input);
+
 	void writeHeaderToFileStream(AudioThreadInputPtr input);
 
-	//write [startInputPosition; endInputPosition[ samples from input into the file.
+	//write [startInputPosition; endInputPosition[ samples from input into the file,
+	//as one block of 16-bit integers.
 	void writePayloadToFileStream(AudioThreadInputPtr input, size_t startInputPosition, size_t endInputPosition);
 };
\ No newline at end of file
@@ -0,0 +1,209 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "AudioFileWriter.h"
+#include <iostream>
+
+//50 ms
+#define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000)
+
+AudioFileWriter *AudioFileWriter::instance = nullptr;
+std::thread *AudioFileWriter::instanceThread = nullptr;
+std::mutex AudioFileWriter::instanceMutex;
+
+AudioFileWriter::AudioFileWriter() : IOThread(), buffers("AudioFileWriterBuffers") {
+    requestQueue = std::make_shared<AudioFileWriteRequestQueue>();
+    requestQueue->set_max_num_items(AUDIO_FILE_WRITER_QUEUE_SIZE);
+    requestQueue->set_stats_name("AudioFileWriteRequests");
+}
+
+AudioFileWriter::~AudioFileWriter() {
+
+}
+
+AudioFileWriter *AudioFileWriter::getInstance() {
+
+    std::lock_guard < std::mutex > lock(instanceMutex);
+
+    if (instance == nullptr) {
+        instance = new AudioFileWriter();
+        instanceThread = new std::thread(&AudioFileWriter::threadMain, instance);
+    }
+
+    return instance;
+}
+
+void AudioFileWriter::cleanup() {
+
+    std::lock_guard < std::mutex > lock(instanceMutex);
+
+    if (instance == nullptr) {
+        return;
+    }
+
+    instance->terminate();
+    instanceThread->join();
+
+    delete instanceThread;
+    delete instance;
+
+    instanceThread = nullptr;
+    instance = nullptr;
+}
+
+AudioFileWriteDataPtr AudioFileWriter::getBuffer() {
+
+    AudioFileWriteDataPtr data = buffers.getBuffer();
+    data->bytes.resize(0);
+
+    return data;
+}
+
+AudioFileStreamPtr AudioFileWriter::open(const std::string& path) {
+
+    AudioFileWriteRequest request;
+    request.cmd = AudioFileWriteRequest::AUDIO_FILE_WRITE_OPEN;
+    request.stream = std::make_shared<AudioFileStream>(path);
+
+    //blocking push: never lose part of a recording.
+    requestQueue->push(request);
+
+    return request.stream;
+}
+
+void AudioFileWriter::append(AudioFileStreamPtr stream, AudioFileWriteDataPtr data) {
+
+    AudioFileWriteRequest request;
+    request.cmd = AudioFileWriteRequest::AUDIO_FILE_WRITE_APPEND;
+    request.stream = stream;
+    request.data = data;
+
+    requestQueue->push(request);
+}
+
+void AudioFileWriter::patch(AudioFileStreamPtr stream, long offset, AudioFileWriteDataPtr data) {
+
+    AudioFileWriteRequest request;
+    request.cmd = AudioFileWriteRequest::AUDIO_FILE_WRITE_PATCH;
+    request.stream = stream;
+    request.data = data;
+    request.offset = offset;
+
+    requestQueue->push(request);
+}
+
+void AudioFileWriter::flush(AudioFileStreamPtr stream) {
+
+    AudioFileWriteRequest request;
+    request.cmd = AudioFileWriteRequest::AUDIO_FILE_WRITE_FLUSH;
+    request.stream = stream;
+
+    requestQueue->push(request);
+}
+
+void AudioFileWriter::close(AudioFileStreamPtr stream) {
+
+    AudioFileWriteRequest request;
+    request.cmd = AudioFileWriteRequest::AUDIO_FILE_WRITE_CLOSE;
+    request.stream = stream;
+
+    requestQueue->push(request);
+}
+
+void AudioFileWriter::run() {
+
+    AudioFileWriteRequest request;
+
+    //on termination, keep going until every pending request is done
+    //so that all files are properly completed.
+    while (!stopping || !requestQueue->empty()) {
+
+        if (!requestQueue->pop(request, HEARTBEAT_CHECK_PERIOD_MICROS)) {
+            continue;
+        }
+
+        process(request);
+
+        //process what has accumulated meanwhile in one go, possibly for many files:
+        //stdio buffering coalesces the blocks of each file into large writes.
+        while (requestQueue->try_pop(request)) {
+            process(request);
+        }
+
+        request = AudioFileWriteRequest();
+    }
+}
+
+void AudioFileWriter::terminate() {
+    IOThread::terminate();
+}
+
+void AudioFileWriter::process(AudioFileWriteRequest &request) {
+
+    AudioFileStream *stream = request.stream.get();
+
+    if (stream == nullptr) {
+        return;
+    }
+
+    switch (request.cmd) {
+        case AudioFileWriteRequest::AUDIO_FILE_WRITE_OPEN:
+            stream->file = fopen(stream->path.c_str(), "wb");
+
+            if (stream->file == nullptr) {
+                std::cout << "AudioFileWriter: unable to open '" << stream->path << "' for writing." << std::endl << std::flush;
+                break;
+            }
+
+            stream->fileBuffer.resize(AUDIO_FILE_WRITER_FILE_BUFFER_SIZE);
+            setvbuf(stream->file, &stream->fileBuffer[0], _IOFBF, stream->fileBuffer.size());
+            break;
+
+        case AudioFileWriteRequest::AUDIO_FILE_WRITE_APPEND:
+            if (stream->file && request.data && request.data->bytes.size()) {
+                if (fwrite(&request.data->bytes[0], 1, request.data->bytes.size(), stream->file) != request.data->bytes.size()) {
+                    fail(stream);
+                }
+            }
+            break;
+
+        case AudioFileWriteRequest::AUDIO_FILE_WRITE_PATCH:
+            if (stream->file && request.data && request.data->bytes.size()) {
+                if (fseek(stream->file, request.offset, SEEK_SET) != 0 ||
+                    fwrite(&request.data->bytes[0], 1, request.data->bytes.size(), stream->file) != request.data->bytes.size() ||
+                    fseek(stream->file, 0, SEEK_END) != 0) {
+                    fail(stream);
+                }
+            }
+            break;
+
+        case AudioFileWriteRequest::AUDIO_FILE_WRITE_FLUSH:
+            if (stream->file && fflush(stream->file) != 0) {
+                fail(stream);
+            }
+            break;
+
+        case AudioFileWriteRequest::AUDIO_FILE_WRITE_CLOSE:
+            if (stream->file) {
+                //the buffered end of the file is only written here.
+                if (fclose(stream->file) != 0) {
+                    std::cout << "AudioFileWriter: unable to complete '" << stream->path << "', the file is incomplete." << std::endl << std::flush;
+                }
+                stream->file = nullptr;
+            }
+            std::vector<char>().swap(stream->fileBuffer);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AudioFileWriter::fail(AudioFileStream *stream) {
+
+    //the later blocks would leave a hole or a wrong header: the file stops here, its requests are ignored.
+    std::cout << "AudioFileWriter: unable to write to '" << stream->path << "', the recording is stopped." << std::endl << std::flush;
+
+    fclose(stream->file);
+    stream->file = nullptr;
+}
@@ -0,0 +1,99 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include "IOThread.h"
+#include "ThreadBlockingQueue.h"
+
+//max number of pending requests before AudioFile producers block.
+#define AUDIO_FILE_WRITER_QUEUE_SIZE (4096)
+
+//stdio buffer of each opened file, so that many small blocks end up in few large writes.
+#define AUDIO_FILE_WRITER_FILE_BUFFER_SIZE (256 * 1024)
+
+//A file written through the AudioFileWriter: only the writer thread uses 'file'.
+class AudioFileStream {
+public:
+    AudioFileStream(const std::string& path) : path(path), file(nullptr) {
+    }
+
+    std::string path;
+    FILE *file;
+    std::vector<char> fileBuffer;
+};
+
+typedef std::shared_ptr<AudioFileStream> AudioFileStreamPtr;
+
+//A block of already encoded bytes, recycled through a ReBuffer.
+class AudioFileWriteData {
+public:
+    std::vector<char> bytes;
+};
+
+typedef std::shared_ptr<AudioFileWriteData> AudioFileWriteDataPtr;
+
+class AudioFileWriteRequest {
+public:
+    enum AudioFileWriteRequestEnum {
+        AUDIO_FILE_WRITE_NULL, AUDIO_FILE_WRITE_OPEN, AUDIO_FILE_WRITE_APPEND, AUDIO_FILE_WRITE_PATCH, AUDIO_FILE_WRITE_FLUSH, AUDIO_FILE_WRITE_CLOSE
+    };
+
+    AudioFileWriteRequest() : cmd(AUDIO_FILE_WRITE_NULL), offset(0) {
+    }
+
+    AudioFileWriteRequestEnum cmd;
+    AudioFileStreamPtr stream;
+    AudioFileWriteDataPtr data;
+    //AUDIO_FILE_WRITE_PATCH only: where to overwrite data in the file.
+    long offset;
+};
+
+typedef ThreadBlockingQueue<AudioFileWriteRequest> AudioFileWriteRequestQueue;
+typedef std::shared_ptr<AudioFileWriteRequestQueue> AudioFileWriteRequestQueuePtr;
+
+//A single thread doing the actual file I/O for all the recordings: AudioFile implementations
+//encode into large blocks and queue them here, requests for a given file being executed in order.
+class AudioFileWriter : public IOThread {
+
+public:
+    AudioFileWriter();
+    virtual ~AudioFileWriter();
+
+    virtual void run();
+    virtual void terminate();
+
+    //the writer shared by all AudioFile, started on first use.
+    static AudioFileWriter *getInstance();
+
+    //complete all pending requests, then stop the shared writer.
+    static void cleanup();
+
+    //get an empty block to fill and pass to append() or patch().
+    AudioFileWriteDataPtr getBuffer();
+
+    AudioFileStreamPtr open(const std::string& path);
+    void append(AudioFileStreamPtr stream, AudioFileWriteDataPtr data);
+    void patch(AudioFileStreamPtr stream, long offset, AudioFileWriteDataPtr data);
+    //push what has been appended so far to the OS, for files which must stay readable while open.
+    void flush(AudioFileStreamPtr stream);
+    void close(AudioFileStreamPtr stream);
+
+private:
+    void process(AudioFileWriteRequest &request);
+    //close 'stream' on an I/O error, reported once.
+    void fail(AudioFileStream *stream);
+
+    AudioFileWriteRequestQueuePtr requestQueue;
+    ReBuffer<AudioFileWriteData> buffers;
+
+    static AudioFileWriter *instance;
+    static std::thread *instanceThread;
+    static std::mutex instanceMutex;
+};
@@ -2,9 +2,13 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "AudioSinkFileThread.h"
+#include "SDREngine.h"
 #include <ctime>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
 
-#define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000) 
+#define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000)
 
 AudioSinkFileThread::AudioSinkFileThread() : AudioSinkThread() {
 
@@ -12,8 +16,20 @@ AudioSinkFileThread::AudioSinkFileThread() : AudioSinkThread() {
 
 AudioSinkFileThread::~AudioSinkFileThread() {
     if (audioFileHandler != nullptr) {
-        audioFileHandler->closeFile();
+        if (transmissionActive) {
+            endTransmission();
+        } else {
+            audioFileHandler->closeFile();
+        }
+        //the handler given by setAudioFileHandler() is owned by this sink.
+        delete audioFileHandler;
     }
+
+    if (indexStream) {
+        AudioFileWriter::getInstance()->close(indexStream);
+    }
+
+    delete preRollRing;
 }
 
 void AudioSinkFileThread::sink(AudioThreadInputPtr input) {
@@ -21,13 +37,18 @@ void AudioSinkFileThread::sink(AudioThreadInputPtr input) {
         return;
     }
 
+	if (squelchOption == SQUELCH_RECORD_TRANSMISSIONS) {
+		sinkTransmission(input);
+		return;
+	}
+
 	//by default, always write something
 	bool isSomethingToWrite = true;
 
 	if (input->is_squelch_active) {
 
 		if (squelchOption == SQUELCH_RECORD_SILENCE) {
-		
+
 			//patch with "silence"
 			input->data.assign(input->data.size(), 0.0f);
 			input->peak = 0.0f;
@@ -38,7 +59,7 @@ void AudioSinkFileThread::sink(AudioThreadInputPtr input) {
 	}
 
 	//else, nothing to do record as if squelch was not enabled.
-	
+
 	if (!isSomethingToWrite) {
 		return;
 	}
@@ -47,23 +68,12 @@ void AudioSinkFileThread::sink(AudioThreadInputPtr input) {
 		durationMeasurement.update();
 
 		//duration exeeded, close this file and create another
-		//with "now" as timestamp.
+		//with the time of its first samples as timestamp.
 		if (durationMeasurement.getSeconds() > fileTimeLimit) {
-			
-			audioFileHandler->closeFile();
 
-			//initialize the filename of the AudioFile with the current time
-			time_t t = std::time(nullptr);
-			tm ltm = *std::localtime(&t);
-
-			//  GCC 5+
-			//    fileName << "_" << std::put_time(&ltm, "%d-%m-%Y_%H-%M-%S");
-
-			char timeStr[512];
-			//International format: Year.Month.Day, also lexicographically sortable
-			strftime(timeStr, sizeof(timeStr), "%Y-%m-%d_%H-%M-%S", &ltm);
+			audioFileHandler->closeFile();
 
-			audioFileHandler->setOutputFileName(fileNameBase + std::string("_") + timeStr);
+			audioFileHandler->setOutputFileName(fileNameBase + std::string("_") + getTimeStamp(std::chrono::system_clock::to_time_t(getInputTime(input))));
 
 			//reset duration counter
 			durationMeasurement.start();
@@ -75,12 +85,19 @@ void AudioSinkFileThread::sink(AudioThreadInputPtr input) {
     audioFileHandler->writeToFile(input);
 }
 
-void AudioSinkFileThread::inputChanged(AudioThreadInput /* oldProps */, AudioThreadInputPtr /* newProps */) {
+void AudioSinkFileThread::inputChanged(AudioThreadInput /* oldProps */, AudioThreadInputPtr newProps) {
     // close, set new parameters, adjust file name sequence and re-open?
     if (!audioFileHandler) {
         return;
     }
 
+	if (squelchOption == SQUELCH_RECORD_TRANSMISSIONS) {
+		//a transmission never spans a frequency or format change.
+		endTransmission();
+		resetPreRoll(newProps);
+		return;
+	}
+
     audioFileHandler->closeFile();
 
 	//reset duration counter
@@ -94,19 +111,9 @@ void AudioSinkFileThread::setAudioFileNameBase(const std::string& baseName) {
 
 void AudioSinkFileThread::setAudioFileHandler(AudioFile * output) {
     audioFileHandler = output;
-	
-	//initialize the filename of the AudioFile with the current time
-	time_t t = std::time(nullptr);
-	tm ltm = *std::localtime(&t);
 
-	//  GCC 5+
-	//    fileName << "_" << std::put_time(&ltm, "%d-%m-%Y_%H-%M-%S");
-
-	char timeStr[512];
-	//International format: Year.Month.Day, also lexicographically sortable
-	strftime(timeStr, sizeof(timeStr), "%Y-%m-%d_%H-%M-%S", &ltm);
-
-	audioFileHandler->setOutputFileName(fileNameBase + std::string("_") + timeStr);
+	//initialize the filename of the AudioFile with the current time
+	audioFileHandler->setOutputFileName(fileNameBase + std::string("_") + getTimeStamp(std::time(nullptr)));
 
 	// reset Timer
 	durationMeasurement.start();
@@ -123,6 +130,9 @@ void AudioSinkFileThread::setSquelchOption(int squelchOptEnumValue) {
 	else if (squelchOptEnumValue == AudioSinkFileThread::SQUELCH_RECORD_ALWAYS) {
 		squelchOption = AudioSinkFileThread::SQUELCH_RECORD_ALWAYS;
 	}
+	else if (squelchOptEnumValue == AudioSinkFileThread::SQUELCH_RECORD_TRANSMISSIONS) {
+		squelchOption = AudioSinkFileThread::SQUELCH_RECORD_TRANSMISSIONS;
+	}
 	else {
 		squelchOption = AudioSinkFileThread::SQUELCH_RECORD_SILENCE;
 	}
@@ -138,3 +148,240 @@ void AudioSinkFileThread::setFileTimeLimit(int nbSeconds) {
 		fileTimeLimit = 0;
 	}
 }
+
+void AudioSinkFileThread::setPreRoll(int nbMilliseconds) {
+
+	preRollMilliseconds = std::max(nbMilliseconds, 0);
+}
+
+void AudioSinkFileThread::setHangTime(int nbMilliseconds) {
+
+	hangTimeMilliseconds = std::max(nbMilliseconds, 0);
+}
+
+std::chrono::system_clock::time_point AudioSinkFileThread::getInputTime(AudioThreadInputPtr input) {
+
+	if (!input->timestamp.isValid()) {
+		return std::chrono::system_clock::now();
+	}
+
+	return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+		std::chrono::nanoseconds(input->timestamp.hostTimeNs)));
+}
+
+std::string AudioSinkFileThread::getTimeStamp(time_t t) {
+
+	tm ltm = *std::localtime(&t);
+
+	//  GCC 5+
+	//    fileName << "_" << std::put_time(&ltm, "%d-%m-%Y_%H-%M-%S");
+
+	char timeStr[512];
+	//International format: Year.Month.Day, also lexicographically sortable
+	strftime(timeStr, sizeof(timeStr), "%Y-%m-%d_%H-%M-%S", &ltm);
+
+	return std::string(timeStr);
+}
+
+void AudioSinkFileThread::sinkTransmission(AudioThreadInputPtr input) {
+
+	if (input->data.empty()) {
+		return;
+	}
+
+	if (!input->is_squelch_active) {
+
+		if (!transmissionActive) {
+			startTransmission(input);
+		}
+
+		hangSamples = 0;
+		transmissionPeak = std::max(transmissionPeak, input->peak);
+	}
+	else if (!transmissionActive) {
+		//nothing to record, only remember the latest audio for the next squelch break.
+		pushPreRoll(input);
+		return;
+	}
+	else {
+		//squelch closed: keep recording for the hang time, in case the transmission resumes.
+		hangSamples += input->data.size();
+	}
+
+	audioFileHandler->writeToFile(input);
+	transmissionSamples += input->data.size();
+
+	size_t hangTimeSamples = (size_t)((long long)hangTimeMilliseconds * input->sampleRate / 1000) * input->channels;
+
+	if (input->is_squelch_active && hangSamples >= hangTimeSamples) {
+		endTransmission();
+	}
+}
+
+void AudioSinkFileThread::resetPreRoll(AudioThreadInputPtr input) {
+
+	//whole frames only
+	preRollSamples = (size_t)((long long)preRollMilliseconds * input->sampleRate / 1000) * input->channels;
+
+	if (preRollSamples == 0) {
+		return;
+	}
+
+	//memory is only ever allocated here, when the format needs a larger ring.
+	if (preRollRing == nullptr || preRollRing->capacity() < preRollSamples) {
+		delete preRollRing;
+		preRollRing = new SPSCRingBuffer<float>(preRollSamples);
+	}
+
+	if (!preRollInput) {
+		preRollInput = std::make_shared<AudioThreadInput>();
+	}
+	preRollInput->data.reserve(preRollRing->capacity());
+
+	//the ring is used by this thread only, as both producer and consumer.
+	preRollRing->consumeAll();
+}
+
+void AudioSinkFileThread::pushPreRoll(AudioThreadInputPtr input) {
+
+	if (preRollRing == nullptr || preRollSamples == 0) {
+		return;
+	}
+
+	const float *src = &input->data[0];
+	size_t nbSamples = input->data.size();
+
+	//only the most recent pre-roll matters
+	if (nbSamples > preRollSamples) {
+		src += nbSamples - preRollSamples;
+		nbSamples = preRollSamples;
+	}
+
+	//drop the oldest samples to make room, so that at most preRollSamples are kept.
+	size_t keep = preRollSamples - nbSamples;
+	size_t available = preRollRing->readAvailable();
+
+	if (available > keep) {
+		preRollRing->consume(available - keep);
+	}
+
+	preRollRing->write(src, nbSamples);
+}
+
+void AudioSinkFileThread::startTransmission(AudioThreadInputPtr input) {
+
+	size_t preRolled = (preRollRing != nullptr && preRollSamples > 0) ? preRollRing->readAvailable() : 0;
+	long long samplesPerSecond = (long long)input->sampleRate * input->channels;
+
+	transmissionActive = true;
+	transmissionSamplesPerSecond = samplesPerSecond;
+	transmissionSamples = 0;
+	hangSamples = 0;
+	transmissionPeak = 0;
+	transmissionFrequency = input->frequency;
+
+	//the file starts with the pre-roll, so does the transmission
+	transmissionStart = getInputTime(input);
+	if (samplesPerSecond > 0) {
+		transmissionStart -= std::chrono::milliseconds((long long)preRolled * 1000 / samplesPerSecond);
+	}
+
+	audioFileHandler->setOutputFileName(fileNameBase + std::string("_") + getTimeStamp(std::chrono::system_clock::to_time_t(transmissionStart)));
+
+	if (preRolled == 0) {
+		return;
+	}
+
+	preRollInput->frequency = input->frequency;
+	preRollInput->inputRate = input->inputRate;
+	preRollInput->sampleRate = input->sampleRate;
+	preRollInput->channels = input->channels;
+	preRollInput->type = input->type;
+	preRollInput->is_squelch_active = true;
+	preRollInput->timestamp = input->timestamp.offset(-(double)preRolled / std::max(input->channels, 1), input->sampleRate);
+
+	//within the reserved capacity, no allocation.
+	preRollInput->data.resize(preRolled);
+	preRollRing->read(&preRollInput->data[0], preRolled);
+
+	float peak = 0;
+	for (size_t i = 0; i < preRolled; i++) {
+		peak = std::max(peak, std::fabs(preRollInput->data[i]));
+	}
+	preRollInput->peak = peak;
+
+	audioFileHandler->writeToFile(preRollInput);
+	transmissionSamples += preRolled;
+}
+
+void AudioSinkFileThread::endTransmission() {
+
+	if (!transmissionActive) {
+		return;
+	}
+
+	audioFileHandler->closeFile();
+
+	double durationSeconds = 0;
+	if (transmissionSamplesPerSecond > 0) {
+		durationSeconds = (double)transmissionSamples / (double)transmissionSamplesPerSecond;
+	}
+
+	writeIndexEntry(audioFileHandler->getCurrentFileName(), durationSeconds);
+
+	transmissionActive = false;
+}
+
+void AudioSinkFileThread::writeIndexEntry(const std::string& fileName, double durationSeconds) {
+
+	AudioFileWriter *writer = AudioFileWriter::getInstance();
+
+	if (!indexStream) {
+		// Strip any invalid characters from the name
+		std::string stripChars("<>:\"/\\|?*");
+		std::string fileNameBaseSafe = fileNameBase;
+
+		for (size_t i = 0, iMax = fileNameBaseSafe.length(); i < iMax; i++) {
+			if (stripChars.find(fileNameBaseSafe[i]) != std::string::npos) {
+				fileNameBaseSafe.replace(i, 1, "_");
+			}
+		}
+
+		std::string indexPath = SDREngine::get()->getConfig()->getRecordingPath() + filePathSeparator +
+			fileNameBaseSafe + "_" + getTimeStamp(std::chrono::system_clock::to_time_t(transmissionStart)) + "_index.csv";
+
+		indexStream = writer->open(indexPath);
+
+		AudioFileWriteDataPtr header = writer->getBuffer();
+		std::string headerLine("start,duration_s,frequency_hz,peak_dbfs,file\n");
+		header->bytes.assign(headerLine.begin(), headerLine.end());
+		writer->append(indexStream, header);
+	}
+
+	//start with milliseconds, local time
+	time_t startTime = std::chrono::system_clock::to_time_t(transmissionStart);
+	tm ltm = *std::localtime(&startTime);
+	char timeStr[64];
+	strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S", &ltm);
+
+	long long startMillis = std::chrono::duration_cast<std::chrono::milliseconds>(transmissionStart.time_since_epoch()).count() % 1000;
+
+	float peakDb = 20.0f * log10(std::max(transmissionPeak, 1e-6f));
+
+	std::string filePart = fileName.substr(fileName.find_last_of(filePathSeparator) + 1);
+
+	char line[1024];
+	int lineLength = snprintf(line, sizeof(line), "%s.%03lld,%.3f,%lld,%.1f,%s\n",
+		timeStr, startMillis, durationSeconds, transmissionFrequency, peakDb, filePart.c_str());
+
+	if (lineLength <= 0) {
+		return;
+	}
+
+	AudioFileWriteDataPtr entry = writer->getBuffer();
+	entry->bytes.assign(line, line + std::min((size_t)lineLength, sizeof(line) - 1));
+	writer->append(indexStream, entry);
+
+	//the index stays usable even if the session is not properly ended.
+	writer->flush(indexStream);
+}
@@ -5,7 +5,10 @@
 
 #include "AudioSinkThread.h"
 #include "AudioFile.h"
+#include "AudioFileWriter.h"
+#include "SPSCRingBuffer.h"
 #include "Timer.h"
+#include <chrono>
 
 class AudioSinkFileThread : public AudioSinkThread {
 
@@ -17,6 +20,7 @@ public:
 		SQUELCH_RECORD_SILENCE = 0, // default value, record as a user would hear it.
 		SQUELCH_SKIP_SILENCE = 1,  // skip below-squelch level. 
 		SQUELCH_RECORD_ALWAYS = 2, // record irrespective of the squelch level.
+		SQUELCH_RECORD_TRANSMISSIONS = 3, // one file per squelch break, with pre-roll and hang time.
 		SQUELCH_RECORD_MAX
 	};
 
@@ -33,6 +37,11 @@ public:
 	// Time limit
 	void setFileTimeLimit(int nbSeconds);
 
+	//SQUELCH_RECORD_TRANSMISSIONS: audio kept from before the squelch break,
+	//and time to keep recording after the squelch closed.
+	void setPreRoll(int nbMilliseconds);
+	void setHangTime(int nbMilliseconds);
+
 protected:
 
 	std::string fileNameBase;
@@ -46,5 +55,36 @@ protected:
 
 	Timer durationMeasurement;
 
+	//SQUELCH_RECORD_TRANSMISSIONS state:
+	int preRollMilliseconds = 0;
+	int hangTimeMilliseconds = 0;
+
+	//last pre-roll of audio heard under squelch, fixed size once allocated.
+	SPSCRingBuffer<float> *preRollRing = nullptr;
+	size_t preRollSamples = 0;
+	AudioThreadInputPtr preRollInput;
+
+	bool transmissionActive = false;
+	size_t transmissionSamples = 0;
+	long long transmissionSamplesPerSecond = 0;
+	size_t hangSamples = 0;
+	float transmissionPeak = 0;
+	long long transmissionFrequency = 0;
+	std::chrono::system_clock::time_point transmissionStart;
+
+	//session index of all recorded transmissions, one CSV line each.
+	AudioFileStreamPtr indexStream;
+
+private:
+	std::string getTimeStamp(time_t t);
+	//when the first frame of input was received by the device, else now.
+	static std::chrono::system_clock::time_point getInputTime(AudioThreadInputPtr input);
+
+	void sinkTransmission(AudioThreadInputPtr input);
+	void resetPreRoll(AudioThreadInputPtr input);
+	void pushPreRoll(AudioThreadInputPtr input);
+	void startTransmission(AudioThreadInputPtr input);
+	void endTransmission();
+	void writeIndexEntry(const std::string& fileName, double durationSeconds);
 };
 
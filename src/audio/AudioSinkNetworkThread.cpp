@@ -0,0 +1,292 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "AudioSinkNetworkThread.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+//payload budget of a packet, so that no packet is fragmented on an Ethernet MTU.
+#define AUDIO_STREAM_MAX_PAYLOAD 1200
+
+#define AUDIO_STREAM_RTP_HEADER_SIZE 12
+
+//Opus packet duration, in 1/1000 s.
+#define AUDIO_STREAM_OPUS_FRAME_MS 20
+
+//the RTP clock of Opus, whatever the audio rate (RFC 7587)
+#define AUDIO_STREAM_OPUS_CLOCK 48000
+
+AudioSinkNetworkThread::AudioSinkNetworkThread() : AudioSinkThread("AudioStreamInput") {
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    std::memset(&destination, 0, sizeof(destination));
+
+    //random initial sequence number and timestamp, as RFC 3550 asks.
+    std::random_device random;
+    sequence = (unsigned short)random();
+    rtpTimestamp = random();
+}
+
+AudioSinkNetworkThread::~AudioSinkNetworkThread() {
+#if USE_OPUS
+    if (opusEncoder) {
+        opus_encoder_destroy(opusEncoder);
+    }
+#endif
+
+    if (streamSocket != AUDIO_STREAM_INVALID_SOCKET) {
+#ifdef _WIN32
+        closesocket(streamSocket);
+#else
+        close(streamSocket);
+#endif
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool AudioSinkNetworkThread::setDestination(const std::string& address, int port) {
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons((unsigned short)port);
+
+    if (inet_pton(AF_INET, address.c_str(), &destination.sin_addr) != 1) {
+        std::cout << "AudioSinkNetworkThread: '" << address << "' is not an IPv4 address." << std::endl;
+        return false;
+    }
+
+    streamSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (streamSocket == AUDIO_STREAM_INVALID_SOCKET) {
+        std::cout << "AudioSinkNetworkThread: unable to create a socket." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void AudioSinkNetworkThread::setSSRC(unsigned int ssrc_in) {
+    ssrc = ssrc_in;
+}
+
+void AudioSinkNetworkThread::setCodec(int codec_in) {
+    if (codec_in >= STREAM_CODEC_PCM && codec_in < STREAM_CODEC_MAX) {
+        codec = (StreamCodec)codec_in;
+    }
+}
+
+void AudioSinkNetworkThread::inputChanged(AudioThreadInput /* oldProps */, AudioThreadInputPtr newProps) {
+    resetStream(newProps);
+}
+
+void AudioSinkNetworkThread::resetStream(AudioThreadInputPtr input) {
+    //what is left of the previous format is dropped, the timestamps keep counting.
+    rtpTimestamp += clockTicks(pending.size() / std::max(channels, 1));
+    pending.clear();
+    marker = true;
+
+    sampleRate = input->sampleRate;
+    channels = std::max(input->channels, 1);
+
+    useOpus = false;
+
+#if USE_OPUS
+    if (opusEncoder) {
+        opus_encoder_destroy(opusEncoder);
+        opusEncoder = nullptr;
+    }
+
+    if (codec == STREAM_CODEC_OPUS && channels <= 2 && (sampleRate == 8000 || sampleRate == 12000 ||
+            sampleRate == 16000 || sampleRate == 24000 || sampleRate == 48000)) {
+        int error;
+        opusEncoder = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_VOIP, &error);
+        useOpus = (error == OPUS_OK);
+    }
+#endif
+
+    if (codec == STREAM_CODEC_OPUS && !useOpus) {
+        std::cout << "AudioSinkNetworkThread: no Opus for " << sampleRate << " Hz audio, streaming PCM." << std::endl;
+    }
+
+    if (useOpus) {
+        frameSize = (size_t)sampleRate * AUDIO_STREAM_OPUS_FRAME_MS / 1000;
+    } else {
+        frameSize = AUDIO_STREAM_MAX_PAYLOAD / (2 * channels);
+    }
+
+    if (pending.capacity() < frameSize * channels * 2) {
+        pending.reserve(frameSize * channels * 2);
+    }
+}
+
+unsigned int AudioSinkNetworkThread::clockTicks(size_t frames) {
+    if (useOpus && sampleRate > 0) {
+        return (unsigned int)(frames * (AUDIO_STREAM_OPUS_CLOCK / sampleRate));
+    }
+    return (unsigned int)frames;
+}
+
+void AudioSinkNetworkThread::sink(AudioThreadInputPtr input) {
+    if (streamSocket == AUDIO_STREAM_INVALID_SOCKET || input->data.empty()) {
+        return;
+    }
+
+    if (!frameSize) {
+        resetStream(input);
+    }
+
+    size_t inputFrames = input->data.size() / channels;
+    size_t packetSamples = frameSize * channels;
+
+    batchBuffer.clear();
+    packetSizes.clear();
+
+    //squelch-gated: nothing on the wire until the next transmission.
+    if (input->is_squelch_active) {
+        //but the end of the transmission, padded with silence to a whole packet.
+        if (!pending.empty()) {
+            pending.resize(packetSamples, 0.0f);
+            queuePacket(&pending[0]);
+            pending.clear();
+            sendBatch();
+        }
+        rtpTimestamp += clockTicks(inputFrames);
+        marker = true;
+        return;
+    }
+
+    pending.insert(pending.end(), input->data.begin(), input->data.begin() + inputFrames * channels);
+
+    size_t consumed = 0;
+
+    while (pending.size() - consumed >= packetSamples) {
+        queuePacket(&pending[consumed]);
+        consumed += packetSamples;
+    }
+
+    pending.erase(pending.begin(), pending.begin() + consumed);
+
+    sendBatch();
+}
+
+void AudioSinkNetworkThread::queuePacket(const float *samples) {
+    size_t start = batchBuffer.size();
+
+    batchBuffer.resize(start + AUDIO_STREAM_RTP_HEADER_SIZE + AUDIO_STREAM_MAX_PAYLOAD);
+
+    unsigned char *header = &batchBuffer[start];
+    unsigned char payloadType = useOpus ? AUDIO_STREAM_PAYLOAD_OPUS : AUDIO_STREAM_PAYLOAD_PCM;
+
+    //version 2, no padding, extension nor CSRC
+    header[0] = 0x80;
+    header[1] = (marker ? 0x80 : 0) | payloadType;
+    header[2] = (unsigned char)(sequence >> 8);
+    header[3] = (unsigned char)sequence;
+    header[4] = (unsigned char)(rtpTimestamp >> 24);
+    header[5] = (unsigned char)(rtpTimestamp >> 16);
+    header[6] = (unsigned char)(rtpTimestamp >> 8);
+    header[7] = (unsigned char)rtpTimestamp;
+    header[8] = (unsigned char)(ssrc >> 24);
+    header[9] = (unsigned char)(ssrc >> 16);
+    header[10] = (unsigned char)(ssrc >> 8);
+    header[11] = (unsigned char)ssrc;
+
+    unsigned char *payload = header + AUDIO_STREAM_RTP_HEADER_SIZE;
+    size_t payloadSize = 0;
+
+#if USE_OPUS
+    if (useOpus) {
+        opus_int32 encoded = opus_encode_float(opusEncoder, samples, (int)frameSize, payload, AUDIO_STREAM_MAX_PAYLOAD);
+        payloadSize = (encoded > 0) ? (size_t)encoded : 0;
+    }
+#endif
+
+    if (!useOpus) {
+        size_t numSamples = frameSize * channels;
+
+        for (size_t i = 0; i < numSamples; i++) {
+            float value = std::min(std::max(samples[i], -1.0f), 1.0f) * 32767.0f;
+            short pcm = (short)(value + ((value < 0) ? -0.5f : 0.5f));
+
+            payload[i * 2] = (unsigned char)((unsigned short)pcm >> 8);
+            payload[i * 2 + 1] = (unsigned char)pcm;
+        }
+        payloadSize = numSamples * 2;
+    }
+
+    rtpTimestamp += clockTicks(frameSize);
+
+    //an encoder error loses that packet only.
+    if (!payloadSize) {
+        batchBuffer.resize(start);
+        return;
+    }
+
+    sequence++;
+    marker = false;
+
+    batchBuffer.resize(start + AUDIO_STREAM_RTP_HEADER_SIZE + payloadSize);
+    packetSizes.push_back(AUDIO_STREAM_RTP_HEADER_SIZE + payloadSize);
+}
+
+void AudioSinkNetworkThread::sendBatch() {
+    if (packetSizes.empty()) {
+        return;
+    }
+
+    //UDP: a packet lost is lost, only the next ones matter.
+#if defined(__linux__)
+    if (messages.size() < packetSizes.size()) {
+        messages.resize(packetSizes.size());
+        vectors.resize(packetSizes.size());
+    }
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < packetSizes.size(); i++) {
+        vectors[i].iov_base = &batchBuffer[offset];
+        vectors[i].iov_len = packetSizes[i];
+        offset += packetSizes[i];
+
+        std::memset(&messages[i], 0, sizeof(mmsghdr));
+        messages[i].msg_hdr.msg_name = &destination;
+        messages[i].msg_hdr.msg_namelen = sizeof(destination);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+
+    while (sent < packetSizes.size()) {
+        int result = sendmmsg(streamSocket, &messages[sent], (unsigned int)(packetSizes.size() - sent), 0);
+
+        if (result <= 0) {
+            break;
+        }
+        sent += result;
+    }
+#else
+    size_t offset = 0;
+
+    for (size_t i = 0; i < packetSizes.size(); i++) {
+        sendto(streamSocket, (const char *)&batchBuffer[offset], (int)packetSizes[i], 0, (sockaddr *)&destination, sizeof(destination));
+        offset += packetSizes[i];
+    }
+#endif
+}
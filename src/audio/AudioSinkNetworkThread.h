@@ -0,0 +1,109 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include "AudioSinkThread.h"
+
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+typedef SOCKET AudioStreamSocket;
+#define AUDIO_STREAM_INVALID_SOCKET INVALID_SOCKET
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+typedef int AudioStreamSocket;
+#define AUDIO_STREAM_INVALID_SOCKET (-1)
+#endif
+
+#if USE_OPUS
+#include <opus/opus.h>
+#endif
+
+//the RTP/AVP default port.
+#define AUDIO_STREAM_DEFAULT_PORT 5004
+
+//dynamic RTP payload types: L16 at the demodulator rate, and Opus (RFC 7587).
+#define AUDIO_STREAM_PAYLOAD_PCM 96
+#define AUDIO_STREAM_PAYLOAD_OPUS 97
+
+/**
+ * Streams the audio of one demodulator over UDP as RTP, for dispatch consoles and the like:
+ * no sound device needed per channel. Every demodulator streamed has its own SSRC,
+ * so they can all share the same destination.
+ * Nothing is sent while the squelch is closed; the RTP timestamps keep counting meanwhile,
+ * and the first packet of each transmission has the marker bit set.
+ * The packets of an input block are sent in one batch.
+ */
+class AudioSinkNetworkThread : public AudioSinkThread {
+
+public:
+    AudioSinkNetworkThread();
+    ~AudioSinkNetworkThread();
+
+    enum StreamCodec {
+        STREAM_CODEC_PCM = 0, // 16 bit big endian, at the demodulator audio rate
+        STREAM_CODEC_OPUS = 1, // only available when built with USE_OPUS, 8, 12, 16, 24 or 48 kHz audio
+        STREAM_CODEC_MAX
+    };
+
+    //before the thread starts: where to send the packets, an IPv4 address.
+    bool setDestination(const std::string& address, int port);
+
+    void setSSRC(unsigned int ssrc);
+
+    //Opus falls back to PCM when not available for the audio rate.
+    void setCodec(int codec);
+
+    virtual void sink(AudioThreadInputPtr input);
+    virtual void inputChanged(AudioThreadInput oldProps, AudioThreadInputPtr newProps);
+
+protected:
+    AudioStreamSocket streamSocket = AUDIO_STREAM_INVALID_SOCKET;
+    sockaddr_in destination;
+
+    StreamCodec codec = STREAM_CODEC_PCM;
+    //the codec actually used for the current input.
+    bool useOpus = false;
+
+    int sampleRate = 0;
+    int channels = 0;
+    //frames per packet
+    size_t frameSize = 0;
+
+    unsigned int ssrc = 0;
+    unsigned short sequence = 0;
+    unsigned int rtpTimestamp = 0;
+    //next packet starts a transmission.
+    bool marker = true;
+
+    //interleaved samples not sent yet, less than a packet once an input is consumed.
+    std::vector<float> pending;
+
+    //the packets of the current batch, back to back.
+    std::vector<unsigned char> batchBuffer;
+    std::vector<size_t> packetSizes;
+
+#if defined(__linux__)
+    //sendmmsg() arguments, kept from one batch to the next.
+    std::vector<mmsghdr> messages;
+    std::vector<iovec> vectors;
+#endif
+
+#if USE_OPUS
+    OpusEncoder *opusEncoder = nullptr;
+#endif
+
+private:
+    void resetStream(AudioThreadInputPtr input);
+    //RTP clock ticks for that many frames.
+    unsigned int clockTicks(size_t frames);
+    void queuePacket(const float *samples);
+    void sendBatch();
+};
@@ -5,9 +5,10 @@
 
 #define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000) 
 
-AudioSinkThread::AudioSinkThread() {
+AudioSinkThread::AudioSinkThread(const std::string& statsName) {
     inputQueuePtr = std::make_shared<AudioThreadInputQueue>();
     inputQueuePtr->set_max_num_items(1000);
+    inputQueuePtr->set_stats_name(statsName);
     setInputQueue("input", inputQueuePtr);
 }
 
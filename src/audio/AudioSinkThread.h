@@ -9,7 +9,8 @@ class AudioSinkThread : public IOThread {
 
 public:
 
-    AudioSinkThread();
+    //statsName: of the input queue in the pipeline telemetry.
+    AudioSinkThread(const std::string& statsName = "AudioSinkInput");
     virtual ~AudioSinkThread();
 
 	virtual void run();
@@ -5,28 +5,52 @@
 #include "CubicSDRDefs.h"
 #include <vector>
 #include <algorithm>
-#include "CubicSDR.h"
 #include "DemodulatorThread.h"
 #include "DemodulatorInstance.h"
 #include <memory.h>
 #include <mutex>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_MIX_SSE 1
+#else
+#define AUDIO_MIX_SSE 0
+#endif
+
 //50 ms
 #define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000) 
 
+//stop-band attenuation [dB] of the mix resamplers
+#define MIX_RESAMPLER_AS (60.0f)
+
+//give up feeding the mix ring if the device consumes nothing for that long, 100 ms
+#define MIX_FEED_TIMEOUT_MICROS (100 * 1000)
+#define MIX_FEED_WAIT_MICROS (1000)
+
 std::map<int, AudioThread* >  AudioThread::deviceController;
 
 std::map<int, int> AudioThread::deviceSampleRate;
 
 std::recursive_mutex AudioThread::m_device_mutex;
 
-AudioThread::AudioThread() : IOThread(), nBufferFrames(1024), sampleRate(0), controllerThread(nullptr) {
+AudioThread::AudioThread() : IOThread(), mixRing(AUDIO_MIX_RING_SIZE), nBufferFrames(1024), sampleRate(0), controllerThread(nullptr) {
 
-    audioQueuePtr = 0;
     underflowCount = 0;
+    underrunCount = 0;
+    mixSources = new std::vector<AudioThread *>();
+    mixCallbackSeq = 0;
+    mixPeak = 0;
+    mixFlush = false;
+    mixResamplerReset = false;
+    mixStreaming = false;
+    mixResampler[0] = mixResampler[1] = nullptr;
+    mixResamplerInputRate = mixResamplerOutputRate = 0;
     active.store(false);
     outputDevice.store(-1);
-    gain = 1.0;
+    gain = 1.0f;
+    cmdQueue.set_stats_name("AudioThreadCommands");
+    //time from the device read to the mixing, the output buffering latency not included.
+    latencyStats = PipelineStats::getStage("AudioThread");
 }
 
 AudioThread::~AudioThread() {
@@ -43,6 +67,10 @@ AudioThread::~AudioThread() {
         delete controllerThread;
         controllerThread = nullptr;
     }
+
+    delete mixSources.exchange(nullptr);
+
+    destroyMixResampler();
 }
 
 std::recursive_mutex & AudioThread::getMutex()
@@ -61,6 +89,7 @@ void AudioThread::bindThread(AudioThread *other) {
 
     if (std::find(boundThreads.begin(), boundThreads.end(), other) == boundThreads.end()) {
         boundThreads.push_back(other);
+        publishMixSources();
     }
 }
 
@@ -72,7 +101,24 @@ void AudioThread::removeThread(AudioThread *other) {
 
     if (i != boundThreads.end()) {
         boundThreads.erase(i);
+        publishMixSources();
+    }
+}
+
+void AudioThread::publishMixSources() {
+    //called with m_mutex held: audioCallback never locks, so give it a new
+    //immutable copy of boundThreads...
+    std::vector<AudioThread *> *previous = mixSources.exchange(new std::vector<AudioThread *>(boundThreads));
+
+    //...then wait for a callback possibly still iterating the previous one to complete before releasing it.
+    unsigned int seq = mixCallbackSeq.load();
+    if (seq & 1) {
+        while (mixCallbackSeq.load() == seq) {
+            std::this_thread::yield();
+        }
     }
+
+    delete previous;
 }
 
 void AudioThread::deviceCleanup() {
@@ -88,160 +134,111 @@ void AudioThread::deviceCleanup() {
     deviceController.clear();
 }
 
+//out[i] += in[i] * gain
+static void mixAdd(float *out, const float *in, size_t n, float gain) {
+    size_t i = 0;
+#if AUDIO_MIX_SSE
+    __m128 vGain = _mm_set1_ps(gain);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), vGain)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] += in[i] * gain;
+    }
+}
+
+//out[i] *= scale
+static void mixScale(float *out, size_t n, float scale) {
+    size_t i = 0;
+#if AUDIO_MIX_SSE
+    __m128 vScale = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(out + i), vScale));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] *= scale;
+    }
+}
+
+//Real-time callback: only reads the bound threads mixRing, so it never locks nor allocates.
 static int audioCallback(void *outputBuffer, void * /* inputBuffer */, unsigned int nBufferFrames, double /* streamTime */, RtAudioStreamStatus status,
     void *userData) {
 
     float *out = (float*)outputBuffer;
+    size_t outSize = nBufferFrames * 2;
 
     //Zero output buffer in all cases: this allow to mute audio if no AudioThread data is 
     //actually active.
-    ::memset(out, 0, nBufferFrames * 2 * sizeof(float));
+    ::memset(out, 0, outSize * sizeof(float));
 
     //src in the controller thread:
     AudioThread *src = (AudioThread *)userData;
 
-    //by construction, src is a controller thread, from deviceController:
-    std::lock_guard<std::recursive_mutex> lock(src->getMutex());
-
     if (src->isTerminated()) {
         return 1;
     }
 
     if (status) {
-        std::cout << "Audio buffer underflow.." << (src->underflowCount++) << std::endl << std::flush;
+        src->underflowCount++;
     }
 
-    double peak = 0.0;
+    //enter callback, see publishMixSources()
+    src->mixCallbackSeq++;
 
-    //Process the bound threads audio:
-    for (size_t j = 0; j < src->boundThreads.size(); j++) {
-
-        AudioThread *srcmix = src->boundThreads[j];
+    std::vector<AudioThread *> *sources = src->mixSources.load();
 
-        //lock every single boundThread srcmix in succession the time we process 
-        //its audio samples.
-        std::lock_guard<std::recursive_mutex> lock(srcmix->getMutex());
+    float peak = 0.0f;
 
-        if (srcmix->isTerminated() || !srcmix->inputQueue || srcmix->inputQueue->empty() || !srcmix->isActive()) {
-            continue;
-        }
+    //Process the bound threads audio:
+    for (size_t j = 0; sources && j < sources->size(); j++) {
 
-        if (!srcmix->currentInput) {
-            srcmix->audioQueuePtr = 0;
+        AudioThread *srcmix = (*sources)[j];
 
-            if (!srcmix->inputQueue->try_pop(srcmix->currentInput)) {
-                continue;
-            }
+        if (srcmix->mixFlush.exchange(false)) {
+            srcmix->mixRing.consumeAll();
+            //the flushed samples are still in the resampler history.
+            srcmix->mixResamplerReset = true;
+        }
 
+        if (srcmix->isTerminated() || !srcmix->isActive()) {
             continue;
         }
 
-        if (srcmix->currentInput->sampleRate != src->getSampleRate()) {
-
-            while (srcmix->inputQueue->try_pop(srcmix->currentInput)) {
-
-                if (srcmix->currentInput) {
-                    if (srcmix->currentInput->sampleRate == src->getSampleRate()) {
-                        break;
-                    }
+        const float *p1, *p2;
+        size_t n1, n2;
+        size_t n = srcmix->mixRing.readRegions(outSize, p1, n1, p2, n2);
 
-                }
-                srcmix->currentInput = nullptr;
-            } //end while
-
-            srcmix->audioQueuePtr = 0;
-
-            if (!srcmix->currentInput) {
-                continue;
-            }
+        //ran short while the source was streaming: that is an underrun
+        //(this includes the tail of each transmission).
+        if (n < outSize && srcmix->mixStreaming) {
+            srcmix->underrunCount++;
         }
+        srcmix->mixStreaming = (n == outSize);
 
-
-        if (srcmix->currentInput->channels == 0 || !srcmix->currentInput->data.size()) {
-            if (!srcmix->inputQueue->empty()) {
-                srcmix->audioQueuePtr = 0;
-                if (srcmix->currentInput) {
-
-                    srcmix->currentInput = nullptr;
-                }
-
-                if (!srcmix->inputQueue->try_pop(srcmix->currentInput)) {
-                    continue;
-                }
-            }
+        if (!n) {
             continue;
         }
 
-        double mixPeak = srcmix->currentInput->peak * srcmix->gain;
-
-        if (srcmix->currentInput->channels == 1) {
-
-            for (unsigned int i = 0; i < nBufferFrames; i++) {
-
-                if (srcmix->audioQueuePtr >= srcmix->currentInput->data.size()) {
-                    srcmix->audioQueuePtr = 0;
-                    if (srcmix->currentInput) {
-
-                        srcmix->currentInput = nullptr;
-                    }
-
-                    if (!srcmix->inputQueue->try_pop(srcmix->currentInput)) {
-                        break;
-                    }
-
-
-                    double srcPeak = srcmix->currentInput->peak * srcmix->gain;
-                    if (mixPeak < srcPeak) {
-                        mixPeak = srcPeak;
-                    }
-                }
-                if (srcmix->currentInput && srcmix->currentInput->data.size()) {
-                    float v = srcmix->currentInput->data[srcmix->audioQueuePtr] * srcmix->gain;
-                    out[i * 2] += v;
-                    out[i * 2 + 1] += v;
-                }
-                srcmix->audioQueuePtr++;
-            }
-        }
-        else {
-            for (int i = 0, iMax = srcmix->currentInput->channels * nBufferFrames; i < iMax; i++) {
-
-                if (srcmix->audioQueuePtr >= srcmix->currentInput->data.size()) {
-                    srcmix->audioQueuePtr = 0;
-                    if (srcmix->currentInput) {
+        float gain = srcmix->gain.load();
 
-                        srcmix->currentInput = nullptr;
-                    }
+        mixAdd(out, p1, n1, gain);
+        mixAdd(out + n1, p2, n2, gain);
 
-                    if (!srcmix->inputQueue->try_pop(srcmix->currentInput)) {
-                        break;
-                    }
-
-                    double srcPeak = srcmix->currentInput->peak * srcmix->gain;
-                    if (mixPeak < srcPeak) {
-                        mixPeak = srcPeak;
-                    }
-                }
-                if (srcmix->currentInput && srcmix->currentInput->data.size()) {
-
-                    out[i] = out[i] + srcmix->currentInput->data[srcmix->audioQueuePtr] * srcmix->gain;
-                }
-                srcmix->audioQueuePtr++;
-            }
-        }
+        srcmix->mixRing.consume(n);
 
-        peak += mixPeak;
+        peak += srcmix->mixPeak.load() * gain;
     }
 
     //normalize volume
-    if (peak > 1.0) {
-        float invPeak = (float)(1.0 / peak);
-
-        for (unsigned int i = 0; i < nBufferFrames * 2; i++) {
-            out[i] *= invPeak;
-        }
+    if (peak > 1.0f) {
+        mixScale(out, outSize, 1.0f / peak);
     }
 
+    //exit callback
+    src->mixCallbackSeq++;
+
     return 0;
 }
 
@@ -349,14 +346,8 @@ void AudioThread::setSampleRate(int sampleRate) {
             srcmix->setSampleRate(sampleRate);  
         }
 
-        //make a local copy, snapshot of the list of demodulators
-        std::vector<DemodulatorInstancePtr> demodulators = wxGetApp().getDemodMgr().getDemodulators();
-
-        for (auto demod : demodulators) {
-            if (demod->getOutputDevice() == outputDevice.load()) {
-                demod->setAudioSampleRate(sampleRate);
-            }
-        }
+        //Demodulators keep running at their own audio rate: the bound threads
+        //resample them to the new device rate in feedMixRing(), so there is no kit to rebuild.
 
         dac.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &nBufferFrames, &audioCallback, (void *)this, &opts);
         dac.startStream();
@@ -373,6 +364,11 @@ int AudioThread::getSampleRate() {
 
 void AudioThread::setupDevice(int deviceId) {
 
+    if (deviceId == AUDIO_THREAD_NULL_DEVICE) {
+        std::cout << "Audio thread: the null device can only be set before start." << std::endl;
+        return;
+    }
+
     //global lock to setup the device...
     std::lock_guard<std::recursive_mutex> lock(m_device_mutex);
 
@@ -462,8 +458,11 @@ void AudioThread::setInitOutputDevice(int deviceId, int sampleRate) {
 
     outputDevice = deviceId;
     if (sampleRate == -1) {
-        if (deviceSampleRate.find(parameters.deviceId) != deviceSampleRate.end()) {
+        if (deviceSampleRate.find(deviceId) != deviceSampleRate.end()) {
             sampleRate = deviceSampleRate[deviceId];
+        } else if (deviceId == AUDIO_THREAD_NULL_DEVICE) {
+            sampleRate = AUDIO_THREAD_NULL_DEVICE_SAMPLE_RATE;
+            deviceSampleRate[deviceId] = sampleRate;
         }
     }
     else {
@@ -482,6 +481,11 @@ void AudioThread::run() {
 
     //    std::cout << "Audio thread initializing.." << std::endl;
 
+    if (outputDevice.load() == AUDIO_THREAD_NULL_DEVICE) {
+        runNullDevice();
+        return;
+    }
+
     if (dac.getDeviceCount() < 1) {
         std::cout << "No audio devices found!" << std::endl;
         return;
@@ -493,20 +497,30 @@ void AudioThread::run() {
 
     inputQueue = std::static_pointer_cast<AudioThreadInputQueue>(getInputQueue("AudioDataInput"));
 
-    //Infinite loop, witing for commands or for termination
+    //Infinite loop, feeding the mix ring from inputQueue, handling commands or waiting for termination
     while (!stopping) {
         AudioThreadCommand command;
 
-        if (!cmdQueue.pop(command, HEARTBEAT_CHECK_PERIOD_MICROS)) {
+        //a controller thread has no input, only wait for commands.
+        if (!inputQueue) {
+            if (cmdQueue.pop(command, HEARTBEAT_CHECK_PERIOD_MICROS)) {
+                handleCommand(command);
+            }
             continue;
         }
 
-        if (command.cmd == AudioThreadCommand::AUDIO_THREAD_CMD_SET_DEVICE) {
-            setupDevice(command.int_value);
+        while (cmdQueue.try_pop(command)) {
+            handleCommand(command);
         }
-        if (command.cmd == AudioThreadCommand::AUDIO_THREAD_CMD_SET_SAMPLE_RATE) {
-            setSampleRate(command.int_value);
+
+        AudioThreadInputPtr inp;
+
+        if (!inputQueue->pop(inp, HEARTBEAT_CHECK_PERIOD_MICROS)) {
+            continue;
         }
+
+        latencyStats->recordSince(inp->ingestTime);
+        feedMixRing(inp);
     } //end while
 
     // Drain any remaining inputs, with a non-blocking pop
@@ -514,9 +528,6 @@ void AudioThread::run() {
         inputQueue->flush();
     }
 
-    //Nullify currentInput...
-    currentInput = nullptr;
-
     //Stop : Retreive the matching controling thread in a scope lock:
     AudioThread* controllerThread = nullptr;
     {
@@ -548,14 +559,156 @@ void AudioThread::run() {
     //    std::cout << "Audio thread done." << std::endl;
 }
 
+void AudioThread::runNullDevice() {
+
+    inputQueue = std::static_pointer_cast<AudioThreadInputQueue>(getInputQueue("AudioDataInput"));
+
+    while (!stopping) {
+        AudioThreadCommand command;
+
+        //no device to switch to, only the sample rate changes apply.
+        while (cmdQueue.try_pop(command)) {
+            if (command.cmd == AudioThreadCommand::AUDIO_THREAD_CMD_SET_SAMPLE_RATE) {
+                std::lock_guard<std::recursive_mutex> lock(m_mutex);
+                sampleRate = command.int_value;
+            }
+        }
+
+        AudioThreadInputPtr inp;
+
+        if (!inputQueue) {
+            std::this_thread::sleep_for(std::chrono::microseconds(HEARTBEAT_CHECK_PERIOD_MICROS));
+        } else if (inputQueue->pop(inp, HEARTBEAT_CHECK_PERIOD_MICROS)) {
+            latencyStats->recordSince(inp->ingestTime);
+        }
+    }
+
+    if (inputQueue != nullptr) {
+        inputQueue->flush();
+    }
+}
+
+void AudioThread::handleCommand(AudioThreadCommand &command) {
+
+    if (command.cmd == AudioThreadCommand::AUDIO_THREAD_CMD_SET_DEVICE) {
+        setupDevice(command.int_value);
+    }
+    if (command.cmd == AudioThreadCommand::AUDIO_THREAD_CMD_SET_SAMPLE_RATE) {
+        setSampleRate(command.int_value);
+    }
+}
+
+void AudioThread::destroyMixResampler() {
+
+    for (int c = 0; c < 2; c++) {
+        if (mixResampler[c]) {
+            msresamp_rrrf_destroy(mixResampler[c]);
+            mixResampler[c] = nullptr;
+        }
+    }
+    mixResamplerInputRate = mixResamplerOutputRate = 0;
+}
+
+void AudioThread::feedMixRing(AudioThreadInputPtr inp) {
+
+    if (!inp || inp->channels == 0 || !inp->data.size()) {
+        return;
+    }
+
+    int outputRate = getSampleRate();
+
+    if (inp->sampleRate <= 0 || outputRate <= 0) {
+        return;
+    }
+
+    size_t channels = (inp->channels == 1) ? 1 : 2;
+    size_t frames = inp->data.size() / channels;
+
+    if (inp->sampleRate == outputRate) {
+        //convert to interleaved stereo
+        if (channels == 1) {
+            mixFeedBuffer.resize(frames * 2);
+
+            for (size_t i = 0; i < frames; i++) {
+                mixFeedBuffer[i * 2] = mixFeedBuffer[i * 2 + 1] = inp->data[i];
+            }
+        } else {
+            mixFeedBuffer.assign(inp->data.begin(), inp->data.begin() + frames * 2);
+        }
+    } else {
+        //the source runs at its own rate: resample it to the device rate instead of
+        //dropping it until the demodulator is rebuilt.
+        if (mixResamplerInputRate != inp->sampleRate || mixResamplerOutputRate != outputRate) {
+            destroyMixResampler();
+
+            float ratio = float(double(outputRate) / double(inp->sampleRate));
+
+            mixResampler[0] = msresamp_rrrf_create(ratio, MIX_RESAMPLER_AS);
+            mixResampler[1] = msresamp_rrrf_create(ratio, MIX_RESAMPLER_AS);
+            mixResamplerInputRate = inp->sampleRate;
+            mixResamplerOutputRate = outputRate;
+        }
+
+        if (mixResamplerReset.exchange(false)) {
+            msresamp_rrrf_reset(mixResampler[0]);
+            msresamp_rrrf_reset(mixResampler[1]);
+        }
+
+        size_t outMax = (size_t)ceil(double(frames) * double(outputRate) / double(inp->sampleRate)) + 512;
+        unsigned int numWritten = 0;
+
+        mixResampleInput.resize(frames);
+
+        for (size_t c = 0; c < channels; c++) {
+            for (size_t i = 0; i < frames; i++) {
+                mixResampleInput[i] = inp->data[i * channels + c];
+            }
+
+            if (mixResampleOutput[c].size() < outMax) {
+                mixResampleOutput[c].resize(outMax);
+            }
+
+            msresamp_rrrf_execute(mixResampler[c], &mixResampleInput[0], (unsigned int)frames, &mixResampleOutput[c][0], &numWritten);
+        }
+
+        const std::vector<float> &left = mixResampleOutput[0];
+        const std::vector<float> &right = mixResampleOutput[channels - 1];
+
+        mixFeedBuffer.resize(numWritten * 2);
+
+        for (size_t i = 0; i < numWritten; i++) {
+            mixFeedBuffer[i * 2] = left[i];
+            mixFeedBuffer[i * 2 + 1] = right[i];
+        }
+    }
+
+    mixPeak.store(inp->peak);
+
+    size_t written = 0, total = mixFeedBuffer.size();
+    int waited = 0;
+
+    //the ring is a bounded buffer: wait for the callback to make room, but never for a device
+    //that is not consuming.
+    while (written < total && !stopping) {
+        written += mixRing.write(mixFeedBuffer.data() + written, total - written);
+
+        if (written < total) {
+            if (!active.load() || waited >= MIX_FEED_TIMEOUT_MICROS) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(MIX_FEED_WAIT_MICROS));
+            waited += MIX_FEED_WAIT_MICROS;
+        }
+    }
+}
+
 void AudioThread::terminate() {
     IOThread::terminate();
 }
 
 bool AudioThread::isActive() {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-
-    return active;
+    //lock-free, also used by audioCallback
+    return active.load();
 }
 
 void AudioThread::setActive(bool state) {
@@ -589,6 +742,7 @@ void AudioThread::setActive(bool state) {
     if (inputQueue) {
         inputQueue->flush();
     }
+    mixFlush = true;
     active = state;
 }
 
@@ -606,3 +760,7 @@ void AudioThread::setGain(float gain_in) {
     }
     gain = gain_in;
 }
+
+size_t AudioThread::getUnderrunCount() {
+    return underrunCount.load();
+}
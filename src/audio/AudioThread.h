@@ -10,6 +10,7 @@
 #include <atomic>
 #include <memory>
 #include "ThreadBlockingQueue.h"
+#include "SPSCRingBuffer.h"
 #include "RtAudio.h"
 #include "DemodDefs.h"
 
@@ -20,13 +21,18 @@ public:
     int sampleRate;
     int channels;
     float peak;
+    float rms;
     int type;
     bool is_squelch_active;
+    //PipelineStats::now() when the source samples were read from the device, 0 if unknown.
+    long long ingestTime;
+    //of the first frame of data, the demodulator delay accounted for.
+    IQTimestamp timestamp;
 
     std::vector<float> data;
 
     AudioThreadInput() :
-        frequency(0), inputRate(0), sampleRate(0), channels(0), peak(0), type(0), is_squelch_active(false) {
+        frequency(0), inputRate(0), sampleRate(0), channels(0), peak(0), rms(0), type(0), is_squelch_active(false), ingestTime(0) {
 
     }
 
@@ -41,8 +47,11 @@ public:
         sampleRate = copyFrom->sampleRate;
         channels = copyFrom->channels;
         peak = copyFrom->peak;
+        rms = copyFrom->rms;
         type = copyFrom->type;
         is_squelch_active = copyFrom->is_squelch_active;
+        ingestTime = copyFrom->ingestTime;
+        timestamp = copyFrom->timestamp;
         data.assign(copyFrom->data.begin(), copyFrom->data.end());
     }
 
@@ -78,6 +87,14 @@ typedef ThreadBlockingQueue<AudioThreadCommand> AudioThreadCommandQueue;
 typedef std::shared_ptr<AudioThreadInputQueue> AudioThreadInputQueuePtr;
 typedef std::shared_ptr<AudioThreadCommandQueue> AudioThreadCommandQueuePtr;
 
+//Size of the per-source mix ring, in interleaved stereo floats (~340 ms at 48 kHz)
+#define AUDIO_MIX_RING_SIZE (32768)
+
+//output device id of an AudioThread without any device: its inputs are consumed and dropped.
+//For the headless server without audio hardware and the benchmark. Only set before run().
+#define AUDIO_THREAD_NULL_DEVICE (-2)
+#define AUDIO_THREAD_NULL_DEVICE_SAMPLE_RATE (48000)
+
 class AudioThread : public IOThread {
 
 public:
@@ -100,6 +117,9 @@ public:
 
     void setGain(float gain_in);
 
+    //number of times the audio callback ran short of samples from this source.
+    size_t getUnderrunCount();
+
     static std::map<int, int> deviceSampleRate;
 
     AudioThreadCommandQueue *getCommandQueue();
@@ -114,13 +134,26 @@ public:
     void attachControllerThread(std::thread* controllerThread);
 
     //fields below, only to be used by other AudioThreads !
-    size_t underflowCount;
+    std::atomic<size_t> underflowCount;
     //protected by m_mutex
     std::vector<AudioThread *> boundThreads;
     AudioThreadInputQueuePtr inputQueue;
-    AudioThreadInputPtr currentInput;
-    size_t audioQueuePtr;
-    float gain;
+    std::atomic<float> gain;
+
+    //Real-time mixing state, read by the controller audioCallback without any lock:
+    //immutable copy of boundThreads, republished by bindThread()/removeThread().
+    std::atomic<std::vector<AudioThread *> *> mixSources;
+    //odd while audioCallback is running, so that a replaced mixSources can be safely released.
+    std::atomic<unsigned int> mixCallbackSeq;
+    //interleaved stereo samples, written by run() and read by audioCallback.
+    SPSCRingBuffer<float> mixRing;
+    std::atomic<float> mixPeak;
+    std::atomic_bool mixFlush;
+    //set by audioCallback on a flush, for run() to reset the mixResampler it owns.
+    std::atomic_bool mixResamplerReset;
+    std::atomic<size_t> underrunCount;
+    //only touched by audioCallback
+    bool mixStreaming;
 
 private:
 
@@ -133,6 +166,7 @@ private:
     RtAudio::StreamParameters parameters;
     AudioThreadCommandQueue cmdQueue;
     int sampleRate;
+    std::shared_ptr<LatencyStats> latencyStats;
 
     //if != nullptr, it mean AudioThread is a controller thread.
     std::thread* controllerThread;
@@ -145,6 +179,21 @@ private:
 
     void bindThread(AudioThread *other);
     void removeThread(AudioThread *other);
+    void publishMixSources();
+
+    void handleCommand(AudioThreadCommand &command);
+    void runNullDevice();
+    void feedMixRing(AudioThreadInputPtr inp);
+    void destroyMixResampler();
+
+    //interleaved stereo conversion of the current input, before it is written into mixRing.
+    std::vector<float> mixFeedBuffer;
+
+    //streaming resampling of this source into the device sample rate, one per channel.
+    msresamp_rrrf mixResampler[2];
+    int mixResamplerInputRate, mixResamplerOutputRate;
+    std::vector<float> mixResampleInput;
+    std::vector<float> mixResampleOutput[2];
 
     static std::map<int, AudioThread* > deviceController;
 
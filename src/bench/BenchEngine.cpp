@@ -0,0 +1,58 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "BenchEngine.h"
+
+#include <iostream>
+
+BenchEngine::BenchEngine(long long frequency, long long sampleRate) : frequency(frequency), sampleRate(sampleRate) {
+    SDREngine::set(this);
+}
+
+BenchEngine::~BenchEngine() {
+
+}
+
+AppConfig *BenchEngine::getConfig() {
+    return &config;
+}
+
+DemodulatorMgr &BenchEngine::getDemodMgr() {
+    return demodMgr;
+}
+
+void BenchEngine::setFrequency(long long freq) {
+    frequency = freq;
+}
+
+long long BenchEngine::getFrequency() {
+    return frequency;
+}
+
+long long BenchEngine::getSampleRate() {
+    return sampleRate;
+}
+
+bool BenchEngine::getSoloMode() {
+    return false;
+}
+
+bool BenchEngine::getUseLocalMod() {
+    return false;
+}
+
+std::string BenchEngine::getModulePath() {
+    return "";
+}
+
+void BenchEngine::sdrThreadNotify(SDRThread::SDRThreadState /* state */, std::string message) {
+    if (!message.empty()) {
+        std::cout << message << std::endl;
+    }
+}
+
+void BenchEngine::sdrEnumThreadNotify(SDREnumerator::SDREnumState /* state */, std::string message) {
+    if (!message.empty()) {
+        std::cout << message << std::endl;
+    }
+}
@@ -0,0 +1,41 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "SDREngine.h"
+
+/**
+ * The least SDREngine to run the processing pipeline on synthetic or recorded IQ:
+ * no device, no window, nobody to notify. The configuration is the default one, never saved.
+ */
+class BenchEngine : public SDREngine {
+public:
+    BenchEngine(long long frequency, long long sampleRate);
+    virtual ~BenchEngine();
+
+    //SDREngine
+    AppConfig *getConfig();
+    DemodulatorMgr &getDemodMgr();
+
+    void setFrequency(long long freq);
+    long long getFrequency();
+    long long getSampleRate();
+    bool getSoloMode();
+
+    bool getUseLocalMod();
+    std::string getModulePath();
+
+    void sdrThreadNotify(SDRThread::SDRThreadState state, std::string message);
+    void sdrEnumThreadNotify(SDREnumerator::SDREnumState state, std::string message);
+
+private:
+    AppConfig config;
+    DemodulatorMgr demodMgr;
+
+    std::atomic_llong frequency;
+    std::atomic_llong sampleRate;
+};
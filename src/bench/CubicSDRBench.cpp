@@ -0,0 +1,773 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include <wx/init.h>
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "BenchEngine.h"
+#include "SDRPostThread.h"
+#include "SpectrumVisualProcessor.h"
+#include "FFTDataDistributor.h"
+#include "PipelineStats.h"
+#include "DataTree.h"
+#include "Modem.h"
+#include "ADSBDecoder.hpp"
+
+//IQ blocks fed per second of stream, as SDRThread reads them.
+#define BENCH_BLOCKS_PER_SECOND 60
+
+//length of the looping synthetic IQ: its tones are multiples of 1 / BENCH_SYNTHETIC_SECONDS Hz, so that it loops seamlessly.
+#define BENCH_SYNTHETIC_SECONDS 0.1
+
+//the demodulators build their modem on the first samples: not measured.
+#define BENCH_WARMUP_SECONDS 1
+
+//without --realtime, how long a block waits for the post-processing to take it.
+#define BENCH_PUSH_TIMEOUT_MICROS (100 * 1000)
+
+#define BENCH_CENTER_FREQUENCY 100000000LL
+
+#define BENCH_DATATREE_LOADS 5
+#define BENCH_DATATREE_GROUP_SIZE 50
+
+//a synthetic ADS-B frame every BENCH_ADSB_FRAME_SPACING samples, decoded BENCH_ADSB_PASSES times.
+#define BENCH_ADSB_FRAME_SPACING 1000
+#define BENCH_ADSB_PASSES 20
+
+//every C++ allocation of the process, for the allocations per second. The C allocations of liquid-dsp are not seen.
+static std::atomic_ullong allocationCount(0);
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+static const wxCmdLineEntryDesc commandLineInfo [] =
+{
+    { wxCMD_LINE_SWITCH, "h", "help", "Command line parameter help", wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "r", "rate", "IQ sample rate. Default: 2500000.", wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, "n", "demods", "Demodulators of each analog type. Default: 1.", wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, "t", "time", "Measured duration, in seconds. Default: 10.", wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, "i", "input", "Recorded IQ to loop over instead of the synthetic one.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "f", "format", "Format of the recorded IQ: cf32 (interleaved floats) or cu8 (rtl_sdr). Default: cf32.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_SWITCH, "R", "realtime", "Feed the IQ at the sample rate, dropping what the pipeline does not take, instead of as fast as it takes it.", wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_OPTION, "b", "bookmarks", "Bookmarks of the generated bookmark file. Default: 10000.", wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, "a", "adsb-input", "Recorded ADS-B magnitudes at 2 MS/s (floats) instead of synthetic frames.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "o", "output", "JSON report file. Default: stdout.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_NONE }
+};
+
+class BenchOptions {
+public:
+    BenchOptions() : sampleRate(DEFAULT_SAMPLE_RATE), demodsPerType(1), seconds(10), realtime(false), bookmarks(10000) {
+    }
+
+    long long sampleRate;
+    int demodsPerType;
+    int seconds;
+    std::string inputFile;
+    std::string inputFormat;
+    bool realtime;
+    int bookmarks;
+    std::string adsbInputFile;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * The spectrum and waterfall processing of the main view, as SpectrumVisualDataThread and FFTVisualDataThread
+ * do it, in a single thread: the visual data is counted and dropped instead of being drawn.
+ */
+class BenchVisualThread : public IOThread {
+public:
+    BenchVisualThread() : spectrumLines(0), waterfallLines(0) {
+        fftQueue = std::make_shared<DemodulatorThreadInputQueue>();
+        fftQueue->set_max_num_items(100);
+        fftQueue->set_stats_name("WaterfallFFTData");
+
+        spectrumOut = std::make_shared<SpectrumVisualDataQueue>();
+        spectrumOut->set_max_num_items(1);
+        spectrumOut->set_stats_name("SpectrumVisualData");
+
+        waterfallOut = std::make_shared<SpectrumVisualDataQueue>();
+        waterfallOut->set_max_num_items(100);
+        waterfallOut->set_stats_name("WaterfallVisualData");
+    }
+
+    virtual void run() {
+        DemodulatorThreadInputQueuePtr pipeIQVisualIn = std::static_pointer_cast<DemodulatorThreadInputQueue>(getInputQueue("IQVisualDataInput"));
+        DemodulatorThreadInputQueuePtr pipeIQDataIn = std::static_pointer_cast<DemodulatorThreadInputQueue>(getInputQueue("IQDataInput"));
+
+        sproc.setInput(pipeIQVisualIn);
+        sproc.attachOutput(spectrumOut);
+        sproc.setup(DEFAULT_FFT_SIZE);
+
+        fftDistrib.setInput(pipeIQDataIn);
+        fftDistrib.attachOutput(fftQueue);
+        fftDistrib.setLinesPerSecond(DEFAULT_WATERFALL_LPS);
+
+        wproc.setInput(fftQueue);
+        wproc.attachOutput(waterfallOut);
+        wproc.setup(DEFAULT_FFT_SIZE);
+
+        SpectrumVisualDataPtr visualData;
+
+        while (!stopping) {
+            std::this_thread::sleep_for(std::chrono::milliseconds((int)(FFT_DISTRIBUTOR_BUFFER_IN_SECONDS * 1000.0 / 25.0)));
+
+            sproc.run();
+
+            int fftSize = wproc.getDesiredInputSize();
+            fftDistrib.setFFTSize(fftSize ? fftSize : DEFAULT_FFT_SIZE * SPECTRUM_VZM);
+            fftDistrib.run();
+
+            while (!stopping && !wproc.isInputEmpty()) {
+                wproc.run();
+            }
+
+            while (spectrumOut->try_pop(visualData)) {
+                spectrumLines++;
+            }
+            while (waterfallOut->try_pop(visualData)) {
+                waterfallLines++;
+            }
+        }
+
+        pipeIQVisualIn->flush();
+        pipeIQDataIn->flush();
+    }
+
+    virtual void terminate() {
+        IOThread::terminate();
+        sproc.flushQueues();
+        fftDistrib.flushQueues();
+        wproc.flushQueues();
+    }
+
+    std::atomic_ullong spectrumLines, waterfallLines;
+
+private:
+    SpectrumVisualProcessor sproc, wproc;
+    FFTDataDistributor fftDistrib;
+
+    DemodulatorThreadInputQueuePtr fftQueue;
+    SpectrumVisualDataQueuePtr spectrumOut, waterfallOut;
+};
+
+//a tone at each demodulator offset over white noise.
+static void makeSyntheticIQ(long long sampleRate, const std::vector<long long>& offsets, std::vector<liquid_float_complex>& iq) {
+    size_t numSamples = (size_t)(sampleRate * BENCH_SYNTHETIC_SECONDS);
+
+    std::mt19937 generator(1);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+
+    float amplitude = 0.5f / (float)std::max((size_t)1, offsets.size());
+
+    iq.resize(numSamples);
+
+    for (size_t i = 0; i < numSamples; i++) {
+        double re = noise(generator), im = noise(generator);
+
+        for (long long offset : offsets) {
+            double phase = 2.0 * M_PI * (double)offset * (double)i / (double)sampleRate;
+            re += amplitude * cos(phase);
+            im += amplitude * sin(phase);
+        }
+
+        iq[i].real = (float)re;
+        iq[i].imag = (float)im;
+    }
+}
+
+static bool loadIQFile(const std::string& fileName, const std::string& format, std::vector<liquid_float_complex>& iq) {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+    if (!file.is_open()) {
+        std::cout << "Unable to open '" << fileName << "'." << std::endl;
+        return false;
+    }
+
+    std::vector<char> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (format == "cu8") {
+        iq.resize(raw.size() / 2);
+        for (size_t i = 0; i < iq.size(); i++) {
+            iq[i].real = ((float)(unsigned char)raw[2 * i] - 127.5f) / 127.5f;
+            iq[i].imag = ((float)(unsigned char)raw[2 * i + 1] - 127.5f) / 127.5f;
+        }
+    } else if (format == "cf32") {
+        iq.resize(raw.size() / (2 * sizeof(float)));
+        for (size_t i = 0; i < iq.size(); i++) {
+            float sample[2];
+            ::memcpy(sample, &raw[i * sizeof(sample)], sizeof(sample));
+            iq[i].real = sample[0];
+            iq[i].imag = sample[1];
+        }
+    } else {
+        std::cout << "Unknown IQ format '" << format << "', use cf32 or cu8." << std::endl;
+        return false;
+    }
+
+    if (iq.empty()) {
+        std::cout << "No IQ in '" << fileName << "'." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+//the SDRPostThread, the spectrum and waterfall processing and the demodulators, fed with looping IQ and playing to no audio device.
+static bool runPipelineBench(const BenchOptions& options, std::ostream& json) {
+    static const char *demodTypes[] = { "FM", "NBFM", "FMS", "AM", "LSB", "USB", "DSB", "I/Q" };
+    const int numTypes = sizeof(demodTypes) / sizeof(demodTypes[0]);
+
+    BenchEngine engine(BENCH_CENTER_FREQUENCY, options.sampleRate);
+    SDREngine::registerModems();
+
+    //demodulators evenly spread over 80% of the band, away from DC, on the synthetic IQ tone grid.
+    int numDemods = numTypes * options.demodsPerType;
+    long long toneStep = (long long)(1.0 / BENCH_SYNTHETIC_SECONDS);
+    std::vector<long long> offsets;
+
+    for (int i = 0; i < numDemods; i++) {
+        double offset = ((double)i + 0.5) / (double)numDemods * 0.8 * options.sampleRate - 0.4 * options.sampleRate;
+        offsets.push_back((long long)(offset / toneStep) * toneStep);
+    }
+
+    std::vector<liquid_float_complex> source;
+
+    if (options.inputFile.empty()) {
+        makeSyntheticIQ(options.sampleRate, offsets, source);
+    } else if (!loadIQFile(options.inputFile, options.inputFormat, source)) {
+        return false;
+    }
+
+    SDRThreadIQDataQueuePtr pipeSDRIQData = std::make_shared<SDRThreadIQDataQueue>();
+    pipeSDRIQData->set_max_num_items(100);
+    pipeSDRIQData->set_stats_name("SDRIQData");
+
+    DemodulatorThreadInputQueuePtr pipeIQVisualData = std::make_shared<DemodulatorThreadInputQueue>();
+    pipeIQVisualData->set_max_num_items(1);
+    pipeIQVisualData->set_stats_name("SpectrumIQVisualData");
+
+    DemodulatorThreadInputQueuePtr pipeWaterfallIQVisualData = std::make_shared<DemodulatorThreadInputQueue>();
+    pipeWaterfallIQVisualData->set_max_num_items(128);
+    pipeWaterfallIQVisualData->set_stats_name("WaterfallIQVisualData");
+
+    SDRPostThread *sdrPostThread = new SDRPostThread();
+    sdrPostThread->setInputQueue("IQDataInput", pipeSDRIQData);
+    sdrPostThread->setOutputQueue("IQVisualDataOutput", pipeIQVisualData);
+    sdrPostThread->setOutputQueue("IQDataOutput", pipeWaterfallIQVisualData);
+
+    BenchVisualThread *visualThread = new BenchVisualThread();
+    visualThread->setInputQueue("IQVisualDataInput", pipeIQVisualData);
+    visualThread->setInputQueue("IQDataInput", pipeWaterfallIQVisualData);
+
+    std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+
+    std::thread *t_PostSDR = new std::thread(&SDRPostThread::threadMain, sdrPostThread);
+    std::thread *t_Visual = new std::thread(&BenchVisualThread::threadMain, visualThread);
+
+    DemodulatorMgr &demodMgr = engine.getDemodMgr();
+
+    for (int i = 0; i < numDemods; i++) {
+        std::string demodType = demodTypes[i % numTypes];
+
+        DemodulatorInstancePtr demod = demodMgr.newThread();
+
+        demod->setDemodulatorType(demodType);
+        demod->setBandwidth(Modem::getModemDefaultSampleRate(demodType));
+        demod->setFrequency(engine.getFrequency() + offsets[i]);
+        demod->setOutputDevice(AUDIO_THREAD_NULL_DEVICE);
+        demod->run();
+        demod->setActive(true);
+    }
+
+    sdrPostThread->notifyDemodulatorsChanged();
+
+    int numChannels = SDRThread::getOptimalChannelCount(options.sampleRate);
+    size_t blockSize = (size_t)(ceil(floor((double)options.sampleRate / BENCH_BLOCKS_PER_SECOND) / numChannels) * numChannels);
+
+    ReBuffer<SDRThreadIQData> buffers("BenchIQBuffers");
+    buffers.reserve(SDR_POST_BUFFERS_RESERVE, [blockSize](SDRThreadIQData& buffer) {
+        buffer.data.reserve(blockSize);
+    });
+
+    long long sampleIndex = 0;
+    size_t sourcePos = 0;
+
+    long long measuredSamples = 0;
+    unsigned long long measuredBlocks = 0;
+    unsigned long long droppedBlocks = 0;
+    unsigned long long measuredAllocations = 0;
+    double measuredSeconds = 0;
+
+    bool measuring = false;
+    std::chrono::steady_clock::time_point feedStart = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point measureStart = feedStart;
+
+    while (true) {
+        double elapsed = secondsSince(feedStart);
+
+        if (!measuring && elapsed >= BENCH_WARMUP_SECONDS) {
+            PipelineStats::reset();
+            allocationCount.store(0);
+            measureStart = std::chrono::steady_clock::now();
+            measuring = true;
+        }
+
+        if (measuring && secondsSince(measureStart) >= options.seconds) {
+            measuredSeconds = secondsSince(measureStart);
+            measuredAllocations = allocationCount.load();
+            break;
+        }
+
+        SDRThreadIQDataPtr dataOut = buffers.getBuffer();
+
+        dataOut->frequency = engine.getFrequency();
+        dataOut->sampleRate = options.sampleRate;
+        dataOut->dcCorrected = true;
+        dataOut->numChannels = numChannels;
+        dataOut->sampleIndex = sampleIndex;
+        dataOut->retuneIndex = 0;
+
+        dataOut->timestamp = IQTimestamp();
+        dataOut->timestamp.sampleIndex = sampleIndex;
+        dataOut->timestamp.deviceSampleRate = options.sampleRate;
+        dataOut->timestamp.hostTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        dataOut->data.resize(blockSize);
+        for (size_t i = 0; i < blockSize; i++) {
+            dataOut->data[i] = source[sourcePos];
+            sourcePos = (sourcePos + 1) % source.size();
+        }
+
+        bool pushed;
+
+        if (options.realtime) {
+            //at the device pace: the block is due once the previous ones have been "received".
+            std::this_thread::sleep_until(feedStart + std::chrono::microseconds((long long)((double)sampleIndex * 1000000.0 / options.sampleRate)));
+
+            dataOut->ingestTime = PipelineStats::now();
+            pushed = pipeSDRIQData->try_push(dataOut);
+        } else {
+            dataOut->ingestTime = PipelineStats::now();
+            pushed = pipeSDRIQData->push(dataOut, BENCH_PUSH_TIMEOUT_MICROS);
+        }
+
+        sampleIndex += blockSize;
+
+        if (measuring) {
+            if (pushed) {
+                measuredSamples += blockSize;
+                measuredBlocks++;
+            } else {
+                droppedBlocks++;
+            }
+        }
+    }
+
+    std::string pipelineStats = PipelineStats::toJSON();
+
+    unsigned long long spectrumLines = visualThread->spectrumLines.load();
+    unsigned long long waterfallLines = visualThread->waterfallLines.load();
+
+    //same order as CubicSDR::OnExit(): the thread feeding all the others first.
+    sdrPostThread->terminate();
+    sdrPostThread->isTerminated(3000);
+
+    visualThread->terminate();
+    visualThread->isTerminated(3000);
+
+    std::vector<DemodulatorInstancePtr> demods = demodMgr.getDemodulators();
+
+    for (auto demod : demods) {
+        demod->terminate();
+    }
+
+    std::vector<long long> demodCPUTimes;
+
+    for (auto demod : demods) {
+        std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+
+        while (!demod->isTerminated() && secondsSince(waitStart) < 3) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        demodCPUTimes.push_back(demod->getCPUTime());
+    }
+
+    double runSeconds = secondsSince(runStart);
+
+    demodMgr.terminateAll();
+
+    t_PostSDR->join();
+    delete t_PostSDR;
+
+    t_Visual->join();
+    delete t_Visual;
+
+    long long postCPUTime = sdrPostThread->getCPUTime();
+    long long visualCPUTime = visualThread->getCPUTime();
+
+    delete sdrPostThread;
+    delete visualThread;
+
+    AudioThread::deviceCleanup();
+
+    //the CPU times cover the whole run, warm-up included.
+    double runMicros = runSeconds * 1000000.0;
+
+    json << "  \"pipeline\": {" << std::endl;
+    json << "    \"input\": \"" << (options.inputFile.empty() ? std::string("synthetic") : options.inputFormat) << "\"," << std::endl;
+    json << "    \"realtime\": " << (options.realtime ? "true" : "false") << "," << std::endl;
+    json << "    \"sample_rate\": " << options.sampleRate << "," << std::endl;
+    json << "    \"channels\": " << numChannels << "," << std::endl;
+    json << "    \"block_size\": " << blockSize << "," << std::endl;
+    json << "    \"seconds\": " << measuredSeconds << "," << std::endl;
+    json << "    \"samples\": " << measuredSamples << "," << std::endl;
+    json << "    \"samples_per_second\": " << (long long)(measuredSamples / measuredSeconds) << "," << std::endl;
+    json << "    \"dropped_blocks\": " << droppedBlocks << "," << std::endl;
+    json << "    \"allocations\": " << measuredAllocations << "," << std::endl;
+    json << "    \"allocations_per_second\": " << (long long)(measuredAllocations / measuredSeconds) << "," << std::endl;
+    //of the whole pipeline, visuals included, per block fed.
+    json << "    \"allocations_per_block\": " << (measuredBlocks ? (double)measuredAllocations / (double)measuredBlocks : 0.0) << "," << std::endl;
+    json << "    \"spectrum_lines\": " << spectrumLines << "," << std::endl;
+    json << "    \"waterfall_lines\": " << waterfallLines << "," << std::endl;
+    json << "    \"post_cpu_percent\": " << 100.0 * postCPUTime / runMicros << "," << std::endl;
+    json << "    \"visual_cpu_percent\": " << 100.0 * visualCPUTime / runMicros << "," << std::endl;
+
+    json << "    \"demodulators\": [";
+    for (size_t i = 0; i < demods.size(); i++) {
+        json << (i ? "," : "") << std::endl << "      { \"type\": \"" << demods[i]->getDemodulatorType() << "\""
+            << ", \"frequency\": " << demods[i]->getFrequency()
+            << ", \"bandwidth\": " << demods[i]->getBandwidth()
+            << ", \"cpu_us\": " << demodCPUTimes[i]
+            << ", \"cpu_percent\": " << 100.0 * demodCPUTimes[i] / runMicros << " }";
+    }
+    json << std::endl << "    ]," << std::endl;
+
+    json << "    \"stats\": " << pipelineStats;
+    json << "  }";
+
+    return true;
+}
+
+//a bookmark file as BookmarkMgr writes it, 'bookmarks' modems by groups of BENCH_DATATREE_GROUP_SIZE.
+static void makeBookmarkTree(int bookmarks, DataTree& s) {
+    static const char *demodTypes[] = { "FM", "NBFM", "AM", "LSB", "USB" };
+
+    DataNode *modems = s.rootNode()->newChild("modems");
+    DataNode *group = nullptr;
+
+    for (int i = 0; i < bookmarks; i++) {
+        if (i % BENCH_DATATREE_GROUP_SIZE == 0) {
+            std::stringstream groupName;
+            groupName << "Group " << (i / BENCH_DATATREE_GROUP_SIZE);
+
+            group = modems->newChild("group");
+            *group->newChild("@name") = groupName.str();
+            *group->newChild("@expanded") = std::string("true");
+        }
+
+        std::wstringstream label;
+        label << L"Bookmark " << i;
+
+        DataNode *node = group->newChild("modem");
+
+        *node->newChild("bandwidth") = 12500;
+        *node->newChild("frequency") = 88000000LL + 12500LL * i;
+        *node->newChild("type") = std::string(demodTypes[i % 5]);
+        node->newChild("user_label")->element()->set(label.str());
+        *node->newChild("squelch_level") = -100.0f;
+        *node->newChild("squelch_enabled") = 0;
+        *node->newChild("output_device") = std::string("default");
+        *node->newChild("gain") = 1.0f;
+        *node->newChild("muted") = 0;
+    }
+}
+
+//best of BENCH_DATATREE_LOADS loads, in milliseconds, or -1 if the file did not load.
+template <typename LoadFn>
+static double bestLoadTime(LoadFn load) {
+    double best = -1;
+
+    for (int i = 0; i < BENCH_DATATREE_LOADS; i++) {
+        DataTree l;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        if (!load(l) || l.rootNode()->getName() != "cubicsdr_bookmarks") {
+            return -1;
+        }
+
+        double loadTime = secondsSince(start) * 1000.0;
+        if (best < 0 || loadTime < best) {
+            best = loadTime;
+        }
+    }
+
+    return best;
+}
+
+static long long fileSize(const std::string& fileName) {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    return file.is_open() ? (long long)file.tellg() : -1;
+}
+
+//the loads of a bookmark file: XML as a whole, XML streamed, and the binary cache.
+static void runDataTreeBench(const BenchOptions& options, std::ostream& json) {
+    wxFileName xmlFile(wxFileName::GetTempDir(), "cubicsdr_bench_bookmarks.xml");
+    std::string xmlPath = xmlFile.GetFullPath().ToStdString();
+    std::string binaryPath = xmlPath + ".bin";
+
+    {
+        DataTree s("cubicsdr_bookmarks");
+        makeBookmarkTree(options.bookmarks, s);
+        s.SaveToFileXML(xmlPath);
+        s.SaveToFileBinary(binaryPath);
+    }
+
+    double xmlTime = bestLoadTime([&](DataTree& l) { return l.LoadFromFileXML(xmlPath); });
+    double xmlStreamTime = bestLoadTime([&](DataTree& l) { return l.LoadFromFileXMLStream(xmlPath); });
+    double binaryTime = bestLoadTime([&](DataTree& l) { return l.LoadFromFileBinary(binaryPath); });
+
+    json << "  \"datatree\": {" << std::endl;
+    json << "    \"bookmarks\": " << options.bookmarks << "," << std::endl;
+    json << "    \"xml_bytes\": " << fileSize(xmlPath) << "," << std::endl;
+    json << "    \"binary_bytes\": " << fileSize(binaryPath) << "," << std::endl;
+    json << "    \"xml_load_ms\": " << xmlTime << "," << std::endl;
+    json << "    \"xml_stream_load_ms\": " << xmlStreamTime << "," << std::endl;
+    json << "    \"binary_load_ms\": " << binaryTime << std::endl;
+    json << "  }";
+
+    std::remove(xmlPath.c_str());
+    std::remove(binaryPath.c_str());
+}
+
+//DF17 frames with a valid parity, each behind its preamble, over a low noise floor.
+static void makeSyntheticADSB(std::vector<float>& magnitudes) {
+    using namespace adsb_decoder;
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> noise(0.0f, 0.05f);
+    std::bernoulli_distribution coin(0.5);
+
+    magnitudes.resize(BUFFER_THRESHOLD);
+    for (float& m : magnitudes) {
+        m = noise(generator);
+    }
+
+    for (size_t pos = 0; pos + SAMPLES_PER_PACKET < magnitudes.size(); pos += BENCH_ADSB_FRAME_SPACING) {
+        BitVector bits{};
+
+        //downlink format 17
+        bits[0] = true;
+        bits[4] = true;
+        for (size_t i = 5; i < BITS_PER_FRAME - 24; i++) {
+            bits[i] = coin(generator);
+        }
+
+        //with a zero parity field, the checksum is the parity to set.
+        uint32_t parity = compute_checksum(bits);
+        for (size_t i = 0; i < 24; i++) {
+            bits[BITS_PER_FRAME - 24 + i] = ((parity >> (23 - i)) & 1) != 0;
+        }
+
+        float *packet = &magnitudes[pos];
+
+        packet[0] = packet[2] = packet[7] = packet[9] = 1.0f;
+
+        for (size_t i = 0; i < BITS_PER_FRAME; i++) {
+            packet[SAMPLES_PER_PREAMBLE + 2 * i] = bits[i] ? 1.0f : noise(generator);
+            packet[SAMPLES_PER_PREAMBLE + 2 * i + 1] = bits[i] ? noise(generator) : 1.0f;
+        }
+    }
+}
+
+//the SAMMY decoding steps over a magnitude vector: preamble search, then extraction and CRC check of each candidate.
+static void runADSBBench(const BenchOptions& options, std::ostream& json) {
+    using namespace adsb_decoder;
+
+    std::vector<float> magnitudes;
+
+    if (!options.adsbInputFile.empty()) {
+        std::ifstream file(options.adsbInputFile.c_str(), std::ios::in | std::ios::binary);
+        std::vector<char> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        magnitudes.resize(raw.size() / sizeof(float));
+        if (!magnitudes.empty()) {
+            ::memcpy(&magnitudes[0], &raw[0], magnitudes.size() * sizeof(float));
+        }
+    }
+
+    if (magnitudes.empty()) {
+        if (!options.adsbInputFile.empty()) {
+            std::cout << "No magnitudes in '" << options.adsbInputFile << "', using synthetic frames." << std::endl;
+        }
+        makeSyntheticADSB(magnitudes);
+    }
+
+    //find_preamble_candidates() and the frame extraction read a packet past the last offset.
+    size_t count = magnitudes.size();
+    magnitudes.resize(count + SAMPLES_PER_PACKET, 0.0f);
+
+    std::vector<unsigned int> candidates;
+    unsigned long long numCandidates = 0, numFrames = 0;
+    ByteArray lastFrame{};
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int pass = 0; pass < BENCH_ADSB_PASSES; pass++) {
+        for (size_t offset = 0; offset < count; offset += BUFFER_THRESHOLD) {
+            const float *buffer = &magnitudes[offset];
+
+            candidates.clear();
+            find_preamble_candidates(buffer, std::min((size_t)BUFFER_THRESHOLD, count - offset), candidates);
+
+            size_t nextOffset = 0;
+
+            for (unsigned int candidate : candidates) {
+                if (candidate < nextOffset) {
+                    continue;
+                }
+
+                const BitVector frameBits = extract_bitvector(&buffer[candidate + SAMPLES_PER_PREAMBLE]);
+
+                if (compute_checksum(frameBits) == 0) {
+                    lastFrame = extract_bytearray(frameBits);
+                    numFrames++;
+                    nextOffset = candidate + SAMPLES_PER_FRAME + 1;
+                }
+            }
+
+            numCandidates += candidates.size();
+        }
+    }
+
+    double seconds = secondsSince(start);
+    double samplesPerSecond = (double)count * BENCH_ADSB_PASSES / seconds;
+
+    json << "  \"adsb\": {" << std::endl;
+    json << "    \"input\": \"" << (options.adsbInputFile.empty() ? "synthetic" : "recorded") << "\"," << std::endl;
+    json << "    \"samples\": " << count << "," << std::endl;
+    json << "    \"candidates_per_pass\": " << numCandidates / BENCH_ADSB_PASSES << "," << std::endl;
+    json << "    \"frames_per_pass\": " << numFrames / BENCH_ADSB_PASSES << "," << std::endl;
+    json << "    \"samples_per_second\": " << (long long)samplesPerSecond << "," << std::endl;
+    json << "    \"frames_per_second\": " << (long long)(numFrames / seconds) << "," << std::endl;
+    json << "    \"last_downlink_format\": " << (lastFrame[0] >> 3) << "," << std::endl;
+    json << "    \"realtime_factor\": " << samplesPerSecond / SAMPLE_RATE << std::endl;
+    json << "  }";
+}
+
+int main(int argc, char **argv) {
+    std::setlocale(LC_ALL, "");
+
+    //wxWidgets only provides the configuration and temporary paths here: no GUI, no GL context.
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk()) {
+        std::cout << "Failed to initialize wxWidgets." << std::endl;
+        return 1;
+    }
+
+    wxCmdLineParser parser(commandLineInfo, argc, argv);
+    if (parser.Parse() != 0) {
+        return 1;
+    }
+
+    BenchOptions options;
+    long value;
+    wxString str, outputFile;
+
+    if (parser.Found("r", &value)) {
+        options.sampleRate = value;
+    }
+    if (parser.Found("n", &value)) {
+        options.demodsPerType = (int)value;
+    }
+    if (parser.Found("t", &value)) {
+        options.seconds = (int)value;
+    }
+    if (parser.Found("b", &value)) {
+        options.bookmarks = (int)value;
+    }
+    if (parser.Found("i", &str)) {
+        options.inputFile = str.ToStdString();
+    }
+    options.inputFormat = parser.Found("f", &str) ? str.ToStdString() : std::string("cf32");
+    if (parser.Found("a", &str)) {
+        options.adsbInputFile = str.ToStdString();
+    }
+    options.realtime = parser.Found("R");
+    parser.Found("o", &outputFile);
+
+    if (options.sampleRate <= 0 || options.demodsPerType < 0 || options.seconds <= 0 || options.bookmarks <= 0) {
+        std::cout << "Invalid parameters, see --help." << std::endl;
+        return 1;
+    }
+
+    std::stringstream json;
+
+    json << "{" << std::endl;
+
+    if (!runPipelineBench(options, json)) {
+        return 2;
+    }
+    json << "," << std::endl;
+
+    runDataTreeBench(options, json);
+    json << "," << std::endl;
+
+    runADSBBench(options, json);
+    json << std::endl << "}" << std::endl;
+
+    if (outputFile.IsEmpty()) {
+        std::cout << json.str();
+        return 0;
+    }
+
+    std::ofstream file(outputFile.ToStdString().c_str(), std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "Unable to open '" << outputFile << "' for writing." << std::endl;
+        return 3;
+    }
+
+    file << json.str();
+
+    return file.good() ? 0 : 3;
+}
@@ -10,9 +10,14 @@
 #include <atomic>
 #include <mutex>
 #include <memory>
+#include <cmath>
 
 #include "IOThread.h"
 
+//buffers of each stage of a demodulator kept allocated, whatever the garbage collection of their ReBuffer:
+//more than the blocks in flight between two stages in steady state.
+#define DEMOD_BUFFERS_RESERVE 8
+
 class DemodulatorThread;
 
 class DemodulatorThreadControlCommand {
@@ -29,21 +34,71 @@ public:
     std::string demodType;
 };
 
+/**
+ * When a sample was taken, carried along the samples derived from it: the position of the sample
+ * in the device stream, the host clock and, if the device has one, the device clock.
+ * Stages that resample or filter move the timestamp of their output by their group delay.
+ */
+class IQTimestamp {
+public:
+    //index of the sample in the device stream, at the device sample rate, counted since the stream start.
+    long long sampleIndex;
+    long long deviceSampleRate;
+    //system clock, in nanoseconds since the epoch.
+    long long hostTimeNs;
+    //device clock in nanoseconds, only if hasDeviceTime.
+    long long deviceTimeNs;
+    bool hasDeviceTime;
+
+    IQTimestamp() : sampleIndex(0), deviceSampleRate(0), hostTimeNs(0), deviceTimeNs(0), hasDeviceTime(false) {
+    }
+
+    //false if the samples do not come from a device stream.
+    bool isValid() const {
+        return deviceSampleRate > 0;
+    }
+
+    //timestamp of the sample 'samples' after this one in a stream at 'sampleRate', or before it if negative.
+    IQTimestamp offset(double samples, long long sampleRate) const {
+        IQTimestamp result(*this);
+
+        if (!isValid() || sampleRate <= 0) {
+            return result;
+        }
+
+        long long deltaNs = std::llround(samples * 1e9 / (double)sampleRate);
+
+        result.sampleIndex += std::llround(samples * (double)deviceSampleRate / (double)sampleRate);
+        result.hostTimeNs += deltaNs;
+        result.deviceTimeNs += deltaNs;
+        return result;
+    }
+};
+
 class DemodulatorThreadIQData {
 public:
     long long frequency;
     long long sampleRate;
+    //first samples after a device retune: unrelated to the previous data.
+    bool retuned;
+    //PipelineStats::now() when the samples were read from the device, 0 if unknown.
+    long long ingestTime;
+    //of data[0]
+    IQTimestamp timestamp;
     std::vector<liquid_float_complex> data;
    
 
     DemodulatorThreadIQData() :
-            frequency(0), sampleRate(0) {
+            frequency(0), sampleRate(0), retuned(false), ingestTime(0) {
 
     }
 
     DemodulatorThreadIQData & operator=(const DemodulatorThreadIQData &other) {
         frequency = other.frequency;
         sampleRate = other.sampleRate;
+        retuned = other.retuned;
+        ingestTime = other.ingestTime;
+        timestamp = other.timestamp;
         data.assign(other.data.begin(), other.data.end());
         return *this;
     }
@@ -61,13 +116,16 @@ public:
     std::vector<liquid_float_complex> data;
 
     long long sampleRate;
+    long long ingestTime;
+    //of data[0], the resampler delay accounted for.
+    IQTimestamp timestamp;
     std::string modemName;
     std::string modemType;
     Modem *modem;
     ModemKit *modemKit;
 
     DemodulatorThreadPostIQData() :
-            sampleRate(0), modem(nullptr), modemKit(nullptr) {
+            sampleRate(0), ingestTime(0), modem(nullptr), modemKit(nullptr) {
 
     }
 
@@ -0,0 +1,146 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "DemodulatorIndex.h"
+#include <algorithm>
+
+static bool entryLowCompare(const DemodulatorIndexEntry& entry, long long low) {
+    return entry.low < low;
+}
+
+static bool orderCompare(const DemodulatorIndexEntry *i, const DemodulatorIndexEntry *j) {
+    return i->order < j->order;
+}
+
+DemodulatorIndex::DemodulatorIndex() : nextOrder(0), version(0) {
+
+}
+
+void DemodulatorIndex::update(DemodulatorInstancePtr demod, bool remove) {
+
+    unsigned long long order = nextOrder;
+    bool found = false;
+
+    for (auto i = entries.begin(); i != entries.end(); i++) {
+        if (i->demod == demod) {
+            //keep the creation order of a moved demodulator
+            order = i->order;
+            found = true;
+            entries.erase(i);
+            break;
+        }
+    }
+
+    if (!remove) {
+        if (!found) {
+            nextOrder++;
+        }
+
+        DemodulatorIndexEntry entry = makeEntry(demod, order);
+
+        //entries remain sorted by low edge, a single insertion.
+        auto pos = std::lower_bound(entries.begin(), entries.end(), entry.low, entryLowCompare);
+        entries.insert(pos, entry);
+    }
+
+    updateMaxHigh();
+}
+
+DemodulatorIndexEntry DemodulatorIndex::makeEntry(DemodulatorInstancePtr demod, unsigned long long order) {
+
+    DemodulatorIndexEntry entry;
+
+    entry.demod = demod;
+    entry.order = order;
+    entry.frequency = demod->getFrequency();
+    entry.bandwidth = demod->getBandwidth();
+
+    long long halfBandwidth = entry.bandwidth / 2;
+    std::string demodType = demod->getDemodulatorType();
+
+    entry.low = entry.frequency - ((demodType != "USB") ? halfBandwidth : 0);
+    entry.high = entry.frequency + ((demodType != "LSB") ? halfBandwidth : 0);
+
+    return entry;
+}
+
+void DemodulatorIndex::updateMaxHigh() {
+
+    maxHigh.resize(entries.size());
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        maxHigh[i] = (i == 0) ? entries[i].high : std::max(maxHigh[i - 1], entries[i].high);
+    }
+}
+
+int DemodulatorIndex::lastCandidate(long long freq, long long halfBuffer) const {
+
+    //first entry starting strictly after freq + halfBuffer
+    auto end = std::lower_bound(entries.begin(), entries.end(), freq + halfBuffer + 1, entryLowCompare);
+
+    return (int)(end - entries.begin()) - 1;
+}
+
+std::vector<DemodulatorInstancePtr> DemodulatorIndex::getDemodulatorsAt(long long freq, int bandwidth) const {
+
+    std::vector<DemodulatorInstancePtr> foundDemods;
+    std::vector<const DemodulatorIndexEntry *> foundEntries;
+
+    long long halfBuffer = bandwidth / 2;
+
+    //every entry before the candidate starts low enough; sweep back while some of them may still end high enough.
+    for (int i = lastCandidate(freq, halfBuffer); i >= 0 && maxHigh[i] >= freq - halfBuffer; i--) {
+        if (entries[i].high >= freq - halfBuffer) {
+            foundEntries.push_back(&entries[i]);
+        }
+    }
+
+    std::sort(foundEntries.begin(), foundEntries.end(), orderCompare);
+
+    foundDemods.reserve(foundEntries.size());
+    for (const DemodulatorIndexEntry *entry : foundEntries) {
+        foundDemods.push_back(entry->demod);
+    }
+
+    return foundDemods;
+}
+
+bool DemodulatorIndex::anyDemodulatorsAt(long long freq, int bandwidth) const {
+
+    long long halfBuffer = bandwidth / 2;
+    int i = lastCandidate(freq, halfBuffer);
+
+    //maxHigh is the best high edge among all the candidates.
+    return (i >= 0 && maxHigh[i] >= freq - halfBuffer);
+}
+
+const DemodulatorIndexEntry *DemodulatorIndex::find(DemodulatorInstance *demod) const {
+
+    for (const DemodulatorIndexEntry& entry : entries) {
+        if (entry.demod.get() == demod) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void DemodulatorIndex::setCurrentModem(DemodulatorInstancePtr demod) {
+    currentModem = demod;
+}
+
+void DemodulatorIndex::setVersion(unsigned long long version_in) {
+    version = version_in;
+}
+
+DemodulatorInstancePtr DemodulatorIndex::getCurrentModem() const {
+    return currentModem;
+}
+
+unsigned long long DemodulatorIndex::getVersion() const {
+    return version;
+}
+
+const std::vector<DemodulatorIndexEntry>& DemodulatorIndex::getEntries() const {
+    return entries;
+}
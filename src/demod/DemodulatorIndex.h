@@ -0,0 +1,80 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "DemodulatorInstance.h"
+
+//A demodulator and the frequency span it occupies, as of the last update.
+class DemodulatorIndexEntry {
+public:
+    DemodulatorIndexEntry() : frequency(0), bandwidth(0), low(0), high(0), order(0) {
+    }
+
+    DemodulatorInstancePtr demod;
+
+    long long frequency;
+    int bandwidth;
+
+    //occupied span [low, high]: only the upper half for USB, only the lower half for LSB.
+    long long low, high;
+
+    //creation order of the demodulator, to report results in a stable order.
+    unsigned long long order;
+};
+
+/**
+ * Frequency index of the demodulators: entries sorted by low edge,
+ * with the running maximum of the high edges, so that a lookup is a binary search
+ * followed by a short backward sweep, instead of a scan of every demodulator.
+ * Once published by DemodulatorMgr an index is immutable: updates are made on a copy
+ * which gets the next version number, so that readers can keep using an old one without lock.
+ */
+class DemodulatorIndex {
+public:
+    DemodulatorIndex();
+
+    //before publication only: remove the entry of 'demod', then add it back with its current span unless 'remove'.
+    void update(DemodulatorInstancePtr demod, bool remove);
+
+    //before publication only.
+    void setCurrentModem(DemodulatorInstancePtr demod);
+    void setVersion(unsigned long long version);
+
+    //DemodulatorMgr::getCurrentModem() at the time of this version.
+    DemodulatorInstancePtr getCurrentModem() const;
+
+    //changes each time a new index is published.
+    unsigned long long getVersion() const;
+
+    //demodulators whose span, widened by bandwidth / 2 on both sides, contains freq, in creation order.
+    std::vector<DemodulatorInstancePtr> getDemodulatorsAt(long long freq, int bandwidth) const;
+    bool anyDemodulatorsAt(long long freq, int bandwidth) const;
+
+    //the entry of the raw pointer demod, nullptr if not indexed.
+    const DemodulatorIndexEntry *find(DemodulatorInstance *demod) const;
+
+    const std::vector<DemodulatorIndexEntry>& getEntries() const;
+
+    static DemodulatorIndexEntry makeEntry(DemodulatorInstancePtr demod, unsigned long long order);
+
+private:
+    //index of the last entry with low <= freq + halfBuffer, -1 if none.
+    int lastCandidate(long long freq, long long halfBuffer) const;
+
+    void updateMaxHigh();
+
+    std::vector<DemodulatorIndexEntry> entries;
+
+    //maxHigh[i] = max of entries[0..i].high
+    std::vector<long long> maxHigh;
+
+    unsigned long long nextOrder;
+    unsigned long long version;
+
+    DemodulatorInstancePtr currentModem;
+};
+
+typedef std::shared_ptr<const DemodulatorIndex> DemodulatorIndexPtr;
@@ -3,17 +3,24 @@
 
 #include <memory>
 #include <iomanip>
+#include <random>
 
 #include "DemodulatorInstance.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
+#include <wx/string.h>
 
 #include "DemodulatorThread.h"
 #include "DemodulatorPreThread.h"
 #include "AudioSinkFileThread.h"
+#include "AudioSinkNetworkThread.h"
 #include "AudioFileWAV.h"
+#if USE_FLAC
+#include "AudioFileFLAC.h"
+#endif
 
-#if USE_HAMLIB
-#include "RigThread.h"
+#if ENABLE_DIGITAL_LAB
+//frequencyToStr
+#include "CubicSDR.h"
 #endif
 
 DemodVisualCue::DemodVisualCue() {
@@ -51,6 +58,16 @@ DemodulatorInstance::DemodulatorInstance() {
 	squelch.store(false);
     muted.store(false);
     recording.store(false);
+    streaming.store(false);
+
+    //the SSRC identifies this demodulator to the receivers, a new one for each instance:
+    //never reused from a session, where a copy of the same file would clash.
+    std::random_device random;
+    unsigned int ssrc = 0;
+    while (!ssrc) {
+        ssrc = random();
+    }
+    streamSSRC.store(ssrc);
     deltaLock.store(false);
     deltaLockOfs.store(0);
 	currentOutputDevice.store(-1);
@@ -63,8 +80,10 @@ DemodulatorInstance::DemodulatorInstance() {
 
     pipeIQInputData = std::make_shared<DemodulatorThreadInputQueue>();
     pipeIQInputData->set_max_num_items(100);
+    pipeIQInputData->set_stats_name("DemodIQInput");
     pipeIQDemodData = std::make_shared< DemodulatorThreadPostInputQueue>();
     pipeIQDemodData->set_max_num_items(100);
+    pipeIQDemodData->set_stats_name("DemodPostIQ");
     
     audioThread = new AudioThread();
             
@@ -74,9 +93,11 @@ DemodulatorInstance::DemodulatorInstance() {
             
     pipeAudioData = std::make_shared<AudioThreadInputQueue>();
     pipeAudioData->set_max_num_items(100);
+    pipeAudioData->set_stats_name("DemodAudio");
 
     threadQueueControl = std::make_shared<DemodulatorThreadControlCommandQueue>();
     threadQueueControl->set_max_num_items(2);
+    threadQueueControl->set_stats_name("DemodControl");
 
     demodulatorThread = new DemodulatorThread(this);
     demodulatorThread->setInputQueue("IQDataInput",pipeIQDemodData);
@@ -111,6 +132,7 @@ DemodulatorInstance::~DemodulatorInstance() {
             delete demodulatorThread;
             delete audioThread;
             delete audioSinkThread;
+            delete audioStreamThread;
 
             break;
         }
@@ -166,7 +188,7 @@ void DemodulatorInstance::updateLabel(long long freq) {
     newLabel.precision(3);
     newLabel << std::fixed << ((long double) freq / 1000000.0);
     setLabel(newLabel.str());
-    wxGetApp().getBookmarkMgr().updateActiveList();
+    SDREngine::get()->notifyDemodulatorsUpdated();
 }
 
 void DemodulatorInstance::terminate() {
@@ -190,6 +212,10 @@ void DemodulatorInstance::terminate() {
         stopRecording();
     }
 
+    if (audioStreamThread != nullptr) {
+        stopStreaming();
+    }
+
     //that will actually unblock the currently blocked push().
     pipeIQInputData->flush();
     pipeAudioData->flush();
@@ -206,6 +232,23 @@ void DemodulatorInstance::setLabel(std::string labelStr) {
     delete label.exchange(new std::string(labelStr));
 }
 
+long long DemodulatorInstance::getCPUTime() {
+
+    std::lock_guard < std::recursive_mutex > lockData(m_thread_control_mutex);
+
+    long long cpuTime = demodulatorPreThread->getCPUTime() + demodulatorThread->getCPUTime() + audioThread->getCPUTime();
+
+    if (audioSinkThread) {
+        cpuTime += audioSinkThread->getCPUTime();
+    }
+
+    if (audioStreamThread) {
+        cpuTime += audioStreamThread->getCPUTime();
+    }
+
+    return cpuTime;
+}
+
 bool DemodulatorInstance::isTerminated() {
 
     std::lock_guard < std::recursive_mutex > lockData(m_thread_control_mutex);
@@ -214,6 +257,7 @@ bool DemodulatorInstance::isTerminated() {
     bool demodTerminated = demodulatorThread->isTerminated();
     bool preDemodTerminated = demodulatorPreThread->isTerminated();
     bool audioSinkTerminated = (audioSinkThread == nullptr) || audioSinkThread->isTerminated();
+    bool audioStreamTerminated = (audioStreamThread == nullptr) || audioStreamThread->isTerminated();
 
     //Cleanup the worker threads, if the threads are indeed terminated.
     // threads are linked as  t_PreDemod ==> t_Demod ==> t_Audio
@@ -270,7 +314,17 @@ bool DemodulatorInstance::isTerminated() {
         }
     }
 
-    bool terminated = audioTerminated && demodTerminated && preDemodTerminated && audioSinkTerminated;
+    if (audioStreamTerminated) {
+
+        if (t_AudioStream != nullptr) {
+            t_AudioStream->join();
+
+            delete t_AudioStream;
+            t_AudioStream = nullptr;
+        }
+    }
+
+    bool terminated = audioTerminated && demodTerminated && preDemodTerminated && audioSinkTerminated && audioStreamTerminated;
 
     return terminated;
 }
@@ -303,7 +357,7 @@ void DemodulatorInstance::setActive(bool state) {
     }
     active = state;
     
-    wxGetApp().getBookmarkMgr().updateActiveList();
+    SDREngine::get()->notifyDemodulatorsUpdated();
 }
 
 void DemodulatorInstance::squelchAuto() {
@@ -347,8 +401,8 @@ float DemodulatorInstance::getSignalCeil() {
 
 void DemodulatorInstance::setSquelchLevel(float signal_level_in) {
     demodulatorThread->setSquelchLevel(signal_level_in);
-    wxGetApp().getDemodMgr().setLastSquelchLevel(signal_level_in);
-    wxGetApp().getDemodMgr().setLastSquelchEnabled(true);
+    SDREngine::get()->getDemodMgr().setLastSquelchLevel(signal_level_in);
+    SDREngine::get()->getDemodMgr().setLastSquelchEnabled(true);
 }
 
 float DemodulatorInstance::getSquelchLevel() {
@@ -412,8 +466,10 @@ void DemodulatorInstance::setDemodulatorType(std::string demod_type_in) {
         }
 #endif
     }
+
+    SDREngine::get()->getDemodMgr().updateIndex(this);
     
-    wxGetApp().getBookmarkMgr().updateActiveList();
+    SDREngine::get()->notifyDemodulatorsUpdated();
 }
 
 std::string DemodulatorInstance::getDemodulatorType() {
@@ -460,6 +516,8 @@ void DemodulatorInstance::setFrequency(long long freq) {
     }
     
     demodulatorPreThread->setFrequency(freq);
+    SDREngine::get()->getDemodMgr().updateIndex(this);
+
 #if ENABLE_DIGITAL_LAB
     if (activeOutput) {
         if (isModemInitialized() && getModemType() == "digital") {
@@ -468,15 +526,12 @@ void DemodulatorInstance::setFrequency(long long freq) {
         }
     }
 #endif
-#if USE_HAMLIB
-    if (wxGetApp().rigIsActive() && wxGetApp().getRigThread()->getFollowModem() &&
-            wxGetApp().getDemodMgr().getCurrentModem().get() == this) {
-        wxGetApp().getRigThread()->setFrequency(freq,true);
+    if (SDREngine::get()->getDemodMgr().getCurrentModem().get() == this) {
+        SDREngine::get()->notifyModemFrequency(freq);
     }
-#endif
     
     if (this->isActive()) {
-        wxGetApp().getBookmarkMgr().updateActiveList();
+        SDREngine::get()->notifyDemodulatorsUpdated();
     }
 }
 
@@ -544,7 +599,7 @@ bool DemodulatorInstance::isMuted() {
 void DemodulatorInstance::setMuted(bool muted) {
     this->muted = muted;
     demodulatorThread->setMuted(muted);
-    wxGetApp().getDemodMgr().setLastMuted(muted);
+    SDREngine::get()->getDemodMgr().setLastMuted(muted);
 }
 
 bool DemodulatorInstance::isRecording()
@@ -562,6 +617,25 @@ void DemodulatorInstance::setRecording(bool recording_in)
     }
 }
 
+bool DemodulatorInstance::isStreaming()
+{
+    return streaming.load();
+}
+
+void DemodulatorInstance::setStreaming(bool streaming_in)
+{
+    if (streaming_in) {
+        startStreaming();
+    }
+    else {
+        stopStreaming();
+    }
+}
+
+unsigned int DemodulatorInstance::getStreamSSRC() {
+    return streamSSRC.load();
+}
+
 DemodVisualCue *DemodulatorInstance::getVisualCue() {
     return &visualCue;
 }
@@ -633,7 +707,16 @@ void DemodulatorInstance::startRecording() {
     }
 
     AudioSinkFileThread *newSinkThread = new AudioSinkFileThread();
-    AudioFileWAV *afHandler = new AudioFileWAV();
+    AudioFile *afHandler = nullptr;
+
+#if USE_FLAC
+    if (SDREngine::get()->getConfig()->getRecordingFileFormat() == AudioFile::AUDIO_FILE_FORMAT_FLAC) {
+        afHandler = new AudioFileFLAC();
+    }
+#endif
+    if (afHandler == nullptr) {
+        afHandler = new AudioFileWAV();
+    }
 
     std::stringstream fileName;
     
@@ -651,8 +734,10 @@ void DemodulatorInstance::startRecording() {
 	newSinkThread->setAudioFileNameBase(fileName.str());
 
 	//attach options:
-    newSinkThread->setSquelchOption(wxGetApp().getConfig()->getRecordingSquelchOption());
-	newSinkThread->setFileTimeLimit(wxGetApp().getConfig()->getRecordingFileTimeLimit());
+    newSinkThread->setSquelchOption(SDREngine::get()->getConfig()->getRecordingSquelchOption());
+	newSinkThread->setFileTimeLimit(SDREngine::get()->getConfig()->getRecordingFileTimeLimit());
+	newSinkThread->setPreRoll(SDREngine::get()->getConfig()->getRecordingPreRoll());
+	newSinkThread->setHangTime(SDREngine::get()->getConfig()->getRecordingHangTime());
 
     newSinkThread->setAudioFileHandler(afHandler);
 
@@ -685,6 +770,52 @@ void DemodulatorInstance::stopRecording() {
 }
 
 
+void DemodulatorInstance::startStreaming() {
+    if (streaming.load()) {
+        return;
+    }
+
+    AppConfig *config = SDREngine::get()->getConfig();
+
+    AudioSinkNetworkThread *newStreamThread = new AudioSinkNetworkThread();
+
+    if (!newStreamThread->setDestination(config->getAudioStreamAddress(), config->getAudioStreamPort())) {
+        delete newStreamThread;
+        return;
+    }
+
+    newStreamThread->setSSRC(streamSSRC.load());
+    newStreamThread->setCodec(config->getAudioStreamCodec());
+
+    audioStreamThread = newStreamThread;
+    t_AudioStream = new std::thread(&AudioSinkThread::threadMain, audioStreamThread);
+
+    demodulatorThread->setOutputQueue("AudioStream", audioStreamThread->getInputQueue("input"));
+
+    streaming.store(true);
+}
+
+
+void DemodulatorInstance::stopStreaming() {
+    if (!streaming.load()) {
+        return;
+    }
+
+    demodulatorThread->setOutputQueue("AudioStream", nullptr);
+    audioStreamThread->terminate();
+
+    t_AudioStream->join();
+
+    delete t_AudioStream;
+    delete audioStreamThread;
+
+    t_AudioStream = nullptr;
+    audioStreamThread = nullptr;
+
+    streaming.store(false);
+}
+
+
 #if ENABLE_DIGITAL_LAB
 ModemDigitalOutput *DemodulatorInstance::getOutput() {
     if (activeOutput == nullptr) {
@@ -60,6 +60,9 @@ public:
     bool isTerminated();
     void updateLabel(long long freq);
 
+    //CPU time used by the pre-demodulation, demodulation and audio threads, in microseconds, once terminated.
+    long long getCPUTime();
+
     bool isActive();
     void setActive(bool state);
 
@@ -114,6 +117,13 @@ public:
     bool isRecording();
     void setRecording(bool recording);
 
+    //RTP audio stream to the configured destination.
+    bool isStreaming();
+    void setStreaming(bool streaming);
+
+    //SSRC of the stream, picked at random for each instance.
+    unsigned int getStreamSSRC();
+
     DemodVisualCue *getVisualCue();
     
     DemodulatorThreadInputQueuePtr getIQInputDataPipe();
@@ -140,6 +150,9 @@ protected:
     void startRecording();
     void stopRecording();
 
+    void startStreaming();
+    void stopStreaming();
+
 private:
     DemodulatorThreadInputQueuePtr pipeIQInputData;
     DemodulatorThreadPostInputQueuePtr pipeIQDemodData;
@@ -152,6 +165,9 @@ private:
     std::thread *t_AudioSink = nullptr;
     AudioThreadInputQueuePtr audioSinkInputQueue;
 
+    AudioSinkThread *audioStreamThread = nullptr;
+    std::thread *t_AudioStream = nullptr;
+
     //protects child thread creation and termination 
     std::recursive_mutex m_thread_control_mutex;
 
@@ -164,6 +180,8 @@ private:
     std::atomic_bool muted;
     std::atomic_bool deltaLock;
     std::atomic_bool recording;
+    std::atomic_bool streaming;
+    std::atomic_uint streamSSRC;
 
     std::atomic_int deltaLockOfs;
 
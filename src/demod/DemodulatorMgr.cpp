@@ -9,11 +9,7 @@
 #include <algorithm>
 
 #include "DemodulatorMgr.h"
-#include "CubicSDR.h"
-
-#if USE_HAMLIB
-#include "RigThread.h"
-#endif
+#include "SDREngine.h"
 
 #include "DataTree.h"
 #include <wx/string.h>
@@ -30,6 +26,9 @@ DemodulatorMgr::DemodulatorMgr() {
     lastGain = 1.0;
     lastMuted = false;
     lastDeltaLock = false;
+
+    demodIndex = std::make_shared<DemodulatorIndex>();
+    indexVersion.store(0);
 }
 
 DemodulatorMgr::~DemodulatorMgr() {
@@ -47,6 +46,8 @@ DemodulatorInstancePtr DemodulatorMgr::newThread() {
     newDemod->setLabel(label.str());
     
     demods.push_back(newDemod);
+
+    indexDemodulator(newDemod, false);
     
     return newDemod;
 }
@@ -148,7 +149,7 @@ void DemodulatorMgr::deleteThread(DemodulatorInstancePtr demod) {
     
     std::lock_guard < std::recursive_mutex > lock(demods_busy);
 
-    wxGetApp().getBookmarkMgr().addRecent(demod);
+    SDREngine::get()->notifyDemodulatorDeleted(demod);
   
     auto i = std::find(demods.begin(), demods.end(), demod);
 
@@ -166,51 +167,79 @@ void DemodulatorMgr::deleteThread(DemodulatorInstancePtr demod) {
         demods.erase(i);
     }
 
+    indexDemodulator(demod, true);
+    indexCurrentModem();
+
     //Ask for termination
     demod->setActive(false);
     demod->terminate();
 }
 
 std::vector<DemodulatorInstancePtr> DemodulatorMgr::getDemodulatorsAt(long long freq, int bandwidth) {
-    std::lock_guard < std::recursive_mutex > lock(demods_busy);
-    
-    std::vector<DemodulatorInstancePtr> foundDemods;
+    return getIndex()->getDemodulatorsAt(freq, bandwidth);
+}
 
-    for (int i = 0, iMax = demods.size(); i < iMax; i++) {
-        DemodulatorInstancePtr testDemod = demods[i];
+bool DemodulatorMgr::anyDemodulatorsAt(long long freq, int bandwidth) {
+    return getIndex()->anyDemodulatorsAt(freq, bandwidth);
+}
 
-        long long freqTest = testDemod->getFrequency();
-        long long bandwidthTest = testDemod->getBandwidth();
-        long long halfBandwidthTest = bandwidthTest / 2;
+DemodulatorIndexPtr DemodulatorMgr::getIndex() {
+    return std::atomic_load(&demodIndex);
+}
+
+unsigned long long DemodulatorMgr::getIndexVersion() {
+    return indexVersion.load();
+}
 
-        long long halfBuffer = bandwidth / 2;
+void DemodulatorMgr::updateIndex(DemodulatorInstance *demod) {
+    std::lock_guard < std::mutex > lock(index_busy);
 
-        if ((freq <= (freqTest + ((testDemod->getDemodulatorType() != "LSB")?halfBandwidthTest:0) + halfBuffer)) && (freq >= (freqTest - ((testDemod->getDemodulatorType() != "USB")?halfBandwidthTest:0) - halfBuffer))) {
-            foundDemods.push_back(testDemod);
-        }
+    DemodulatorIndexPtr current = getIndex();
+    const DemodulatorIndexEntry *entry = current->find(demod);
+
+    //not managed (yet), nothing to update.
+    if (entry == nullptr) {
+        return;
     }
 
-    return foundDemods;
+    auto next = std::make_shared<DemodulatorIndex>(*current);
+    next->update(entry->demod, false);
+
+    publishIndex(next);
 }
 
-bool DemodulatorMgr::anyDemodulatorsAt(long long freq, int bandwidth) {
-    std::lock_guard < std::recursive_mutex > lock(demods_busy);
-    for (int i = 0, iMax = demods.size(); i < iMax; i++) {
-        DemodulatorInstancePtr testDemod = demods[i];
+void DemodulatorMgr::indexDemodulator(DemodulatorInstancePtr demod, bool remove) {
+    std::lock_guard < std::mutex > lock(index_busy);
 
-        long long freqTest = testDemod->getFrequency();
-        long long bandwidthTest = testDemod->getBandwidth();
-        long long halfBandwidthTest = bandwidthTest / 2;
-        
-        long long halfBuffer = bandwidth / 2;
-        
-        if ((freq <= (freqTest + ((testDemod->getDemodulatorType() != "LSB")?halfBandwidthTest:0) + halfBuffer)) && (freq >= (freqTest - ((testDemod->getDemodulatorType() != "USB")?halfBandwidthTest:0) - halfBuffer))) {
-           
-            return true;
-        }
+    auto next = std::make_shared<DemodulatorIndex>(*getIndex());
+    next->update(demod, remove);
+
+    publishIndex(next);
+}
+
+void DemodulatorMgr::indexCurrentModem() {
+    std::lock_guard < std::mutex > lock(index_busy);
+
+    DemodulatorIndexPtr current = getIndex();
+
+    if (current->getCurrentModem() == currentModem) {
+        return;
     }
 
-    return false;
+    auto next = std::make_shared<DemodulatorIndex>(*current);
+    next->setCurrentModem(currentModem);
+
+    publishIndex(next);
+}
+
+void DemodulatorMgr::publishIndex(std::shared_ptr<DemodulatorIndex> next) {
+
+    next->setVersion(getIndex()->getVersion() + 1);
+
+    std::atomic_store(&demodIndex, DemodulatorIndexPtr(next));
+
+    //only now, so that a reader seeing the new version gets at least this index.
+    indexVersion.store(next->getVersion());
 }
 
 
@@ -229,13 +258,11 @@ void DemodulatorMgr::setActiveDemodulator(DemodulatorInstancePtr demod, bool tem
 
         updateLastState();
 
-        wxGetApp().getBookmarkMgr().updateActiveList();
+        SDREngine::get()->notifyDemodulatorsUpdated();
 
-#if USE_HAMLIB
-        if (wxGetApp().rigIsActive() && wxGetApp().getRigThread()->getFollowModem() && currentModem) {
-            wxGetApp().getRigThread()->setFrequency(currentModem->getFrequency(),true);
+        if (currentModem) {
+            SDREngine::get()->notifyModemFrequency(currentModem->getFrequency());
         }
-#endif
     }
 
     // TODO: This is probably unnecessary and confusing
@@ -243,12 +270,12 @@ void DemodulatorMgr::setActiveDemodulator(DemodulatorInstancePtr demod, bool tem
         activeVisualDemodulator->setVisualOutputQueue(nullptr);
     }
     if (demod) {
-        demod->setVisualOutputQueue(wxGetApp().getAudioVisualQueue());
+        demod->setVisualOutputQueue(SDREngine::get()->getAudioVisualQueue());
         activeVisualDemodulator = demod;
     } else {
         DemodulatorInstancePtr last = getCurrentModem();
         if (last) {
-            last->setVisualOutputQueue(wxGetApp().getAudioVisualQueue());
+            last->setVisualOutputQueue(SDREngine::get()->getAudioVisualQueue());
         }
         activeVisualDemodulator = last;
     }
@@ -342,6 +369,7 @@ void DemodulatorMgr::updateLastState() {
         lastModemSettings[lastDemodType] = currentModem->readModemSettings();
     }
 
+    indexCurrentModem();
 }
 
 int DemodulatorMgr::getLastBandwidth() const {
@@ -351,8 +379,8 @@ int DemodulatorMgr::getLastBandwidth() const {
 void DemodulatorMgr::setLastBandwidth(int lastBandwidth) {
     if (lastBandwidth < MIN_BANDWIDTH) {
         lastBandwidth = MIN_BANDWIDTH;
-    } else  if (lastBandwidth > wxGetApp().getSampleRate()) {
-        lastBandwidth = wxGetApp().getSampleRate();
+    } else  if (lastBandwidth > SDREngine::get()->getSampleRate()) {
+        lastBandwidth = SDREngine::get()->getSampleRate();
     }
     this->lastBandwidth = lastBandwidth;
 }
@@ -435,6 +463,9 @@ void DemodulatorMgr::saveInstance(DataNode *node, DemodulatorInstancePtr inst) {
     *node->newChild("output_device") = outputDevices[inst->getOutputDevice()].name;
     *node->newChild("gain") = inst->getGain();
     *node->newChild("muted") = inst->isMuted() ? 1 : 0;
+    if (inst->isStreaming()) {
+        *node->newChild("streaming") = 1;
+    }
     if (inst->isDeltaLock()) {
         *node->newChild("delta_lock") = inst->isDeltaLock() ? 1 : 0;
         *node->newChild("delta_ofs") = inst->getDeltaLockOfs();
@@ -495,6 +526,8 @@ DemodulatorInstancePtr DemodulatorMgr::loadInstance(DataNode *node) {
     float squelch_level = node->hasAnother("squelch_level") ? (float) *node->getNext("squelch_level") : 0;
     int squelch_enabled = node->hasAnother("squelch_enabled") ? (int) *node->getNext("squelch_enabled") : 0;
     int muted = node->hasAnother("muted") ? (int) *node->getNext("muted") : 0;
+    //a stream_ssrc of older sessions is ignored: each instance picks its own.
+    int streaming = node->hasAnother("streaming") ? (int) *node->getNext("streaming") : 0;
     int delta_locked = node->hasAnother("delta_lock") ? (int) *node->getNext("delta_lock") : 0;
     int delta_ofs = node->hasAnother("delta_ofs") ? (int) *node->getNext("delta_ofs") : 0;
     std::string output_device = node->hasAnother("output_device") ? string(*(node->getNext("output_device"))) : "";
@@ -565,6 +598,9 @@ DemodulatorInstancePtr DemodulatorMgr::loadInstance(DataNode *node) {
     newDemod->setGain(gain);
     newDemod->updateLabel(freq);
     newDemod->setMuted(muted?true:false);
+    if (streaming) {
+        newDemod->setStreaming(true);
+    }
     if (delta_locked) {
         newDemod->setDeltaLock(true);
         newDemod->setDeltaLockOfs(delta_ofs);
@@ -587,7 +623,7 @@ DemodulatorInstancePtr DemodulatorMgr::loadInstance(DataNode *node) {
         }
     }
 	//if no device is found, choose the first of the list anyway.
-	if (!matching_device_found) {
+	if (!matching_device_found && !outputDevices.empty()) {
 		newDemod->setOutputDevice(outputDevices.begin()->first);
 	}
     
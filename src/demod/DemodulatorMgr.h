@@ -6,8 +6,10 @@
 #include <vector>
 #include <map>
 #include <thread>
+#include <mutex>
 
 #include "DemodulatorInstance.h"
+#include "DemodulatorIndex.h"
 
 class DataNode;
 
@@ -31,6 +33,15 @@ public:
     bool anyDemodulatorsAt(long long freq, int bandwidth);
     void deleteThread(DemodulatorInstancePtr);
 
+    //current frequency index of the demodulators, usable without any lock.
+    DemodulatorIndexPtr getIndex();
+
+    //version of the current index, a cheap check before getIndex().
+    unsigned long long getIndexVersion();
+
+    //to be called each time the frequency, bandwidth or type of demod changed.
+    void updateIndex(DemodulatorInstance *demod);
+
     void terminateAll();
 
     void setActiveDemodulator(DemodulatorInstancePtr demod, bool temporary = true);
@@ -85,6 +96,13 @@ private:
     //return an empty string.
     static std::wstring getSafeWstringValue(DataNode* node);
 
+    //publish a new index where demod is updated, or removed.
+    void indexDemodulator(DemodulatorInstancePtr demod, bool remove);
+    //publish a new index with the current currentModem.
+    void indexCurrentModem();
+    //with index_busy held: give next the next version and make it the current index.
+    void publishIndex(std::shared_ptr<DemodulatorIndex> next);
+
     std::vector<DemodulatorInstancePtr> demods;
     
     DemodulatorInstancePtr activeContextModem;
@@ -103,6 +121,12 @@ private:
     //protects access to demods lists and such, need to be recursive
     //because of the usage of public re-entrant methods 
     std::recursive_mutex demods_busy;
+
+    //replaced as a whole on each update, always read and written with std::atomic_load / std::atomic_store.
+    DemodulatorIndexPtr demodIndex;
+    //serializes the index updates, which may come from the demodulator threads.
+    std::mutex index_busy;
+    std::atomic<unsigned long long> indexVersion;
    
     std::map<std::string, ModemSettings> lastModemSettings;
     std::map<int,RtAudio::DeviceInfo> outputDevices;
@@ -9,7 +9,7 @@
 #endif
 
 #include "DemodulatorPreThread.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include "DemodulatorInstance.h"
 
 //50 ms
@@ -23,11 +23,15 @@ DemodulatorPreThread::DemodulatorPreThread(DemodulatorInstance* parent) : IOThre
     freqShifter = nco_crcf_create(LIQUID_VCO);
     shiftFrequency = 0;
 
+    latencyStats = PipelineStats::getStage("DemodulatorPreThread");
+
     workerQueue = std::make_shared<DemodulatorThreadWorkerCommandQueue>();
     workerQueue->set_max_num_items(2);
+    workerQueue->set_stats_name("DemodWorkerCommands");
 
     workerResults = std::make_shared<DemodulatorThreadWorkerResultQueue>();
     workerResults->set_max_num_items(100);
+    workerResults->set_stats_name("DemodWorkerResults");
      
     workerThread = new DemodulatorWorkerThread();
     workerThread->setInputQueue("WorkerCommandQueue",workerQueue);
@@ -64,6 +68,7 @@ void DemodulatorPreThread::run() {
 //    std::cout << "Demodulator preprocessor thread started.." << std::endl;
 
     ReBuffer<DemodulatorThreadPostIQData> buffers("DemodulatorPreThreadBuffers");
+    buffers.reserve(DEMOD_BUFFERS_RESERVE);
 
     iqInputQueue = std::static_pointer_cast<DemodulatorThreadInputQueue>(getInputQueue("IQDataInput"));
     iqOutputQueue = std::static_pointer_cast<DemodulatorThreadPostInputQueue>(getOutputQueue("IQDataOutput"));
@@ -79,6 +84,8 @@ void DemodulatorPreThread::run() {
         if (!iqInputQueue->pop(inp, HEARTBEAT_CHECK_PERIOD_MICROS)) {
             continue;
         }
+
+        latencyStats->recordSince(inp->ingestTime);
         
         if (frequencyChanged.load()) {
             currentFrequency.store(newFrequency);
@@ -198,6 +205,7 @@ void DemodulatorPreThread::run() {
             }
 
             DemodulatorThreadPostIQDataPtr resamp = buffers.getBuffer();
+            resamp->ingestTime = inp->ingestTime;
 
             size_t out_size = ceil((double) (bufSize) * iqResampleRatio) + 512;
 
@@ -211,8 +219,16 @@ void DemodulatorPreThread::run() {
             unsigned int numWritten;
             msresamp_crcf_execute(iqResampler, in_buf, bufSize, &resampledData[0], &numWritten);
 
+            //room for the largest block of this rate at once, instead of growing with the blocks.
+            if (resamp->data.capacity() < out_size) {
+                resamp->data.reserve(out_size);
+            }
             resamp->data.assign(resampledData.begin(), resampledData.begin() + numWritten);
 
+            //the frequency shift is instantaneous, the resampler delays its output.
+            long long resampledRate = std::llround((double)inp->sampleRate * iqResampleRatio);
+            resamp->timestamp = inp->timestamp.offset(-msresamp_crcf_get_delay(iqResampler), resampledRate);
+
             resamp->modemType = cModem->getType();
             resamp->modemName = cModem->getName();
             resamp->modem = cModem;
@@ -264,6 +280,9 @@ void DemodulatorPreThread::run() {
                         demodType = result.modemName;
                         demodTypeChanged.store(false);
                     }
+
+                    //the bandwidth and type are only effective now.
+                    SDREngine::get()->getDemodMgr().updateIndex(parent);
                         
                     shiftFrequency = inp->frequency-1;
                     initialized.store(cModem != nullptr);
@@ -73,6 +73,8 @@ protected:
     nco_crcf freqShifter;
     int shiftFrequency;
 
+    std::shared_ptr<LatencyStats> latencyStats;
+
     std::atomic_bool initialized;
     std::atomic_bool demodTypeChanged;
     std::string demodType;
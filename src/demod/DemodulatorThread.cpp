@@ -4,14 +4,22 @@
 #include "CubicSDRDefs.h"
 #include "DemodulatorThread.h"
 #include "DemodulatorInstance.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include <vector>
+#include <algorithm>
 
 #include <cmath>
 #ifndef M_PI
 #define M_PI        3.14159265358979323846
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DEMOD_STATS_SSE 1
+#else
+#define DEMOD_STATS_SSE 0
+#endif
+
 //50 ms
 #define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000) 
 
@@ -23,12 +31,13 @@ DemodulatorInstance* DemodulatorThread::squelchLock(nullptr);
 std::mutex DemodulatorThread::squelchLockMutex;
 
 DemodulatorThread::DemodulatorThread(DemodulatorInstance* parent)
-    : IOThread(), outputBuffers("DemodulatorThreadBuffers"), squelchLevel(-100), 
+    : IOThread(), outputBuffers("DemodulatorThreadBuffers"), visualBuffers("DemodulatorThreadVisualBuffers"), squelchLevel(-100), 
       signalLevel(-100), signalFloor(-30), signalCeil(30), squelchEnabled(false) {
     
     demodInstance = parent;
     muted.store(false);
     squelchBreak = false;
+    latencyStats = PipelineStats::getStage("DemodulatorThread");
 }
 
 DemodulatorThread::~DemodulatorThread() {
@@ -49,17 +58,103 @@ void DemodulatorThread::onBindOutput(std::string name, ThreadQueueBasePtr thread
 
         audioSinkOutputQueue = std::static_pointer_cast<AudioThreadInputQueue>(threadQueue);
     }
+
+    if (name == "AudioStream") {
+        std::lock_guard < SpinMutex > lock(m_mutexAudioVisOutputQueue);
+
+        audioStreamOutputQueue = std::static_pointer_cast<AudioThreadInputQueue>(threadQueue);
+    }
 }
 
-double DemodulatorThread::abMagnitude(float inphase, float quadrature) {
-    
-    // cast to double, so we keep precision despite the **2 op later.
-    double dinphase = (double)inphase;
-    double dquadrature = (double)quadrature;
+void DemodulatorThread::computeStats(const std::vector<float>& data, DemodulatorBlockStats& stats) {
+
+    size_t n = data.size();
+    const float *p = data.data();
+    size_t i = 0;
 
-    //sqrt() has been an insanely fast intrinsic for years, use it !
-    return sqrt(dinphase * dinphase + dquadrature * dquadrature);
+    float sumAbs = 0, sumSq = 0, peak = 0;
+
+#if DEMOD_STATS_SSE
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 vAbs = _mm_setzero_ps(), vSq = _mm_setzero_ps(), vPeak = _mm_setzero_ps();
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(p + i);
+        __m128 a = _mm_and_ps(x, absMask);
+        vAbs = _mm_add_ps(vAbs, a);
+        vSq = _mm_add_ps(vSq, _mm_mul_ps(x, x));
+        vPeak = _mm_max_ps(vPeak, a);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, vAbs);
+    sumAbs = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_storeu_ps(lanes, vSq);
+    sumSq = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_storeu_ps(lanes, vPeak);
+    peak = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+
+    //remainder, or the whole block without SSE.
+    for (; i < n; i++) {
+        float a = fabsf(p[i]);
+        sumAbs += a;
+        sumSq += a * a;
+        if (a > peak) {
+            peak = a;
+        }
+    }
+
+    stats.mean = n ? (sumAbs / float(n)) : 0;
+    stats.rms = n ? sqrtf(sumSq / float(n)) : 0;
+    stats.peak = peak;
+}
+
+void DemodulatorThread::computeStats(const std::vector<liquid_float_complex>& data, DemodulatorBlockStats& stats) {
+
+    size_t n = data.size();
+    //liquid_float_complex is laid out as interleaved (real, imag) floats.
+    const float *p = (const float *)data.data();
+    size_t i = 0;
+
+    float sumMag = 0, sumSq = 0, peakSq = 0;
+
+#if DEMOD_STATS_SSE
+    __m128 vMag = _mm_setzero_ps(), vSq = _mm_setzero_ps(), vPeak = _mm_setzero_ps();
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(p + i * 2);
+        __m128 b = _mm_loadu_ps(p + i * 2 + 4);
+        //de-interleave 4 complex samples into real and imag lanes
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 sq = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        vSq = _mm_add_ps(vSq, sq);
+        vMag = _mm_add_ps(vMag, _mm_sqrt_ps(sq));
+        vPeak = _mm_max_ps(vPeak, sq);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, vMag);
+    sumMag = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_storeu_ps(lanes, vSq);
+    sumSq = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_storeu_ps(lanes, vPeak);
+    peakSq = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+
+    for (; i < n; i++) {
+        float sq = p[i * 2] * p[i * 2] + p[i * 2 + 1] * p[i * 2 + 1];
+        sumSq += sq;
+        sumMag += sqrtf(sq);
+        if (sq > peakSq) {
+            peakSq = sq;
+        }
+    }
 
+    stats.mean = n ? (sumMag / float(n)) : 0;
+    stats.rms = n ? sqrtf(sumSq / float(n)) : 0;
+    stats.peak = sqrtf(peakSq);
 }
 
 double DemodulatorThread::linearToDb(double linear) {
@@ -71,6 +166,32 @@ double DemodulatorThread::linearToDb(double linear) {
     return 20.0 * log10(linear);
 }
 
+void DemodulatorThread::reserveOutputBuffers(size_t inputSize) {
+
+    //at most the size ModemAnalog::initOutputBuffers() gives to the resampled audio, for 2 channels:
+    //no audio block of this kit then grows the buffers.
+    double audioRatio = 1.0;
+    if (cModemKit->sampleRate > 0 && cModemKit->audioSampleRate > cModemKit->sampleRate) {
+        audioRatio = double(cModemKit->audioSampleRate) / double(cModemKit->sampleRate);
+    }
+    size_t audioSize = 2 * ((size_t)ceil(double(inputSize) * audioRatio) + 512);
+
+    outputBuffers.reserve(DEMOD_BUFFERS_RESERVE, [audioSize](AudioThreadInput& buffer) {
+        if (buffer.data.capacity() < audioSize) {
+            buffer.data.reserve(audioSize);
+        }
+    });
+
+    //the visual copy is DEMOD_VIS_SIZE stereo samples at most, or the whole input for digital modems.
+    size_t visualSize = std::max((size_t)DEMOD_VIS_SIZE, inputSize) * 2;
+
+    visualBuffers.reserve(2, [visualSize](AudioThreadInput& buffer) {
+        if (buffer.data.capacity() < visualSize) {
+            buffer.data.reserve(visualSize);
+        }
+    });
+}
+
 void DemodulatorThread::run() {
 #ifdef __APPLE__
     pthread_t tID = pthread_self();  // ID of this thread
@@ -93,6 +214,8 @@ void DemodulatorThread::run() {
         if (!iqInputQueue->pop(inp, HEARTBEAT_CHECK_PERIOD_MICROS)) {
             continue;
         }
+
+        latencyStats->recordSince(inp->ingestTime);
          
         size_t bufSize = inp->data.size();
         
@@ -106,6 +229,7 @@ void DemodulatorThread::run() {
                 cModem->disposeKit(cModemKit);
             }
             cModemKit = inp->modemKit;
+            reserveOutputBuffers(bufSize);
         }
         
         if (inp->modem && inp->modem != cModem) {
@@ -135,37 +259,41 @@ void DemodulatorThread::run() {
             
             ati->sampleRate = cModemKit->audioSampleRate;
             ati->inputRate = inp->sampleRate;
+            ati->ingestTime = inp->ingestTime;
         } else if (modemDigital != nullptr) {
             ati = outputBuffers.getBuffer();
             
             ati->sampleRate = cModemKit->sampleRate;
             ati->inputRate = inp->sampleRate;
+            ati->ingestTime = inp->ingestTime;
             ati->data.resize(0);
         }
 
         cModem->demodulate(cModemKit, &modemData, ati.get());
 
+        if (ati) {
+            ati->timestamp = inp->timestamp.offset(-cModem->getOutputDelay(cModemKit), ati->sampleRate);
+        }
+
         double currentSignalLevel = 0;
         double sampleTime = double(inp->data.size()) / double(inp->sampleRate);
 
-        if (audioOutputQueue != nullptr && ati && ati->data.size()) {
-            double accum = 0;
-
-             if (cModem->useSignalOutput()) {
+        //single pass over the audio output: mean magnitude, peak and RMS.
+        DemodulatorBlockStats audioStats;
 
-                for (auto i : ati->data) {
-                    accum += abMagnitude(i, 0.0);
-                }
+        if (ati && ati->data.size()) {
+            computeStats(ati->data, audioStats);
+        }
 
-                currentSignalLevel = linearToDb(accum / double(ati->data.size()));
+        if (audioOutputQueue != nullptr && ati && ati->data.size()) {
 
+            if (cModem->useSignalOutput()) {
+                currentSignalLevel = linearToDb(audioStats.mean);
             } else {
-   
-                for (auto i : inp->data) {
-                    accum += abMagnitude(i.real, i.imag);
-                }
+                DemodulatorBlockStats iqStats;
+                computeStats(inp->data, iqStats);
 
-                currentSignalLevel = linearToDb(accum / double(inp->data.size()));
+                currentSignalLevel = linearToDb(iqStats.mean);
             }
             
             float sf = signalFloor.load(), sc = signalCeil.load(), sl = squelchLevel.load();
@@ -205,12 +333,12 @@ void DemodulatorThread::run() {
         
         if (squelchEnabled) {
             if (!squelched && !squelchBreak) {
-                    if (wxGetApp().getSoloMode() && !wxGetApp().getAppFrame()->isUserDemodBusy()) {
+                    if (SDREngine::get()->getSoloMode() && !SDREngine::get()->isUserDemodBusy()) {
                         std::lock_guard < std::mutex > lock(squelchLockMutex);
                         if (squelchLock == nullptr) {
                             squelchLock = demodInstance;
-                            wxGetApp().getDemodMgr().setActiveDemodulator(nullptr);
-                            wxGetApp().getDemodMgr().setActiveDemodulatorByRawPointer(demodInstance, false);
+                            SDREngine::get()->getDemodMgr().setActiveDemodulator(nullptr);
+                            SDREngine::get()->getDemodMgr().setActiveDemodulatorByRawPointer(demodInstance, false);
                             squelchBreak = true;
                             demodInstance->getVisualCue()->triggerSquelchBreak(120);
                         }
@@ -225,24 +353,23 @@ void DemodulatorThread::run() {
             }
         }
 
-		//compute audio peak:
-		if (audioOutputQueue != nullptr && ati) {
-
-			ati->peak = 0;
-
-			for (auto data_i : ati->data) {
-				float p = fabs(data_i);
-				if (p > ati->peak) {
-					ati->peak = p;
-				}
-			}
-		}
+        //attach the audio peak and RMS, already computed above:
+        if (audioOutputQueue != nullptr && ati) {
+            ati->peak = audioStats.peak;
+            ati->rms = audioStats.rms;
+        }
 
 		//attach squelch flag to samples, to be used by audio sink.
 		if (ati) {
 			ati->is_squelch_active = squelched;
 		}
 
+        //digital modems have no audio output: their buffer only served the level above,
+        //and is dropped whether the scope is consuming or not.
+        if (modemDigital) {
+            ati = nullptr;
+        }
+
         //At that point, capture the current state of audioVisOutputQueue in a local 
         //variable, and works with it with now on until the next while-turn.
         DemodulatorThreadOutputQueuePtr localAudioVisOutputQueue = nullptr;
@@ -251,19 +378,18 @@ void DemodulatorThread::run() {
             localAudioVisOutputQueue = audioVisOutputQueue;
         }
 
-        if (!squelched && (ati || modemDigital) && localAudioVisOutputQueue != nullptr && localAudioVisOutputQueue->empty()) {
+        //only build the visual copy when the scope is actually consuming it.
+        bool visualConsumer = localAudioVisOutputQueue != nullptr && SDREngine::get()->isAudioVisualConsuming();
 
-            AudioThreadInputPtr ati_vis = std::make_shared<AudioThreadInput>();
+        if (!squelched && (ati || modemDigital) && visualConsumer && localAudioVisOutputQueue->empty()) {
+
+            AudioThreadInputPtr ati_vis = visualBuffers.getBuffer();
 
             ati_vis->sampleRate = inp->sampleRate;
             ati_vis->inputRate = inp->sampleRate;
             
             size_t num_vis = DEMOD_VIS_SIZE;
             if (modemDigital) {
-                if (ati) {  // TODO: handle digital modems with audio output
-                   
-                    ati = nullptr;
-                }
                 ati_vis->data.resize(inputData->size());
                 ati_vis->channels = 2;
                 for (int i = 0, iMax = inputData->size() / 2; i < iMax; i++) {
@@ -313,21 +439,17 @@ void DemodulatorThread::run() {
                 ati_vis->type = 0;
             }
             
+            //non-blocking push needed for audio vis out, a drop is counted in the queue telemetry.
             if (!localAudioVisOutputQueue->try_push(ati_vis)) {
-                //non-blocking push needed for audio vis out
-            
-                std::cout << "DemodulatorThread::run() cannot push ati_vis into localAudioVisOutputQueue, is full !" << std::endl;
                 std::this_thread::yield();
             }
         }
 
         if (!squelched && ati != nullptr) {
-            if (!muted.load() && (!wxGetApp().getSoloMode() || (demodInstance ==
-                    wxGetApp().getDemodMgr().getCurrentModem().get()))) {
-                //non-blocking push needed for audio out
+            if (!muted.load() && (!SDREngine::get()->getSoloMode() || (demodInstance ==
+                    SDREngine::get()->getDemodMgr().getCurrentModem().get()))) {
+                //non-blocking push needed for audio out, a drop is counted in the queue telemetry.
                 if (!audioOutputQueue->try_push(ati)) {
-                  
-                    std::cout << "DemodulatorThread::run() cannot push ati into audioOutputQueue, is full !" << std::endl;
                     std::this_thread::yield();
                 }
             }
@@ -336,20 +458,26 @@ void DemodulatorThread::run() {
         
         // Capture audioSinkOutputQueue state in a local variable
         DemodulatorThreadOutputQueuePtr localAudioSinkOutputQueue = nullptr;
+        DemodulatorThreadOutputQueuePtr localAudioStreamOutputQueue = nullptr;
         {
             std::lock_guard < SpinMutex > lock(m_mutexAudioVisOutputQueue);
             localAudioSinkOutputQueue = audioSinkOutputQueue;
+            localAudioStreamOutputQueue = audioStreamOutputQueue;
         }
 
         //Push to audio sink, if any:
         if (ati && localAudioSinkOutputQueue != nullptr) {
             
             if (!localAudioSinkOutputQueue->try_push(ati)) {
-                std::cout << "DemodulatorThread::run() cannot push ati into audioSinkOutputQueue, is full !" << std::endl;
                 std::this_thread::yield();
             }
         }
 
+        //and to the network stream, if any: a late stream drops the block, counted in "AudioStreamInput".
+        if (ati && localAudioStreamOutputQueue != nullptr) {
+            localAudioStreamOutputQueue->try_push(ati);
+        }
+
         DemodulatorThreadControlCommand command;
         
         //empty command queue, execute commands
@@ -18,6 +18,14 @@
 
 class DemodulatorInstance;
 
+//Statistics of a single demodulator block, produced in one pass by DemodulatorThread::computeStats()
+class DemodulatorBlockStats {
+public:
+    float mean = 0;
+    float peak = 0;
+    float rms = 0;
+};
+
 class DemodulatorThread : public IOThread {
 public:
 
@@ -44,11 +52,19 @@ public:
     static void releaseSquelchLock(DemodulatorInstance* inst);
 protected:
     
-    double abMagnitude(float inphase, float quadrature);
+    //Fused mean magnitude / peak / RMS reductions, vectorized where SSE is available.
+    static void computeStats(const std::vector<float>& data, DemodulatorBlockStats& stats);
+    static void computeStats(const std::vector<liquid_float_complex>& data, DemodulatorBlockStats& stats);
+
     double linearToDb(double linear);
 
+    //size the output pools for the kit just received, from its first input block of 'inputSize' samples.
+    void reserveOutputBuffers(size_t inputSize);
+
     DemodulatorInstance* demodInstance;
     ReBuffer<AudioThreadInput> outputBuffers;
+    ReBuffer<AudioThreadInput> visualBuffers;
+    std::shared_ptr<LatencyStats> latencyStats;
 
     std::atomic_bool muted;
 
@@ -69,6 +85,7 @@ protected:
     DemodulatorThreadControlCommandQueuePtr threadQueueControl;
 
     DemodulatorThreadOutputQueuePtr audioSinkOutputQueue = nullptr;
+    DemodulatorThreadOutputQueuePtr audioStreamOutputQueue = nullptr;
 
     //protects the audioVisOutputQueue dynamic binding change at runtime (in DemodulatorMgr)
     SpinMutex m_mutexAudioVisOutputQueue;
@@ -3,7 +3,7 @@
 
 #include "DemodulatorWorkerThread.h"
 #include "CubicSDRDefs.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include <vector>
 
 //50 ms
@@ -71,7 +71,7 @@ void DemodulatorWorkerThread::run() {
                 }
                 std::cout << "makeDemod: sampleRate=" << demodCommand.sampleRate << std::endl;
                 result.sampleRate = demodCommand.sampleRate;
-                wxGetApp().getAppFrame()->notifyUpdateModemProperties();
+                SDREngine::get()->notifyModemPropertiesChanged();
             }
             result.modem = cModem;
 
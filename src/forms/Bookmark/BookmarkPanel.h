@@ -66,6 +66,7 @@ class BookmarkPanel : public wxPanel
 		virtual void onTreeActivate( wxTreeEvent& event ) { event.Skip(); }
 		virtual void onTreeCollapse( wxTreeEvent& event ) { event.Skip(); }
 		virtual void onTreeExpanded( wxTreeEvent& event ) { event.Skip(); }
+		virtual void onTreeExpanding( wxTreeEvent& event ) { event.Skip(); }
 		virtual void onTreeItemGetTooltip( wxTreeEvent& event ) { event.Skip(); }
 		virtual void onTreeItemMenu( wxTreeEvent& event ) { event.Skip(); }
 		virtual void onTreeSelect( wxTreeEvent& event ) { event.Skip(); }
@@ -23,6 +23,10 @@
 #define BOOKMARK_VIEW_STR_UNNAMED "Unnamed"
 #define BOOKMARK_VIEW_STR_CLEAR_RECENT "Clear Recents"
 #define BOOKMARK_VIEW_STR_RENAME_GROUP "Rename Group"
+#define BOOKMARK_VIEW_STR_MORE "(%d more..)"
+
+//bookmarks of a group added to the tree at a time: the rest only when scrolled to.
+#define BOOKMARK_VIEW_GROUP_PAGE_SIZE 200
 
 
 BookmarkViewVisualDragItem::BookmarkViewVisualDragItem(wxString labelValue) : wxDialog(NULL, wxID_ANY, L"", wxPoint(20,20), wxSize(-1,-1), wxFRAME_TOOL_WINDOW | wxNO_BORDER | wxSTAY_ON_TOP | wxALL ) {
@@ -114,10 +118,8 @@ public:
     void doClickOK() {
         BookmarkRangeEntryPtr ue = BookmarkView::makeActiveRangeEntry();
 
-        subject->freq = ue->freq;
-        subject->startFreq = ue->startFreq;
-        subject->endFreq = ue->endFreq;
-          
+        wxGetApp().getBookmarkMgr().updateRange(subject, ue->freq, ue->startFreq, ue->endFreq);
+
         wxGetApp().getBookmarkMgr().updateActiveList();
     }
     
@@ -186,6 +188,14 @@ void BookmarkView::onUpdateTimer( wxTimerEvent& /* event */ ) {
         }  
         doUpdateBookmarks.store(false);  
     }
+
+    //scrolled down to the end of a partially shown group: add its next page.
+    for (auto &more_i : groupMoreItem) {
+        if (more_i.second.IsOk() && m_treeView->IsVisible(more_i.second)) {
+            expandMoreItem(more_i.second);
+            break;
+        }
+    }
 }
 
 bool BookmarkView::skipEvents() {
@@ -237,23 +247,43 @@ void BookmarkView::updateBookmarks(std::string group) {
     doUpdateBookmarks.store(true);
 }
 
-bool BookmarkView::isKeywordMatch(std::wstring search_str, std::vector<std::wstring> &keywords) {
-    wstring str = search_str;
-    std::transform(str.begin(), str.end(), str.begin(), towlower);
+bool BookmarkView::isKeywordMatch(std::wstring search_str, std::vector<BookmarkSearchPhrase> &phrases) {
+    std::vector<std::wstring> tokens;
 
-    for (auto k : keywords) {
-        if (str.find(k) == wstring::npos) {
-            return false;
-        }
+    //same word matching as the bookmark search index.
+    BookmarkMgr::getSearchTokens(search_str, tokens);
+
+    return BookmarkMgr::isSearchMatch(tokens, phrases);
+}
+
+void BookmarkView::updateSearchResult() {
+
+    BookmarkMgr &mgr = wxGetApp().getBookmarkMgr();
+    unsigned long long version = mgr.getSearchIndexVersion();
+
+    //typing more of the same words can only narrow the previous result: refine it instead of searching again.
+    bool refine = (version == lastSearchVersion && lastSearchKeywords.size() > 0 && searchKeywords.size() >= lastSearchKeywords.size());
+
+    for (size_t i = 0; refine && i < lastSearchKeywords.size(); i++) {
+        refine = (searchKeywords[i].compare(0, lastSearchKeywords[i].length(), lastSearchKeywords[i]) == 0);
     }
-    
-    return true;
+
+    if (refine) {
+        BookmarkSearchResult previous;
+        previous.swap(lastSearchResult);
+        lastSearchResult = mgr.searchBookmarks(searchKeywords, &previous);
+    } else {
+        lastSearchResult = mgr.searchBookmarks(searchKeywords);
+    }
+
+    lastSearchKeywords = searchKeywords;
+    lastSearchVersion = version;
 }
 
 wxTreeItemId BookmarkView::refreshBookmarks() {
     
-    //capture the previously selected item info BY COPY (because the original will be destroyed together with the destroyed tree items) to restore it again after 
-    //having rebuilding the whole tree.
+    //capture the previously selected item info BY COPY (because the original may be destroyed together with the removed tree items) to restore it again after 
+    //having updated the tree.
     TreeViewItem* prevSel = itemToTVI(m_treeView->GetSelection());
     TreeViewItem* prevSelCopy = nullptr;
 
@@ -268,22 +298,34 @@ wxTreeItemId BookmarkView::refreshBookmarks() {
    
     wxTreeItemId bmSelFound = nullptr;
     
-    std::map<std::string, bool> groupExpandState;
     bool searchState = (searchKeywords.size() != 0);
-    
-    groups.clear();
 
-    m_treeView->DeleteChildren(bookmarkBranch);
+    if (searchState) {
+        updateSearchResult();
+    }
 
-    bool bmExpandState = expandState["bookmark"];
+    m_treeView->Freeze();
+    
+    TreeViewRows groupRows;
 
     for (auto gn_i : groupNames) {
-        TreeViewItem* tvi = new TreeViewItem();
-        tvi->type = TreeViewItem::TREEVIEW_ITEM_TYPE_GROUP;
-        tvi->groupName = gn_i;
-        wxTreeItemId group_itm = m_treeView->AppendItem(bookmarkBranch, gn_i);
-        SetTreeItemData(group_itm, tvi);
+        TreeViewItem tvi;
+        tvi.type = TreeViewItem::TREEVIEW_ITEM_TYPE_GROUP;
+        tvi.groupName = gn_i;
+        groupRows.push_back(TreeViewRow(tvi, gn_i));
+    }
+
+    std::vector<wxTreeItemId> groupItems = syncChildren(bookmarkBranch, groupRows);
+
+    groups.clear();
+    groupMoreItem.clear();
+
+    for (size_t i = 0; i < groupNames.size(); i++) {
+        std::string gn_i = groupNames[i];
+        wxTreeItemId group_itm = groupItems[i];
+
         groups[gn_i] = group_itm;
+
         if (prevSelCopy != nullptr && prevSelCopy->type == TreeViewItem::TREEVIEW_ITEM_TYPE_GROUP && gn_i == prevSelCopy->groupName) {
             bmSelFound = group_itm;
         } else if (nextGroup != "" && gn_i == nextGroup) {
@@ -292,72 +334,213 @@ wxTreeItemId BookmarkView::refreshBookmarks() {
         }
     }
 
-    if (searchState || bmExpandState) {
+    if (searchState || expandState["bookmark"]) {
         m_treeView->Expand(bookmarkBranch);
     } else {
         m_treeView->Collapse(bookmarkBranch);
     }
 
     for (auto gn_i : groupNames) {
-        wxTreeItemId groupItem = groups[gn_i];
-
         bool groupExpanded = searchState || wxGetApp().getBookmarkMgr().getExpandState(gn_i);
 
-        BookmarkList bmList = wxGetApp().getBookmarkMgr().getBookmarks(gn_i);
+        wxTreeItemId groupSel = refreshGroup(gn_i, groups[gn_i], groupExpanded, prevSelCopy);
 
+        if (groupSel) {
+            bmSelFound = groupSel;
+        }
+
+        if (groupExpanded) {
+            m_treeView->Expand(groups[gn_i]);
+        }
+    }
+
+    m_treeView->Thaw();
+
+    delete prevSelCopy;
+
+    return bmSelFound;
+}
+
+wxTreeItemId BookmarkView::refreshGroup(std::string groupName, wxTreeItemId groupItem, bool &groupExpanded, TreeViewItem *prevSel) {
+
+    bool searchState = (searchKeywords.size() != 0);
+    BookmarkList bmList = wxGetApp().getBookmarkMgr().getBookmarks(groupName);
+
+    if (groupRowLimit.find(groupName) == groupRowLimit.end()) {
+        groupRowLimit[groupName] = BOOKMARK_VIEW_GROUP_PAGE_SIZE;
+    }
+    size_t &rowLimit = groupRowLimit[groupName];
+
+    TreeViewRows rows;
+    size_t numMatches = 0;
+
+    for (auto &bmEnt : bmList) {
+        if (searchState && lastSearchResult.find(bmEnt.get()) == lastSearchResult.end()) {
+            continue;
+        }
+
+        //a bookmark to be selected is always materialized, even in a collapsed group.
+        if (nextEnt == bmEnt) {
+            groupExpanded = true;
+            rowLimit = std::max(rowLimit, numMatches + 1);
+        }
+
+        numMatches++;
+    }
+
+    //a collapsed group has no children items until it is expanded, only its expand button.
+    if (groupExpanded) {
         for (auto &bmEnt : bmList) {
-            std::wstring labelVal = BookmarkMgr::getBookmarkEntryDisplayName(bmEnt);
-
-            if (searchState) {
-                std::string freqStr = frequencyToStr(bmEnt->frequency);
-                std::string bwStr = frequencyToStr(bmEnt->bandwidth);
-
-                std::wstring fullText = labelVal +
-                    L" " + bmEnt->label +
-                    L" " + std::to_wstring(bmEnt->frequency) +
-                    L" " + wxString(freqStr).ToStdWstring() +
-                    L" " + wxString(bwStr).ToStdWstring() +
-                    L" " + wxString(bmEnt->type).ToStdWstring();
-                
-                if (!isKeywordMatch(fullText, searchKeywords)) {
-                    continue;
-                }
+            if (rows.size() == rowLimit) {
+                break;
             }
-            
-            TreeViewItem* tvi = new TreeViewItem();
-            tvi->type = TreeViewItem::TREEVIEW_ITEM_TYPE_BOOKMARK;
-            tvi->bookmarkEnt = bmEnt;
-            tvi->groupName = gn_i;
-            
-            wxTreeItemId itm = m_treeView->AppendItem(groupItem, labelVal);
-            SetTreeItemData(itm, tvi);
-            if (prevSelCopy != nullptr && prevSelCopy->type == TreeViewItem::TREEVIEW_ITEM_TYPE_BOOKMARK && prevSelCopy->bookmarkEnt == bmEnt && groupExpanded) {
-                bmSelFound = itm;
-            }
-            if (nextEnt == bmEnt) {
-                bmSelFound = itm;
-                nextEnt = nullptr;
+
+            if (searchState && lastSearchResult.find(bmEnt.get()) == lastSearchResult.end()) {
+                continue;
             }
+
+            TreeViewItem tvi;
+            tvi.type = TreeViewItem::TREEVIEW_ITEM_TYPE_BOOKMARK;
+            tvi.bookmarkEnt = bmEnt;
+            tvi.groupName = groupName;
+
+            rows.push_back(TreeViewRow(tvi, BookmarkMgr::getBookmarkEntryDisplayName(bmEnt)));
         }
 
-        if (groupExpanded) {
-            m_treeView->Expand(groupItem);
+        if (numMatches > rows.size()) {
+            TreeViewItem tvi;
+            tvi.type = TreeViewItem::TREEVIEW_ITEM_TYPE_MORE;
+            tvi.groupName = groupName;
+
+            rows.push_back(TreeViewRow(tvi, wxString::Format(BOOKMARK_VIEW_STR_MORE, (int)(numMatches - rows.size()))));
         }
     }
 
-    delete prevSelCopy;
+    std::vector<wxTreeItemId> items = syncChildren(groupItem, rows);
+
+    m_treeView->SetItemHasChildren(groupItem, numMatches > 0);
+
+    wxTreeItemId bmSelFound = nullptr;
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        const TreeViewItem &tvi = rows[i].item;
+
+        if (tvi.type == TreeViewItem::TREEVIEW_ITEM_TYPE_MORE) {
+            groupMoreItem[groupName] = items[i];
+            continue;
+        }
+
+        if (prevSel != nullptr && prevSel->type == TreeViewItem::TREEVIEW_ITEM_TYPE_BOOKMARK && prevSel->bookmarkEnt == tvi.bookmarkEnt && groupExpanded) {
+            bmSelFound = items[i];
+        }
+        if (nextEnt == tvi.bookmarkEnt) {
+            bmSelFound = items[i];
+            nextEnt = nullptr;
+        }
+    }
 
     return bmSelFound;
 }
 
+std::vector<wxTreeItemId> BookmarkView::syncChildren(wxTreeItemId parent, const TreeViewRows& rows) {
+
+    std::vector<wxTreeItemId> items;
+    items.reserve(rows.size());
+
+    //rows still to be placed: an existing item of one of them is kept, any other item is removed.
+    std::set<TreeViewItemKey> pending;
+
+    for (auto &row : rows) {
+        pending.insert(row.item.getKey());
+    }
+
+    wxTreeItemIdValue cookie;
+    wxTreeItemId cursor = m_treeView->GetFirstChild(parent, cookie);
+    wxTreeItemId prev = nullptr;
+
+    for (auto &row : rows) {
+        wxTreeItemId itm = nullptr;
+        TreeViewItemKey key = row.item.getKey();
+
+        while (cursor.IsOk()) {
+            TreeViewItem *tvi = itemToTVI(cursor);
+
+            if (tvi != nullptr && tvi->getKey() == key) {
+                itm = cursor;
+                break;
+            }
+
+            if (tvi != nullptr && pending.count(tvi->getKey())) {
+                //the item of a later row: the current row comes before it.
+                break;
+            }
+
+            wxTreeItemId next = m_treeView->GetNextSibling(cursor);
+            m_treeView->Delete(cursor);
+            cursor = next;
+        }
+
+        if (itm.IsOk()) {
+            if (m_treeView->GetItemText(itm) != row.label) {
+                m_treeView->SetItemText(itm, row.label);
+            }
+            cursor = m_treeView->GetNextSibling(cursor);
+        } else {
+            if (prev.IsOk()) {
+                itm = m_treeView->InsertItem(parent, prev, row.label);
+            } else {
+                itm = m_treeView->PrependItem(parent, row.label);
+            }
+            SetTreeItemData(itm, new TreeViewItem(row.item));
+        }
+
+        pending.erase(key);
+        items.push_back(itm);
+        prev = itm;
+    }
+
+    //past the last row
+    while (cursor.IsOk()) {
+        wxTreeItemId next = m_treeView->GetNextSibling(cursor);
+        m_treeView->Delete(cursor);
+        cursor = next;
+    }
+
+    return items;
+}
+
+bool BookmarkView::expandMoreItem(wxTreeItemId moreItem) {
+
+    TreeViewItem *tvi = itemToTVI(moreItem);
+
+    if (tvi == nullptr || tvi->type != TreeViewItem::TREEVIEW_ITEM_TYPE_MORE) {
+        return false;
+    }
+
+    std::string groupName = tvi->groupName;
+    bool searchState = (searchKeywords.size() != 0);
+
+    bool groupExpanded = searchState || wxGetApp().getBookmarkMgr().getExpandState(groupName);
+
+    groupRowLimit[groupName] += BOOKMARK_VIEW_GROUP_PAGE_SIZE;
+    groupMoreItem.erase(groupName);
+
+    //the group only, the rows already there are kept as is.
+    m_treeView->Freeze();
+    refreshGroup(groupName, groups[groupName], groupExpanded, nullptr);
+    m_treeView->Thaw();
+
+    return true;
+}
+
 
 void BookmarkView::doUpdateActiveList() {
 
     auto demods = wxGetApp().getDemodMgr().getDemodulators();
     auto lastActiveDemodulator = wxGetApp().getDemodMgr().getCurrentModem();
 
-    //capture the previously selected item info BY COPY (because the original will be destroyed together with the destroyed tree items) to restore it again after 
-    //having rebuilding the whole tree.
+    //capture the previously selected item info BY COPY (because the original may be destroyed together with the removed tree items) to restore it again after 
+    //having updated the tree.
     TreeViewItem* prevSel = itemToTVI(m_treeView->GetSelection());
     TreeViewItem* prevSelCopy = nullptr;
    
@@ -365,11 +548,13 @@ void BookmarkView::doUpdateActiveList() {
         prevSelCopy = new TreeViewItem(*prevSel);
     }
 
+    m_treeView->Freeze();
+
     // Actives
-    m_treeView->DeleteChildren(activeBranch);
-    
     bool activeExpandState = expandState["active"];
     bool searchState = (searchKeywords.size() != 0);
+
+    TreeViewRows activeRows;
     
     wxTreeItemId selItem = nullptr;
     for (auto demod_i : demods) {
@@ -387,23 +572,28 @@ void BookmarkView::doUpdateActiveList() {
             L" " + wxString(bwStr).ToStdWstring() +
             L" " + wxString(mtype).ToStdWstring();
             
-            if (!isKeywordMatch(fullText, searchKeywords)) {
+            if (!isKeywordMatch(fullText, searchPhrases)) {
                 continue;
             }
         }
 
-        TreeViewItem* tvi = new TreeViewItem();
-        tvi->type = TreeViewItem::TREEVIEW_ITEM_TYPE_ACTIVE;
-        tvi->demod = demod_i;
+        TreeViewItem tvi;
+        tvi.type = TreeViewItem::TREEVIEW_ITEM_TYPE_ACTIVE;
+        tvi.demod = demod_i;
+
+        activeRows.push_back(TreeViewRow(tvi, activeLabel));
+    }
+
+    std::vector<wxTreeItemId> activeItems = syncChildren(activeBranch, activeRows);
+
+    for (size_t i = 0; i < activeRows.size(); i++) {
+        DemodulatorInstancePtr demod_i = activeRows[i].item.demod;
 
-        wxTreeItemId itm = m_treeView->AppendItem(activeBranch,activeLabel);
-        SetTreeItemData(itm, tvi);
-        
         if (nextDemod != nullptr && nextDemod == demod_i) {
-            selItem = itm;
+            selItem = activeItems[i];
             nextDemod = nullptr;
         } else if (!selItem && activeExpandState && lastActiveDemodulator && lastActiveDemodulator == demod_i) {
-            selItem = itm;
+            selItem = activeItems[i];
         }
     }
 
@@ -412,12 +602,12 @@ void BookmarkView::doUpdateActiveList() {
 	//Ranges
     BookmarkRangeList bmRanges = wxGetApp().getBookmarkMgr().getRanges();
 
-    m_treeView->DeleteChildren(rangeBranch);
+    TreeViewRows rangeRows;
     
     for (auto &re_i: bmRanges) {
-        TreeViewItem* tvi = new TreeViewItem();
-        tvi->type = TreeViewItem::TREEVIEW_ITEM_TYPE_RANGE;
-        tvi->rangeEnt = re_i;
+        TreeViewItem tvi;
+        tvi.type = TreeViewItem::TREEVIEW_ITEM_TYPE_RANGE;
+        tvi.rangeEnt = re_i;
         
         std::wstring labelVal = re_i->label;
         
@@ -427,14 +617,19 @@ void BookmarkView::doUpdateActiveList() {
             labelVal = wxString(wstr).ToStdWstring();
         }
         
-        wxTreeItemId itm = m_treeView->AppendItem(rangeBranch, labelVal);
-        SetTreeItemData(itm, tvi);
-        
+        rangeRows.push_back(TreeViewRow(tvi, labelVal));
+    }
+
+    std::vector<wxTreeItemId> rangeItems = syncChildren(rangeBranch, rangeRows);
+
+    for (size_t i = 0; i < rangeRows.size(); i++) {
+        BookmarkRangeEntryPtr re_i = rangeRows[i].item.rangeEnt;
+
         if (nextRange == re_i) {
-            selItem = itm;
+            selItem = rangeItems[i];
             nextRange = nullptr;
         } else if (!selItem && rangeExpandState && prevSelCopy && prevSelCopy->type == TreeViewItem::TREEVIEW_ITEM_TYPE_RANGE && prevSelCopy->rangeEnt == re_i) {
-            selItem = itm;
+            selItem = rangeItems[i];
         }
     }
      
@@ -442,13 +637,13 @@ void BookmarkView::doUpdateActiveList() {
     
     // Recents
     BookmarkList bmRecents = wxGetApp().getBookmarkMgr().getRecents();
-    
-	m_treeView->DeleteChildren(recentBranch);
+
+    TreeViewRows recentRows;
     
     for (auto &bmr_i: bmRecents) {
-        TreeViewItem* tvi = new TreeViewItem();
-        tvi->type = TreeViewItem::TREEVIEW_ITEM_TYPE_RECENT;
-        tvi->bookmarkEnt = bmr_i;
+        TreeViewItem tvi;
+        tvi.type = TreeViewItem::TREEVIEW_ITEM_TYPE_RECENT;
+        tvi.bookmarkEnt = bmr_i;
 
         std::wstring labelVal;
         bmr_i->node->child("user_label")->element()->get(labelVal);
@@ -471,19 +666,24 @@ void BookmarkView::doUpdateActiveList() {
                 L" " + wxString(bwStr).ToStdWstring() +
                 L" " + wxString(bmr_i->type).ToStdWstring();
             
-            if (!isKeywordMatch(fullText, searchKeywords)) {
+            if (!isKeywordMatch(fullText, searchPhrases)) {
                 continue;
             }
         }
         
-        wxTreeItemId itm = m_treeView->AppendItem(recentBranch, labelVal);
-        SetTreeItemData(itm, tvi);
+        recentRows.push_back(TreeViewRow(tvi, labelVal));
+    }
+
+    std::vector<wxTreeItemId> recentItems = syncChildren(recentBranch, recentRows);
+
+    for (size_t i = 0; i < recentRows.size(); i++) {
+        BookmarkEntryPtr bmr_i = recentRows[i].item.bookmarkEnt;
 
         if (nextEnt == bmr_i) {
-            selItem = itm;
+            selItem = recentItems[i];
             nextEnt = nullptr;
         } else if (!selItem && recentExpandState && prevSelCopy && prevSelCopy->type == TreeViewItem::TREEVIEW_ITEM_TYPE_RECENT && prevSelCopy->bookmarkEnt == bmr_i) {
-            selItem = itm;
+            selItem = recentItems[i];
         }
     }
     
@@ -503,6 +703,8 @@ void BookmarkView::doUpdateActiveList() {
         m_treeView->Collapse(rangeBranch);
     }
 
+    m_treeView->Thaw();
+
     //select the item having the same meaning as the previously selected item
     if (selItem != nullptr) {
         m_treeView->SelectItem(selItem);
@@ -582,6 +784,8 @@ void BookmarkView::onTreeActivate( wxTreeEvent& event ) {
         activateBookmark(tvi->bookmarkEnt);
     } else if (tvi->type == TreeViewItem::TREEVIEW_ITEM_TYPE_RANGE) {
         activateRange(tvi->rangeEnt);
+    } else if (tvi->type == TreeViewItem::TREEVIEW_ITEM_TYPE_MORE) {
+        expandMoreItem(itm);
     }
 }
 
@@ -616,6 +820,23 @@ void BookmarkView::onTreeCollapse( wxTreeEvent& event ) {
 }
 
 
+void BookmarkView::onTreeExpanding( wxTreeEvent& event ) {
+
+    TreeViewItem *tvi = itemToTVI(event.GetItem());
+
+    //the bookmarks of a collapsed group are not in the tree: add them now, before it opens.
+    if (tvi != nullptr && tvi->type == TreeViewItem::TREEVIEW_ITEM_TYPE_GROUP && !m_treeView->GetChildrenCount(event.GetItem(), false)) {
+        bool groupExpanded = true;
+
+        m_treeView->Freeze();
+        refreshGroup(tvi->groupName, event.GetItem(), groupExpanded, nullptr);
+        m_treeView->Thaw();
+    }
+
+    event.Skip();
+}
+
+
 void BookmarkView::onTreeExpanded( wxTreeEvent& event ) {
 
     bool searchState = (searchKeywords.size() != 0);
@@ -931,7 +1152,8 @@ void BookmarkView::activateBookmark(BookmarkEntryPtr bmEnt) {
 	long long currentFreq = wxGetApp().getFrequency();
 	long long currentRate = wxGetApp().getSampleRate();
 
-	if ((abs(freq - currentFreq) > currentRate / 2) || (abs(currentFreq - freq) > currentRate / 2)) {
+	//no retuning either if an additional receiver covers it.
+	if (((abs(freq - currentFreq) > currentRate / 2) || (abs(currentFreq - freq) > currentRate / 2)) && SDRCoverage::getReceiverAt(freq) < 0) {
 		wxGetApp().setFrequency(freq);
 	}
 
@@ -1183,15 +1405,13 @@ void BookmarkView::onLabelText( wxCommandEvent& /* event */ ) {
             curSel->demod->setDemodulatorUserLabel(newLabel);
             wxGetApp().getBookmarkMgr().updateActiveList();
         } else if (curSel->type == TreeViewItem::TREEVIEW_ITEM_TYPE_BOOKMARK) {
-            curSel->bookmarkEnt->label = m_labelText->GetValue().ToStdWstring();
-            curSel->bookmarkEnt->node->child("user_label")->element()->set(newLabel);
+            wxGetApp().getBookmarkMgr().setBookmarkLabel(curSel->bookmarkEnt, newLabel);
             wxGetApp().getBookmarkMgr().updateBookmarks();
         } else if (curSel->type == TreeViewItem::TREEVIEW_ITEM_TYPE_RECENT) {
-            curSel->bookmarkEnt->label = m_labelText->GetValue().ToStdWstring();
-            curSel->bookmarkEnt->node->child("user_label")->element()->set(newLabel);
+            wxGetApp().getBookmarkMgr().setBookmarkLabel(curSel->bookmarkEnt, newLabel);
             wxGetApp().getBookmarkMgr().updateActiveList();
         } else if (curSel->type == TreeViewItem::TREEVIEW_ITEM_TYPE_RANGE) {
-            curSel->rangeEnt->label = m_labelText->GetValue().ToStdWstring();
+            wxGetApp().getBookmarkMgr().setRangeLabel(curSel->rangeEnt, newLabel);
             wxGetApp().getBookmarkMgr().updateActiveList();
         } else if (curSel->type == TreeViewItem::TREEVIEW_ITEM_TYPE_GROUP) {
             std::string newGroupName = m_labelText->GetValue().ToStdString();
@@ -1593,11 +1813,18 @@ void BookmarkView::onSearchText( wxCommandEvent& /* event */ ) {
         
         while(std::getline(searchTextLo, tmp, L' ')) {
             if (tmp.length() != 0 && tmp.find(L"search.") == std::wstring::npos) {
+                //"100.5" searches for the words "100" then "5", next to each other.
                 searchKeywords.push_back(tmp);
-//                std::wcout << L"Keyword: " << tmp << '\n';
             }
         }
     }
+
+    BookmarkMgr::getSearchPhrases(searchKeywords, searchPhrases);
+
+    //nothing to search in punctuation only.
+    if (searchPhrases.empty()) {
+        searchKeywords.clear();
+    }
     
     if (searchKeywords.size() != 0 && !m_clearSearchButton->IsShown()) {
         m_clearSearchButton->Show();
@@ -1619,6 +1846,7 @@ void BookmarkView::onClearSearch( wxCommandEvent& /* event */ ) {
     m_treeView->SetFocus();
 
     searchKeywords.clear();
+    searchPhrases.clear();
 
     wxGetApp().getBookmarkMgr().updateActiveList();
     wxGetApp().getBookmarkMgr().updateBookmarks();
@@ -6,10 +6,14 @@
 #include "wx/choice.h"
 #include "wx/dialog.h"
 
+#include <tuple>
+
 #include "BookmarkPanel.h"
 #include "BookmarkMgr.h"
 #include "MouseTracker.h"
 
+typedef std::tuple<int, const void *, std::string> TreeViewItemKey;
+
 class TreeViewItem : public wxTreeItemData {
 public:
     enum TreeViewItemType {
@@ -17,7 +21,9 @@ public:
         TREEVIEW_ITEM_TYPE_ACTIVE,
         TREEVIEW_ITEM_TYPE_RECENT,
         TREEVIEW_ITEM_TYPE_BOOKMARK,
-        TREEVIEW_ITEM_TYPE_RANGE
+        TREEVIEW_ITEM_TYPE_RANGE,
+        //stands for the bookmarks of groupName not in the tree yet.
+        TREEVIEW_ITEM_TYPE_MORE
     };
     
     TreeViewItem() {
@@ -37,6 +43,14 @@ public:
     virtual ~TreeViewItem() {
       //
     };
+
+    //items of the same key show the same thing, so one tree item can stand for the other.
+    TreeViewItemKey getKey() const {
+        const void *entry = bookmarkEnt ? (const void *)bookmarkEnt.get() : rangeEnt ? (const void *)rangeEnt.get() : (const void *)demod.get();
+        bool isGroup = (type == TREEVIEW_ITEM_TYPE_GROUP || type == TREEVIEW_ITEM_TYPE_MORE);
+
+        return TreeViewItemKey(type, entry, isGroup ? groupName : std::string());
+    }
     
     TreeViewItemType type;
     
@@ -48,6 +62,19 @@ public:
 };
 
 
+//A wanted child item of the tree: its data and text.
+class TreeViewRow {
+public:
+    TreeViewRow(const TreeViewItem& item, const wxString& label) : item(item), label(label) {
+    }
+
+    TreeViewItem item;
+    wxString label;
+};
+
+typedef std::vector<TreeViewRow> TreeViewRows;
+
+
 class BookmarkViewVisualDragItem : public wxDialog {
 public:
     BookmarkViewVisualDragItem(wxString labelValue = L"Popup");
@@ -70,7 +97,7 @@ public:
     void updateBookmarks();
     void updateBookmarks(std::string group);
 
-    bool isKeywordMatch(std::wstring str, std::vector<std::wstring> &keywords);
+    bool isKeywordMatch(std::wstring str, std::vector<BookmarkSearchPhrase> &phrases);
    
     wxTreeItemId refreshBookmarks();
     void updateTheme();
@@ -106,10 +133,21 @@ protected:
     //refresh / rebuild the whole tree item immediatly
     void doUpdateActiveList();
 
+    //make the children of parent match rows, keeping the items already there; returns the item of each row.
+    std::vector<wxTreeItemId> syncChildren(wxTreeItemId parent, const TreeViewRows& rows);
+
+    //materialize the bookmarks of an expanded group, up to its page limit; returns the item to select, if any.
+    //groupExpanded is set if the group had to be materialized anyway, for the bookmark to focus.
+    wxTreeItemId refreshGroup(std::string groupName, wxTreeItemId groupItem, bool &groupExpanded, TreeViewItem *prevSel);
+
+    //grow the group of a visible "more" item by a page.
+    bool expandMoreItem(wxTreeItemId moreItem);
+
     void onKeyUp( wxKeyEvent& event );
     void onTreeActivate( wxTreeEvent& event );
     void onTreeCollapse( wxTreeEvent& event );
     void onTreeExpanded( wxTreeEvent& event );
+    void onTreeExpanding( wxTreeEvent& event );
     void onTreeItemMenu( wxTreeEvent& event );
     void onTreeSelect( wxTreeEvent& event );
     void onTreeSelectChanging( wxTreeEvent& event );
@@ -186,6 +224,9 @@ protected:
     std::set< std::string > doUpdateBookmarkGroup;
     BookmarkNames groupNames;
     std::map<std::string, wxTreeItemId> groups;
+    //number of bookmarks materialized per group, and the "more" item following them, if any.
+    std::map<std::string, size_t> groupRowLimit;
+    std::map<std::string, wxTreeItemId> groupMoreItem;
     wxArrayString bookmarkChoices;
     wxChoice *bookmarkChoice;
     
@@ -200,6 +241,14 @@ protected:
     
     // Search
     std::vector<std::wstring> searchKeywords;
+    //the words of searchKeywords, see BookmarkMgr::getSearchPhrases().
+    std::vector<BookmarkSearchPhrase> searchPhrases;
+
+    //the bookmarks matching lastSearchKeywords, as of index version lastSearchVersion.
+    void updateSearchResult();
+    std::vector<std::wstring> lastSearchKeywords;
+    BookmarkSearchResult lastSearchResult;
+    unsigned long long lastSearchVersion = 0;
 
     void setStatusText(std::string statusText);
 
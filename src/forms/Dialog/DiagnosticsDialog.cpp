@@ -0,0 +1,154 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include <wx/wx.h>
+#include <wx/filedlg.h>
+
+#include "DiagnosticsDialog.h"
+#include "PipelineStats.h"
+#include "RenderScheduler.h"
+#include "CubicSDR.h"
+
+DiagnosticsDialog::DiagnosticsDialog(wxWindow *parent)
+    : wxDialog(parent, wxID_ANY, wxT("Pipeline Diagnostics"), wxDefaultPosition, wxSize(760, 560),
+               wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
+      m_refresh_timer(this) {
+
+    auto *main_sizer = new wxBoxSizer(wxVERTICAL);
+
+    main_sizer->Add(new wxStaticText(this, wxID_ANY, wxT("Queues")), 0, wxLEFT | wxTOP, 10);
+
+    m_queue_list = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL);
+    m_queue_list->AppendColumn(wxT("Name"), wxLIST_FORMAT_LEFT, 200);
+    m_queue_list->AppendColumn(wxT("Count"), wxLIST_FORMAT_RIGHT, 50);
+    m_queue_list->AppendColumn(wxT("Depth"), wxLIST_FORMAT_RIGHT, 60);
+    m_queue_list->AppendColumn(wxT("Max"), wxLIST_FORMAT_RIGHT, 60);
+    m_queue_list->AppendColumn(wxT("Capacity"), wxLIST_FORMAT_RIGHT, 70);
+    m_queue_list->AppendColumn(wxT("Pushes"), wxLIST_FORMAT_RIGHT, 100);
+    m_queue_list->AppendColumn(wxT("Pops"), wxLIST_FORMAT_RIGHT, 100);
+    m_queue_list->AppendColumn(wxT("Dropped"), wxLIST_FORMAT_RIGHT, 80);
+    main_sizer->Add(m_queue_list, 3, wxEXPAND | wxALL, 10);
+
+    main_sizer->Add(new wxStaticText(this, wxID_ANY, wxT("Stage latencies, since the device read (us)")), 0, wxLEFT, 10);
+
+    m_stage_list = new wxListCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL);
+    m_stage_list->AppendColumn(wxT("Stage"), wxLIST_FORMAT_LEFT, 200);
+    m_stage_list->AppendColumn(wxT("Count"), wxLIST_FORMAT_RIGHT, 100);
+    m_stage_list->AppendColumn(wxT("Mean"), wxLIST_FORMAT_RIGHT, 90);
+    m_stage_list->AppendColumn(wxT("p50"), wxLIST_FORMAT_RIGHT, 90);
+    m_stage_list->AppendColumn(wxT("p99"), wxLIST_FORMAT_RIGHT, 90);
+    m_stage_list->AppendColumn(wxT("Max"), wxLIST_FORMAT_RIGHT, 90);
+    main_sizer->Add(m_stage_list, 2, wxEXPAND | wxALL, 10);
+
+    m_render_text = new wxStaticText(this, wxID_ANY, wxT(""));
+    main_sizer->Add(m_render_text, 0, wxEXPAND | wxLEFT | wxRIGHT, 10);
+
+    auto *button_sizer = new wxBoxSizer(wxHORIZONTAL);
+    m_reset_button = new wxButton(this, wxID_ANY, wxT("Reset Counters"));
+    m_save_button = new wxButton(this, wxID_ANY, wxT("Save JSON..."));
+    button_sizer->Add(m_reset_button, 0, wxRIGHT, 10);
+    button_sizer->Add(m_save_button, 0, 0, 0);
+    main_sizer->Add(button_sizer, 0, wxALIGN_RIGHT | wxALL, 10);
+
+    SetSizer(main_sizer);
+    Layout();
+
+    Connect(wxEVT_TIMER, wxTimerEventHandler(DiagnosticsDialog::OnRefresh));
+    m_reset_button->Connect(wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(DiagnosticsDialog::OnReset), nullptr, this);
+    m_save_button->Connect(wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(DiagnosticsDialog::OnSaveJSON), nullptr, this);
+
+    refresh();
+    m_refresh_timer.Start(DIAGNOSTICS_DIALOG_REFRESH_MS);
+}
+
+DiagnosticsDialog::~DiagnosticsDialog() {
+    m_refresh_timer.Stop();
+
+    Disconnect(wxEVT_TIMER, wxTimerEventHandler(DiagnosticsDialog::OnRefresh));
+    m_reset_button->Disconnect(wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(DiagnosticsDialog::OnReset), nullptr, this);
+    m_save_button->Disconnect(wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(DiagnosticsDialog::OnSaveJSON), nullptr, this);
+}
+
+void DiagnosticsDialog::OnRefresh(wxTimerEvent& /* event */) {
+    if (IsShown()) {
+        refresh();
+    }
+}
+
+void DiagnosticsDialog::OnReset(wxCommandEvent& /* event */) {
+    PipelineStats::reset();
+    refresh();
+}
+
+void DiagnosticsDialog::OnSaveJSON(wxCommandEvent& /* event */) {
+    wxFileDialog saveFileDialog(this, _("Save pipeline diagnostics"), "", "cubicsdr_diagnostics.json",
+                                "JSON files (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+    if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+        return;
+    }
+
+    if (!PipelineStats::saveJSON(saveFileDialog.GetPath().ToStdString())) {
+        wxMessageBox(wxT("Unable to write ") + saveFileDialog.GetPath(), wxT("Pipeline Diagnostics"), wxOK | wxICON_ERROR, this);
+    }
+}
+
+void DiagnosticsDialog::setRow(wxListCtrl *list, long row, const std::vector<wxString>& values) {
+    //keep the existing rows to avoid flickering, only add or remove at the end.
+    if (row >= list->GetItemCount()) {
+        list->InsertItem(row, values[0]);
+    } else if (list->GetItemText(row) != values[0]) {
+        list->SetItemText(row, values[0]);
+    }
+
+    for (size_t col = 1; col < values.size(); col++) {
+        if (list->GetItemText(row, (int)col) != values[col]) {
+            list->SetItem(row, (int)col, values[col]);
+        }
+    }
+}
+
+void DiagnosticsDialog::refresh() {
+    std::vector<QueueStatsSnapshot> queues;
+    std::vector<LatencyStatsSnapshot> stages;
+
+    PipelineStats::snapshot(queues, stages);
+
+    long row = 0;
+    for (auto& q : queues) {
+        setRow(m_queue_list, row++, {
+            wxString(q.name),
+            wxString::Format("%d", q.instances),
+            wxString::Format("%llu", q.depth),
+            wxString::Format("%llu", q.maxDepth),
+            wxString::Format("%llu", q.capacity),
+            wxString::Format("%llu", q.pushes),
+            wxString::Format("%llu", q.pops),
+            wxString::Format("%llu", q.pushFailures)
+        });
+    }
+    while (m_queue_list->GetItemCount() > row) {
+        m_queue_list->DeleteItem(m_queue_list->GetItemCount() - 1);
+    }
+
+    row = 0;
+    for (auto& s : stages) {
+        setRow(m_stage_list, row++, {
+            wxString(s.name),
+            wxString::Format("%llu", s.count),
+            wxString::Format("%.0f", s.mean),
+            wxString::Format("%llu", s.p50),
+            wxString::Format("%llu", s.p99),
+            wxString::Format("%llu", s.max)
+        });
+    }
+    while (m_stage_list->GetItemCount() > row) {
+        m_stage_list->DeleteItem(m_stage_list->GetItemCount() - 1);
+    }
+
+    RenderScheduler *renderScheduler = wxGetApp().getAppFrame() ? wxGetApp().getAppFrame()->getRenderScheduler() : nullptr;
+
+    if (renderScheduler) {
+        m_render_text->SetLabel(wxString::Format("UI: %.1f frames per second", renderScheduler->getFramesPerSecond()));
+    }
+}
@@ -0,0 +1,38 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <wx/dialog.h>
+#include <wx/listctrl.h>
+#include <wx/stattext.h>
+#include <wx/button.h>
+#include <wx/timer.h>
+
+//refresh period of the shown counters, in milliseconds.
+#define DIAGNOSTICS_DIALOG_REFRESH_MS 500
+
+/**
+ * Live view of the pipeline telemetry (PipelineStats): queue depths and drops,
+ * stage latencies, and the UI frame rate. Can save the whole snapshot as JSON.
+ */
+class DiagnosticsDialog : public wxDialog {
+public:
+    DiagnosticsDialog(wxWindow *parent);
+    ~DiagnosticsDialog() override;
+
+protected:
+    void OnRefresh(wxTimerEvent& event);
+    void OnReset(wxCommandEvent& event);
+    void OnSaveJSON(wxCommandEvent& event);
+
+    void refresh();
+    void setRow(wxListCtrl *list, long row, const std::vector<wxString>& values);
+
+    wxListCtrl *m_queue_list;
+    wxListCtrl *m_stage_list;
+    wxStaticText *m_render_text;
+    wxButton *m_reset_button;
+    wxButton *m_save_button;
+    wxTimer m_refresh_timer;
+};
@@ -10,9 +10,10 @@ ADSBConsole::ADSBConsole(
         wxWindow*                   parent,
         ModemDigitalOutputConsole*  modem_parent)
     : ADSBFrame(parent), m_modem_parent(modem_parent),
-      m_msgs_recv(0), m_raw_frame_queue(), m_frame_queue_mutex(),
+      m_msgs_recv(0), m_raw_frame_queue(ADSB_CONSOLE_FRAME_QUEUE_SIZE),
       m_aircraft_manager()
 {
+    m_frame_batch.resize(m_raw_frame_queue.capacity());
 }
 
 ADSBConsole::~ADSBConsole()
@@ -24,11 +25,8 @@ void
 ADSBConsole::push_frame(
         const adsb_decoder::ByteArray &frame_bytes)
 {
-    std::lock_guard<std::mutex> lg(m_frame_queue_mutex);
-    if (m_raw_frame_queue.size() > 1000000) {
-        return;
-    }
-    m_raw_frame_queue.push_back(frame_bytes);
+    // never blocks the modem thread: when the console is that far behind, the frame is dropped.
+    m_raw_frame_queue.write(&frame_bytes, 1);
 }
 
 void
@@ -41,26 +39,16 @@ void
 ADSBConsole::DoRefresh(
         wxTimerEvent& /* evt */)
 {
-    std::vector<adsb_decoder::ByteArray> frame_batch;
-
-    {
-        std::lock_guard<std::mutex> lg(m_frame_queue_mutex);
+    const size_t nb_frames = m_raw_frame_queue.read(m_frame_batch.data(), m_frame_batch.size());
 
-        if (m_raw_frame_queue.empty()) {
-            return;
-        }
-
-        while (not m_raw_frame_queue.empty())
-        {
-            frame_batch.push_back(m_raw_frame_queue.front());
-            m_raw_frame_queue.pop_front();
-        }
+    if (nb_frames == 0) {
+        return;
     }
 
     // go through these batch of frames to decode and feed to the aircraft manager
-    for (const auto& frame : frame_batch)
+    for (size_t i = 0; i < nb_frames; i++)
     {
-        const auto message = adsb_decoder::extract_message(frame);
+        const auto message = adsb_decoder::extract_message(m_frame_batch[i]);
         std::cout << message.to_string() << std::endl;
         m_aircraft_manager[message.icao].update(message);
         m_msgs_recv++;
@@ -12,6 +12,10 @@
 #include "DigitalConsoleFrame.h"
 #include "ADSBFrame.hpp"
 #include "ModemDigital.h"
+#include "SPSCRingBuffer.h"
+
+// frames waiting for the ADSB console refresh, beyond that the newest are dropped.
+#define ADSB_CONSOLE_FRAME_QUEUE_SIZE 65536
 
 
 class ModemDigitalOutputConsole;
@@ -43,8 +47,9 @@ private:
 
     unsigned int m_msgs_recv;
 
-    std::list<adsb_decoder::ByteArray> m_raw_frame_queue;
-    std::mutex m_frame_queue_mutex;
+    // written by the modem thread only, read by the GUI refresh only.
+    SPSCRingBuffer<adsb_decoder::ByteArray> m_raw_frame_queue;
+    std::vector<adsb_decoder::ByteArray> m_frame_batch;
     std::map<int, TrackedAircraft> m_aircraft_manager;
 };
 
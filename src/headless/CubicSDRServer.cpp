@@ -0,0 +1,107 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include <wx/init.h>
+#include <wx/cmdline.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <clocale>
+#include <iostream>
+#include <thread>
+
+#include "HeadlessEngine.h"
+
+//how often the main thread checks for a signal or a device failure.
+#define SERVER_POLL_PERIOD_MS 100
+
+static std::atomic_bool stopRequested(false);
+
+static void onStopSignal(int /* sig */) {
+    stopRequested.store(true);
+}
+
+static const wxCmdLineEntryDesc commandLineInfo [] =
+{
+    { wxCMD_LINE_SWITCH, "h", "help", "Command line parameter help", wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_SWITCH, "l", "list", "List the devices and exit.", wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_OPTION, "s", "session", "Session file to run.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "d", "device", "Device to use: part of its id, its name or its driver. Default: the first available.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "c", "config", "Specify a named configuration to use, i.e. '-c ham'", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_SWITCH, "r", "record", "Record every demodulator of the session.", wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_OPTION, "p", "record-path", "Recording directory, instead of the configured one.", wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_SWITCH, "n", "stream", "Stream the audio of every demodulator of the session as RTP, to the configured destination.", wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_OPTION, "i", "iq-server", "Re-serve the device IQ over TCP in the rtl_tcp protocol on this port, i.e. '-i 1234'", wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_NONE }
+};
+
+int main(int argc, char **argv) {
+    std::setlocale(LC_ALL, "");
+
+    //wxWidgets only provides the configuration paths here: no GUI, no GL context.
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk()) {
+        std::cout << "Failed to initialize wxWidgets." << std::endl;
+        return 1;
+    }
+
+    wxCmdLineParser parser(commandLineInfo, argc, argv);
+    if (parser.Parse() != 0) {
+        return 1;
+    }
+
+    wxString sessionFile, deviceSelector, configName, recordPath;
+
+    parser.Found("s", &sessionFile);
+    parser.Found("d", &deviceSelector);
+    parser.Found("c", &configName);
+    parser.Found("p", &recordPath);
+
+    long iqServerPort = 0;
+    parser.Found("i", &iqServerPort);
+
+    HeadlessEngine engine;
+
+    if (parser.Found("l")) {
+        engine.init(configName.ToStdString());
+        engine.listDevices();
+        return 0;
+    }
+
+    if (sessionFile.IsEmpty()) {
+        std::cout << "A session file is required, see --help." << std::endl;
+        return 1;
+    }
+
+    if (!engine.init(configName.ToStdString(), (int)iqServerPort) || !engine.startDevice(deviceSelector.ToStdString())) {
+        return 2;
+    }
+
+    if (!engine.loadSession(sessionFile.ToStdString())) {
+        return 3;
+    }
+
+    if (parser.Found("r") && !engine.startRecording(recordPath.ToStdString())) {
+        return 4;
+    }
+
+    if (parser.Found("n")) {
+        engine.startStreaming();
+    }
+
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+
+    std::cout << "Running, press Ctrl-C to stop." << std::endl;
+
+    while (!stopRequested.load() && !engine.hasFailed()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SERVER_POLL_PERIOD_MS));
+        engine.removeFailedReceivers();
+    }
+
+    std::cout << "Terminating.." << std::endl;
+    engine.terminate();
+
+    return engine.hasFailed() ? 5 : 0;
+}
@@ -0,0 +1,452 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "HeadlessEngine.h"
+#include "DataTree.h"
+
+#include <iostream>
+#include <map>
+
+HeadlessEngine::HeadlessEngine() : frequency(0), sampleRate(DEFAULT_SAMPLE_RATE), soloMode(false), failed(false),
+    sdrThread(nullptr), sdrPostThread(nullptr), iqStreamServer(nullptr), t_SDR(nullptr), t_PostSDR(nullptr), t_IQStreamServer(nullptr), devs(nullptr) {
+
+    SDREngine::set(this);
+}
+
+HeadlessEngine::~HeadlessEngine() {
+    terminate();
+}
+
+bool HeadlessEngine::init(const std::string& configName, int iqServerPort) {
+    if (!configName.empty()) {
+        config.setConfigName(configName);
+    }
+    config.load();
+
+    SDREngine::registerModems();
+
+    frequency = config.getCenterFreq();
+
+    initAudioDevices();
+
+    pipeSDRIQData = std::make_shared<SDRThreadIQDataQueue>();
+    pipeSDRIQData->set_max_num_items(100);
+    pipeSDRIQData->set_stats_name("SDRIQData");
+
+    sdrThread = new SDRThread();
+    sdrThread->setOutputQueue("IQDataOutput", pipeSDRIQData);
+
+    //no visual outputs: the post-processing only feeds the demodulators.
+    sdrPostThread = new SDRPostThread();
+    sdrPostThread->setInputQueue("IQDataInput", pipeSDRIQData);
+
+    int streamPort = iqServerPort ? iqServerPort : config.getIQServerPort();
+
+    if (streamPort > 0) {
+        iqStreamServer = new IQStreamServer();
+
+        if (!iqStreamServer->listen(config.getIQServerAddress(), streamPort)) {
+            delete iqStreamServer;
+            iqStreamServer = nullptr;
+            return false;
+        }
+        sdrPostThread->setOutputQueue("IQStreamOutput", iqStreamServer->getInputQueue("IQDataInput"));
+        t_IQStreamServer = new std::thread(&IQStreamServer::threadMain, iqStreamServer);
+    }
+
+    t_PostSDR = new std::thread(&SDRPostThread::threadMain, sdrPostThread);
+
+    return true;
+}
+
+void HeadlessEngine::initAudioDevices() {
+    std::vector<RtAudio::DeviceInfo> devices;
+    std::map<int, RtAudio::DeviceInfo> outputDevices;
+
+    AudioThread::enumerateDevices(devices);
+
+    int i = 0;
+
+    for (auto devices_i = devices.begin(); devices_i != devices.end(); devices_i++) {
+        if (devices_i->outputChannels) {
+            outputDevices[i] = *devices_i;
+        }
+        i++;
+    }
+
+    demodMgr.setOutputDevices(outputDevices);
+}
+
+void HeadlessEngine::listDevices() {
+    if (!devs) {
+        devs = SDREnumerator::enumerate_devices("");
+    }
+
+    if (!devs || devs->empty()) {
+        std::cout << "No devices found." << std::endl;
+        return;
+    }
+
+    for (SDRDeviceInfo *dev : *devs) {
+        std::cout << dev->getDeviceId() << " [" << dev->getDriver() << "]" << (dev->isAvailable() ? "" : " (unavailable)") << std::endl;
+    }
+}
+
+bool HeadlessEngine::startDevice(const std::string& selector) {
+    if (!devs) {
+        devs = SDREnumerator::enumerate_devices("");
+    }
+
+    SDRDeviceInfo *dev = nullptr;
+
+    if (devs) {
+        for (SDRDeviceInfo *devCheck : *devs) {
+            if (!devCheck->isAvailable()) {
+                continue;
+            }
+            if (selector.empty() || devCheck->getDeviceId().find(selector) != std::string::npos ||
+                    devCheck->getName() == selector || devCheck->getDriver() == selector) {
+                dev = devCheck;
+                break;
+            }
+        }
+    }
+
+    if (!dev) {
+        std::cout << "No available device matching '" << selector << "'." << std::endl;
+        return false;
+    }
+
+    std::cout << "Using device " << dev->getDeviceId() << std::endl;
+
+    DeviceConfig *devConfig = config.getDevice(dev->getDeviceId());
+
+    ConfigSettings settings = devConfig->getSettings();
+    for (ConfigSettings::const_iterator i = settings.begin(); i != settings.end(); i++) {
+        sdrThread->writeSetting(i->first, i->second);
+    }
+    sdrThread->setStreamArgs(devConfig->getStreamOpts());
+    sdrThread->setDevice(dev);
+
+    if (long devSampleRate = devConfig->getSampleRate()) {
+        sampleRate = dev->getSampleRateNear(SOAPY_SDR_RX, 0, devSampleRate);
+    } else {
+        sampleRate = dev->getSampleRateNear(SOAPY_SDR_RX, 0, DEFAULT_SAMPLE_RATE);
+    }
+
+    setSampleRate(sampleRate);
+
+    sdrThread->setPPM(devConfig->getPPM());
+    sdrThread->setOffset(devConfig->getOffset());
+    sdrThread->setAGCMode(devConfig->getAGCMode());
+    sdrThread->setAntenna(devConfig->getAntennaName());
+
+    t_SDR = new std::thread(&SDRThread::threadMain, sdrThread);
+
+    startReceivers();
+
+    return true;
+}
+
+void HeadlessEngine::startReceivers() {
+    SDRDeviceInfo *mainDev = sdrThread->getDevice();
+
+    for (const SDRReceiverDef& rdef : config.getReceivers()) {
+        if ((int)receivers.size() + 1 >= SDR_MAX_RECEIVERS) {
+            std::cout << "Too many receivers, '" << rdef.deviceId << "' is not started." << std::endl;
+            break;
+        }
+
+        for (SDRDeviceInfo *dev : *devs) {
+            if (dev->getDeviceId() != rdef.deviceId || dev == mainDev || !dev->isAvailable() || dev->isActive()) {
+                continue;
+            }
+
+            //no visual outputs either: the receivers only feed the demodulators of their band.
+            SDRReceiver *receiver = new SDRReceiver((int)receivers.size() + 1);
+            receiver->start(dev, rdef.frequency);
+            receivers.push_back(receiver);
+            break;
+        }
+    }
+}
+
+bool HeadlessEngine::loadSession(const std::string& fileName) {
+    DataTree l;
+    if (!l.LoadFromFile(fileName)) {
+        std::cout << "Unable to load session file '" << fileName << "'." << std::endl;
+        return false;
+    }
+
+    if (l.rootNode()->getName() != "cubicsdr_session") {
+        std::cout << "'" << fileName << "' is not a session file." << std::endl;
+        return false;
+    }
+
+    demodMgr.setActiveDemodulator(nullptr, false);
+    demodMgr.terminateAll();
+
+    try {
+        if (!l.rootNode()->hasAnother("header")) {
+            return false;
+        }
+        DataNode *header = l.rootNode()->getNext("header");
+
+        if (header->hasAnother("sample_rate")) {
+            long sample_rate = *header->getNext("sample_rate");
+
+            SDRDeviceInfo *dev = sdrThread->getDevice();
+            if (dev) {
+                std::vector<long> sampleRates = dev->getSampleRates(SOAPY_SDR_RX, 0);
+
+                long minRate = sampleRates.empty() ? MANUAL_SAMPLE_RATE_MIN : sampleRates.front();
+                long maxRate = sampleRates.empty() ? MANUAL_SAMPLE_RATE_MAX : sampleRates.back();
+
+                if (sample_rate < minRate || sample_rate > maxRate) {
+                    sample_rate = dev->getSampleRateNear(SOAPY_SDR_RX, 0, sample_rate);
+                }
+            }
+            setSampleRate(sample_rate);
+        }
+
+        if (header->hasAnother("solo_mode")) {
+            int solo_mode_activated = *header->getNext("solo_mode");
+            soloMode = (solo_mode_activated > 0);
+        } else {
+            soloMode = false;
+        }
+
+        DemodulatorInstancePtr loadedActiveDemod = nullptr;
+        DemodulatorInstancePtr newDemod = nullptr;
+
+        //without any audio device, the demodulators run anyway and drop their audio, to record it.
+        bool noAudioDevice = demodMgr.getOutputDevices().empty();
+
+        if (l.rootNode()->hasAnother("demodulators")) {
+            DataNode *demodulators = l.rootNode()->getNext("demodulators");
+
+            while (demodulators->hasAnother("demodulator")) {
+                DataNode *demod = demodulators->getNext("demodulator");
+
+                if (!demod->hasAnother("bandwidth") || !demod->hasAnother("frequency")) {
+                    continue;
+                }
+
+                newDemod = demodMgr.loadInstance(demod);
+
+                if (noAudioDevice) {
+                    newDemod->setOutputDevice(AUDIO_THREAD_NULL_DEVICE);
+                }
+
+                if (demod->hasAnother("active")) {
+                    loadedActiveDemod = newDemod;
+                }
+
+                newDemod->run();
+                newDemod->setActive(true);
+
+                std::cout << "Demodulator " << newDemod->getDemodulatorType() << " at " << newDemod->getFrequency() << " Hz" << std::endl;
+            }
+
+            sdrPostThread->notifyDemodulatorsChanged();
+        }
+
+        if (header->hasAnother("center_freq")) {
+            long long center_freq = *header->getNext("center_freq");
+            setFrequency(center_freq);
+        }
+
+        if (loadedActiveDemod || newDemod) {
+            demodMgr.setActiveDemodulator(loadedActiveDemod ? loadedActiveDemod : newDemod, false);
+        }
+    } catch (DataTypeMismatchException &e) {
+        std::cout << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool HeadlessEngine::startRecording(const std::string& path) {
+    if (!path.empty()) {
+        config.setRecordingPath(path);
+    }
+
+    //no dialog to report it here, unlike AppConfig::verifyRecordingPath().
+    std::string recPath = config.getRecordingPath();
+
+    if (recPath.empty() || !wxFileName::DirExists(recPath) || !wxFileName::IsDirWritable(recPath)) {
+        std::cout << "Recording path '" << recPath << "' is not a writable directory." << std::endl;
+        return false;
+    }
+
+    for (auto demod : demodMgr.getDemodulators()) {
+        if (!demod->isRecording()) {
+            demod->setRecording(true);
+        }
+    }
+
+    return true;
+}
+
+void HeadlessEngine::startStreaming() {
+    for (auto demod : demodMgr.getDemodulators()) {
+        if (!demod->isStreaming()) {
+            demod->setStreaming(true);
+        }
+    }
+
+    std::cout << "Streaming the audio to " << config.getAudioStreamAddress() << ":" << config.getAudioStreamPort() << "." << std::endl;
+}
+
+void HeadlessEngine::setSampleRate(long long rate) {
+    sampleRate = rate;
+
+    if (sdrThread && !sdrThread->isTerminated()) {
+        sdrThread->setSampleRate(rate);
+    }
+
+    setFrequency(frequency);
+}
+
+bool HeadlessEngine::hasFailed() {
+    return failed.load();
+}
+
+void HeadlessEngine::removeFailedReceivers() {
+    for (std::vector<SDRReceiver *>::iterator i = receivers.begin(); i != receivers.end();) {
+        SDRReceiver *receiver = *i;
+
+        if (!receiver->hasFailed()) {
+            i++;
+            continue;
+        }
+
+        std::cout << "Receiver " << receiver->getIndex() << " (" << receiver->getDevice()->getName() << ") failed, stopping it." << std::endl;
+
+        //terminate() clears its band: its demodulators are routed to the main device again.
+        receiver->terminate();
+        delete receiver;
+        i = receivers.erase(i);
+
+        sdrPostThread->notifyDemodulatorsChanged();
+    }
+}
+
+void HeadlessEngine::terminate() {
+    //not started, or already terminated.
+    if (!sdrPostThread) {
+        return;
+    }
+
+    //same order as CubicSDR::OnExit(): the thread feeding all the others first.
+    if (t_SDR) {
+        sdrThread->terminate();
+        sdrThread->isTerminated(3000);
+    }
+
+    sdrPostThread->terminate();
+    sdrPostThread->isTerminated(3000);
+
+    for (SDRReceiver *receiver : receivers) {
+        receiver->terminate();
+        delete receiver;
+    }
+    receivers.clear();
+
+    if (iqStreamServer) {
+        iqStreamServer->terminate();
+        iqStreamServer->isTerminated(1000);
+    }
+
+    demodMgr.terminateAll();
+
+    if (t_SDR) {
+        t_SDR->join();
+        delete t_SDR;
+        t_SDR = nullptr;
+    }
+
+    if (t_PostSDR) {
+        t_PostSDR->join();
+        delete t_PostSDR;
+        t_PostSDR = nullptr;
+    }
+
+    if (t_IQStreamServer) {
+        t_IQStreamServer->join();
+        delete t_IQStreamServer;
+        t_IQStreamServer = nullptr;
+    }
+
+    delete iqStreamServer;
+    iqStreamServer = nullptr;
+
+    delete sdrThread;
+    sdrThread = nullptr;
+
+    delete sdrPostThread;
+    sdrPostThread = nullptr;
+
+    AudioThread::deviceCleanup();
+
+    SDREnumerator::cleanup();
+}
+
+AppConfig *HeadlessEngine::getConfig() {
+    return &config;
+}
+
+DemodulatorMgr &HeadlessEngine::getDemodMgr() {
+    return demodMgr;
+}
+
+void HeadlessEngine::setFrequency(long long freq) {
+    if (freq < sampleRate / 2) {
+        freq = sampleRate / 2;
+    }
+    frequency = freq;
+
+    if (sdrThread) {
+        sdrThread->setFrequency(freq);
+    }
+}
+
+long long HeadlessEngine::getFrequency() {
+    return frequency;
+}
+
+long long HeadlessEngine::getSampleRate() {
+    return sampleRate;
+}
+
+bool HeadlessEngine::getSoloMode() {
+    return soloMode.load();
+}
+
+bool HeadlessEngine::getUseLocalMod() {
+    return false;
+}
+
+std::string HeadlessEngine::getModulePath() {
+    return "";
+}
+
+void HeadlessEngine::sdrThreadNotify(SDRThread::SDRThreadState state, std::string message) {
+    std::lock_guard < std::mutex > lock(notify_busy);
+
+    if (state == SDRThread::SDR_THREAD_FAILED) {
+        failed.store(true);
+    }
+    if (!message.empty()) {
+        std::cout << message << std::endl;
+    }
+}
+
+void HeadlessEngine::sdrEnumThreadNotify(SDREnumerator::SDREnumState /* state */, std::string message) {
+    std::lock_guard < std::mutex > lock(notify_busy);
+
+    if (!message.empty()) {
+        std::cout << message << std::endl;
+    }
+}
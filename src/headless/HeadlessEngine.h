@@ -0,0 +1,99 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SDREngine.h"
+#include "SDRPostThread.h"
+#include "SDRReceiver.h"
+#include "IQStreamServer.h"
+
+/**
+ * The SDR, demodulator and audio threads of CubicSDR, without any window nor visual processing:
+ * the SDR thread feeds the post-processing thread which only feeds the demodulators.
+ * Demodulators come from a session file, and play to their audio device and/or record to files.
+ */
+class HeadlessEngine : public SDREngine {
+public:
+    HeadlessEngine();
+    virtual ~HeadlessEngine();
+
+    //load the configuration 'configName', or the default one if empty, then start the post-processing,
+    //and the IQ stream server on 'iqServerPort', or on the configured port if 0.
+    bool init(const std::string& configName, int iqServerPort = 0);
+
+    //enumerate the devices and start the first one available matching 'selector', among
+    //the device ids, names and drivers, or the first one available if empty;
+    //then the configured receivers, on the other devices.
+    bool startDevice(const std::string& selector);
+
+    //demodulators, sample rate, center frequency and solo mode of a CubicSDR session file.
+    bool loadSession(const std::string& fileName);
+
+    //record every demodulator to 'path', or to the configured recording path if empty.
+    bool startRecording(const std::string& path);
+
+    //stream the audio of every demodulator as RTP, to the configured destination.
+    void startStreaming();
+
+    //print the devices found on stdout.
+    void listDevices();
+
+    void setSampleRate(long long rate);
+
+    //true once the SDR thread reported its device failed.
+    bool hasFailed();
+
+    //stop the receivers whose device stream failed, the main device keeps running; polled by the server loop.
+    void removeFailedReceivers();
+
+    void terminate();
+
+    //SDREngine
+    AppConfig *getConfig();
+    DemodulatorMgr &getDemodMgr();
+
+    void setFrequency(long long freq);
+    long long getFrequency();
+    long long getSampleRate();
+    bool getSoloMode();
+
+    bool getUseLocalMod();
+    std::string getModulePath();
+
+    void sdrThreadNotify(SDRThread::SDRThreadState state, std::string message);
+    void sdrEnumThreadNotify(SDREnumerator::SDREnumState state, std::string message);
+
+private:
+    void initAudioDevices();
+    void startReceivers();
+
+    AppConfig config;
+    DemodulatorMgr demodMgr;
+
+    std::atomic_llong frequency;
+    std::atomic_llong sampleRate;
+    std::atomic_bool soloMode;
+    std::atomic_bool failed;
+
+    std::mutex notify_busy;
+
+    SDRThreadIQDataQueuePtr pipeSDRIQData;
+
+    SDRThread *sdrThread;
+    SDRPostThread *sdrPostThread;
+    IQStreamServer *iqStreamServer;
+    std::vector<SDRReceiver *> receivers;
+
+    std::thread *t_SDR;
+    std::thread *t_PostSDR;
+    std::thread *t_IQStreamServer;
+
+    std::vector<SDRDeviceInfo *> *devs;
+};
@@ -2,7 +2,6 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "Modem.h"
-#include "CubicSDR.h"
 
 
 ModemFactoryList Modem::modemFactories;
@@ -77,6 +76,10 @@ int Modem::getDefaultSampleRate() {
     return 200000;
 }
 
+double Modem::getOutputDelay(ModemKit * /* kit */) {
+    return 0;
+}
+
 void Modem::writeSetting(std::string /* setting */, std::string /* value */) {
     // ...
 }
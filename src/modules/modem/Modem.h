@@ -153,6 +153,9 @@ public:
     virtual void disposeKit(ModemKit *kit) = 0;
     
     virtual void demodulate(ModemKit *kit, ModemIQData *input, AudioThreadInput *audioOut) = 0;
+
+    //how late the output of demodulate() is on its input, in output samples.
+    virtual double getOutputDelay(ModemKit *kit);
     
     bool shouldRebuildKit();
     void rebuildKit();
@@ -39,6 +39,13 @@ void ModemAnalog::disposeKit(ModemKit *kit) {
     delete akit;
 }
 
+double ModemAnalog::getOutputDelay(ModemKit *kit) {
+    ModemKitAnalog *akit = (ModemKitAnalog *)kit;
+
+    //the demodulators add a few samples at most, the audio resampler is what delays.
+    return akit->audioResampler ? msresamp_rrrf_get_delay(akit->audioResampler) : 0;
+}
+
 void ModemAnalog::initOutputBuffers(ModemKitAnalog *akit, ModemIQData *input) {
     bufSize = input->data.size();
     
@@ -89,6 +96,9 @@ void ModemAnalog::buildAudioOutput(ModemKitAnalog *akit, AudioThreadInput *audio
     
     audioOut->channels = 1;
     audioOut->sampleRate = akit->audioSampleRate;
+    if (audioOut->data.capacity() < resampledOutputData.size()) {
+        audioOut->data.reserve(resampledOutputData.size());
+    }
     audioOut->data.assign(resampledOutputData.begin(), resampledOutputData.begin() + numAudioWritten);
 }
 
@@ -22,6 +22,7 @@ public:
     virtual int checkSampleRate(long long sampleRate, int audioSampleRate);
     virtual ModemKit *buildKit(long long sampleRate, int audioSampleRate);
     virtual void disposeKit(ModemKit *kit);
+    virtual double getOutputDelay(ModemKit *kit);
     virtual void initOutputBuffers(ModemKitAnalog *akit, ModemIQData *input);
     virtual void buildAudioOutput(ModemKitAnalog *akit, AudioThreadInput *audioOut, bool autoGain);
     virtual std::vector<float> *getDemodOutputData();
@@ -256,8 +256,8 @@ void ModemFMStereo::demodulate(ModemKit *kit, ModemIQData *input, AudioThreadInp
     msresamp_rrrf_execute(fmkit->stereoResampler, &demodStereoData[0], (int)bufSize, &resampledStereoData[0], &numAudioWritten);
     
     audioOut->channels = 2;
-    if (audioOut->data.capacity() < (numAudioWritten * 2)) {
-        audioOut->data.reserve(numAudioWritten * 2);
+    if (audioOut->data.capacity() < (resampledStereoData.size() * 2)) {
+        audioOut->data.reserve(resampledStereoData.size() * 2);
     }
     audioOut->data.resize(numAudioWritten * 2);
     for (size_t i = 0; i < numAudioWritten; i++) {
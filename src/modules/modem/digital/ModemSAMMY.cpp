@@ -1,5 +1,6 @@
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 #include "dump1090.h"
 #include "ModemSAMMY.hpp"
@@ -8,7 +9,8 @@
 
 ModemSAMMY::ModemSAMMY()
     : ModemDigital(),
-      m_buffer(adsb_decoder::BUFFER_SIZE), m_buf_idx(0)
+      m_buffer(adsb_decoder::BUFFER_SIZE), m_buf_idx(0),
+      m_work_generation(0), m_work_slices(0), m_work_pending(0), m_work_terminate(false)
 //    m_stats_count(0), m_outfile("modem_sammy.dat", std::ios::binary), m_outbuffer(OUTBUFFER_SIZE), m_out_count(0)
 {
     std::cout << "ModemSAMMY::ModemSAMMY()" << std::endl;
@@ -17,6 +19,17 @@ ModemSAMMY::ModemSAMMY()
 ModemSAMMY::~ModemSAMMY()
 {
     std::cout << "ModemSAMMY::~ModemSAMMY()" << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(m_work_mutex);
+        m_work_terminate = true;
+    }
+    m_work_cond.notify_all();
+
+    for (auto worker : m_workers) {
+        worker->join();
+        delete worker;
+    }
 }
 
 std::string ModemSAMMY::getName()
@@ -42,75 +55,150 @@ ModemSAMMY::_decode_mode_s()
 {
     using namespace adsb_decoder;
 
-    // scan through the buffer
-    unsigned int possible_preambles = 0;
-    unsigned int valid_messages = 0;
-    for (int i = 0; i < BUFFER_THRESHOLD; i++)
-    {
-        // shamelessly borrowed from dump1090.c
-
-        // The Mode S preamble is made of impulses of 0.5 microseconds at
-        // the following time offsets:
-        //
-        // 0   - 0.5 usec: first impulse.
-        // 1.0 - 1.5 usec: second impulse.
-        // 3.5 - 4   usec: third impulse.
-        // 4.5 - 5   usec: last impulse.
-        //
-        // Since we are sampling at 2 Mhz every sample in our magnitude vector
-        // is 0.5 usec, so the preamble will look like this, assuming there is
-        // an impulse at offset 0 in the array:
-        //
-        // 0   -----------------
-        // 1   -
-        // 2   ------------------
-        // 3   --
-        // 4   -
-        // 5   --
-        // 6   -
-        // 7   ------------------
-        // 8   --
-        // 9   -------------------
-        if (not check_preamble_relations(&m_buffer[i]))
-        {
-            // samples at the current position in the buffer don't match the pattern of a preamble
-            continue;
-        }
+    // The Mode S preamble is made of impulses of 0.5 microseconds at
+    // the following time offsets:
+    //
+    // 0   - 0.5 usec: first impulse.
+    // 1.0 - 1.5 usec: second impulse.
+    // 3.5 - 4   usec: third impulse.
+    // 4.5 - 5   usec: last impulse.
+    //
+    // Since we are sampling at 2 Mhz every sample in our magnitude vector
+    // is 0.5 usec, so the preamble will look like this, assuming there is
+    // an impulse at offset 0 in the array:
+    //
+    // 0   -----------------
+    // 1   -
+    // 2   ------------------
+    // 3   --
+    // 4   -
+    // 5   --
+    // 6   -
+    // 7   ------------------
+    // 8   --
+    // 9   -------------------
+
+    // first, a single vectorized pass over the whole buffer for the offsets matching that pattern
+    m_candidates.clear();
+    find_preamble_candidates(m_buffer.data(), BUFFER_THRESHOLD, m_candidates);
+
+    const size_t nb_candidates = m_candidates.size();
+    if (nb_candidates == 0) {
+        return;
+    }
+
+    m_candidate_frames.resize(nb_candidates);
+    m_candidate_valid.resize(nb_candidates);
+
+    // then extract and CRC check the frame behind every candidate, in parallel when there are enough of them
+    size_t slices = std::min((size_t)MODEM_SAMMY_MAX_DECODE_THREADS, nb_candidates / MODEM_SAMMY_CANDIDATES_PER_THREAD);
+
+    if (slices > 1) {
+        _start_workers();
+        slices = std::min(slices, m_workers.size() + 1);
+    }
 
-        if (not check_preamble_levels(&m_buffer[i]))
+    if (slices <= 1) {
+        _decode_candidates(0, nb_candidates);
+    } else {
         {
-            // levels in between the spikes in the buffer don't match the profile for a preamble
-            continue;
+            std::lock_guard<std::mutex> lock(m_work_mutex);
+            m_work_slices = (unsigned int)slices;
+            m_work_pending = (unsigned int)slices - 1;
+            m_work_generation++;
         }
+        m_work_cond.notify_all();
+
+        // this thread takes the last slice
+        _decode_candidates(nb_candidates * (slices - 1) / slices, nb_candidates);
 
-        possible_preambles++;
+        std::unique_lock<std::mutex> lock(m_work_mutex);
+        m_done_cond.wait(lock, [this] { return m_work_pending == 0; });
+    }
 
-        // now that we have a possible preamble, extract the frame from the buffer into a bytestream
-        const auto frame_bitvector = extract_bitvector(&m_buffer[i + SAMPLES_PER_PREAMBLE]);
+    // finally pass the valid frames along, in order. As in a sequential scan,
+    // once a frame is found the candidates within it are skipped.
+    size_t next_offset = 0;
 
-        // and check if that bytestream is valid data by applying the CRC check
-        const auto checksum = compute_checksum(frame_bitvector);
-        if (checksum == 0) {
-            valid_messages++;
-        } else {
+    for (size_t c = 0; c < nb_candidates; c++)
+    {
+        if (not m_candidate_valid[c] or m_candidates[c] < next_offset) {
             continue;
         }
 
-        // if the CRC check passes, pass the data along the bytestream
-        const ByteArray frame_bytes = extract_bytearray(frame_bitvector);
+        const ByteArray& frame_bytes = m_candidate_frames[c];
         outStream.write((char*)frame_bytes.data(), frame_bytes.size());
-//        const auto message = extract_message(frame_bytes);
-//
-//        outStream << message.to_string() << std::endl << std::endl;
 
-        // ...then jump to the next sample after the end of this packet to start scanning for the next preamble
-        i += SAMPLES_PER_FRAME;
+        next_offset = m_candidates[c] + SAMPLES_PER_FRAME + 1;
+    }
+}
+
+void
+ModemSAMMY::_decode_candidates(size_t first, size_t last)
+{
+    using namespace adsb_decoder;
+
+    for (size_t c = first; c < last; c++)
+    {
+        // extract the frame following the preamble into a bytestream...
+        const auto frame_bitvector = extract_bitvector(&m_buffer[m_candidates[c] + SAMPLES_PER_PREAMBLE]);
+
+        // ...and check if that bytestream is valid data by applying the CRC check
+        m_candidate_valid[c] = (compute_checksum(frame_bitvector) == 0);
+
+        if (m_candidate_valid[c]) {
+            m_candidate_frames[c] = extract_bytearray(frame_bitvector);
+        }
+    }
+}
+
+void
+ModemSAMMY::_start_workers()
+{
+    if (!m_workers.empty()) {
+        return;
     }
 
-//    std::cout << "Decoder Report:" << std::endl;
-//    std::cout << "  " << possible_preambles << " possible preambles." << std::endl;
-//    std::cout << "  " << valid_messages << " valid messages." << std::endl;
-//    std::cout << ::std::endl;
+    const unsigned int nb_threads = std::min((unsigned int)MODEM_SAMMY_MAX_DECODE_THREADS, std::thread::hardware_concurrency());
+
+    // the workers only react to the generations after the current one
+    for (unsigned int i = 0; i + 1 < nb_threads; i++) {
+        m_workers.push_back(new std::thread(&ModemSAMMY::_worker_main, this, i, m_work_generation));
+    }
+}
+
+void
+ModemSAMMY::_worker_main(unsigned int worker_idx, unsigned long long generation)
+{
+    while (true)
+    {
+        size_t slices;
+
+        {
+            std::unique_lock<std::mutex> lock(m_work_mutex);
+            m_work_cond.wait(lock, [&] { return m_work_terminate or m_work_generation != generation; });
+
+            if (m_work_terminate) {
+                return;
+            }
+
+            generation = m_work_generation;
+            slices = m_work_slices;
+        }
+
+        if (worker_idx + 1 >= slices) {
+            continue;
+        }
+
+        const size_t nb_candidates = m_candidates.size();
+        _decode_candidates(nb_candidates * worker_idx / slices, nb_candidates * (worker_idx + 1) / slices);
+
+        {
+            std::lock_guard<std::mutex> lock(m_work_mutex);
+            m_work_pending--;
+        }
+        m_done_cond.notify_one();
+    }
 }
 
 void ModemSAMMY::demodulate(ModemKit *kit, ModemIQData *input, AudioThreadInput *audioOut)
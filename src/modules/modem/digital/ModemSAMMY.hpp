@@ -3,8 +3,19 @@
 
 #include <fstream>
 #include <array>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "ModemDigital.h"
+#include "ADSBDecoder.hpp"
+
+// most threads decoding the candidate frames of a buffer, including the modem thread itself.
+#define MODEM_SAMMY_MAX_DECODE_THREADS 4
+
+// below that many candidates per thread, the modem thread decodes them alone.
+#define MODEM_SAMMY_CANDIDATES_PER_THREAD 64
 
 
 class ModemSAMMY : public ModemDigital {
@@ -25,10 +36,31 @@ public:
 private:
 
     void _decode_mode_s();
+    void _decode_candidates(size_t first, size_t last);
+
+    void _start_workers();
+    void _worker_main(unsigned int worker_idx, unsigned long long generation);
 
     std::vector<float> m_buffer;
     unsigned int m_buf_idx;
 
+    // offsets in m_buffer that look like a preamble, then for each the frame found there
+    // and whether it passed the CRC check.
+    std::vector<unsigned int> m_candidates;
+    std::vector<adsb_decoder::ByteArray> m_candidate_frames;
+    std::vector<char> m_candidate_valid;
+
+    // extra decode threads, started on first use. For each new work generation,
+    // the first (m_work_slices - 1) workers decode one slice of the candidates each.
+    std::vector<std::thread *> m_workers;
+    std::mutex m_work_mutex;
+    std::condition_variable m_work_cond;
+    std::condition_variable m_done_cond;
+    unsigned long long m_work_generation;
+    unsigned int m_work_slices;
+    unsigned int m_work_pending;
+    bool m_work_terminate;
+
 //    unsigned int m_stats_count;
 //    std::ofstream m_outfile;
 //    std::vector<float> m_outbuffer;
@@ -38,8 +38,8 @@ void FFTDataDistributor::process() {
         }
 
 		if (inp) {
-            //Settings have changed, set new values and dump all previous samples stored in inputBuffer: 
-			if (inputBuffer.sampleRate != inp->sampleRate || inputBuffer.frequency != inp->frequency) {
+            //Settings have changed, or the device was retuned, set new values and dump all previous samples stored in inputBuffer: 
+			if (inputBuffer.sampleRate != inp->sampleRate || inputBuffer.frequency != inp->frequency || inp->retuned) {
 
                 //bufferMax must be at least fftSize (+ margin), else the waterfall get frozen, because no longer updated.
                 bufferMax = std::max((size_t)(inp->sampleRate * FFT_DISTRIBUTOR_BUFFER_IN_SECONDS), (size_t)(1.2 * fftSize.load()));
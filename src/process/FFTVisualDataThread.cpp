@@ -3,6 +3,7 @@
 
 #include "FFTVisualDataThread.h"
 #include "CubicSDR.h"
+#include "RenderScheduler.h"
 
 FFTVisualDataThread::FFTVisualDataThread() {
 	linesPerSecond.store(DEFAULT_WATERFALL_LPS);
@@ -33,6 +34,7 @@ void FFTVisualDataThread::run() {
     
 
     fftQueue->set_max_num_items(100); 
+    fftQueue->set_stats_name("WaterfallFFTData");
     pipeFFTDataOut->set_max_num_items(100);
 
     //FFT distributor plumbing:
@@ -73,8 +75,16 @@ void FFTVisualDataThread::run() {
         fftDistrib.run();
       
         // Make wproc do a FFT of each of the sample sets provided by fftDistrib: 
+        bool newLines = false;
+
         while (!stopping && !wproc.isInputEmpty()) {
             wproc.run();
+            newLines = true;
+        }
+
+        //new waterfall lines to draw
+        if (newLines) {
+            RenderScheduler::wake();
         }
     }
 
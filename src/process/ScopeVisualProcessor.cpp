@@ -43,6 +43,10 @@ void ScopeVisualProcessor::setSpectrumEnabled(bool spectrumEnable) {
     spectrumEnabled.store(spectrumEnable);
 }
 
+bool ScopeVisualProcessor::isConsuming() {
+    return scopeEnabled.load() || spectrumEnabled.load();
+}
+
 void ScopeVisualProcessor::process() {
     if (!isOutputEmpty()) {
         return;
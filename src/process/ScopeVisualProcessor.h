@@ -37,6 +37,8 @@ public:
     void setup(int fftSize_in);
     void setScopeEnabled(bool scopeEnable);
     void setSpectrumEnabled(bool spectrumEnable);
+    //true if either the scope or the spectrum actually consumes the input
+    bool isConsuming();
 protected:
     virtual void process();
     ReBuffer<ScopeRenderData> outputBuffers;
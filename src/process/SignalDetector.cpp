@@ -0,0 +1,577 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "SignalDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+//smoothing of each bin over the lines.
+#define SIGNAL_DETECTOR_SMOOTHING 0.5f
+//smoothing of the noise floor over the lines: slow, so that a signal barely moves it.
+#define SIGNAL_DETECTOR_NOISE_SMOOTHING 0.05f
+
+//about that many blocks of bins per line, of SIGNAL_DETECTOR_MIN_BLOCK_BINS at least.
+#define SIGNAL_DETECTOR_BLOCKS 1024
+#define SIGNAL_DETECTOR_MIN_BLOCK_BINS 8
+//the noise floor is computed every that many blocks, and interpolated in between.
+#define SIGNAL_DETECTOR_SEGMENT_BLOCKS 8
+
+//a signal is that many bins wide at least, gaps up to that many Hz are bridged.
+#define SIGNAL_DETECTOR_MIN_BINS 2
+#define SIGNAL_DETECTOR_MAX_GAP_HZ 500
+
+//lines a signal is seen on before it is reported: also the lines to learn the floor at start.
+#define SIGNAL_DETECTOR_CONFIRM_LINES 3
+//a signal ends once missing for that many ms, and that many lines at least.
+#define SIGNAL_DETECTOR_HOLD_MS 500
+#define SIGNAL_DETECTOR_HOLD_LINES 3
+
+//time slots of the occupancy window, the oldest one leaves the window at once.
+#define SIGNAL_DETECTOR_OCCUPANCY_SLOTS 30
+
+static float toDb(float power) {
+    return 10.0f * log10f(std::max(power, 1e-20f));
+}
+
+SignalDetector::SignalDetector() : lineBucketWidth(0), lines(0), lastCenterFreq(0), lastSampleRate(0), thresholdDb(SIGNAL_DETECTOR_DEFAULT_THRESHOLD_DB),
+    nextId(1), bucketWidth(SIGNAL_DETECTOR_DEFAULT_BUCKET_WIDTH), windowSeconds(SIGNAL_DETECTOR_DEFAULT_OCCUPANCY_WINDOW), lastTimeMs(0), lastPruneSlot(0),
+    noiseCenterFreq(0), noiseSampleRate(0) {
+
+}
+
+void SignalDetector::processLine(const std::vector<float>& power, long long centerFreq, long long sampleRate, long long timeMs) {
+    size_t numBins = power.size();
+
+    if (numBins < SIGNAL_DETECTOR_MIN_BLOCK_BINS * 2 || sampleRate <= 0) {
+        return;
+    }
+
+    if (numBins != smoothed.size() || centerFreq != lastCenterFreq || sampleRate != lastSampleRate) {
+        reset();
+
+        smoothed.assign(power.begin(), power.end());
+        lastCenterFreq = centerFreq;
+        lastSampleRate = sampleRate;
+    } else {
+        for (size_t i = 0; i < numBins; i++) {
+            smoothed[i] += SIGNAL_DETECTOR_SMOOTHING * (power[i] - smoothed[i]);
+        }
+    }
+
+    lines++;
+
+    //the per-bin work, without lock: the queries only wait for the results update below.
+    updateNoiseFloor(numBins);
+    findClusters(numBins, sampleRate);
+    bucketLine(centerFreq, sampleRate);
+
+    double lineMs = (double)numBins * 1000.0 / (double)sampleRate;
+
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    lastTimeMs = timeMs;
+
+    updateTracks(centerFreq, sampleRate, timeMs);
+    updateOccupancy(timeMs, lineMs);
+
+    noiseOut.assign(noise.begin(), noise.end());
+    noiseCenterFreq = centerFreq;
+    noiseSampleRate = sampleRate;
+}
+
+void SignalDetector::reset() {
+    smoothed.clear();
+    segmentNoise.clear();
+    clusters.clear();
+    lines = 0;
+
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+    endTracks();
+}
+
+void SignalDetector::updateNoiseFloor(size_t numBins) {
+    size_t blockBins = std::max((size_t)SIGNAL_DETECTOR_MIN_BLOCK_BINS, numBins / SIGNAL_DETECTOR_BLOCKS);
+    size_t numBlocks = numBins / blockBins;
+
+    //median of each block
+    blockMedians.resize(numBlocks);
+
+    for (size_t b = 0; b < numBlocks; b++) {
+        scratch.assign(smoothed.begin() + b * blockBins, smoothed.begin() + (b + 1) * blockBins);
+        std::nth_element(scratch.begin(), scratch.begin() + blockBins / 2, scratch.end());
+        blockMedians[b] = scratch[blockBins / 2];
+    }
+
+    //lower quartile of the block medians over a quarter of the band: signals may fill up to 3/4 of it.
+    size_t segmentBlocks = std::min((size_t)SIGNAL_DETECTOR_SEGMENT_BLOCKS, numBlocks);
+    size_t numSegments = (numBlocks + segmentBlocks - 1) / segmentBlocks;
+    size_t windowBlocks = std::min(numBlocks, std::max((size_t)1, numBlocks / 4) + 1);
+
+    bool learnt = (segmentNoise.size() == numSegments);
+    segmentNoise.resize(numSegments);
+
+    for (size_t s = 0; s < numSegments; s++) {
+        size_t center = std::min(s * segmentBlocks + segmentBlocks / 2, numBlocks - 1);
+        size_t first = (center > windowBlocks / 2) ? (center - windowBlocks / 2) : 0;
+        first = std::min(first, numBlocks - windowBlocks);
+
+        scratch.assign(blockMedians.begin() + first, blockMedians.begin() + first + windowBlocks);
+        std::nth_element(scratch.begin(), scratch.begin() + windowBlocks / 4, scratch.end());
+        float reference = scratch[windowBlocks / 4];
+
+        segmentNoise[s] = learnt ? (segmentNoise[s] + SIGNAL_DETECTOR_NOISE_SMOOTHING * (reference - segmentNoise[s])) : reference;
+    }
+
+    //per bin, between the segment centers.
+    noise.resize(numBins);
+
+    double segmentBins = (double)(segmentBlocks * blockBins);
+    double lastSegment = (double)(numSegments - 1);
+
+    for (size_t i = 0; i < numBins; i++) {
+        double pos = ((double)i + 0.5) / segmentBins - 0.5;
+
+        if (pos <= 0) {
+            noise[i] = segmentNoise[0];
+        } else if (pos >= lastSegment) {
+            noise[i] = segmentNoise[numSegments - 1];
+        } else {
+            size_t s = (size_t)pos;
+            float frac = (float)(pos - (double)s);
+            noise[i] = segmentNoise[s] + frac * (segmentNoise[s + 1] - segmentNoise[s]);
+        }
+    }
+}
+
+void SignalDetector::findClusters(size_t numBins, long long sampleRate) {
+    clusters.clear();
+
+    //the floor is still being learnt.
+    if (lines < SIGNAL_DETECTOR_CONFIRM_LINES) {
+        return;
+    }
+
+    float threshold = powf(10.0f, thresholdDb.load() / 10.0f);
+    double binWidth = (double)sampleRate / (double)numBins;
+    int maxGap = std::max(1, (int)(SIGNAL_DETECTOR_MAX_GAP_HZ / binWidth));
+
+    Cluster current;
+    bool open = false;
+    int lastHit = -1;
+    double weightSum = 0, binSum = 0;
+
+    auto closeCluster = [&]() {
+        current.endBin = lastHit;
+        if (current.endBin - current.startBin + 1 >= SIGNAL_DETECTOR_MIN_BINS) {
+            current.centroid = binSum / weightSum;
+            clusters.push_back(current);
+        }
+        open = false;
+    };
+
+    for (int i = 0, iMax = (int)numBins; i < iMax; i++) {
+        if (smoothed[i] <= noise[i] * threshold) {
+            continue;
+        }
+
+        if (open && (i - lastHit - 1) > maxGap) {
+            closeCluster();
+        }
+
+        if (!open) {
+            current.startBin = i;
+            current.peakPower = 0;
+            current.peakSnr = 0;
+            weightSum = 0;
+            binSum = 0;
+            open = true;
+        }
+
+        weightSum += smoothed[i];
+        binSum += (double)smoothed[i] * (double)i;
+
+        if (smoothed[i] > current.peakPower) {
+            current.peakPower = smoothed[i];
+            current.peakSnr = smoothed[i] / std::max(noise[i], 1e-20f);
+        }
+
+        lastHit = i;
+    }
+
+    if (open) {
+        closeCluster();
+    }
+}
+
+void SignalDetector::bucketLine(long long centerFreq, long long sampleRate) {
+    lineBuckets.clear();
+
+    long long width;
+    {
+        std::lock_guard < std::mutex > busy_lock(busy_results);
+        width = bucketWidth;
+    }
+    lineBucketWidth = width;
+
+    size_t numBins = smoothed.size();
+    double binWidth = (double)sampleRate / (double)numBins;
+    double startFreq = (double)centerFreq - (double)sampleRate / 2.0;
+
+    size_t c = 0;
+
+    for (size_t i = 0; i < numBins; i++) {
+        long long bucket = (long long)floor((startFreq + ((double)i + 0.5) * binWidth) / (double)width);
+
+        while (c < clusters.size() && clusters[c].endBin < (int)i) {
+            c++;
+        }
+
+        bool hit = (c < clusters.size() && clusters[c].startBin <= (int)i);
+
+        if (lineBuckets.empty() || lineBuckets.back().first != bucket) {
+            lineBuckets.push_back(std::make_pair(bucket, hit));
+        } else if (hit) {
+            lineBuckets.back().second = true;
+        }
+    }
+}
+
+void SignalDetector::updateTracks(long long centerFreq, long long sampleRate, long long timeMs) {
+    size_t numBins = smoothed.size();
+    double binWidth = (double)sampleRate / (double)numBins;
+    double startFreq = (double)centerFreq - (double)sampleRate / 2.0;
+
+    double lineMs = (double)numBins * 1000.0 / (double)sampleRate;
+    long long holdMs = std::max((long long)SIGNAL_DETECTOR_HOLD_MS, (long long)(lineMs * SIGNAL_DETECTOR_HOLD_LINES));
+
+    for (const Cluster& cluster : clusters) {
+        long long clusterStart = std::llround(startFreq + (double)cluster.startBin * binWidth);
+        long long clusterEnd = std::llround(startFreq + (double)(cluster.endBin + 1) * binWidth);
+        long long clusterFreq = std::llround(startFreq + (cluster.centroid + 0.5) * binWidth);
+
+        //the tracked signal overlapping the most, give or take a gap.
+        TrackedSignal *match = nullptr;
+        long long bestOverlap = -1;
+
+        for (TrackedSignal& track : tracks) {
+            long long overlap = std::min(clusterEnd, track.endFreq + SIGNAL_DETECTOR_MAX_GAP_HZ) - std::max(clusterStart, track.startFreq - SIGNAL_DETECTOR_MAX_GAP_HZ);
+
+            if (overlap >= 0 && overlap > bestOverlap) {
+                bestOverlap = overlap;
+                match = &track;
+            }
+        }
+
+        if (!match) {
+            tracks.push_back(TrackedSignal());
+            match = &tracks.back();
+
+            match->signal.onsetMs = timeMs;
+            match->signal.peakDb = toDb(cluster.peakPower);
+            match->signal.snrDb = toDb(cluster.peakSnr);
+            match->frequencySum = 0;
+            match->frequencyCount = 0;
+            match->confirmed = false;
+        } else if (match->signal.lastSeenMs == timeMs) {
+            //another part of the same signal on this line.
+            clusterStart = std::min(clusterStart, match->startFreq);
+            clusterEnd = std::max(clusterEnd, match->endFreq);
+        }
+
+        DetectedSignal& signal = match->signal;
+
+        if (signal.lastSeenMs != timeMs || !signal.lines) {
+            signal.lines++;
+        }
+
+        match->startFreq = clusterStart;
+        match->endFreq = clusterEnd;
+        match->frequencySum += (double)clusterFreq;
+        match->frequencyCount++;
+
+        signal.frequency = std::llround(match->frequencySum / (double)match->frequencyCount);
+        signal.bandwidth = std::max(signal.bandwidth, clusterEnd - clusterStart);
+        signal.peakDb = std::max(signal.peakDb, toDb(cluster.peakPower));
+        signal.snrDb = std::max(signal.snrDb, toDb(cluster.peakSnr));
+        signal.lastSeenMs = timeMs;
+
+        if (!match->confirmed && signal.lines >= SIGNAL_DETECTOR_CONFIRM_LINES) {
+            match->confirmed = true;
+            signal.id = nextId++;
+        }
+    }
+
+    for (auto i = tracks.begin(); i != tracks.end();) {
+        if (timeMs - i->signal.lastSeenMs > holdMs) {
+            endTrack(*i);
+            i = tracks.erase(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void SignalDetector::updateOccupancy(long long timeMs, double lineMs) {
+    //the bucket width changed meanwhile.
+    if (lineBucketWidth != bucketWidth) {
+        return;
+    }
+
+    for (const std::pair<long long, bool>& lineBucket : lineBuckets) {
+        OccupancyBucket& bucket = occupancy[lineBucket.first];
+
+        size_t slot = (size_t)(getSlot(bucket, timeMs) % SIGNAL_DETECTOR_OCCUPANCY_SLOTS);
+
+        bucket.observedMs[slot] += (float)lineMs;
+        if (lineBucket.second) {
+            bucket.occupiedMs[slot] += (float)lineMs;
+        }
+    }
+
+    //forget the buckets out of the window, once per slot.
+    long long slotMs = std::max(1LL, (long long)windowSeconds * 1000 / SIGNAL_DETECTOR_OCCUPANCY_SLOTS);
+    long long currentSlot = timeMs / slotMs;
+
+    if (currentSlot != lastPruneSlot) {
+        for (auto i = occupancy.begin(); i != occupancy.end();) {
+            if (i->second.lastSlot <= currentSlot - SIGNAL_DETECTOR_OCCUPANCY_SLOTS) {
+                i = occupancy.erase(i);
+            } else {
+                i++;
+            }
+        }
+        lastPruneSlot = currentSlot;
+    }
+}
+
+long long SignalDetector::getSlot(OccupancyBucket& bucket, long long timeMs) {
+    long long slotMs = std::max(1LL, (long long)windowSeconds * 1000 / SIGNAL_DETECTOR_OCCUPANCY_SLOTS);
+    long long slot = timeMs / slotMs;
+
+    if (bucket.observedMs.empty()) {
+        bucket.observedMs.assign(SIGNAL_DETECTOR_OCCUPANCY_SLOTS, 0);
+        bucket.occupiedMs.assign(SIGNAL_DETECTOR_OCCUPANCY_SLOTS, 0);
+    }
+
+    //the clock went back: stay on the last slot.
+    if (slot <= bucket.lastSlot) {
+        return bucket.lastSlot;
+    }
+
+    //clear the slots reused since the last line, all of them if it is a window away.
+    for (long long s = std::max(bucket.lastSlot + 1, slot - SIGNAL_DETECTOR_OCCUPANCY_SLOTS + 1); s <= slot; s++) {
+        bucket.observedMs[s % SIGNAL_DETECTOR_OCCUPANCY_SLOTS] = 0;
+        bucket.occupiedMs[s % SIGNAL_DETECTOR_OCCUPANCY_SLOTS] = 0;
+    }
+
+    bucket.lastSlot = slot;
+
+    return slot;
+}
+
+void SignalDetector::endTrack(TrackedSignal& track) {
+    if (!track.confirmed) {
+        return;
+    }
+
+    history.push_back(track.signal);
+
+    while (history.size() > SIGNAL_DETECTOR_HISTORY_SIZE) {
+        history.pop_front();
+    }
+}
+
+void SignalDetector::endTracks() {
+    for (TrackedSignal& track : tracks) {
+        endTrack(track);
+    }
+    tracks.clear();
+}
+
+void SignalDetector::setThreshold(float thresholdDb_in) {
+    thresholdDb.store(thresholdDb_in);
+}
+
+float SignalDetector::getThreshold() {
+    return thresholdDb.load();
+}
+
+void SignalDetector::setOccupancyBucketWidth(long long bucketWidth_in) {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    if (bucketWidth_in <= 0 || bucketWidth_in == bucketWidth) {
+        return;
+    }
+
+    bucketWidth = bucketWidth_in;
+    occupancy.clear();
+}
+
+long long SignalDetector::getOccupancyBucketWidth() {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    return bucketWidth;
+}
+
+void SignalDetector::setOccupancyWindow(int seconds) {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    if (seconds <= 0 || seconds == windowSeconds) {
+        return;
+    }
+
+    //the slots change length.
+    windowSeconds = seconds;
+    occupancy.clear();
+}
+
+int SignalDetector::getOccupancyWindow() {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    return windowSeconds;
+}
+
+std::vector<DetectedSignal> SignalDetector::getActiveSignals() {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    std::vector<DetectedSignal> result;
+
+    for (const TrackedSignal& track : tracks) {
+        if (track.confirmed) {
+            result.push_back(track.signal);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const DetectedSignal& a, const DetectedSignal& b) {
+        return a.frequency < b.frequency;
+    });
+
+    return result;
+}
+
+std::vector<DetectedSignal> SignalDetector::getSignalHistory() {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    return std::vector<DetectedSignal>(history.begin(), history.end());
+}
+
+std::vector<ChannelOccupancy> SignalDetector::getOccupancy() {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    std::vector<ChannelOccupancy> result;
+
+    long long slotMs = std::max(1LL, (long long)windowSeconds * 1000 / SIGNAL_DETECTOR_OCCUPANCY_SLOTS);
+    long long currentSlot = lastTimeMs / slotMs;
+
+    for (auto& i : occupancy) {
+        OccupancyBucket& bucket = i.second;
+
+        if (bucket.lastSlot <= currentSlot - SIGNAL_DETECTOR_OCCUPANCY_SLOTS) {
+            continue;
+        }
+
+        float observedMs = 0, occupiedMs = 0;
+
+        long long firstSlot = std::max(currentSlot, bucket.lastSlot) - SIGNAL_DETECTOR_OCCUPANCY_SLOTS + 1;
+
+        for (long long s = std::max(0LL, firstSlot); s <= bucket.lastSlot; s++) {
+            observedMs += bucket.observedMs[s % SIGNAL_DETECTOR_OCCUPANCY_SLOTS];
+            occupiedMs += bucket.occupiedMs[s % SIGNAL_DETECTOR_OCCUPANCY_SLOTS];
+        }
+
+        if (observedMs <= 0) {
+            continue;
+        }
+
+        ChannelOccupancy channel;
+        channel.frequency = i.first * bucketWidth + bucketWidth / 2;
+        channel.bandwidth = bucketWidth;
+        channel.occupancy = occupiedMs / observedMs;
+        channel.observedSeconds = observedMs / 1000.0f;
+
+        result.push_back(channel);
+    }
+
+    return result;
+}
+
+bool SignalDetector::getNoiseFloor(long long frequency, float& noiseDb) {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    if (noiseOut.empty() || noiseSampleRate <= 0) {
+        return false;
+    }
+
+    long long offset = frequency - (noiseCenterFreq - noiseSampleRate / 2);
+
+    if (offset < 0 || offset >= noiseSampleRate) {
+        return false;
+    }
+
+    size_t bin = std::min((size_t)((double)offset * (double)noiseOut.size() / (double)noiseSampleRate), noiseOut.size() - 1);
+    noiseDb = toDb(noiseOut[bin]);
+
+    return true;
+}
+
+bool SignalDetector::exportSignals(const std::string& fileName) {
+    std::ofstream out(fileName);
+
+    if (!out.is_open()) {
+        std::cout << "SignalDetector: unable to write '" << fileName << "'." << std::endl;
+        return false;
+    }
+
+    std::vector<DetectedSignal> active = getActiveSignals();
+    std::vector<DetectedSignal> ended = getSignalHistory();
+
+    out << "id,frequency_hz,bandwidth_hz,peak_dbfs,snr_db,onset_ms,last_seen_ms,duration_ms,lines,active" << std::endl;
+    out << std::fixed << std::setprecision(1);
+
+    auto writeSignal = [&out](const DetectedSignal& signal, bool isActive) {
+        out << signal.id << "," << signal.frequency << "," << signal.bandwidth << ","
+            << signal.peakDb << "," << signal.snrDb << ","
+            << signal.onsetMs << "," << signal.lastSeenMs << "," << signal.getDurationMs() << ","
+            << signal.lines << "," << (isActive ? 1 : 0) << std::endl;
+    };
+
+    for (const DetectedSignal& signal : active) {
+        writeSignal(signal, true);
+    }
+    for (const DetectedSignal& signal : ended) {
+        writeSignal(signal, false);
+    }
+
+    return out.good();
+}
+
+bool SignalDetector::exportOccupancy(const std::string& fileName) {
+    std::ofstream out(fileName);
+
+    if (!out.is_open()) {
+        std::cout << "SignalDetector: unable to write '" << fileName << "'." << std::endl;
+        return false;
+    }
+
+    std::vector<ChannelOccupancy> channels = getOccupancy();
+
+    out << "frequency_hz,bandwidth_hz,occupancy,observed_s" << std::endl;
+
+    for (const ChannelOccupancy& channel : channels) {
+        out << channel.frequency << "," << channel.bandwidth << ","
+            << std::setprecision(4) << std::fixed << channel.occupancy << ","
+            << std::setprecision(1) << channel.observedSeconds << std::endl;
+    }
+
+    return out.good();
+}
+
+void SignalDetector::clearHistory() {
+    std::lock_guard < std::mutex > busy_lock(busy_results);
+
+    history.clear();
+}
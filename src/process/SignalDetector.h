@@ -0,0 +1,166 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define SIGNAL_DETECTOR_DEFAULT_FFT_SIZE 65536
+#define SIGNAL_DETECTOR_DEFAULT_THRESHOLD_DB 10.0f
+//the usual narrow channel step.
+#define SIGNAL_DETECTOR_DEFAULT_BUCKET_WIDTH 12500
+#define SIGNAL_DETECTOR_DEFAULT_OCCUPANCY_WINDOW 600
+
+//ended signals kept, the oldest ones go first.
+#define SIGNAL_DETECTOR_HISTORY_SIZE 4096
+
+//a signal, as tracked over the FFT lines.
+class DetectedSignal {
+public:
+    long long id = 0;
+    //power weighted center, averaged over the lines, in Hz.
+    long long frequency = 0;
+    //widest seen, in Hz.
+    long long bandwidth = 0;
+    //highest seen, in dB full scale.
+    float peakDb = 0;
+    //highest seen, above the noise floor.
+    float snrDb = 0;
+    //first and last line of the signal, in milliseconds since the epoch.
+    long long onsetMs = 0;
+    long long lastSeenMs = 0;
+    int lines = 0;
+
+    long long getDurationMs() const {
+        return lastSeenMs - onsetMs;
+    }
+};
+
+//the share of the time a frequency bucket had a signal, over the rolling window.
+class ChannelOccupancy {
+public:
+    //center of the bucket, in Hz.
+    long long frequency = 0;
+    long long bandwidth = 0;
+    //0 to 1
+    float occupancy = 0;
+    //time the bucket was in band, within the window.
+    float observedSeconds = 0;
+};
+
+/**
+ * Detects signals in successive FFT power lines, then tracks and counts them.
+ * Per line:
+ *  - each bin is smoothed over a few lines,
+ *  - the noise floor of each bin is an order statistic (OS-CFAR): the lower quartile of the medians
+ *    of the blocks of bins around it, over a quarter of the band, smoothed over time,
+ *  - bins above their noise floor by the threshold are clustered, across small gaps, into signals,
+ *  - signals are matched to the ones tracked by frequency overlap: onset, duration, peak and bandwidth.
+ *    A signal is reported once seen on a few lines, and ends once missing for a while.
+ *  - each frequency bucket counts the lines it was observed on and those with a signal.
+ * processLine() is called by one thread; the results are queried and exported from any other.
+ */
+class SignalDetector {
+public:
+    SignalDetector();
+
+    //power of each bin, linear, from the lowest frequency; 'timeMs' of the line, since the epoch.
+    void processLine(const std::vector<float>& power, long long centerFreq, long long sampleRate, long long timeMs);
+
+    //the line continuity is lost (retune, new FFT size...): the tracked signals end, the floor is learnt again.
+    void reset();
+
+    void setThreshold(float thresholdDb);
+    float getThreshold();
+
+    //clears the occupancy, the buckets are resized.
+    void setOccupancyBucketWidth(long long bucketWidth);
+    long long getOccupancyBucketWidth();
+
+    void setOccupancyWindow(int seconds);
+    int getOccupancyWindow();
+
+    //the confirmed signals present now.
+    std::vector<DetectedSignal> getActiveSignals();
+    //the ended signals, oldest first.
+    std::vector<DetectedSignal> getSignalHistory();
+    //the buckets observed within the window, by frequency.
+    std::vector<ChannelOccupancy> getOccupancy();
+    //noise floor estimate at 'frequency', in dB full scale, if in the band of the last line.
+    bool getNoiseFloor(long long frequency, float& noiseDb);
+
+    //CSV files: the active then ended signals, and the occupancy.
+    bool exportSignals(const std::string& fileName);
+    bool exportOccupancy(const std::string& fileName);
+
+    void clearHistory();
+
+private:
+    //adjacent bins above the floor.
+    class Cluster {
+    public:
+        int startBin, endBin;
+        double centroid;
+        float peakPower, peakSnr;
+    };
+
+    class TrackedSignal {
+    public:
+        DetectedSignal signal;
+        long long startFreq, endFreq;
+        double frequencySum;
+        int frequencyCount;
+        bool confirmed;
+    };
+
+    //observed and occupied milliseconds, per time slot of the window.
+    class OccupancyBucket {
+    public:
+        std::vector<float> observedMs, occupiedMs;
+        long long lastSlot = -1;
+    };
+
+    void updateNoiseFloor(size_t numBins);
+    void findClusters(size_t numBins, long long sampleRate);
+    //the bucket runs of the line, before locking.
+    void bucketLine(long long centerFreq, long long sampleRate);
+    void updateTracks(long long centerFreq, long long sampleRate, long long timeMs);
+    void updateOccupancy(long long timeMs, double lineMs);
+    void endTrack(TrackedSignal& track);
+    void endTracks();
+    //slot of 'timeMs', making sure 'bucket' only holds the slots of the window ending there.
+    long long getSlot(OccupancyBucket& bucket, long long timeMs);
+
+    //detection thread only:
+    std::vector<float> smoothed, noise, scratch, blockMedians, segmentNoise;
+    std::vector<Cluster> clusters;
+    //bucket of each run of bins of the line, and if a signal was in it.
+    std::vector<std::pair<long long, bool>> lineBuckets;
+    long long lineBucketWidth;
+    size_t lines;
+    long long lastCenterFreq, lastSampleRate;
+
+    std::atomic<float> thresholdDb;
+
+    //protects all below
+    std::mutex busy_results;
+
+    std::vector<TrackedSignal> tracks;
+    std::deque<DetectedSignal> history;
+    long long nextId;
+
+    std::map<long long, OccupancyBucket> occupancy;
+    long long bucketWidth;
+    int windowSeconds;
+    long long lastTimeMs, lastPruneSlot;
+
+    //of the last line, for getNoiseFloor()
+    std::vector<float> noiseOut;
+    long long noiseCenterFreq, noiseSampleRate;
+};
@@ -0,0 +1,191 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "SignalDetectorThread.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+//how long the thread waits for a block before checking for termination.
+#define SIGNAL_DETECTOR_POLL_MICROS (50 * 1000)
+
+//about 1 s of blocks at usual rates, a backlog the thread catches up on.
+#define SIGNAL_DETECTOR_INPUT_QUEUE_SIZE 128
+
+SignalDetectorThread::SignalDetectorThread() : IOThread(), enabled(false), fftSize(SIGNAL_DETECTOR_DEFAULT_FFT_SIZE), currentFFTSize(0),
+    fftInput(nullptr), fftOutput(nullptr), fftPlan(nullptr), powerScale(1), lineFill(0), lineTimeMs(0), lineFrequency(0), lineSampleRate(0), nextSampleIndex(0), lineCount(0) {
+
+    inputQueue = std::make_shared<DemodulatorThreadInputQueue>();
+    inputQueue->set_max_num_items(SIGNAL_DETECTOR_INPUT_QUEUE_SIZE);
+    inputQueue->set_stats_name("SignalDetectorData");
+    setInputQueue("IQDataInput", inputQueue);
+}
+
+SignalDetectorThread::~SignalDetectorThread() {
+    if (fftPlan) {
+        fft_destroy_plan(fftPlan);
+    }
+    free(fftInput);
+    free(fftOutput);
+}
+
+void SignalDetectorThread::setEnabled(bool enabled_in) {
+    enabled.store(enabled_in);
+}
+
+bool SignalDetectorThread::isEnabled() {
+    return enabled.load();
+}
+
+void SignalDetectorThread::setFFTSize(int fftSize_in) {
+    fftSize.store(fftSize_in);
+}
+
+int SignalDetectorThread::getFFTSize() {
+    return fftSize.load();
+}
+
+SignalDetector *SignalDetectorThread::getDetector() {
+    return &detector;
+}
+
+long long SignalDetectorThread::getLineCount() {
+    return lineCount.load();
+}
+
+void SignalDetectorThread::setupFFT(int fftSize_in) {
+    currentFFTSize = fftSize_in;
+
+    int memSize = sizeof(liquid_float_complex) * currentFFTSize;
+
+    if (fftPlan) {
+        fft_destroy_plan(fftPlan);
+    }
+    free(fftInput);
+    free(fftOutput);
+
+    fftInput = (liquid_float_complex*)malloc(memSize);
+    fftOutput = (liquid_float_complex*)malloc(memSize);
+
+    fftPlan = fft_create_plan(currentFFTSize, fftInput, fftOutput, LIQUID_FFT_FORWARD, 0);
+
+    //Hann window; a full scale tone reads 0 dB.
+    window.resize(currentFFTSize);
+
+    double windowSum = 0;
+    for (int i = 0; i < currentFFTSize; i++) {
+        window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)currentFFTSize));
+        windowSum += window[i];
+    }
+    powerScale = (float)(1.0 / (windowSum * windowSum));
+
+    lineSamples.resize(currentFFTSize);
+    linePower.resize(currentFFTSize);
+    lineFill = 0;
+
+    detector.reset();
+}
+
+void SignalDetectorThread::run() {
+
+    DemodulatorThreadIQDataPtr inp;
+
+    while (!stopping) {
+        if (!inputQueue->pop(inp, SIGNAL_DETECTOR_POLL_MICROS)) {
+            continue;
+        }
+
+        if (!inp || inp->data.empty() || inp->sampleRate <= 0) {
+            inp = nullptr;
+            continue;
+        }
+
+        if (!enabled.load()) {
+            //the tracked signals end, the next line starts afresh once enabled again.
+            if (lineFrequency) {
+                detector.reset();
+            }
+            lineFill = 0;
+            lineFrequency = 0;
+            inp = nullptr;
+            continue;
+        }
+
+        if (fftSize.load() != currentFFTSize) {
+            setupFFT(fftSize.load());
+        }
+
+        //the line in progress does not continue across a retune.
+        if (inp->retuned || inp->frequency != lineFrequency || inp->sampleRate != lineSampleRate) {
+            lineFill = 0;
+            lineFrequency = inp->frequency;
+            lineSampleRate = inp->sampleRate;
+        }
+
+        size_t numSamples = inp->data.size();
+        size_t pos = 0;
+
+        //nor across blocks dropped at the input queue: one FFT line is contiguous IQ.
+        if (inp->timestamp.isValid()) {
+            if (lineFill && std::llabs(inp->timestamp.sampleIndex - nextSampleIndex) > 1) {
+                lineFill = 0;
+            }
+            nextSampleIndex = inp->timestamp.offset((double)numSamples, inp->sampleRate).sampleIndex;
+        }
+
+        while (pos < numSamples) {
+            if (lineFill == 0) {
+                if (inp->timestamp.isValid()) {
+                    lineTimeMs = inp->timestamp.offset((double)pos, inp->sampleRate).hostTimeNs / 1000000;
+                } else {
+                    lineTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                }
+            }
+
+            size_t numCopy = std::min(numSamples - pos, (size_t)currentFFTSize - lineFill);
+
+            std::copy(inp->data.begin() + pos, inp->data.begin() + pos + numCopy, lineSamples.begin() + lineFill);
+
+            pos += numCopy;
+            lineFill += numCopy;
+
+            if (lineFill == (size_t)currentFFTSize) {
+                processLine(lineFrequency, lineSampleRate, lineTimeMs);
+                lineFill = 0;
+            }
+        }
+
+        //give the buffer back to SDRPostThread right away.
+        inp = nullptr;
+    }
+
+    inputQueue->flush();
+}
+
+void SignalDetectorThread::processLine(long long centerFreq, long long sampleRate, long long timeMs) {
+    for (int i = 0; i < currentFFTSize; i++) {
+        fftInput[i].real = lineSamples[i].real * window[i];
+        fftInput[i].imag = lineSamples[i].imag * window[i];
+    }
+
+    fft_execute(fftPlan);
+
+    //from the lowest frequency: the upper half of the FFT output first.
+    int half = currentFFTSize / 2;
+
+    for (int i = 0; i < currentFFTSize; i++) {
+        const liquid_float_complex& bin = fftOutput[(i + half) % currentFFTSize];
+        linePower[i] = (bin.real * bin.real + bin.imag * bin.imag) * powerScale;
+    }
+
+    detector.processLine(linePower, centerFreq, sampleRate, timeMs);
+
+    lineCount++;
+}
+
+void SignalDetectorThread::terminate() {
+    IOThread::terminate();
+    //unblock push()
+    inputQueue->flush();
+}
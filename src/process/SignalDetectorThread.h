@@ -0,0 +1,69 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "IOThread.h"
+#include "DemodDefs.h"
+#include "SignalDetector.h"
+
+/**
+ * Runs a SignalDetector on the full band IQ of SDRPostThread ("IQDetectorOutput"), in its own thread:
+ * consecutive, non-overlapping FFT lines of fftSize samples, i.e. every sample once at the full line rate,
+ * whatever the display lines per second. Neither the display threads nor SDRPostThread ever wait for it:
+ * if it falls behind, whole blocks are dropped at its input queue.
+ */
+class SignalDetectorThread : public IOThread {
+public:
+    SignalDetectorThread();
+    virtual ~SignalDetectorThread();
+
+    //disabled, the blocks are dropped as they come.
+    void setEnabled(bool enabled_in);
+    bool isEnabled();
+
+    //taken at the next line.
+    void setFFTSize(int fftSize_in);
+    int getFFTSize();
+
+    SignalDetector *getDetector();
+
+    //FFT lines processed since the start.
+    long long getLineCount();
+
+    virtual void run();
+    virtual void terminate();
+
+private:
+    void setupFFT(int fftSize_in);
+    void processLine(long long centerFreq, long long sampleRate, long long timeMs);
+
+    DemodulatorThreadInputQueuePtr inputQueue;
+
+    SignalDetector detector;
+
+    std::atomic_bool enabled;
+    std::atomic_int fftSize;
+    int currentFFTSize;
+
+    liquid_float_complex *fftInput, *fftOutput;
+    fftplan fftPlan;
+    std::vector<float> window;
+    //normalization of the window gain, for dB full scale.
+    float powerScale;
+
+    //samples of the line being filled, and the time of its first one.
+    std::vector<liquid_float_complex> lineSamples;
+    size_t lineFill;
+    long long lineTimeMs;
+    long long lineFrequency, lineSampleRate;
+    //device stream position expected at the start of the next block.
+    long long nextSampleIndex;
+
+    std::vector<float> linePower;
+
+    std::atomic_llong lineCount;
+};
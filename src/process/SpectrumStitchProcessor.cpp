@@ -0,0 +1,214 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "SpectrumStitchProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+
+//points of the stitched spectrum at most, in multiples of the main spectrum ones.
+#define SPECTRUM_STITCH_MAX_SPAN SDR_MAX_RECEIVERS
+
+SpectrumStitchProcessor::SpectrumStitchProcessor(SpectrumVisualProcessor *mainProcessor) : outputBuffers("SpectrumStitchProcessorBuffers"), mainProcessor(mainProcessor) {
+    for (int i = 0; i < SDR_MAX_RECEIVERS; i++) {
+        receivers[i] = nullptr;
+    }
+}
+
+SpectrumStitchProcessor::~SpectrumStitchProcessor() {
+    for (int i = 0; i < SDR_MAX_RECEIVERS; i++) {
+        delete receivers[i];
+    }
+}
+
+DemodulatorThreadInputQueuePtr SpectrumStitchProcessor::addReceiver(int receiver) {
+    std::lock_guard < std::mutex > busy_lock(busy_receivers);
+
+    if (receiver <= 0 || receiver >= SDR_MAX_RECEIVERS) {
+        return nullptr;
+    }
+
+    delete receivers[receiver];
+
+    ReceiverSpectrum *receiverSpectrum = new ReceiverSpectrum();
+
+    //like the main spectrum input: the latest block only.
+    receiverSpectrum->iqInput = std::make_shared<DemodulatorThreadInputQueue>();
+    receiverSpectrum->iqInput->set_max_num_items(1);
+    receiverSpectrum->iqInput->set_stats_name("SpectrumIQVisualData" + std::to_string(receiver));
+
+    receiverSpectrum->spectrumOutput = std::make_shared<SpectrumVisualDataQueue>();
+    receiverSpectrum->spectrumOutput->set_max_num_items(1);
+
+    receiverSpectrum->processor.setInput(receiverSpectrum->iqInput);
+    receiverSpectrum->processor.attachOutput(receiverSpectrum->spectrumOutput);
+    receiverSpectrum->processor.setup(mainProcessor->getFFTSize());
+
+    receivers[receiver] = receiverSpectrum;
+
+    return receiverSpectrum->iqInput;
+}
+
+void SpectrumStitchProcessor::removeReceiver(int receiver) {
+    std::lock_guard < std::mutex > busy_lock(busy_receivers);
+
+    if (receiver <= 0 || receiver >= SDR_MAX_RECEIVERS) {
+        return;
+    }
+
+    delete receivers[receiver];
+    receivers[receiver] = nullptr;
+}
+
+void SpectrumStitchProcessor::updateReceiver(ReceiverSpectrum& receiverSpectrum) {
+    SpectrumVisualProcessor& processor = receiverSpectrum.processor;
+
+    //follow the main spectrum settings, the changed ones only: they reset the processor state.
+    if (processor.getFFTSize() != mainProcessor->getFFTSize()) {
+        processor.setFFTSize(mainProcessor->getFFTSize());
+    }
+    if (processor.getFFTAverageRate() != mainProcessor->getFFTAverageRate()) {
+        processor.setFFTAverageRate(mainProcessor->getFFTAverageRate());
+    }
+    if (processor.getScaleFactor() != mainProcessor->getScaleFactor()) {
+        processor.setScaleFactor(mainProcessor->getScaleFactor());
+    }
+    if (receiverSpectrum.peakHold != mainProcessor->getPeakHold()) {
+        receiverSpectrum.peakHold = mainProcessor->getPeakHold();
+        processor.setPeakHold(receiverSpectrum.peakHold);
+    }
+
+    processor.run();
+
+    SpectrumVisualDataPtr spectrum;
+    while (receiverSpectrum.spectrumOutput->try_pop(spectrum)) {
+        receiverSpectrum.latest = spectrum;
+    }
+}
+
+double SpectrumStitchProcessor::getLevel(SpectrumVisualData& data, float point) {
+    //reverse of the SpectrumVisualProcessor scaling, whose output ceiling is divided by the scale factor.
+    double sf = mainProcessor->getScaleFactor();
+    double floorOfs = data.fft_floor - 0.75;
+    double range = log10(data.fft_ceiling * sf + 0.25 - floorOfs);
+
+    return pow(10.0, (point / sf) * range) - 0.25 + floorOfs;
+}
+
+void SpectrumStitchProcessor::process() {
+    SpectrumVisualDataPtr mainData;
+
+    if (!input->try_pop(mainData) || !mainData) {
+        return;
+    }
+
+    std::lock_guard < std::mutex > busy_lock(busy_receivers);
+
+    std::vector<SpectrumVisualData *> sources;
+
+    for (int i = 1; i < SDR_MAX_RECEIVERS; i++) {
+        if (!receivers[i]) {
+            continue;
+        }
+
+        long long frequency, sampleRate;
+
+        if (!SDRCoverage::getBand(i, frequency, sampleRate)) {
+            receivers[i]->latest = nullptr;
+            continue;
+        }
+
+        //a whole band, the stitching places it.
+        receivers[i]->processor.setView(false, frequency, sampleRate);
+
+        updateReceiver(*receivers[i]);
+
+        SpectrumVisualDataPtr latest = receivers[i]->latest;
+
+        if (latest && latest->bandwidth == sampleRate && latest->centerFreq == frequency && latest->spectrum_points.size()) {
+            sources.push_back(latest.get());
+        }
+    }
+
+    if (sources.empty() || mainProcessor->isView() || !mainData->bandwidth || mainData->spectrum_points.empty()) {
+        distribute(mainData);
+        return;
+    }
+
+    //the main spectrum first, it wins over the overlapping receivers.
+    sources.insert(sources.begin(), mainData.get());
+
+    long long spanStart = mainData->centerFreq - mainData->bandwidth / 2;
+    long long spanEnd = mainData->centerFreq + mainData->bandwidth / 2;
+    double spanFloor = mainData->fft_floor;
+    double spanCeil = mainData->fft_ceiling;
+
+    for (SpectrumVisualData *source : sources) {
+        spanStart = std::min(spanStart, source->centerFreq - source->bandwidth / 2);
+        spanEnd = std::max(spanEnd, source->centerFreq + source->bandwidth / 2);
+        spanFloor = std::min(spanFloor, source->fft_floor);
+        spanCeil = std::max(spanCeil, source->fft_ceiling);
+    }
+
+    long long spanBandwidth = spanEnd - spanStart;
+
+    //the resolution of the main spectrum, over the whole span.
+    size_t mainPoints = mainData->spectrum_points.size() / 2;
+    size_t numPoints = (size_t)((double)mainPoints * (double)spanBandwidth / (double)mainData->bandwidth);
+    numPoints = std::min(std::max(numPoints, mainPoints), mainPoints * SPECTRUM_STITCH_MAX_SPAN);
+
+    bool doPeak = !mainData->spectrum_hold_points.empty();
+
+    SpectrumVisualDataPtr output = outputBuffers.getBuffer();
+
+    output->spectrum_points.resize(numPoints * 2);
+    output->spectrum_hold_points.resize(doPeak ? numPoints * 2 : 0);
+
+    double sf = mainProcessor->getScaleFactor();
+    double floorOfs = spanFloor - 0.75;
+    double range = log10(spanCeil * sf + 0.25 - floorOfs);
+
+    for (size_t x = 0; x < numPoints; x++) {
+        long long freq = spanStart + (long long)((double)spanBandwidth * ((double)x + 0.5) / (double)numPoints);
+
+        double level = spanFloor;
+        double holdLevel = spanFloor;
+
+        for (SpectrumVisualData *source : sources) {
+            long long sourceStart = source->centerFreq - source->bandwidth / 2;
+
+            if (freq < sourceStart || freq >= sourceStart + source->bandwidth) {
+                continue;
+            }
+
+            size_t sourcePoints = source->spectrum_points.size() / 2;
+            size_t idx = std::min((size_t)((double)(freq - sourceStart) * (double)sourcePoints / (double)source->bandwidth), sourcePoints - 1);
+
+            level = getLevel(*source, source->spectrum_points[idx * 2 + 1]);
+
+            if (doPeak) {
+                bool hasHold = (source->spectrum_hold_points.size() == source->spectrum_points.size());
+                holdLevel = getLevel(*source, hasHold ? source->spectrum_hold_points[idx * 2 + 1] : source->spectrum_points[idx * 2 + 1]);
+            }
+            break;
+        }
+
+        float px = (float)x / (float)numPoints;
+
+        output->spectrum_points[x * 2] = px;
+        output->spectrum_points[x * 2 + 1] = (log10(std::max(level + 0.25 - floorOfs, 1.0)) / range) * sf;
+
+        if (doPeak) {
+            output->spectrum_hold_points[x * 2] = px;
+            output->spectrum_hold_points[x * 2 + 1] = (log10(std::max(holdLevel + 0.25 - floorOfs, 1.0)) / range) * sf;
+        }
+    }
+
+    output->fft_ceiling = spanCeil;
+    output->fft_floor = spanFloor;
+    output->centerFreq = spanStart + spanBandwidth / 2;
+    output->bandwidth = (int)spanBandwidth;
+    output->stitched = true;
+
+    distribute(output);
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include "SpectrumVisualProcessor.h"
+#include "SDRCoverage.h"
+
+#include <mutex>
+
+/**
+ * Stitches the main spectrum with the spectra of the additional receivers (SDRReceiver) into one,
+ * covering all their bands. The input is the output of the main SpectrumVisualProcessor;
+ * each receiver has a SpectrumVisualProcessor of its own, run here and following the FFT size,
+ * averaging, peak hold and scale of the main one.
+ * The levels of each spectrum are brought back to a common floor and ceiling.
+ * Where bands overlap, the main device wins, then the lowest receiver index.
+ * Without receivers, or while the main spectrum is zoomed in, the main spectrum goes through as is.
+ */
+class SpectrumStitchProcessor : public VisualProcessor<SpectrumVisualData, SpectrumVisualData> {
+public:
+    SpectrumStitchProcessor(SpectrumVisualProcessor *mainProcessor);
+    ~SpectrumStitchProcessor();
+
+    //the full band IQ input of 'receiver', i.e. for its SDRPostThread "IQVisualDataOutput".
+    DemodulatorThreadInputQueuePtr addReceiver(int receiver);
+    void removeReceiver(int receiver);
+
+protected:
+    virtual void process();
+
+    ReBuffer<SpectrumVisualData> outputBuffers;
+
+private:
+    class ReceiverSpectrum {
+    public:
+        SpectrumVisualProcessor processor;
+        DemodulatorThreadInputQueuePtr iqInput;
+        SpectrumVisualDataQueuePtr spectrumOutput;
+        //the latest spectrum of the receiver, stitched until a newer one comes.
+        SpectrumVisualDataPtr latest;
+        bool peakHold = false;
+    };
+
+    void updateReceiver(ReceiverSpectrum& receiverSpectrum);
+
+    //the linear level of a point of 'data', whose levels are scaled between its own floor and ceiling.
+    double getLevel(SpectrumVisualData& data, float point);
+
+    SpectrumVisualProcessor *mainProcessor;
+
+    //protects receivers
+    std::mutex busy_receivers;
+    ReceiverSpectrum *receivers[SDR_MAX_RECEIVERS];
+};
@@ -3,18 +3,38 @@
 
 #include "SpectrumVisualDataThread.h"
 #include "CubicSDR.h"
+#include "RenderScheduler.h"
 
 SpectrumVisualDataThread::SpectrumVisualDataThread() {
 }
 
 SpectrumVisualDataThread::~SpectrumVisualDataThread() {
-    
+    delete stitcher;
 }
 
 SpectrumVisualProcessor *SpectrumVisualDataThread::getProcessor() {
     return &sproc;
 }
 
+void SpectrumVisualDataThread::enableStitching() {
+    if (stitcher) {
+        return;
+    }
+
+    stitcher = new SpectrumStitchProcessor(&sproc);
+
+    SpectrumVisualDataQueuePtr stitchInput = std::make_shared<SpectrumVisualDataQueue>();
+    stitchInput->set_max_num_items(1);
+    stitchInput->set_stats_name("SpectrumStitchInput");
+
+    sproc.attachOutput(stitchInput);
+    stitcher->setInput(stitchInput);
+}
+
+SpectrumStitchProcessor *SpectrumVisualDataThread::getStitcher() {
+    return stitcher;
+}
+
 void SpectrumVisualDataThread::run() {
     
     while(!stopping) {
@@ -22,7 +42,19 @@ void SpectrumVisualDataThread::run() {
         //so sleep for << FFT_DISTRIBUTOR_BUFFER_IN_SECONDS not to be overflown
        std::this_thread::sleep_for(std::chrono::milliseconds((int)(FFT_DISTRIBUTOR_BUFFER_IN_SECONDS * 1000.0 / 25.0)));
 
+        bool newData = !sproc.isInputEmpty();
+
         sproc.run();
+
+        //same thread: the stitched spectrum is ready right away.
+        if (stitcher) {
+            stitcher->run();
+        }
+
+        //a new spectrum to draw
+        if (newData) {
+            RenderScheduler::wake();
+        }
     }
     
 //    std::cout << "Spectrum visual data thread done." << std::endl;
@@ -31,4 +63,7 @@ void SpectrumVisualDataThread::run() {
 void SpectrumVisualDataThread::terminate() {
     IOThread::terminate();
     sproc.flushQueues();
+    if (stitcher) {
+        stitcher->flushQueues();
+    }
 }
\ No newline at end of file
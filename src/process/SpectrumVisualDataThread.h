@@ -5,12 +5,19 @@
 
 #include "IOThread.h"
 #include "SpectrumVisualProcessor.h"
+#include "SpectrumStitchProcessor.h"
 
 class SpectrumVisualDataThread : public IOThread {
 public:
     SpectrumVisualDataThread();
     ~SpectrumVisualDataThread();
     SpectrumVisualProcessor *getProcessor();
+
+    //the main spectrum, before the thread starts: run a SpectrumStitchProcessor after the processor,
+    //whose outputs are then the spectrum ones.
+    void enableStitching();
+    //nullptr if not enabled.
+    SpectrumStitchProcessor *getStitcher();
     
     virtual void run();
 
@@ -18,4 +25,5 @@ public:
     
 protected:
     SpectrumVisualProcessor sproc;
+    SpectrumStitchProcessor *stitcher = nullptr;
 };
@@ -2,7 +2,7 @@
 // SPDX-License-Identifier: GPL-2.0+
 
 #include "SpectrumVisualProcessor.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 
 //50 ms
 #define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000) 
@@ -243,6 +243,11 @@ void SpectrumVisualProcessor::process() {
 
     //then get the busy_lock for the rest of the processing.
     std::lock_guard < std::mutex > busy_lock(busy_run);    
+
+    //never run an FFT over samples from both sides of a retune: prime again from the new samples.
+    if (iqData->retuned) {
+        lastDataSize = 0;
+    }
    
     bool doPeak = peakHold && (peakReset == 0);
     
@@ -303,7 +308,7 @@ void SpectrumVisualProcessor::process() {
             
             if (centerFreq != iqData->frequency) {
                 if ((centerFreq - iqData->frequency) != shiftFrequency || lastInputBandwidth != iqData->sampleRate) {
-                    if (abs(iqData->frequency - centerFreq) < (wxGetApp().getSampleRate() / 2)) {
+                    if (abs(iqData->frequency - centerFreq) < (SDREngine::get()->getSampleRate() / 2)) {
                         long lastShiftFrequency = shiftFrequency;
                         shiftFrequency = centerFreq - iqData->frequency;
                         nco_crcf_set_frequency(freqShifter, (2.0 * M_PI) * (((double) abs(shiftFrequency)) / ((double) iqData->sampleRate)));
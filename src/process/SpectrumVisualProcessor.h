@@ -18,6 +18,8 @@ public:
     double fft_ceiling, fft_floor;
     long long centerFreq;
     int bandwidth;
+    //from SpectrumStitchProcessor, over several receivers: wider than the main device, drawn over its own span.
+    bool stitched = false;
 
     virtual ~SpectrumVisualData() {};
 };
@@ -6,7 +6,7 @@
 std::vector<const struct rig_caps *> RigThread::rigCaps;
 
 RigThread::RigThread() {
-    freq = wxGetApp().getFrequency();
+    freq = SDREngine::get()->getFrequency();
     newFreq = freq;
     freqChanged.store(true);
     termStatus = 0;
@@ -135,8 +135,8 @@ void RigThread::run() {
     while (!stopping) {
         std::this_thread::sleep_for(std::chrono::milliseconds(150));
         
-        auto activeDemod = wxGetApp().getDemodMgr().getActiveContextModem();
-        auto lastDemod = wxGetApp().getDemodMgr().getCurrentModem();
+        auto activeDemod = SDREngine::get()->getDemodMgr().getActiveContextModem();
+        auto lastDemod = SDREngine::get()->getDemodMgr().getCurrentModem();
 
         if (freqChanged.load() && (controlMode.load() || setOneShot.load())) {
             status = rig_get_freq(rig, RIG_VFO_CURR, &freq);
@@ -173,10 +173,10 @@ void RigThread::run() {
                             lastDemod->setFollow(true);
                         }
                     } else {
-                        wxGetApp().setFrequency((long long)checkFreq);
+                        SDREngine::get()->setFrequency((long long)checkFreq);
                     }
-                } else if (wxGetApp().getFrequency() != freq && controlMode.load() && !centerLock.load() && !followModem.load()) {
-                    freq = wxGetApp().getFrequency();
+                } else if (SDREngine::get()->getFrequency() != freq && controlMode.load() && !centerLock.load() && !followModem.load()) {
+                    freq = SDREngine::get()->getFrequency();
                     status = rig_set_freq(rig, RIG_VFO_CURR, freq);
                     if (status == -RIG_ENIMPL) {
                         std::cout << "Rig does not support rig_set_freq?" << std::endl;
@@ -203,8 +203,8 @@ void RigThread::run() {
             }
         }
         
-        if (!centerLock.load() && followModem.load() && wxGetApp().getFrequency() != freq && (lastDemod && lastDemod != activeDemod)) {
-            wxGetApp().setFrequency((long long)freq);
+        if (!centerLock.load() && followModem.load() && SDREngine::get()->getFrequency() != freq && (lastDemod && lastDemod != activeDemod)) {
+            SDREngine::get()->setFrequency((long long)freq);
         }
         
 //        std::cout <<  "Rig Freq: " << freq << std::endl;
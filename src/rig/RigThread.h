@@ -4,7 +4,7 @@
 #pragma once
 
 #include "IOThread.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include <hamlib/rig.h>
 #include <hamlib/riglist.h>
 
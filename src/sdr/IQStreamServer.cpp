@@ -0,0 +1,324 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "IQStreamServer.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+//how long the thread waits for a block before serving the sockets anyway.
+#define IQ_STREAM_POLL_MICROS (5 * 1000)
+
+#define IQ_STREAM_INPUT_QUEUE_SIZE 64
+
+//rtl_tcp dongle info sent on connect: "RTL0", then the tuner type and its gain count, big endian.
+//Advertise a R820T, the tuner the clients know best.
+#define IQ_STREAM_TUNER_TYPE 5
+#define IQ_STREAM_TUNER_GAIN_COUNT 29
+
+#ifdef MSG_NOSIGNAL
+#define IQ_STREAM_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define IQ_STREAM_SEND_FLAGS 0
+#endif
+
+static bool setNonBlocking(IQStreamSocket socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+//the last socket call failed only because it would have blocked.
+static bool wouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+static void putBigEndian(unsigned char *dst, unsigned int value) {
+    dst[0] = (unsigned char)(value >> 24);
+    dst[1] = (unsigned char)(value >> 16);
+    dst[2] = (unsigned char)(value >> 8);
+    dst[3] = (unsigned char)value;
+}
+
+IQStreamServer::Client::Client(IQStreamSocket socket, const std::string& peer) : socket(socket), peer(peer), ring(IQ_STREAM_CLIENT_BUFFER_BYTES) {
+    stats = PipelineStats::addQueue();
+    stats->setName("IQStreamClient");
+    stats->setCapacity(ring.capacity());
+}
+
+IQStreamServer::IQStreamServer() : IOThread(), listenSocket(IQ_STREAM_INVALID_SOCKET), clientCount(0) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    inputQueue = std::make_shared<DemodulatorThreadInputQueue>();
+    inputQueue->set_max_num_items(IQ_STREAM_INPUT_QUEUE_SIZE);
+    inputQueue->set_stats_name("IQStreamData");
+    setInputQueue("IQDataInput", inputQueue);
+}
+
+IQStreamServer::~IQStreamServer() {
+    for (ClientPtr client : clients) {
+        closeSocket(client->socket);
+    }
+    clients.clear();
+
+    if (listenSocket != IQ_STREAM_INVALID_SOCKET) {
+        closeSocket(listenSocket);
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool IQStreamServer::listen(const std::string& address, int port) {
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cout << "IQStreamServer: '" << address << "' is not an IPv4 address." << std::endl;
+        return false;
+    }
+
+    listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == IQ_STREAM_INVALID_SOCKET) {
+        std::cout << "IQStreamServer: unable to create a socket." << std::endl;
+        return false;
+    }
+
+#ifndef _WIN32
+    //restart on the same port right away, while the previous connections linger.
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+    if (bind(listenSocket, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(listenSocket, IQ_STREAM_MAX_CLIENTS) != 0 || !setNonBlocking(listenSocket)) {
+        std::cout << "IQStreamServer: unable to listen on " << address << ":" << port << "." << std::endl;
+        closeSocket(listenSocket);
+        listenSocket = IQ_STREAM_INVALID_SOCKET;
+        return false;
+    }
+
+    std::cout << "IQStreamServer: listening on " << address << ":" << port << " (rtl_tcp)." << std::endl;
+    return true;
+}
+
+void IQStreamServer::run() {
+
+    DemodulatorThreadIQDataPtr inp;
+
+    while (!stopping) {
+        if (inputQueue->pop(inp, IQ_STREAM_POLL_MICROS)) {
+            if (inp && !inp->data.empty()) {
+                queueBlock(*inp);
+            }
+            //give the buffer back to SDRPostThread right away.
+            inp = nullptr;
+        }
+
+        if (listenSocket != IQ_STREAM_INVALID_SOCKET) {
+            acceptClients();
+        }
+
+        for (auto i = clients.begin(); i != clients.end();) {
+            if (!readCommands(**i) || !sendPending(**i)) {
+                std::cout << "IQStreamServer: client " << (*i)->peer << " disconnected." << std::endl;
+                closeSocket((*i)->socket);
+                i = clients.erase(i);
+            } else {
+                i++;
+            }
+        }
+
+        clientCount.store((int)clients.size());
+    }
+
+    for (ClientPtr client : clients) {
+        closeSocket(client->socket);
+    }
+    clients.clear();
+    clientCount.store(0);
+}
+
+void IQStreamServer::terminate() {
+    IOThread::terminate();
+    //unblock push()
+    inputQueue->flush();
+}
+
+int IQStreamServer::getClientCount() {
+    return clientCount.load();
+}
+
+void IQStreamServer::acceptClients() {
+    while (true) {
+        sockaddr_in addr;
+        socklen_t addrLen = sizeof(addr);
+
+        IQStreamSocket clientSocket = accept(listenSocket, (sockaddr *)&addr, &addrLen);
+
+        if (clientSocket == IQ_STREAM_INVALID_SOCKET) {
+            return;
+        }
+
+        char host[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+        std::string peer = std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+
+        if (clients.size() >= IQ_STREAM_MAX_CLIENTS || !setNonBlocking(clientSocket)) {
+            std::cout << "IQStreamServer: client " << peer << " refused." << std::endl;
+            closeSocket(clientSocket);
+            continue;
+        }
+
+#ifdef SO_NOSIGPIPE
+        //no MSG_NOSIGNAL here: a client gone must not kill the application.
+        int noSigPipe = 1;
+        setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+        ClientPtr client = std::make_shared<Client>(clientSocket, peer);
+
+        unsigned char dongleInfo[12] = { 'R', 'T', 'L', '0' };
+        putBigEndian(dongleInfo + 4, IQ_STREAM_TUNER_TYPE);
+        putBigEndian(dongleInfo + 8, IQ_STREAM_TUNER_GAIN_COUNT);
+        client->ring.write(dongleInfo, sizeof(dongleInfo));
+
+        clients.push_back(client);
+
+        std::cout << "IQStreamServer: client " << peer << " connected." << std::endl;
+    }
+}
+
+bool IQStreamServer::readCommands(Client& client) {
+    //5 bytes commands: tuning, gain, sample rate... The device belongs to CubicSDR, drop them.
+    char discard[256];
+
+    while (true) {
+        int received = (int)recv(client.socket, discard, sizeof(discard), 0);
+
+        if (received > 0) {
+            continue;
+        }
+        //0: closed by the client.
+        return (received < 0) && wouldBlock();
+    }
+}
+
+bool IQStreamServer::sendPending(Client& client) {
+    while (true) {
+        const unsigned char *p1, *p2;
+        size_t n1, n2;
+
+        size_t pending = client.ring.readRegions(client.ring.capacity(), p1, n1, p2, n2);
+
+        if (!pending) {
+            return true;
+        }
+
+        //both regions of the ring straight to the socket.
+#ifdef _WIN32
+        WSABUF buffers[2];
+        buffers[0].buf = (CHAR *)p1;
+        buffers[0].len = (ULONG)n1;
+        buffers[1].buf = (CHAR *)p2;
+        buffers[1].len = (ULONG)n2;
+
+        DWORD sent = 0;
+        if (WSASend(client.socket, buffers, n2 ? 2 : 1, &sent, 0, nullptr, nullptr) == SOCKET_ERROR) {
+            return wouldBlock();
+        }
+#else
+        iovec buffers[2];
+        buffers[0].iov_base = (void *)p1;
+        buffers[0].iov_len = n1;
+        buffers[1].iov_base = (void *)p2;
+        buffers[1].iov_len = n2;
+
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = buffers;
+        message.msg_iovlen = n2 ? 2 : 1;
+
+        ssize_t sent = sendmsg(client.socket, &message, IQ_STREAM_SEND_FLAGS);
+        if (sent < 0) {
+            return wouldBlock();
+        }
+#endif
+
+        client.ring.consume((size_t)sent);
+
+        //the socket buffer is full, the rest on the next round.
+        if ((size_t)sent < pending) {
+            return true;
+        }
+    }
+}
+
+void IQStreamServer::queueBlock(const DemodulatorThreadIQData& block) {
+    if (clients.empty()) {
+        return;
+    }
+
+    size_t numSamples = block.data.size();
+
+    if (convertBuffer.capacity() < numSamples * 2) {
+        convertBuffer.reserve(numSamples * 2);
+    }
+    convertBuffer.resize(numSamples * 2);
+
+    //rtl_tcp samples: unsigned 8 bit, 127.5 for 0.
+    for (size_t i = 0; i < numSamples; i++) {
+        float re = std::min(std::max(block.data[i].real * 127.5f + 128.0f, 0.0f), 255.0f);
+        float im = std::min(std::max(block.data[i].imag * 127.5f + 128.0f, 0.0f), 255.0f);
+
+        convertBuffer[i * 2] = (unsigned char)re;
+        convertBuffer[i * 2 + 1] = (unsigned char)im;
+    }
+
+    for (ClientPtr client : clients) {
+        //a whole block or nothing, so that the client stays aligned on I/Q pairs.
+        if (client->ring.writeAvailable() < convertBuffer.size()) {
+            client->stats->onPushFailure();
+            continue;
+        }
+
+        client->ring.write(&convertBuffer[0], convertBuffer.size());
+        client->stats->onPush(client->ring.readAvailable());
+    }
+}
+
+void IQStreamServer::closeSocket(IQStreamSocket socket) {
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
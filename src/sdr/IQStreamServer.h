@@ -0,0 +1,84 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include "IOThread.h"
+#include "DemodDefs.h"
+#include "PipelineStats.h"
+#include "SPSCRingBuffer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+typedef SOCKET IQStreamSocket;
+#define IQ_STREAM_INVALID_SOCKET INVALID_SOCKET
+#else
+typedef int IQStreamSocket;
+#define IQ_STREAM_INVALID_SOCKET (-1)
+#endif
+
+//the rtl_tcp default port.
+#define IQ_STREAM_DEFAULT_PORT 1234
+
+//bytes queued per client, about 0.7 s at 2.88 Msps: beyond that a slow client loses whole blocks.
+#define IQ_STREAM_CLIENT_BUFFER_BYTES (1 << 22)
+
+#define IQ_STREAM_MAX_CLIENTS 8
+
+/**
+ * Re-serves the DC-corrected IQ of SDRPostThread over TCP in the rtl_tcp protocol,
+ * so that other tools can share the device CubicSDR has opened.
+ * Each client has its own bounded ring, sent from directly (scatter/gather, no staging copy).
+ * A slow client loses whole blocks on its own ring: neither the other clients nor SDRPostThread ever wait for it.
+ * The device belongs to CubicSDR: the tuning commands of the clients are read and ignored.
+ */
+class IQStreamServer : public IOThread {
+public:
+    IQStreamServer();
+    virtual ~IQStreamServer();
+
+    //open the listening socket, before the thread starts. 'address' is the local address to bind, i.e. "127.0.0.1".
+    bool listen(const std::string& address, int port);
+
+    virtual void run();
+    virtual void terminate();
+
+    int getClientCount();
+
+private:
+    class Client {
+    public:
+        Client(IQStreamSocket socket, const std::string& peer);
+
+        IQStreamSocket socket;
+        std::string peer;
+        SPSCRingBuffer<unsigned char> ring;
+        //pushes are the blocks queued, push failures the blocks dropped, depth in bytes.
+        std::shared_ptr<QueueStats> stats;
+    };
+
+    typedef std::shared_ptr<Client> ClientPtr;
+
+    void acceptClients();
+    //false once the client is gone.
+    bool readCommands(Client& client);
+    bool sendPending(Client& client);
+    void queueBlock(const DemodulatorThreadIQData& block);
+    void closeSocket(IQStreamSocket socket);
+
+    DemodulatorThreadInputQueuePtr inputQueue;
+
+    IQStreamSocket listenSocket;
+    std::vector<ClientPtr> clients;
+    std::atomic_int clientCount;
+
+    //the last block, as rtl_tcp unsigned 8 bit I/Q pairs.
+    std::vector<unsigned char> convertBuffer;
+};
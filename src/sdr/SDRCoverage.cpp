@@ -0,0 +1,83 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "SDRCoverage.h"
+
+#include <cstdlib>
+#include <thread>
+
+std::atomic_uint SDRCoverage::sequences[SDR_MAX_RECEIVERS];
+std::atomic_llong SDRCoverage::frequencies[SDR_MAX_RECEIVERS];
+std::atomic_llong SDRCoverage::sampleRates[SDR_MAX_RECEIVERS];
+std::atomic_ullong SDRCoverage::version(1);
+
+void SDRCoverage::setBand(int receiver, long long frequency, long long sampleRate) {
+    if (receiver < 0 || receiver >= SDR_MAX_RECEIVERS) {
+        return;
+    }
+
+    long long currentFrequency, currentSampleRate;
+
+    readBand(receiver, currentFrequency, currentSampleRate);
+
+    //only a real change re-routes the demodulators.
+    if (currentFrequency == frequency && currentSampleRate == sampleRate) {
+        return;
+    }
+
+    //odd: being written. Taken by exchange, in case the band is cleared from another thread.
+    unsigned int seq = sequences[receiver].load();
+
+    while ((seq & 1) || !sequences[receiver].compare_exchange_weak(seq, seq + 1)) {
+        std::this_thread::yield();
+        seq = sequences[receiver].load();
+    }
+
+    frequencies[receiver].store(frequency);
+    sampleRates[receiver].store(sampleRate);
+
+    sequences[receiver].store(seq + 2);
+
+    version++;
+}
+
+void SDRCoverage::readBand(int receiver, long long& frequency, long long& sampleRate) {
+    unsigned int seq;
+
+    do {
+        seq = sequences[receiver].load();
+        frequency = frequencies[receiver].load();
+        sampleRate = sampleRates[receiver].load();
+    } while ((seq & 1) || sequences[receiver].load() != seq);
+}
+
+void SDRCoverage::clearBand(int receiver) {
+    setBand(receiver, 0, 0);
+}
+
+bool SDRCoverage::getBand(int receiver, long long& frequency, long long& sampleRate) {
+    if (receiver < 0 || receiver >= SDR_MAX_RECEIVERS) {
+        return false;
+    }
+
+    readBand(receiver, frequency, sampleRate);
+
+    return sampleRate > 0;
+}
+
+int SDRCoverage::getReceiverAt(long long frequency) {
+    for (int i = 0; i < SDR_MAX_RECEIVERS; i++) {
+        long long center, rate;
+
+        readBand(i, center, rate);
+
+        if (rate > 0 && std::llabs(center - frequency) <= (rate / 2)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+unsigned long long SDRCoverage::getVersion() {
+    return version.load();
+}
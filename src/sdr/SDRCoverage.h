@@ -0,0 +1,39 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+
+//the main device, and up to 3 additional receivers.
+#define SDR_MAX_RECEIVERS 4
+
+/**
+ * The band each running receiver covers, for the SDRPostThreads to route the demodulators:
+ * a demodulator is fed by the first receiver covering its frequency, the main device (0) first.
+ * Lock-free: a receiver only ever writes its own band, and every change bumps a version
+ * the post-processing threads check, like the DemodulatorMgr index.
+ * The frequency and rate of a band go together: each band has a sequence number, odd while
+ * it is being written, and a reader tries again until it read both between the same even values.
+ */
+class SDRCoverage {
+public:
+    static void setBand(int receiver, long long frequency, long long sampleRate);
+    static void clearBand(int receiver);
+
+    //false if 'receiver' covers nothing.
+    static bool getBand(int receiver, long long& frequency, long long& sampleRate);
+
+    //the receiver covering 'frequency', -1 for none.
+    static int getReceiverAt(long long frequency);
+
+    static unsigned long long getVersion();
+
+private:
+    static void readBand(int receiver, long long& frequency, long long& sampleRate);
+
+    static std::atomic_uint sequences[SDR_MAX_RECEIVERS];
+    static std::atomic_llong frequencies[SDR_MAX_RECEIVERS];
+    static std::atomic_llong sampleRates[SDR_MAX_RECEIVERS];
+    static std::atomic_ullong version;
+};
@@ -15,6 +15,12 @@ typedef struct _SDRManualDef {
     std::string params;
 } SDRManualDef;
 
+//an additional receiver of the configuration: the device, and the frequency it is tuned to.
+typedef struct _SDRReceiverDef {
+    std::string deviceId;
+    long long frequency;
+} SDRReceiverDef;
+
 typedef std::map<std::string, SoapySDR::Range> SDRRangeMap;
 
 class SDRDeviceInfo {
@@ -4,8 +4,13 @@
 #include "SDREnumerator.h"
 #include "CubicSDRDefs.h"
 #include <vector>
-#include "CubicSDR.h"
+#include "SDREngine.h"
+#include "DataTree.h"
 #include <string>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
 
 #ifdef WIN32
 #include <locale>
@@ -19,6 +24,12 @@ std::map< std::string, std::vector<SDRDeviceInfo *> > SDREnumerator::devs;
 bool SDREnumerator::soapy_initialized = false;
 bool SDREnumerator::has_remote = false;
 std::vector<SDRManualDef> SDREnumerator::manuals;
+std::mutex SDREnumerator::devs_busy;
+std::map<std::string, SDRDeviceProbe> SDREnumerator::probeCache;
+bool SDREnumerator::probe_cache_loaded = false;
+std::mutex SDREnumerator::probe_cache_busy;
+std::string SDREnumerator::probeCachePath;
+std::map<std::string, SDRDeviceLateProbe> SDREnumerator::lateProbes;
 
 SDREnumerator::SDREnumerator() : IOThread() {
   
@@ -81,8 +92,12 @@ SoapySDR::Kwargs SDREnumerator::argsStrToKwargs(const std::string &args)
 
 std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remoteAddr, bool noInit) {
 
-    if (SDREnumerator::devs[remoteAddr].size()) {
-        return &SDREnumerator::devs[remoteAddr];
+    {
+        std::lock_guard < std::mutex > lock(devs_busy);
+
+        if (SDREnumerator::devs[remoteAddr].size()) {
+            return &SDREnumerator::devs[remoteAddr];
+        }
     }
     
     if (noInit) {
@@ -97,13 +112,13 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
         
         std::cout << "\tLoading modules... " << std::endl << std::flush;
         
-        std::string userModPath = wxGetApp().getModulePath();
+        std::string userModPath = SDREngine::get()->getModulePath();
         
         if (userModPath != "") {
-            wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules from " + userModPath + "..");
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules from " + userModPath + "..");
             std::vector<std::string> localMods = SoapySDR::listModules(userModPath);
             for (std::string mod : localMods) {
-                wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Initializing user specified SoapySDR module " + (mod) + "..");
+                SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Initializing user specified SoapySDR module " + (mod) + "..");
                 std::cout << "Initializing user specified SoapySDR module " << (mod) <<  ".." << std::endl << std::flush;
                 SoapySDR::loadModule(mod);
             }
@@ -113,14 +128,14 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
 			wxFileName exePath = wxFileName(wxStandardPaths::Get().GetExecutablePath());
 			std::vector<std::string> localMods = SoapySDR::listModules(exePath.GetPath().ToStdString() + "/modules/");
 			for (std::vector<std::string>::iterator mods_i = localMods.begin(); mods_i != localMods.end(); mods_i++) {
-				wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Initializing bundled SoapySDR module " + (*mods_i) + "..");
+				SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Initializing bundled SoapySDR module " + (*mods_i) + "..");
 				std::cout << "Loading bundled SoapySDR module " << (*mods_i) << ".." << std::endl << std::flush;
 				SoapySDR::loadModule(*mods_i);
 			}
 			#else
-            bool localModPref = wxGetApp().getUseLocalMod();
+            bool localModPref = SDREngine::get()->getUseLocalMod();
             if (localModPref) {
-                wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules..");
+                SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules..");
                 std::cout << "Checking local system SoapySDR modules.." << std::endl << std::flush;
                 SoapySDR::loadModules();
             }
@@ -128,19 +143,19 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
             wxFileName exePath = wxFileName(wxStandardPaths::Get().GetExecutablePath());
             std::vector<std::string> localMods = SoapySDR::listModules(exePath.GetPath().ToStdString() + "/modules/");
             for (std::string mod : localMods) {
-                wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Initializing bundled SoapySDR module " + (mod) + "..");
+                SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Initializing bundled SoapySDR module " + (mod) + "..");
                 std::cout << "Loading bundled SoapySDR module " << (mod) <<  ".." << std::endl << std::flush;
                 SoapySDR::loadModule(mod);
             }
         
             if (!localModPref) {
-                wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules..");
+                SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules..");
                 std::cout << "Checking system SoapySDR modules.."  << std::endl << std::flush;
                 SoapySDR::loadModules();
             }
 			#endif
             #else
-            wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules..");
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Loading SoapySDR modules..");
             SoapySDR::loadModules();
             #endif
 
@@ -167,13 +182,17 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
         }
         if ((factories.size() == 1) && factories.find("null") != factories.end()) {
             std::cout << "Just 'null' factory found." << std::endl;
-            wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_FAILED, std::string("No modules available."));
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_FAILED, std::string("No modules available."));
         }
         std::cout << std::endl;
         soapy_initialized = true;
     }
     
-    modules = SoapySDR::listModules();
+    {
+        std::lock_guard < std::mutex > lock(devs_busy);
+
+        modules = SoapySDR::listModules();
+    }
 
     std::vector<SoapySDR::Kwargs> results;
     SoapySDR::Kwargs enumArgs;
@@ -202,7 +221,7 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
             
             manualParams.push_back(m_i->params);
             
-            wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Enumerating manual device '") + strDevArgs + "'..");
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Enumerating manual device '") + strDevArgs + "'..");
 
             manual_result = SoapySDR::Device::enumerate(strDevArgs);
             
@@ -222,8 +241,15 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
     }
     
     if (isRemote) {
-        wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Opening remote server ") + remoteAddr + "..");
+        SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Opening remote server ") + remoteAddr + "..");
     }
+
+    loadProbeCache();
+
+    std::vector<SDRDeviceInfo *> found;
+    std::vector<std::future<SDRDeviceProbe> > probes(results.size());
+    std::vector<std::thread *> probeThreads(results.size(), nullptr);
+
     for (size_t i = 0; i < results.size(); i++) {
         SDRDeviceInfo *dev = new SDRDeviceInfo();
         
@@ -250,58 +276,124 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
         if (i>=manualsIdx) {
             dev->setManualParams(manualParams[i-manualsIdx]);
         }
-        
-        std::cout << "Make device " << i << std::endl;
-        if (i<manualsIdx || manualResult[i-manualsIdx]) try {
-            SoapySDR::Device *device = SoapySDR::Device::make(deviceArgs);
-            SoapySDR::Kwargs info = device->getHardwareInfo();
-            for (SoapySDR::Kwargs::const_iterator it = info.begin(); it != info.end(); ++it) {
-                std::cout << "  " << it->first << "=" << it->second << std::endl;
-                if (it->first == "hardware") {
-                    dev->setHardware(it->second);
-                }
+
+        found.push_back(dev);
+
+        if (i>=manualsIdx && !manualResult[i-manualsIdx]) {
+            continue;
+        }
+
+        //not opened again while a previous probe is stuck in it.
+        if (isLateProbeRunning(getProbeKey(deviceArgs))) {
+            std::cout << "Device " << i << " still busy with a previous query" << std::endl;
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Device #") + std::to_string(i) + " still busy with a previous query");
+            continue;
+        }
+
+        std::map<std::string, SDRDeviceProbe>::iterator cached_i;
+        bool isCached;
+        {
+            std::lock_guard < std::mutex > lock(probe_cache_busy);
+
+            cached_i = probeCache.find(getProbeKey(deviceArgs));
+            isCached = (cached_i != probeCache.end());
+
+            if (isCached) {
+                dev->setHardware(cached_i->second.hardware);
             }
-            
-            if (isRemote) {
-                wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Querying remote " + remoteAddr + " device #" + std::to_string(i) + ": " + dev-> getName());
+        }
+
+        if (isCached) {
+            //usable right away, checked again when the device is opened.
+            std::cout << "Device " << i << " from cache" << std::endl;
+            dev->setAvailable(true);
+            continue;
+        }
+
+        if (isRemote) {
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Querying remote " + remoteAddr + " device #" + std::to_string(i) + ": " + dev-> getName());
+        } else {
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Querying device #") + std::to_string(i) + ": " + dev->getName());
+        }
+
+        //all the devices are opened at the same time, each one on its own thread.
+        std::cout << "Make device " << i << std::endl;
+        std::shared_ptr<std::packaged_task<SDRDeviceProbe()> > probe = std::make_shared<std::packaged_task<SDRDeviceProbe()> >(std::bind(&SDREnumerator::probeDevice, deviceArgs));
+        probes[i] = probe->get_future();
+        probeThreads[i] = new std::thread([probe]() { (*probe)(); });
+    }
+
+    std::chrono::steady_clock::time_point probeDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SDR_ENUM_PROBE_TIMEOUT_MS);
+    bool probed = false;
+
+    for (size_t i = 0; i < results.size(); i++) {
+        SDRDeviceInfo *dev = found[i];
+        SoapySDR::Kwargs deviceArgs = results[i];
+
+        if (probes[i].valid()) try {
+            if (probes[i].wait_until(probeDeadline) != std::future_status::ready) {
+                std::cerr << "Timeout making device " << i << std::endl;
+                SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Timeout querying device #") + std::to_string(i));
+                dev->setAvailable(false);
+
+                //a thread stuck in a driver is kept with its device, busy until it returns.
+                std::lock_guard < std::mutex > lock(probe_cache_busy);
+                SDRDeviceLateProbe &lateProbe = lateProbes[getProbeKey(deviceArgs)];
+                lateProbe.thread = probeThreads[i];
+                lateProbe.result = std::move(probes[i]);
+                probeThreads[i] = nullptr;
             } else {
-                wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Querying device #") + std::to_string(i) + ": " + dev->getName());
+                SDRDeviceProbe probe = probes[i].get();
+
+                std::cout << "  hardware=" << probe.hardware << std::endl;
+                dev->setHardware(probe.hardware);
+                dev->setAvailable(true);
+
+                std::lock_guard < std::mutex > lock(probe_cache_busy);
+                probeCache[getProbeKey(deviceArgs)] = probe;
+                probed = true;
             }
+        } catch (const std::exception &ex) {
+            std::cerr << "Error making device: " << ex.what() << std::endl;
+            SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Error querying device #") + std::to_string(i));
+            dev->setAvailable(false);
+        }
+
+        //done, one way or the other.
+        if (probeThreads[i]) {
+            probeThreads[i]->join();
+            delete probeThreads[i];
+        }
 
-            SoapySDR::ArgInfoList settingsInfo = device->getSettingInfo();
+        if (dev->isAvailable()) {
+            //servers are enumerated at the same time, the configuration is shared.
+            std::lock_guard < std::mutex > lock(devs_busy);
 
-            DeviceConfig *cfg = wxGetApp().getConfig()->getDevice(dev->getDeviceId());
+            DeviceConfig *cfg = SDREngine::get()->getConfig()->getDevice(dev->getDeviceId());
 
             ConfigSettings devSettings = cfg->getSettings();
             if (devSettings.size()) {
-				// Load the saved device settings to deviceArgs, and back to settingsInfo.
+				// Load the saved device settings to deviceArgs.
                 for (ConfigSettings::const_iterator set_i = devSettings.begin(); set_i != devSettings.end(); set_i++) {
                     deviceArgs[set_i->first] = set_i->second;
                 }
-                for (size_t j = 0; j < settingsInfo.size(); j++) {
-                    if (deviceArgs.find(settingsInfo[j].key) != deviceArgs.end()) {
-                        settingsInfo[j].value = deviceArgs[settingsInfo[j].key];
-                    }
-                }
             }
             
             dev->setDeviceArgs(deviceArgs);
-            
-            SoapySDR::Device::unmake(device);
-            dev->setAvailable(true);
-        } catch (const std::exception &ex) {
-            std::cerr << "Error making device: " << ex.what() << std::endl;
-            wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Error querying device #") + std::to_string(i));
-            dev->setAvailable(false);
-        } else {
-            dev->setAvailable(false);
         }
         std::cout << std::endl;
+    }
 
-        SDREnumerator::devs[remoteAddr].push_back(dev);
+    if (probed) {
+        saveProbeCache();
     }
+
+    std::lock_guard < std::mutex > lock(devs_busy);
+
+    SDREnumerator::devs[remoteAddr].insert(SDREnumerator::devs[remoteAddr].end(), found.begin(), found.end());
+
     if (SDREnumerator::devs[remoteAddr].empty()) {
-        wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("No devices found!"));
+        SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("No devices found!"));
     }
     std::cout << std::endl;
 
@@ -309,24 +401,210 @@ std::vector<SDRDeviceInfo *> *SDREnumerator::enumerate_devices(std::string remot
 }
 
 
+bool SDREnumerator::isLateProbeRunning(const std::string& key) {
+
+    std::lock_guard < std::mutex > lock(probe_cache_busy);
+
+    std::map<std::string, SDRDeviceLateProbe>::iterator late_i = lateProbes.find(key);
+
+    if (late_i == lateProbes.end()) {
+        return false;
+    }
+
+    if (late_i->second.result.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        return true;
+    }
+
+    late_i->second.thread->join();
+    delete late_i->second.thread;
+
+    //late, but still worth keeping.
+    try {
+        probeCache[key] = late_i->second.result.get();
+    } catch (const std::exception &ex) {
+        std::cerr << "Error making device: " << ex.what() << std::endl;
+    }
+
+    lateProbes.erase(late_i);
+
+    return false;
+}
+
+void SDREnumerator::cleanup() {
+
+    std::map<std::string, SDRDeviceLateProbe> pending;
+
+    {
+        std::lock_guard < std::mutex > lock(probe_cache_busy);
+        pending.swap(lateProbes);
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SDR_ENUM_LATE_PROBE_EXIT_TIMEOUT_MS);
+
+    for (auto &late_i : pending) {
+        if (late_i.second.result.wait_until(deadline) == std::future_status::ready) {
+            late_i.second.thread->join();
+            delete late_i.second.thread;
+        } else {
+            //still stuck in the driver: it goes with the process.
+            std::cout << "Device query '" << late_i.first << "' still running at exit." << std::endl;
+        }
+    }
+}
+
+SDRDeviceProbe SDREnumerator::probeDevice(SoapySDR::Kwargs deviceArgs) {
+
+    SDRDeviceProbe probe;
+
+    SoapySDR::Device *device = SoapySDR::Device::make(deviceArgs);
+    SoapySDR::Kwargs info = device->getHardwareInfo();
+
+    if (info.count("hardware")) {
+        probe.hardware = info["hardware"];
+    }
+
+    SoapySDR::Device::unmake(device);
+    probe.available = true;
+
+    return probe;
+}
+
+std::string SDREnumerator::getProbeKey(const SoapySDR::Kwargs &deviceArgs) {
+
+    std::string key;
+
+    SoapySDR::Kwargs::const_iterator driver_i = deviceArgs.find("driver");
+    SoapySDR::Kwargs::const_iterator serial_i = deviceArgs.find("serial");
+    SoapySDR::Kwargs::const_iterator remote_i = deviceArgs.find("remote");
+
+    if (serial_i == deviceArgs.end()) {
+        serial_i = deviceArgs.find("label");
+    }
+
+    key.append((driver_i != deviceArgs.end()) ? driver_i->second : "");
+    key.append(",");
+    key.append((serial_i != deviceArgs.end()) ? serial_i->second : "");
+
+    if (remote_i != deviceArgs.end()) {
+        key.append("@" + remote_i->second);
+    }
+
+    return key;
+}
+
+void SDREnumerator::loadProbeCache() {
+
+    std::lock_guard < std::mutex > lock(probe_cache_busy);
+
+    if (probe_cache_loaded) {
+        return;
+    }
+    probe_cache_loaded = true;
+
+    probeCachePath = SDREngine::get()->getConfig()->getConfigDir() + filePathSeparator + SDR_ENUM_PROBE_CACHE_FILE;
+
+    DataTree cache;
+
+    if (!wxFileExists(probeCachePath) || !cache.LoadFromFileBinary(probeCachePath)) {
+        return;
+    }
+
+    DataNode *devices = cache.rootNode();
+
+    while (devices->hasAnother("device")) {
+        DataNode *device = devices->getNext("device");
+
+        if (!device->hasAnother("key") || !device->hasAnother("hardware")) {
+            continue;
+        }
+
+        std::string key;
+        SDRDeviceProbe probe;
+
+        device->getNext("key")->element()->get(key);
+        device->getNext("hardware")->element()->get(probe.hardware);
+        probe.available = true;
+
+        probeCache[key] = probe;
+    }
+}
+
+void SDREnumerator::saveProbeCache() {
+
+    std::lock_guard < std::mutex > lock(probe_cache_busy);
+
+    if (probeCachePath.empty()) {
+        return;
+    }
+
+    DataTree cache("devices");
+
+    for (auto &probe_i : probeCache) {
+        DataNode *device = cache.rootNode()->newChild("device");
+
+        *device->newChild("key") = probe_i.first;
+        *device->newChild("hardware") = probe_i.second.hardware;
+    }
+
+    if (!cache.SaveToFileBinary(probeCachePath)) {
+        std::cout << "Unable to write device cache '" << probeCachePath << "'." << std::endl;
+    }
+}
+
+void SDREnumerator::revalidateDevice(const SoapySDR::Kwargs &deviceArgs, SoapySDR::Device *device) {
+
+    std::string key = getProbeKey(deviceArgs);
+    SDRDeviceProbe probe;
+
+    SoapySDR::Kwargs info = device->getHardwareInfo();
+
+    if (info.count("hardware")) {
+        probe.hardware = info["hardware"];
+    }
+    probe.available = true;
+
+    {
+        std::lock_guard < std::mutex > lock(probe_cache_busy);
+
+        std::map<std::string, SDRDeviceProbe>::iterator cached_i = probeCache.find(key);
+
+        if (cached_i != probeCache.end() && cached_i->second.hardware == probe.hardware) {
+            return;
+        }
+
+        probeCache[key] = probe;
+    }
+
+    saveProbeCache();
+}
+
 void SDREnumerator::run() {
 
     std::cout << "SDR enumerator starting." << std::endl;
     
 
-    wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Scanning local devices, please wait..");
+    SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Scanning local devices, please wait..");
     SDREnumerator::enumerate_devices("");
 
     if (remotes.size()) {
+
+        //the servers are scanned at the same time, SoapySDR is initialized by then.
+        std::vector<std::thread *> remoteThreads;
+
+        SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Scanning remote devices, please wait..");
       
         for (std::string remote : remotes) {
-            wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, "Scanning devices at " + (remote) + ", please wait..");
-            SDREnumerator::enumerate_devices(remote);
+            remoteThreads.push_back(new std::thread(&SDREnumerator::enumerate_devices, remote, false));
+        }
+
+        for (std::thread *remoteThread : remoteThreads) {
+            remoteThread->join();
+            delete remoteThread;
         }
     }
     
     std::cout << "Reporting enumeration complete." << std::endl;
-    wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_DEVICES_READY, "Finished scanning devices.");
+    SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_DEVICES_READY, "Finished scanning devices.");
     std::cout << "SDR enumerator done." << std::endl;
 
 }
@@ -4,8 +4,11 @@
 #pragma once
 
 #include <atomic>
+#include <future>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include "IOThread.h"
 #include "SDRDeviceInfo.h"
 #include "AppConfig.h"
@@ -15,6 +18,34 @@
 #include <SoapySDR/Registry.hpp>
 #include <SoapySDR/Device.hpp>
 
+//time given to all the devices being probed at once, beyond it a device is reported unavailable.
+#define SDR_ENUM_PROBE_TIMEOUT_MS (10000)
+
+//time given at exit to the probes still running past their timeout.
+#define SDR_ENUM_LATE_PROBE_EXIT_TIMEOUT_MS (3000)
+
+//probed device capabilities, in the config dir.
+#define SDR_ENUM_PROBE_CACHE_FILE "devices.cache"
+
+//What enumeration learns by opening a device.
+class SDRDeviceProbe {
+public:
+    SDRDeviceProbe() : available(false) {
+    }
+
+    std::string hardware;
+    bool available;
+};
+
+//A probe still running past the timeout, its device is busy until it returns.
+class SDRDeviceLateProbe {
+public:
+    SDRDeviceLateProbe() : thread(nullptr) {
+    }
+
+    std::thread *thread;
+    std::future<SDRDeviceProbe> result;
+};
 
 class SDREnumerator: public IOThread {
 private:
@@ -39,8 +70,33 @@ public:
     static void setManuals(std::vector<SDRManualDef> manuals);
     static void reset();
     static std::vector<std::string> &getFactories();
+
+    //device of deviceArgs just opened: refresh its cached capabilities, for the next enumeration.
+    static void revalidateDevice(const SoapySDR::Kwargs &deviceArgs, SoapySDR::Device *device);
+
+    //at exit: wait for the probes still running past their timeout.
+    static void cleanup();
     
 protected:
+    //open deviceArgs to read its capabilities, throws on failure.
+    static SDRDeviceProbe probeDevice(SoapySDR::Kwargs deviceArgs);
+
+    //devices of the same key are the same device: driver and serial, or label if no serial.
+    static std::string getProbeKey(const SoapySDR::Kwargs &deviceArgs);
+
+    static void loadProbeCache();
+    static void saveProbeCache();
+
+    //true while the late probe of 'key' is running; once it returned, its thread is joined and its result cached.
+    static bool isLateProbeRunning(const std::string& key);
+
+    static std::map<std::string, SDRDeviceProbe> probeCache;
+    static std::string probeCachePath;
+    static bool probe_cache_loaded;
+    static std::mutex probe_cache_busy;
+    //by probe key, protected by probe_cache_busy.
+    static std::map<std::string, SDRDeviceLateProbe> lateProbes;
+
     static bool soapy_initialized, has_remote;
     static std::vector<std::string> factories;
     static std::vector<std::string> modules;
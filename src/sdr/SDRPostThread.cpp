@@ -3,7 +3,7 @@
 
 #include "SDRPostThread.h"
 #include "CubicSDRDefs.h"
-#include "CubicSDR.h"
+#include "SDREngine.h"
 
 #include <vector>
 #include <deque>
@@ -12,10 +12,15 @@
 //50 ms
 #define HEARTBEAT_CHECK_PERIOD_MICROS (50 * 1000) 
 
-SDRPostThread::SDRPostThread() : IOThread(), buffers("SDRPostThreadBuffers"), visualDataBuffers("SDRPostThreadVisualDataBuffers"), frequency(0) {
+SDRPostThread::SDRPostThread() : IOThread(), buffers("SDRPostThreadBuffers"), visualDataBuffers("SDRPostThreadVisualDataBuffers"), frequency(0), retuned(false), lastRetuneIndex(-1), ingestTime(0), channelizerDelay(0) {
     iqDataInQueue = nullptr;
     iqDataOutQueue = nullptr;
     iqVisualQueue = nullptr;
+    iqStreamQueue = nullptr;
+    iqDetectorQueue = nullptr;
+
+    buffers.reserve(SDR_POST_BUFFERS_RESERVE);
+    visualDataBuffers.reserve(SDR_POST_BUFFERS_RESERVE);
 
     numChannels = 0;
     channelizer = nullptr;
@@ -26,14 +31,27 @@ SDRPostThread::SDRPostThread() : IOThread(), buffers("SDRPostThreadBuffers"), vi
     lastChanMode = 0;
     
     sampleRate = 0;
+
+    //time from the device read to the start of the post-processing.
+    latencyStats = PipelineStats::getStage("SDRPostThread");
     
     doRefresh.store(false);
     dcFilter = iirfilt_crcf_create_dc_blocker(0.0005f);
+    streamDCFilter = iirfilt_crcf_create_dc_blocker(0.0005f);
+
+    demodIndexVersion = 0;
+    demodChannelsDirty = true;
+    activeDemodChannel = -1;
+    runCurrentModemRouted = false;
+
+    receiver = 0;
+    coverageVersion = 0;
 }
 
 
 SDRPostThread::~SDRPostThread() {
     iirfilt_crcf_destroy(dcFilter);
+    iirfilt_crcf_destroy(streamDCFilter);
 }
 
 
@@ -42,34 +60,54 @@ void SDRPostThread::notifyDemodulatorsChanged() {
 }
 
 
-// Update the active list of demodulators for handling
+// Update the active list of demodulators for handling, from the current DemodulatorMgr index
 void SDRPostThread::updateActiveDemodulators() {
     // In range?
    
     runDemods.clear();
     demodChannel.clear();
+    runDemodFrequency.clear();
 
-    long long centerFreq = wxGetApp().getFrequency();
+    long long centerFreq = SDREngine::get()->getFrequency();
 
-    //retreive the current list of demodulators:
-    auto demodulators = wxGetApp().getDemodMgr().getDemodulators();
+    //publish the band of this receiver before routing, then route on the coverage of all of them.
+    if (sampleRate) {
+        SDRCoverage::setBand(receiver, frequency, sampleRate);
+    }
+    coverageVersion = SDRCoverage::getVersion();
+
+    //retreive the current index of demodulators, without lock:
+    DemodulatorIndexPtr demodIndex = SDREngine::get()->getDemodMgr().getIndex();
+    demodIndexVersion = demodIndex->getVersion();
+
+    DemodulatorInstancePtr currentModem = demodIndex->getCurrentModem();
    
-    for (auto demod : demodulators) {
+    for (const DemodulatorIndexEntry& entry : demodIndex->getEntries()) {
+        DemodulatorInstancePtr demod = entry.demod;
+        long long demodFrequency = entry.frequency;
             
-        // not in range?
-        if (demod->isDeltaLock()) {
-            if (demod->getFrequency() != centerFreq + demod->getDeltaLockOfs()) {
-                demod->setFrequency(centerFreq + demod->getDeltaLockOfs());
-                demod->updateLabel(demod->getFrequency());
+        // not in range? the delta lock follows the main device only.
+        if (demod->isDeltaLock() && receiver == 0) {
+            if (demodFrequency != centerFreq + demod->getDeltaLockOfs()) {
+                demodFrequency = centerFreq + demod->getDeltaLockOfs();
+                demod->setFrequency(demodFrequency);
+                demod->updateLabel(demodFrequency);
                 demod->setFollow(false);
                 demod->setTracking(false);
             }
         }
-        
-        if (abs(frequency - demod->getFrequency()) > (sampleRate / 2)) {
+
+        int demodReceiver = SDRCoverage::getReceiverAt(demodFrequency);
+
+        if (demodReceiver != receiver) {
+            //fed by another receiver, which manages it; out of any band, the main device does.
+            if (demodReceiver >= 0 || receiver != 0) {
+                continue;
+            }
+
             // deactivate if active
            
-            if (wxGetApp().getDemodMgr().getCurrentModem() == demod) {
+            if (currentModem == demod) {
 
                 demod->setActive(false);
             }
@@ -78,15 +116,15 @@ void SDRPostThread::updateActiveDemodulators() {
             } 
             
             // follow if follow mode
-            if (demod->isFollow() && centerFreq != demod->getFrequency()) {
-                wxGetApp().setFrequency(demod->getFrequency());
+            if (demod->isFollow() && centerFreq != demodFrequency) {
+                SDREngine::get()->setFrequency(demodFrequency);
                 demod->setFollow(false);
             }
         } else if (!demod->isActive()) { // in range, activate if not activated
             demod->setActive(true);
-            if (wxGetApp().getDemodMgr().getCurrentModem() == nullptr) {
+            if (SDREngine::get()->getDemodMgr().getCurrentModem() == nullptr) {
 
-                wxGetApp().getDemodMgr().setActiveDemodulator(demod);
+                SDREngine::get()->getDemodMgr().setActiveDemodulator(demod);
             }
         }
         
@@ -97,13 +135,18 @@ void SDRPostThread::updateActiveDemodulators() {
         // Add active demods to the current run:
         runDemods.push_back(demod);
         demodChannel.push_back(-1);
+        runDemodFrequency.push_back(demodFrequency);
     }
+
+    runCurrentModem = currentModem;
+    runCurrentModemRouted = currentModem && std::find(runDemods.begin(), runDemods.end(), currentModem) != runDemods.end();
+    demodChannelsDirty = true;
 }
 
 
 void SDRPostThread::resetAllDemodulators() {
     //retreive the current list of demodulators:
-    auto demodulators = wxGetApp().getDemodMgr().getDemodulators();
+    auto demodulators = SDREngine::get()->getDemodMgr().getDemodulators();
 
     for (auto demod : demodulators) {
 
@@ -124,6 +167,8 @@ void SDRPostThread::updateChannels() {
         chanCenters[i+(numChannels/2)] = frequency - (sampleRate/2) + ofs;
     }
     chanCenters[numChannels] = frequency + (sampleRate/2);
+
+    demodChannelsDirty = true;
 }
 
 
@@ -152,6 +197,16 @@ SDRPostThreadChannelizerType SDRPostThread::getChannelizerType() {
 }
 
 
+void SDRPostThread::setReceiver(int receiver_in) {
+    receiver = receiver_in;
+}
+
+
+int SDRPostThread::getReceiver() {
+    return receiver;
+}
+
+
 void SDRPostThread::run() {
 #ifdef __APPLE__
     pthread_t tID = pthread_self();  // ID of this thread
@@ -166,6 +221,8 @@ void SDRPostThread::run() {
     iqDataOutQueue = std::static_pointer_cast<DemodulatorThreadInputQueue>(getOutputQueue("IQDataOutput"));
     iqVisualQueue = std::static_pointer_cast<DemodulatorThreadInputQueue>(getOutputQueue("IQVisualDataOutput"));
     iqActiveDemodVisualQueue = std::static_pointer_cast<DemodulatorThreadInputQueue>(getOutputQueue("IQActiveDemodVisualDataOutput"));
+    iqStreamQueue = std::static_pointer_cast<DemodulatorThreadInputQueue>(getOutputQueue("IQStreamOutput"));
+    iqDetectorQueue = std::static_pointer_cast<DemodulatorThreadInputQueue>(getOutputQueue("IQDetectorOutput"));
     
     while (!stopping) {
         SDRThreadIQDataPtr data_in;
@@ -178,6 +235,12 @@ void SDRPostThread::run() {
 
         if (data_in && data_in->data.size()) {
 
+            retuned = (data_in->retuneIndex != lastRetuneIndex);
+            lastRetuneIndex = data_in->retuneIndex;
+            ingestTime = data_in->ingestTime;
+            timestamp = data_in->timestamp;
+            latencyStats->recordSince(ingestTime);
+
 //            std::cout << "SDRPostThread::run():" << std::endl;
 //            std::cout << "  data_in->numChannels=" << data_in->numChannels << std::endl;
 //            std::cout << "  data_in->sampleRate=" << data_in->sampleRate << std::endl;
@@ -198,11 +261,15 @@ void SDRPostThread::run() {
         }
         
         for (size_t j = 0; j < runDemods.size(); j++) {
-            DemodulatorInstancePtr demod = runDemods[j];
-            if (abs(frequency - demod->getFrequency()) > (sampleRate / 2)) {
+            if (abs(frequency - runDemodFrequency[j]) > (sampleRate / 2)) {
                 doUpdate = true;
             }
         }
+
+        //the demodulators, or the bands of the receivers, changed since the last update: lock-free checks.
+        if (SDREngine::get()->getDemodMgr().getIndexVersion() != demodIndexVersion || SDRCoverage::getVersion() != coverageVersion) {
+            doUpdate = true;
+        }
         
         //Only update the list of demodulators here
         if (doUpdate || doRefresh.load()) {
@@ -212,10 +279,10 @@ void SDRPostThread::run() {
     } //end while
     
     //Be safe, remove as many elements as possible
-    iqVisualQueue->flush();   
-    iqDataInQueue->flush();
-    iqDataOutQueue->flush();
-    iqActiveDemodVisualQueue->flush();
+    flushQueues();
+
+    //the demodulators of this band go to the other receivers, if any covers them.
+    SDRCoverage::clearBand(receiver);
 
 //    std::cout << "SDR post-processing thread done." << std::endl;
 }
@@ -223,10 +290,29 @@ void SDRPostThread::run() {
 void SDRPostThread::terminate() {
     IOThread::terminate();
     //unblock push()
-    iqVisualQueue->flush();
-    iqDataInQueue->flush();
-    iqDataOutQueue->flush();
-    iqActiveDemodVisualQueue->flush();
+    flushQueues();
+}
+
+void SDRPostThread::flushQueues() {
+    //the visual outputs are optional: a headless engine has none.
+    if (iqVisualQueue) {
+        iqVisualQueue->flush();
+    }
+    if (iqDataInQueue) {
+        iqDataInQueue->flush();
+    }
+    if (iqDataOutQueue) {
+        iqDataOutQueue->flush();
+    }
+    if (iqActiveDemodVisualQueue) {
+        iqActiveDemodVisualQueue->flush();
+    }
+    if (iqStreamQueue) {
+        iqStreamQueue->flush();
+    }
+    if (iqDetectorQueue) {
+        iqDetectorQueue->flush();
+    }
 }
 
 // Copy the full badwidth into a new DemodulatorThreadIQDataPtr.
@@ -236,23 +322,53 @@ DemodulatorThreadIQDataPtr SDRPostThread::getFullSampleRateIqData(SDRThreadIQDat
 
     iqDataOut->frequency = data_in->frequency;
     iqDataOut->sampleRate = data_in->sampleRate;
+    iqDataOut->retuned = retuned;
+    iqDataOut->ingestTime = ingestTime;
+    iqDataOut->timestamp = timestamp;
     iqDataOut->data.assign(data_in->data.begin(), data_in->data.begin() + data_in->data.size());
 
     return iqDataOut;
 }
 
-// Push visual data; i.e. Main Waterfall (all frames) and Spectrum (active frame)
-void SDRPostThread::pushVisualData(DemodulatorThreadIQDataPtr iqDataOut) {
+// Same, through a DC blocker of its own: the channelizers only correct channel 0, not the full band.
+DemodulatorThreadIQDataPtr SDRPostThread::getDCCorrectedIqData(SDRThreadIQData *data_in) {
 
+    DemodulatorThreadIQDataPtr iqDataOut = visualDataBuffers.getBuffer();
+
+    iqDataOut->frequency = data_in->frequency;
+    iqDataOut->sampleRate = data_in->sampleRate;
+    iqDataOut->retuned = retuned;
+    iqDataOut->ingestTime = ingestTime;
+    iqDataOut->timestamp = timestamp;
+    iqDataOut->data.resize(data_in->data.size());
+
+    iirfilt_crcf_execute_block(streamDCFilter, &data_in->data[0], data_in->data.size(), &iqDataOut->data[0]);
+
+    return iqDataOut;
+}
+
+// Push visual data; i.e. Main Waterfall (all frames) and Spectrum (active frame), and the full band to the signal detector,
+// and 'streamDataOut', the DC-corrected full band, to the IQ stream server
+void SDRPostThread::pushVisualData(DemodulatorThreadIQDataPtr iqDataOut, DemodulatorThreadIQDataPtr streamDataOut) {
+
+    if (iqStreamQueue != nullptr && streamDataOut != nullptr) {
+        //non-blocking push here, the server drops data for its slow clients on its own.
+        iqStreamQueue->try_push(streamDataOut);
+    }
+
+    if (iqDetectorQueue != nullptr) {
+        //non-blocking push here too: the detector drops whole blocks when it falls behind.
+        iqDetectorQueue->try_push(iqDataOut);
+    }
+
+    //non-blocking pushes here, we can afford to loose some samples for a ever-changing visual display.
+    //An additional receiver only feeds the spectrum, not the waterfall.
     if (iqDataOutQueue != nullptr) {
-        
-        //non-blocking push here, we can afford to loose some samples for a ever-changing visual display.
         iqDataOutQueue->try_push(iqDataOut);
+    }
 
-        if (iqVisualQueue != nullptr) {
-            //non-blocking push here, we can afford to loose some samples for a ever-changing visual display.
-            iqVisualQueue->try_push(iqDataOut);
-        }
+    if (iqVisualQueue != nullptr) {
+        iqVisualQueue->try_push(iqDataOut);
     }
 }
 
@@ -284,6 +400,10 @@ void SDRPostThread::runSingleCH(SDRThreadIQData *data_in) {
 
     demodDataOut->frequency = frequency;
     demodDataOut->sampleRate = sampleRate;
+    demodDataOut->retuned = retuned;
+    demodDataOut->ingestTime = ingestTime;
+    //the DC blocker has no delay to speak of.
+    demodDataOut->timestamp = timestamp;
     
     if (demodDataOut->data.size() != outSize) {
         if (demodDataOut->data.capacity() < outSize) {
@@ -296,9 +416,10 @@ void SDRPostThread::runSingleCH(SDRThreadIQData *data_in) {
     iirfilt_crcf_execute_block(dcFilter, &data_in->data[0], data_in->data.size(), &demodDataOut->data[0]);
 
     //push the DC-corrected data as Main Spactrum + Waterfall data.
-    pushVisualData(demodDataOut);
+    pushVisualData(demodDataOut, demodDataOut);
 
-    if (runDemods.size() > 0 && iqActiveDemodVisualQueue != nullptr) {
+    //the active demod view only shows the band of the receiver feeding the current modem.
+    if (runCurrentModemRouted && iqActiveDemodVisualQueue != nullptr) {
         //non-blocking push here, we can afford to loose some samples for a ever-changing visual display.
         iqActiveDemodVisualQueue->try_push(demodDataOut);
     }
@@ -313,32 +434,38 @@ void SDRPostThread::runSingleCH(SDRThreadIQData *data_in) {
 
 // Handle active channels, channel 0 offset correction, de-interlacing and push data to demodulators
 void SDRPostThread::runDemodChannels(int channelBandwidth) {
-    DemodulatorInstancePtr activeDemod = wxGetApp().getDemodMgr().getCurrentModem();
 
     // Calculate channel data size
     size_t chanDataSize = dataOut.size()/numChannels;
 
-    // Channel for the 'active' demod that's displaying visual data
-    int activeDemodChannel = -1;
-    
-    for (int i = 0, iMax = numChannels+1; i < iMax; i++) {
-        demodChannelActive[i] = 0;
-    }
-    
-    // Find nearest channel for each demodulator
-    for (size_t i = 0; i < runDemods.size(); i++) {
-        DemodulatorInstancePtr demod = runDemods[i];
-        demodChannel[i] = getChannelAt(demod->getFrequency());
-        if (demod == activeDemod) {
-            activeDemodChannel = demodChannel[i];
+    //the channel samples come out of the channelizer filter late by its group delay.
+    IQTimestamp channelTimestamp = timestamp.offset(-channelizerDelay, sampleRate);
+
+    // Channel assignments only change with the demodulators or the channels
+    if (demodChannelsDirty) {
+        // Channel for the 'active' demod that's displaying visual data
+        activeDemodChannel = -1;
+
+        for (int i = 0, iMax = numChannels+1; i < iMax; i++) {
+            demodChannelActive[i] = 0;
         }
-    }
-    
-    // Count the demods per-channel
-    for (size_t i = 0; i < runDemods.size(); i++) {
-        if (demodChannel[i] >= 0) {
-            demodChannelActive[demodChannel[i]]++;
+
+        // Find nearest channel for each demodulator
+        for (size_t i = 0; i < runDemods.size(); i++) {
+            demodChannel[i] = getChannelAt(runDemodFrequency[i]);
+            if (runDemods[i] == runCurrentModem) {
+                activeDemodChannel = demodChannel[i];
+            }
         }
+
+        // Count the demods per-channel
+        for (size_t i = 0; i < runDemods.size(); i++) {
+            if (demodChannel[i] >= 0) {
+                demodChannelActive[demodChannel[i]]++;
+            }
+        }
+
+        demodChannelsDirty = false;
     }
 
     // Run channels
@@ -354,6 +481,9 @@ void SDRPostThread::runDemodChannels(int channelBandwidth) {
         DemodulatorThreadIQDataPtr demodDataOut = buffers.getBuffer();
         demodDataOut->frequency = chanCenters[i];
         demodDataOut->sampleRate = channelBandwidth;
+        demodDataOut->retuned = retuned;
+        demodDataOut->ingestTime = ingestTime;
+        demodDataOut->timestamp = channelTimestamp;
 
         // Resize and update capacity of buffer if necessary
         if (demodDataOut->data.size() != chanDataSize) {
@@ -415,7 +545,8 @@ void SDRPostThread::initPFBCH() {
     if (channelizer) {
         firpfbch_crcf_destroy(channelizer);
     }
-    channelizer = firpfbch_crcf_create_kaiser(LIQUID_ANALYZER, numChannels, 4, 60);
+    channelizer = firpfbch_crcf_create_kaiser(LIQUID_ANALYZER, numChannels, SDR_POST_CHANNELIZER_SEMI_LENGTH, 60);
+    channelizerDelay = numChannels * SDR_POST_CHANNELIZER_SEMI_LENGTH;
     
     chanBw = (sampleRate / numChannels);
     
@@ -443,7 +574,8 @@ void SDRPostThread::runPFBCH(SDRThreadIQData *data_in) {
 
     //push the full data_in into (Main spectrum + waterfall) visual queue:
     DemodulatorThreadIQDataPtr fullSampleRateIQ = getFullSampleRateIqData(data_in);
-    pushVisualData(fullSampleRateIQ);
+    //the DC correction of the full band costs a filter pass at the full rate: only while it is streamed.
+    pushVisualData(fullSampleRateIQ, (iqStreamQueue != nullptr) ? getDCCorrectedIqData(data_in) : nullptr);
     
     size_t outSize = data_in->data.size();
     
@@ -472,7 +604,8 @@ void SDRPostThread::initPFBCH2() {
     if (channelizer2) {
         firpfbch2_crcf_destroy(channelizer2);
     }
-    channelizer2 = firpfbch2_crcf_create_kaiser(LIQUID_ANALYZER, numChannels, 4, 60);
+    channelizer2 = firpfbch2_crcf_create_kaiser(LIQUID_ANALYZER, numChannels, SDR_POST_CHANNELIZER_SEMI_LENGTH, 60);
+    channelizerDelay = numChannels * SDR_POST_CHANNELIZER_SEMI_LENGTH;
     
     chanBw = (sampleRate / numChannels);
     
@@ -499,7 +632,8 @@ void SDRPostThread::runPFBCH2(SDRThreadIQData *data_in) {
 
     //push the full data_in into (Main spectrum + waterfall) visual queue:
     DemodulatorThreadIQDataPtr fullSampleRateIQ = getFullSampleRateIqData(data_in);
-    pushVisualData(fullSampleRateIQ);
+    //the DC correction of the full band costs a filter pass at the full rate: only while it is streamed.
+    pushVisualData(fullSampleRateIQ, (iqStreamQueue != nullptr) ? getDCCorrectedIqData(data_in) : nullptr);
     
     size_t outSize = data_in->data.size() * 2;
     
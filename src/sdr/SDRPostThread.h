@@ -4,8 +4,15 @@
 #pragma once
 
 #include "SoapySDRThread.h"
+#include "SDRCoverage.h"
 #include <algorithm>
 
+//filter semi-length of the channelizers, in symbols: the prototype filter spans 2 * m * numChannels samples.
+#define SDR_POST_CHANNELIZER_SEMI_LENGTH 4
+
+//buffers kept allocated for the demodulators and the visuals, whatever the garbage collection of their ReBuffer.
+#define SDR_POST_BUFFERS_RESERVE 16
+
 enum SDRPostThreadChannelizerType {
     SDRPostPFBCH = 1,
     SDRPostPFBCH2 = 2
@@ -25,18 +32,30 @@ public:
 
     void setChannelizerType(SDRPostThreadChannelizerType chType);
     SDRPostThreadChannelizerType getChannelizerType();
-    
+
+    //before the thread starts: 0 for the main device, else the index of an additional SDRReceiver.
+    //Only the demodulators SDRCoverage routes to that receiver are fed.
+    void setReceiver(int receiver_in);
+    int getReceiver();
+
     
 protected:
     SDRThreadIQDataQueuePtr iqDataInQueue;
     DemodulatorThreadInputQueuePtr iqDataOutQueue;
     DemodulatorThreadInputQueuePtr iqVisualQueue;
     DemodulatorThreadInputQueuePtr iqActiveDemodVisualQueue;
+    //optional: the IQStreamServer re-serving the device, DC-corrected in every channelizer mode.
+    DemodulatorThreadInputQueuePtr iqStreamQueue;
+    //optional: the SignalDetectorThread.
+    DemodulatorThreadInputQueuePtr iqDetectorQueue;
 
 private:
     // Copy the full samplerate into a new DemodulatorThreadIQDataPtr.
     DemodulatorThreadIQDataPtr getFullSampleRateIqData(SDRThreadIQData *data_in);
-    void pushVisualData(DemodulatorThreadIQDataPtr iqDataOut);
+    // Same, DC-corrected, for the IQ stream server.
+    DemodulatorThreadIQDataPtr getDCCorrectedIqData(SDRThreadIQData *data_in);
+    void pushVisualData(DemodulatorThreadIQDataPtr iqDataOut, DemodulatorThreadIQDataPtr streamDataOut);
+    void flushQueues();
 
     void runSingleCH(SDRThreadIQData *data_in);
 
@@ -57,9 +76,20 @@ private:
     std::vector<long long> chanCenters;
     long long chanBw = 0;
     
+    //routing, rebuilt by updateActiveDemodulators() from a DemodulatorMgr index,
+    //so that the sample path never queries the demodulators themselves.
     std::vector<DemodulatorInstancePtr> runDemods;
+    std::vector<long long> runDemodFrequency;
     std::vector<int> demodChannel;
     std::vector<int> demodChannelActive;
+    DemodulatorInstancePtr runCurrentModem;
+    //the current modem is among runDemods.
+    bool runCurrentModemRouted;
+    int activeDemodChannel;
+    bool demodChannelsDirty;
+    unsigned long long demodIndexVersion;
+    int receiver;
+    unsigned long long coverageVersion;
 
     ReBuffer<DemodulatorThreadIQData> visualDataBuffers;
     atomic_bool doRefresh;
@@ -67,8 +97,20 @@ private:
 
     int numChannels, sampleRate, lastChanMode;
     long long frequency;
+    //the input block being processed is the first one since a device retune,
+    //which is not always the block starting at it: that one may have been dropped.
+    bool retuned;
+    long long lastRetuneIndex;
+    //and was read from the device at that time.
+    long long ingestTime;
+    IQTimestamp timestamp;
+    //group delay of the channelizer, in input samples.
+    int channelizerDelay;
+    std::shared_ptr<LatencyStats> latencyStats;
     firpfbch_crcf channelizer;
     firpfbch2_crcf channelizer2;
     iirfilt_crcf dcFilter;
+    //full band, for the IQ stream server in the channelizer modes.
+    iirfilt_crcf streamDCFilter;
     std::vector<liquid_float_complex> dcBuf;
 };
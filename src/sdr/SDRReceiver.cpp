@@ -0,0 +1,112 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "SDRReceiver.h"
+#include "SDREngine.h"
+
+#include <iostream>
+
+SDRReceiver::SDRReceiver(int index) : index(index), t_SDR(nullptr), t_PostSDR(nullptr) {
+    pipeSDRIQData = std::make_shared<SDRThreadIQDataQueue>();
+    pipeSDRIQData->set_max_num_items(100);
+    pipeSDRIQData->set_stats_name("SDRIQData" + std::to_string(index));
+
+    sdrThread = new SDRThread();
+    sdrThread->setPrimary(false);
+    sdrThread->setOutputQueue("IQDataOutput", pipeSDRIQData);
+
+    sdrPostThread = new SDRPostThread();
+    sdrPostThread->setReceiver(index);
+    sdrPostThread->setInputQueue("IQDataInput", pipeSDRIQData);
+}
+
+SDRReceiver::~SDRReceiver() {
+    terminate();
+
+    delete sdrThread;
+    delete sdrPostThread;
+}
+
+void SDRReceiver::start(SDRDeviceInfo *dev, long long frequency) {
+    DeviceConfig *devConfig = SDREngine::get()->getConfig()->getDevice(dev->getDeviceId());
+
+    ConfigSettings settings = devConfig->getSettings();
+    for (ConfigSettings::const_iterator i = settings.begin(); i != settings.end(); i++) {
+        sdrThread->writeSetting(i->first, i->second);
+    }
+    sdrThread->setStreamArgs(devConfig->getStreamOpts());
+    sdrThread->setDevice(dev);
+
+    long sampleRate = devConfig->getSampleRate() ? devConfig->getSampleRate() : DEFAULT_SAMPLE_RATE;
+    sampleRate = dev->getSampleRateNear(SOAPY_SDR_RX, 0, sampleRate);
+
+    if (frequency < sampleRate / 2) {
+        frequency = sampleRate / 2;
+    }
+
+    sdrThread->setSampleRate(sampleRate);
+    sdrThread->setFrequency(frequency);
+    sdrThread->setPPM(devConfig->getPPM());
+    sdrThread->setOffset(devConfig->getOffset());
+    sdrThread->setAGCMode(devConfig->getAGCMode());
+    sdrThread->setAntenna(devConfig->getAntennaName());
+
+    std::cout << "Receiver " << index << ": " << dev->getDeviceId() << " at " << frequency << " Hz, " << sampleRate << " sps." << std::endl;
+
+    t_PostSDR = new std::thread(&SDRPostThread::threadMain, sdrPostThread);
+    t_SDR = new std::thread(&SDRThread::threadMain, sdrThread);
+}
+
+void SDRReceiver::terminate() {
+    //same order as the main device: the SDR thread first, then its post-processing.
+    if (t_SDR) {
+        sdrThread->terminate();
+        sdrThread->isTerminated(3000);
+        t_SDR->join();
+        delete t_SDR;
+        t_SDR = nullptr;
+    }
+
+    if (t_PostSDR) {
+        sdrPostThread->terminate();
+        sdrPostThread->isTerminated(3000);
+        t_PostSDR->join();
+        delete t_PostSDR;
+        t_PostSDR = nullptr;
+    }
+
+    //the post-processing clears its band on exit, unless it never ran.
+    SDRCoverage::clearBand(index);
+}
+
+int SDRReceiver::getIndex() {
+    return index;
+}
+
+SDRDeviceInfo *SDRReceiver::getDevice() {
+    return sdrThread->getDevice();
+}
+
+void SDRReceiver::setFrequency(long long freq) {
+    sdrThread->setFrequency(freq);
+}
+
+long long SDRReceiver::getFrequency() {
+    return sdrThread->getFrequency();
+}
+
+long long SDRReceiver::getSampleRate() {
+    return sdrThread->getSampleRate();
+}
+
+bool SDRReceiver::hasFailed() {
+    return sdrThread->hasFailed();
+}
+
+SDRThread *SDRReceiver::getSDRThread() {
+    return sdrThread;
+}
+
+SDRPostThread *SDRReceiver::getSDRPostThread() {
+    return sdrPostThread;
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <thread>
+
+#include "SoapySDRThread.h"
+#include "SDRPostThread.h"
+
+/**
+ * An additional device run alongside the main one, so that one process covers adjacent bands:
+ * its own SDRThread and SDRPostThread, feeding the demodulators of the shared DemodulatorMgr
+ * that SDRCoverage routes to it, those in its band but not in the main device's.
+ * Tuned once, with the settings of its DeviceConfig: the tuning, gain and sample rate
+ * controls of the UI stay the main device's.
+ */
+class SDRReceiver {
+public:
+    //'index' from 1 to SDR_MAX_RECEIVERS - 1, 0 being the main device.
+    SDRReceiver(int index);
+    ~SDRReceiver();
+
+    //the post-processing outputs ("IQVisualDataOutput", "IQActiveDemodVisualDataOutput"...) are bound
+    //on getSDRPostThread() before.
+    void start(SDRDeviceInfo *dev, long long frequency);
+    void terminate();
+
+    int getIndex();
+    SDRDeviceInfo *getDevice();
+
+    void setFrequency(long long freq);
+    long long getFrequency();
+    long long getSampleRate();
+
+    //its device stream could not be set up; the main device is not affected.
+    bool hasFailed();
+
+    SDRThread *getSDRThread();
+    SDRPostThread *getSDRPostThread();
+
+private:
+    int index;
+
+    SDRThreadIQDataQueuePtr pipeSDRIQData;
+
+    SDRThread *sdrThread;
+    SDRPostThread *sdrPostThread;
+
+    std::thread *t_SDR;
+    std::thread *t_PostSDR;
+};
@@ -4,7 +4,7 @@
 #include "SoapySDRThread.h"
 #include "CubicSDRDefs.h"
 #include <vector>
-#include "CubicSDR.h"
+#include "SDREngine.h"
 #include <string>
 #include <algorithm>
 #include <SoapySDR/Logger.h>
@@ -13,6 +13,9 @@
 #define TARGET_DISPLAY_FPS (60)
 #define SDR_DEVICE_LOST (-666)
 
+//host clock drift, or samples lost by the device, beyond which the host time reference is taken again.
+#define SDR_HOST_TIME_RESYNC_NS (50 * 1000 * 1000LL)
+
 SDRThread::SDRThread() : IOThread(), buffers("SDRThreadBuffers") {
     device = nullptr;
 
@@ -45,6 +48,17 @@ SDRThread::SDRThread() : IOThread(), buffers("SDRThreadBuffers") {
     frequency_locked.store(false);
     lock_freq.store(0);
     iq_swap.store(false);
+    primary.store(true);
+    failed.store(false);
+
+    tunedFrequency = 0;
+    tunedSampleRate = DEFAULT_SAMPLE_RATE;
+    streamSampleIndex = 0;
+    retuneSampleIndex.store(0);
+    timeRefSampleRate = 0;
+    hostTimeRefIndex = hostTimeRefNs = 0;
+    deviceTimeRefIndex = deviceTimeRefNs = 0;
+    hasDeviceTimeRef = false;
 }
 
 SDRThread::~SDRThread() {
@@ -68,7 +82,7 @@ bool SDRThread::init() {
 //    SoapySDR_setLogLevel(SOAPY_SDR_DEBUG);
     
     SDRDeviceInfo *devInfo = deviceInfo.load();
-    deviceConfig.store(wxGetApp().getConfig()->getDevice(devInfo->getDeviceId()));
+    deviceConfig.store(SDREngine::get()->getConfig()->getDevice(devInfo->getDeviceId()));
     DeviceConfig *devConfig = deviceConfig.load();
     
     ppm.store(devConfig->getPPM());
@@ -80,9 +94,16 @@ bool SDRThread::init() {
     
     SoapySDR::Kwargs args = devInfo->getDeviceArgs();
     
-    wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Initializing device."));
+    failed.store(false);
+
+    if (primary.load()) {
+        SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Initializing device."));
+    }
     
     device = devInfo->getSoapyDevice();
+
+    //a device enumerated from cache is only really opened now.
+    SDREnumerator::revalidateDevice(args, device);
     
     SoapySDR::Kwargs currentStreamArgs = combineArgs(devInfo->getStreamArgs(),streamArgs);
     
@@ -96,7 +117,11 @@ bool SDRThread::init() {
     }
 
     if (!stream) {
-        wxGetApp().sdrThreadNotify(SDRThread::SDR_THREAD_FAILED, std::string("Stream setup failed, stream is null. ") + streamExceptionStr);
+        failed.store(true);
+        //an additional receiver failing leaves the main device, and the engine, running.
+        if (primary.load()) {
+            SDREngine::get()->sdrThreadNotify(SDRThread::SDR_THREAD_FAILED, std::string("Stream setup failed, stream is null. ") + streamExceptionStr);
+        }
         std::cout << "Stream setup failed, stream is null. " << streamExceptionStr << std::endl;
         return false;
     }
@@ -109,7 +134,12 @@ bool SDRThread::init() {
     deviceConfig.load()->setStreamOpts(currentStreamArgs);
   
     //4. Apply other settings: Frequency, PPM correction, Gains,  Device-specific settings:
-    device->setFrequency(SOAPY_SDR_RX,0,"RF",frequency - offset.load());
+    tunedFrequency = frequency.load();
+    device->setFrequency(SOAPY_SDR_RX,0,"RF",tunedFrequency - offset.load());
+
+    streamSampleIndex = 0;
+    retuneSampleIndex.store(0);
+    timeRefSampleRate = 0;
 
     if (device->hasFrequencyCorrection(SOAPY_SDR_RX, 0)) {
         hasPPM.store(true);
@@ -123,7 +153,7 @@ bool SDRThread::init() {
 
     if (device->hasDCOffsetMode(SOAPY_SDR_RX, 0)) {
         hasHardwareDC.store(true);
-//        wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Found hardware DC offset correction support, internal disabled."));
+//        SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Found hardware DC offset correction support, internal disabled."));
         device->setDCOffsetMode(SOAPY_SDR_RX, 0, true);
     } else {
         hasHardwareDC.store(false);
@@ -159,16 +189,22 @@ bool SDRThread::init() {
 
     } //leave lock guard scope
       
-    wxGetApp().sdrThreadNotify(SDRThread::SDR_THREAD_INITIALIZED, std::string("Device Initialized."));
+    if (primary.load()) {
+        SDREngine::get()->sdrThreadNotify(SDRThread::SDR_THREAD_INITIALIZED, std::string("Device Initialized."));
+    }
 
     //5. Activate stream: (through update settings)
-    wxGetApp().sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Activating stream."));
+    if (primary.load()) {
+        SDREngine::get()->sdrEnumThreadNotify(SDREnumerator::SDR_ENUM_MESSAGE, std::string("Activating stream."));
+    }
 
     rate_changed.store(true);
     updateSettings();
 
 	//rebuild menu now that settings are really been applied.
-	wxGetApp().notifyMainUIOfDeviceChange(true);
+    if (primary.load()) {
+        SDREngine::get()->notifyMainUIOfDeviceChange(true);
+    }
 
     return true;
 }
@@ -192,6 +228,58 @@ void SDRThread::assureBufferMinSize(SDRThreadIQData * dataOut, size_t minSize) {
     }
 }
 
+//duration of 'numSamples' at 'sampleRate', without overflowing for the sample counts of a long session.
+static long long samplesToNs(long long numSamples, long long sampleRate) {
+    return (numSamples / sampleRate) * 1000000000LL + (numSamples % sampleRate) * 1000000000LL / sampleRate;
+}
+
+void SDRThread::updateTimeRef(long long readIndex, int numRead, int flags, long long timeNs) {
+
+    //a new rate makes the previous references useless.
+    if (timeRefSampleRate != tunedSampleRate) {
+        timeRefSampleRate = tunedSampleRate;
+        hostTimeRefNs = 0;
+        hasDeviceTimeRef = false;
+    }
+
+    if (flags & SOAPY_SDR_HAS_TIME) {
+        deviceTimeRefIndex = readIndex;
+        deviceTimeRefNs = timeNs;
+        hasDeviceTimeRef = true;
+    }
+
+    //the read returns about when its last sample arrives: estimate the host time of its first sample.
+    long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    long long readStartNs = nowNs - samplesToNs(numRead, timeRefSampleRate);
+
+    //keep the reference as long as the sample count agrees with the host clock, for a jitter-free time.
+    long long expectedNs = hostTimeRefNs + samplesToNs(readIndex - hostTimeRefIndex, timeRefSampleRate);
+
+    if (hostTimeRefNs == 0 || std::abs(readStartNs - expectedNs) > SDR_HOST_TIME_RESYNC_NS) {
+        hostTimeRefIndex = readIndex;
+        hostTimeRefNs = readStartNs;
+    }
+}
+
+IQTimestamp SDRThread::getTimestamp(long long sampleIndex) {
+    IQTimestamp timestamp;
+
+    if (timeRefSampleRate <= 0 || hostTimeRefNs == 0) {
+        return timestamp;
+    }
+
+    timestamp.sampleIndex = sampleIndex;
+    timestamp.deviceSampleRate = timeRefSampleRate;
+    timestamp.hostTimeNs = hostTimeRefNs + samplesToNs(sampleIndex - hostTimeRefIndex, timeRefSampleRate);
+
+    if (hasDeviceTimeRef) {
+        timestamp.hasDeviceTime = true;
+        timestamp.deviceTimeNs = deviceTimeRefNs + samplesToNs(sampleIndex - deviceTimeRefIndex, timeRefSampleRate);
+    }
+
+    return timestamp;
+}
+
 //Called in an infinite loop, read SaopySDR device to build 
 // a 'this.numElems' sized batch of samples (SDRThreadIQData) and push it into  iqDataOutQueue.
 //this batch of samples is built to represent 1 frame / TARGET_DISPLAY_FPS.
@@ -220,6 +308,9 @@ int SDRThread::readStream(SDRThreadIQDataQueuePtr iqDataOutQueue) {
     //0. Retreive a new batch 
     SDRThreadIQDataPtr dataOut = buffers.getBuffer();
 
+    //the overflow samples are the last ones read, they come first in the batch.
+    long long batchSampleIndex = streamSampleIndex - numOverflow;
+
     //resize to the target size immedialetly, to minimize later reallocs:
     assureBufferMinSize(dataOut.get(), nElems);
 
@@ -257,6 +348,11 @@ int SDRThread::readStream(SDRThreadIQDataQueuePtr iqDataOutQueue) {
         
         readStreamCode = n_stream_read;
 
+        if (n_stream_read > 0) {
+            updateTimeRef(streamSampleIndex, n_stream_read, flags, timeNs);
+            streamSampleIndex += n_stream_read;
+        }
+
         //if the n_stream_read <= 0, bail out from reading. 
         if (n_stream_read == 0) {
              std::cout << "SDRThread::readStream(): 2. SoapySDR read blocking..." << std::endl;
@@ -379,10 +475,15 @@ int SDRThread::readStream(SDRThreadIQDataQueuePtr iqDataOutQueue) {
         //clamp result to the actual read size:
         dataOut->data.resize(n_read);
 
-        dataOut->frequency = frequency.load();
-        dataOut->sampleRate = sampleRate.load();
+        //the tuning the samples were read at, not a change requested meanwhile.
+        dataOut->frequency = tunedFrequency;
+        dataOut->sampleRate = tunedSampleRate;
         dataOut->dcCorrected = hasHardwareDC.load();
         dataOut->numChannels = numChannels.load();
+        dataOut->sampleIndex = batchSampleIndex;
+        dataOut->retuneIndex = retuneSampleIndex.load();
+        dataOut->ingestTime = PipelineStats::now();
+        dataOut->timestamp = getTimestamp(batchSampleIndex);
         
         if (!iqDataOutQueue->try_push(dataOut)) {
             //The rest of the system saturates,
@@ -513,6 +614,7 @@ void SDRThread::updateSettings() {
         } 
 
         sampleRate.store(applied_sample_rate);
+        tunedSampleRate = (long long)applied_sample_rate;
 
         numChannels.store(getOptimalChannelCount(sampleRate.load()));
         numElems.store(getOptimalElementCount(sampleRate.load(), TARGET_DISPLAY_FPS));
@@ -533,8 +635,9 @@ void SDRThread::updateSettings() {
             ::free(buffs[0]);
         }
         buffs[0] = ::malloc(mtuElems.load() * 4 * sizeof(float));
-        //clear overflow buffer
+        //clear overflow buffer: the next batch starts at the new rate.
         numOverflow = 0;
+        retuneSampleIndex.store(streamSampleIndex);
 
         //
         rate_changed.store(false);
@@ -551,13 +654,29 @@ void SDRThread::updateSettings() {
     }
     
     if (freq_changed.load()) {
+        //clear the flag first: a change made from now on is applied on the next batch.
+        freq_changed.store(false);
+
+        long long newFrequency = frequency.load();
+        bool retuned = false;
+
         if (frequency_locked.load() && !frequency_lock_init.load()) {
             device->setFrequency(SOAPY_SDR_RX,0,"RF",lock_freq.load());
             frequency_lock_init.store(true);
+            retuned = true;
         } else if (!frequency_locked.load()) {
-            device->setFrequency(SOAPY_SDR_RX,0,"RF",frequency.load() - offset.load());
+            device->setFrequency(SOAPY_SDR_RX,0,"RF",newFrequency - offset.load());
+            retuned = true;
+        }
+
+        tunedFrequency = newFrequency;
+
+        if (retuned) {
+            //the overflow samples were read at the previous frequency: drop them, so that
+            //the next batch starts at the retune instead of mixing both frequencies.
+            numOverflow = 0;
+            retuneSampleIndex.store(streamSampleIndex);
         }
-        freq_changed.store(false);
     }
    
     
@@ -609,8 +728,8 @@ void SDRThread::updateSettings() {
         doUpdate = true;
     }
     
-    if (doUpdate) {
-        wxGetApp().sdrThreadNotify(SDRThread::SDR_THREAD_INITIALIZED, std::string("Settings updated."));
+    if (doUpdate && primary.load()) {
+        SDREngine::get()->sdrThreadNotify(SDRThread::SDR_THREAD_INITIALIZED, std::string("Settings updated."));
     }
 }
 
@@ -663,7 +782,7 @@ SDRDeviceInfo *SDRThread::getDevice() {
 void SDRThread::setDevice(SDRDeviceInfo *dev) {
     deviceInfo.store(dev);
     if (dev) {
-        deviceConfig.store(wxGetApp().getConfig()->getDevice(dev->getDeviceId()));
+        deviceConfig.store(SDREngine::get()->getConfig()->getDevice(dev->getDeviceId()));
     } else {
         deviceConfig.store(nullptr);
     }
@@ -849,3 +968,19 @@ std::string SDRThread::readSetting(std::string name) {
 void SDRThread::setStreamArgs(SoapySDR::Kwargs streamArgs_in) {
     streamArgs = streamArgs_in;
 }
+
+long long SDRThread::getRetuneSampleIndex() {
+    return retuneSampleIndex.load();
+}
+
+void SDRThread::setPrimary(bool primary_in) {
+    primary.store(primary_in);
+}
+
+bool SDRThread::isPrimary() {
+    return primary.load();
+}
+
+bool SDRThread::hasFailed() {
+    return failed.load();
+}
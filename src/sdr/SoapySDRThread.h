@@ -23,15 +23,24 @@ public:
     long long sampleRate;
     bool dcCorrected;
     int numChannels;
+    //position of data[0] in the device stream, counting every sample read since the stream start.
+    long long sampleIndex;
+    //position in the device stream of the first sample read at the current frequency and sample rate:
+    //a block with sampleIndex == retuneIndex starts right at a retune.
+    long long retuneIndex;
+    //PipelineStats::now() when the samples were read, for the stage latencies.
+    long long ingestTime;
+    //of data[0]
+    IQTimestamp timestamp;
     std::vector<liquid_float_complex> data;
 
     SDRThreadIQData() :
-            frequency(0), sampleRate(DEFAULT_SAMPLE_RATE), dcCorrected(true), numChannels(0) {
+            frequency(0), sampleRate(DEFAULT_SAMPLE_RATE), dcCorrected(true), numChannels(0), sampleIndex(0), retuneIndex(0), ingestTime(0) {
 
     }
 
     SDRThreadIQData(long long bandwidth, long long frequency, std::vector<signed char> * /* data */) :
-            frequency(frequency), sampleRate(bandwidth) {
+            frequency(frequency), sampleRate(bandwidth), sampleIndex(0), retuneIndex(0), ingestTime(0) {
 
     }
 
@@ -43,6 +52,11 @@ typedef std::shared_ptr<SDRThreadIQData> SDRThreadIQDataPtr;
 typedef ThreadBlockingQueue<SDRThreadIQDataPtr> SDRThreadIQDataQueue;
 typedef std::shared_ptr<SDRThreadIQDataQueue> SDRThreadIQDataQueuePtr;
 
+/**
+ * Setting changes (frequency, sample rate, gains...) only store the latest value and raise a changed flag,
+ * so that a burst of changes coalesces into the last one. The SDR thread applies them between two IQ blocks:
+ * a block is always read entirely at one frequency and sample rate, and tagged with them.
+ */
 class SDRThread : public IOThread {
 private:
     bool init();
@@ -66,7 +80,7 @@ public:
     SDRDeviceInfo *getDevice();
     void setDevice(SDRDeviceInfo *dev);
     int getOptimalElementCount(long long sampleRate, int fps);
-    int getOptimalChannelCount(long long sampleRate);
+    static int getOptimalChannelCount(long long sampleRate);
     
     void setFrequency(long long freq);
     long long getFrequency();
@@ -100,6 +114,16 @@ public:
     std::string readSetting(std::string name);
     
     void setStreamArgs(SoapySDR::Kwargs streamArgs);
+
+    //position in the device stream where the last frequency or sample rate change took effect.
+    long long getRetuneSampleIndex();
+
+    //false for an additional receiver: its device changes are not the UI's to show.
+    void setPrimary(bool primary_in);
+    bool isPrimary();
+
+    //the stream could not be set up at the last init().
+    bool hasFailed();
     
 protected:
     void updateGains();
@@ -126,6 +150,7 @@ protected:
     std::string antennaName;
     std::atomic_bool agc_mode, rate_changed, freq_changed, offset_changed, antenna_changed,
         ppm_changed, device_changed, agc_mode_changed, gain_value_changed, setting_value_changed, frequency_locked, frequency_lock_init, iq_swap;
+    std::atomic_bool primary, failed;
 
     std::mutex gain_busy;
     std::map<std::string, float> gainValues;
@@ -133,6 +158,22 @@ protected:
     
     SoapySDR::Kwargs streamArgs;
 
+    //SDR thread only: the tuning in effect on the device, and the number of samples read from the stream.
+    long long tunedFrequency, tunedSampleRate;
+    long long streamSampleIndex;
+    std::atomic_llong retuneSampleIndex;
+
+    //SDR thread only: a sample of known time for each clock, the others are timed from their index.
+    //timeRefSampleRate == 0 means no reference yet.
+    long long timeRefSampleRate;
+    long long hostTimeRefIndex, hostTimeRefNs;
+    long long deviceTimeRefIndex, deviceTimeRefNs;
+    bool hasDeviceTimeRef;
+
 private:
 	void assureBufferMinSize(SDRThreadIQData * dataOut, size_t minSize);
+
+    //after a successful read of 'numRead' samples starting at 'readIndex', with the readStream() flags and time.
+    void updateTimeRef(long long readIndex, int numRead, int flags, long long timeNs);
+    IQTimestamp getTimestamp(long long sampleIndex);
 };
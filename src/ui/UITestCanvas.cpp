@@ -19,7 +19,6 @@
 #include <algorithm>
 
 wxBEGIN_EVENT_TABLE(UITestCanvas, wxGLCanvas) EVT_PAINT(UITestCanvas::OnPaint)
-EVT_IDLE(UITestCanvas::OnIdle)
 EVT_MOTION(UITestCanvas::OnMouseMoved)
 EVT_LEFT_DOWN(UITestCanvas::OnMouseDown)
 EVT_LEFT_UP(UITestCanvas::OnMouseReleased)
@@ -55,8 +54,8 @@ void UITestCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
     SwapBuffers();
 }
 
-void UITestCanvas::OnIdle(wxIdleEvent& /* event */) {
-    Refresh(false);
+bool UITestCanvas::isFrameDirty() {
+    return true;
 }
 
 void UITestCanvas::OnMouseMoved(wxMouseEvent& event) {
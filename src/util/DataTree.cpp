@@ -30,6 +30,9 @@
 #include <locale>
 #include <stdlib.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
 
 
 /* DataElement class */
@@ -125,6 +128,28 @@ void DataElement::get(std::set<string> &strset_out) {
     }
 }
 
+void DataElement::setRaw(DataElementTypeEnum type_in, const unsigned char *data_in, size_t size_in) {
+    data_type = type_in;
+
+    data_val.assign(data_in, data_in + size_in);
+    data_val_vector.clear();
+}
+
+void DataElement::setRawVector(DataElementTypeEnum type_in, DataElementBufferVector &vector_in) {
+    data_type = type_in;
+
+    data_val.clear();
+    data_val_vector.swap(vector_in);
+}
+
+const DataElement::DataElementBufferVector &DataElement::getDataVector() {
+    return data_val_vector;
+}
+
+bool DataElement::isVectorType(DataElementTypeEnum type_in) {
+    return (type_in >= DATA_STR_VECTOR && type_in <= DATA_DOUBLE_VECTOR);
+}
+
 std::string DataElement::toString() {
     int dataType = getDataType();
     std::string strValue = "";
@@ -388,7 +413,7 @@ void DataTree::decodeXMLText(DataNode *elem, const char *src_text, DT_FloatingPo
     int tmp_char;
     int tmp_int;
     long tmp_long;
-    long long tmp_llong;
+    long long tmp_llong = 0;
     double tmp_double;
     float tmp_float;
     string tmp_str;
@@ -1077,6 +1102,704 @@ bool DataTree::LoadFromFileXML(const std::string& filename, DT_FloatingPointPoli
     return true;
 }
 
+#define DATATREE_XML_STREAM_CHUNK (64 * 1024)
+
+//chunked character source of the streaming XML loader, with the line breaks normalized as TiXmlDocument::LoadFile()
+//does, and ending at the first NUL like its in-memory copy.
+class DataTreeXMLStream {
+public:
+    DataTreeXMLStream(FILE *fp_in) : fp(fp_in), raw(DATATREE_XML_STREAM_CHUNK), pos(0), ended(false), lastCR(false) {
+    }
+
+    //the character 'ahead' of the current one, EOF past the end.
+    int peek(size_t ahead = 0) {
+        while (pos + ahead >= buf.size()) {
+            if (!fill()) {
+                return EOF;
+            }
+        }
+        return (unsigned char)buf[pos + ahead];
+    }
+
+    bool atEnd() {
+        return peek() == EOF;
+    }
+
+    int next() {
+        int c = peek();
+        if (c != EOF) {
+            pos++;
+        }
+        return c;
+    }
+
+    void skip(size_t count) {
+        while (count-- && next() != EOF) {
+        }
+    }
+
+    //as TiXmlBase::StringEqual(), on what comes next.
+    bool startsWith(const char *tag, bool ignoreCase = false) {
+        for (size_t i = 0; tag[i]; i++) {
+            int c = peek(i);
+            if (c == EOF) {
+                return false;
+            }
+            if (ignoreCase ? (xmlToLower(c) != xmlToLower((unsigned char)tag[i])) : (c != (unsigned char)tag[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static int xmlToLower(int c) {
+        return (c < 128) ? tolower(c) : c;
+    }
+
+    bool fill() {
+        if (ended) {
+            return false;
+        }
+
+        //keep only what has not been consumed yet.
+        buf.erase(0, pos);
+        pos = 0;
+
+        size_t len = fread(&raw[0], 1, raw.size(), fp);
+
+        if (len == 0) {
+            ended = true;
+            return false;
+        }
+
+        for (size_t i = 0; i < len; i++) {
+            char c = raw[i];
+
+            if (c == 0) {
+                ended = true;
+                break;
+            }
+            if (lastCR && c == '\n') {
+                lastCR = false;
+                continue;
+            }
+            lastCR = (c == '\r');
+            buf.push_back(lastCR ? '\n' : c);
+        }
+
+        return true;
+    }
+
+    FILE *fp;
+    vector<char> raw;
+    string buf;
+    size_t pos;
+    bool ended, lastCR;
+};
+
+//A port of the TinyXML parser reading from a DataTreeXMLStream, filling the DataNodes as setFromXML() would from
+//the TiXmlDocument, element by element: the same rules, quirks included, give the same tree for the same file.
+class DataTreeXMLStreamParser {
+public:
+    DataTreeXMLStreamParser(DataTree *tree_in, FILE *fp, DT_FloatingPointPolicy fpp_in) :
+        tree(tree_in), in(fp), fpp(fpp_in), encoding(TIXML_ENCODING_UNKNOWN) {
+    }
+
+    //TiXmlDocument::Parse(), then a root element is required.
+    bool parseDocument() {
+        if (in.atEnd()) {
+            return false;
+        }
+
+        if (in.startsWith("\xef\xbb\xbf")) {
+            encoding = TIXML_ENCODING_UTF8;
+        }
+
+        skipWhiteSpace();
+
+        bool hasChild = false, hasRoot = false;
+
+        while (!in.atEnd() && in.peek() == '<') {
+            string declEncoding;
+            bool isDeclaration = in.startsWith("<?xml", true);
+
+            NodeResult result = parseNode(nullptr, hasRoot, isDeclaration ? &declEncoding : nullptr);
+            hasChild = true;
+
+            if (result == NODE_ERROR) {
+                return false;
+            }
+
+            if (isDeclaration && encoding == TIXML_ENCODING_UNKNOWN) {
+                if (declEncoding.empty() || startsWith(declEncoding, "UTF-8") || startsWith(declEncoding, "UTF8")) {
+                    encoding = TIXML_ENCODING_UTF8;
+                } else {
+                    encoding = TIXML_ENCODING_LEGACY;
+                }
+            }
+
+            //the document ends without error where its last node stopped.
+            if (result == NODE_END) {
+                break;
+            }
+
+            skipWhiteSpace();
+        }
+
+        return hasChild && hasRoot;
+    }
+
+private:
+    //NODE_END: the node returned no position without an error, which ends the document but not inside an element.
+    enum NodeResult { NODE_OK, NODE_END, NODE_ERROR };
+
+    //what the content of an element goes to.
+    class Content {
+    public:
+        Content(DataNode *node_in, bool strItem_in) : node(node_in), strItem(strItem_in), hasChild(false), strVector(false), firstIsText(false) {
+        }
+
+        //nullptr: only parsed.
+        DataNode *node;
+        //a <str> of a string vector: only its first child, if text, is its value.
+        bool strItem;
+        bool hasChild;
+        //a first child <str> makes the element a vector of strings.
+        bool strVector;
+        vector<string> strs;
+        bool firstIsText;
+        string firstText;
+    };
+
+    static bool isWhiteSpace(int c) {
+        return c != EOF && (isspace((unsigned char)c) || c == '\n' || c == '\r');
+    }
+
+    static bool isAlpha(int c) {
+        return c != EOF && ((c < 127) ? (isalpha(c) != 0) : true);
+    }
+
+    static bool isAlphaNum(int c) {
+        return c != EOF && ((c < 127) ? (isalnum(c) != 0) : true);
+    }
+
+    static int utf8Length(int c) {
+        if (c >= 0xc2 && c <= 0xdf) {
+            return 2;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            return 3;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            return 4;
+        }
+        return 1;
+    }
+
+    static bool startsWith(const string& str, const char *tag) {
+        for (size_t i = 0; tag[i]; i++) {
+            if (i >= str.length() || tolower((unsigned char)str[i]) != tolower((unsigned char)tag[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //TinyXML values are read as C strings: up to the first NUL.
+    static bool valueIs(const string& value, const char *str) {
+        return strcmp(value.c_str(), str) == 0;
+    }
+
+    void skipWhiteSpace() {
+        while (!in.atEnd()) {
+            //the UTF-8 byte order marks are skipped as white space.
+            if (encoding == TIXML_ENCODING_UTF8 && in.peek() == 0xef &&
+                ((in.peek(1) == 0xbb && in.peek(2) == 0xbf) || (in.peek(1) == 0xbf && (in.peek(2) == 0xbe || in.peek(2) == 0xbf)))) {
+                in.skip(3);
+            } else if (isWhiteSpace(in.peek())) {
+                in.skip(1);
+            } else {
+                break;
+            }
+        }
+    }
+
+    bool readName(string &name) {
+        name.clear();
+
+        if (!isAlpha(in.peek()) && in.peek() != '_') {
+            return false;
+        }
+
+        int c;
+        while ((c = in.peek()) != EOF && (isAlphaNum(c) || c == '_' || c == '-' || c == '.' || c == ':')) {
+            name.push_back((char)in.next());
+        }
+        return true;
+    }
+
+    static void appendUTF8(string &out, unsigned long input) {
+        const unsigned long BYTE_MASK = 0xBF;
+        const unsigned long BYTE_MARK = 0x80;
+        const unsigned long FIRST_BYTE_MARK[5] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0 };
+
+        int length;
+        if (input < 0x80) {
+            length = 1;
+        } else if (input < 0x800) {
+            length = 2;
+        } else if (input < 0x10000) {
+            length = 3;
+        } else if (input < 0x200000) {
+            length = 4;
+        } else {
+            return;
+        }
+
+        char bytes[4];
+        for (int i = length - 1; i > 0; i--) {
+            bytes[i] = (char)((input | BYTE_MARK) & BYTE_MASK);
+            input >>= 6;
+        }
+        bytes[0] = (char)(input | FIRST_BYTE_MARK[length]);
+
+        out.append(bytes, length);
+    }
+
+    //TiXmlBase::GetEntity(), at '&': false on a malformed character reference.
+    bool readEntity(string &out) {
+        static const char *entities[][2] = { { "&amp;", "&" }, { "&lt;", "<" }, { "&gt;", ">" }, { "&quot;", "\"" }, { "&apos;", "'" } };
+
+        if (in.peek(1) == '#' && in.peek(2) != EOF) {
+            bool hex = (in.peek(2) == 'x');
+            size_t end = hex ? 3 : 2;
+
+            //the number runs to the next ';', wherever it is.
+            int c;
+            while ((c = in.peek(end)) != ';') {
+                if (c == EOF) {
+                    return false;
+                }
+                end++;
+            }
+
+            //read backwards from the ';', as TinyXML.
+            unsigned long ucs = 0;
+            unsigned mult = 1;
+
+            for (size_t q = end - 1; (c = in.peek(q)) != (hex ? 'x' : '#'); q--) {
+                if (c >= '0' && c <= '9') {
+                    ucs += mult * (c - '0');
+                } else if (hex && c >= 'a' && c <= 'f') {
+                    ucs += mult * (c - 'a' + 10);
+                } else if (hex && c >= 'A' && c <= 'F') {
+                    ucs += mult * (c - 'A' + 10);
+                } else {
+                    return false;
+                }
+                mult *= hex ? 16 : 10;
+            }
+
+            in.skip(end + 1);
+
+            if (encoding == TIXML_ENCODING_UTF8) {
+                appendUTF8(out, ucs);
+            } else {
+                out.push_back((char)ucs);
+            }
+            return true;
+        }
+
+        for (auto &entity : entities) {
+            if (in.startsWith(entity[0])) {
+                out.append(entity[1]);
+                in.skip(strlen(entity[0]));
+                return true;
+            }
+        }
+
+        //an unknown entity loses its '&'.
+        in.skip(1);
+        return true;
+    }
+
+    //TiXmlBase::GetChar()
+    bool readChar(string &out) {
+        int length = (encoding == TIXML_ENCODING_UTF8) ? utf8Length(in.peek()) : 1;
+
+        if (length == 1 && in.peek() == '&') {
+            return readEntity(out);
+        }
+
+        for (int i = 0; i < length && !in.atEnd(); i++) {
+            out.push_back((char)in.next());
+        }
+        return true;
+    }
+
+    //TiXmlBase::ReadText(): false unless 'endTag' is found with something after it.
+    //'endTag' is consumed only if 'consumeEnd'.
+    bool readText(string &text, bool trimWhiteSpace, const char *endTag, bool consumeEnd) {
+        text.clear();
+
+        if (!trimWhiteSpace) {
+            while (!in.atEnd() && !in.startsWith(endTag)) {
+                if (!readChar(text)) {
+                    return false;
+                }
+            }
+        } else {
+            bool whitespace = false;
+
+            skipWhiteSpace();
+
+            while (!in.atEnd() && !in.startsWith(endTag)) {
+                if (isWhiteSpace(in.peek())) {
+                    whitespace = true;
+                    in.skip(1);
+                } else {
+                    if (whitespace) {
+                        text.push_back(' ');
+                        whitespace = false;
+                    }
+                    if (!readChar(text)) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        if (in.atEnd()) {
+            return false;
+        }
+
+        size_t endLength = strlen(endTag);
+
+        if (consumeEnd) {
+            in.skip(endLength);
+            return !in.atEnd();
+        }
+        return in.peek(endLength) != EOF;
+    }
+
+    //TiXmlAttribute::Parse(), 'value' filled as far as it could be read.
+    bool parseAttribute(string &name, string &value) {
+        value.clear();
+
+        skipWhiteSpace();
+        if (in.atEnd() || !readName(name) || in.atEnd()) {
+            return false;
+        }
+
+        skipWhiteSpace();
+        if (in.peek() != '=') {
+            return false;
+        }
+        in.skip(1);
+
+        skipWhiteSpace();
+        if (in.atEnd()) {
+            return false;
+        }
+
+        int quote = in.peek();
+
+        if (quote == '\'' || quote == '"') {
+            in.skip(1);
+            return readText(value, false, (quote == '"') ? "\"" : "'", true);
+        }
+
+        //unquoted, up to white space or the end of the tag.
+        int c;
+        while ((c = in.peek()) != EOF && !isWhiteSpace(c) && c != '/' && c != '>') {
+            if (c == '\'' || c == '"') {
+                return false;
+            }
+            value.push_back((char)in.next());
+        }
+        return true;
+    }
+
+    //the child of 'parent' with this value, as setFromXML() handles it.
+    void linkText(Content *parent, const string& text) {
+        if (parent == nullptr) {
+            return;
+        }
+        if (parent->strItem && !parent->hasChild) {
+            parent->firstIsText = true;
+            parent->firstText = text.c_str();
+        }
+        if (parent->strVector) {
+            if (valueIs(text, "str")) {
+                parent->strs.push_back("");
+            }
+        } else if (parent->node) {
+            tree->decodeXMLText(parent->node, text.c_str(), fpp);
+        }
+        parent->hasChild = true;
+    }
+
+    void linkOther(Content *parent, const string& value) {
+        if (parent == nullptr) {
+            return;
+        }
+        if (parent->strVector && valueIs(value, "str")) {
+            parent->strs.push_back("");
+        }
+        parent->hasChild = true;
+    }
+
+    //TiXmlNode::Identify() then Parse() of the node at '<': 'hasRoot' is set by the first element of the document,
+    //'declEncoding' receives the encoding of a declaration.
+    NodeResult parseNode(Content *parent, bool &hasRoot, string *declEncoding) {
+        string value;
+
+        if (in.startsWith("<?xml", true)) {
+            return parseDeclaration(parent, declEncoding);
+        }
+
+        if (in.startsWith("<!--")) {
+            in.skip(4);
+            while (!in.atEnd() && !in.startsWith("-->")) {
+                value.push_back((char)in.next());
+            }
+            in.skip(3);
+            linkOther(parent, value);
+            return NODE_OK;
+        }
+
+        if (in.startsWith("<![CDATA[")) {
+            in.skip(9);
+            while (!in.atEnd() && !in.startsWith("]]>")) {
+                value.push_back((char)in.next());
+            }
+            //the text is taken even if it does not end.
+            linkText(parent, value);
+
+            string dummy;
+            return readText(dummy, false, "]]>", true) ? NODE_OK : NODE_END;
+        }
+
+        if (!in.startsWith("<!") && (isAlpha(in.peek(1)) || in.peek(1) == '_')) {
+            return parseElement(parent, hasRoot) ? NODE_OK : NODE_ERROR;
+        }
+
+        //anything else is kept as an unknown node, up to '>'.
+        in.skip(1);
+        while (!in.atEnd() && in.peek() != '>') {
+            value.push_back((char)in.next());
+        }
+        in.skip(1);
+        linkOther(parent, value);
+        return NODE_OK;
+    }
+
+    //TiXmlDeclaration::Parse(), never an error.
+    NodeResult parseDeclaration(Content *parent, string *declEncoding) {
+        //its value is always empty.
+        linkOther(parent, "");
+
+        in.skip(5);
+
+        string name, value;
+
+        while (!in.atEnd()) {
+            if (in.peek() == '>') {
+                in.skip(1);
+                return NODE_OK;
+            }
+
+            skipWhiteSpace();
+
+            if (in.startsWith("version", true) || in.startsWith("standalone", true)) {
+                if (!parseAttribute(name, value)) {
+                    return NODE_END;
+                }
+            } else if (in.startsWith("encoding", true)) {
+                bool parsed = parseAttribute(name, value);
+                if (declEncoding) {
+                    *declEncoding = value.c_str();
+                }
+                if (!parsed) {
+                    return NODE_END;
+                }
+            } else {
+                int c;
+                while ((c = in.peek()) != EOF && c != '>' && !isWhiteSpace(c)) {
+                    in.skip(1);
+                }
+            }
+        }
+        return NODE_END;
+    }
+
+    //TiXmlElement::ReadValue(): the children, up to the end tag.
+    bool parseContent(Content &content) {
+        bool hasRoot = true;
+        string text;
+
+        skipWhiteSpace();
+
+        while (!in.atEnd()) {
+            if (in.peek() != '<') {
+                if (!readText(text, true, "<", false)) {
+                    return false;
+                }
+
+                //blank text is dropped.
+                for (char c : text) {
+                    if (!isWhiteSpace((unsigned char)c)) {
+                        linkText(&content, text);
+                        break;
+                    }
+                }
+            } else if (in.startsWith("</")) {
+                return true;
+            } else if (parseNode(&content, hasRoot, nullptr) != NODE_OK) {
+                return false;
+            }
+
+            skipWhiteSpace();
+        }
+        return false;
+    }
+
+    //TiXmlElement::Parse(), at '<'.
+    bool parseElement(Content *parent, bool &hasRoot) {
+        string name;
+
+        in.skip(1);
+        skipWhiteSpace();
+
+        if (!readName(name) || in.atEnd()) {
+            return false;
+        }
+
+        DataNode *node = nullptr;
+        bool strItem = false;
+
+        if (parent == nullptr) {
+            //the root element, the next ones are only parsed.
+            if (!hasRoot) {
+                node = tree->rootNode();
+                node->setName(name.c_str());
+                hasRoot = true;
+            }
+        } else {
+            if (parent->node && !parent->hasChild && name == "str") {
+                parent->strVector = true;
+            }
+            if (parent->strItem && !parent->hasChild) {
+                parent->firstIsText = false;
+            }
+
+            if (parent->strVector) {
+                strItem = (name == "str");
+            } else if (parent->node) {
+                node = parent->node->newChild(name.c_str());
+            }
+            parent->hasChild = true;
+        }
+
+        Content content(node, strItem);
+        vector<string> attributes;
+        string attrName, attrValue;
+
+        while (true) {
+            skipWhiteSpace();
+
+            if (in.atEnd()) {
+                return false;
+            }
+
+            if (in.peek() == '/') {
+                in.skip(1);
+                if (in.peek() != '>') {
+                    return false;
+                }
+                in.skip(1);
+                break;
+            }
+
+            if (in.peek() == '>') {
+                in.skip(1);
+
+                if (!parseContent(content)) {
+                    return false;
+                }
+
+                //"</name >" is valid as well.
+                if (!in.startsWith(("</" + name).c_str())) {
+                    return false;
+                }
+                in.skip(name.length() + 2);
+                skipWhiteSpace();
+
+                if (in.peek() != '>') {
+                    return false;
+                }
+                in.skip(1);
+                break;
+            }
+
+            if (!parseAttribute(attrName, attrValue) || in.atEnd()) {
+                return false;
+            }
+
+            if (std::find(attributes.begin(), attributes.end(), attrName) != attributes.end()) {
+                return false;
+            }
+            attributes.push_back(attrName);
+
+            //following badgerfish xml->json and xml->ruby convention for attributes..
+            if (node) {
+                tree->decodeXMLText(node->newChild(("@" + attrName).c_str()), attrValue.c_str(), fpp);
+            }
+        }
+
+        if (content.strVector) {
+            node->element()->set(content.strs);
+        }
+
+        if (strItem) {
+            if (!content.hasChild) {
+                parent->strs.push_back("");
+            } else if (content.firstIsText) {
+                parent->strs.push_back(content.firstText);
+            }
+        }
+
+        return true;
+    }
+
+    DataTree *tree;
+    DataTreeXMLStream in;
+    DT_FloatingPointPolicy fpp;
+    TiXmlEncoding encoding;
+};
+
+bool DataTree::LoadFromFileXMLStream(const std::string& filename, DT_FloatingPointPolicy fpp) {
+
+    FILE *fp = fopen(filename.c_str(), "rb");
+
+    if (!fp) {
+        std::cout << "LoadFromFileXMLStream[error loading]: " << filename << std::endl;
+        return false;
+    }
+
+    DataTreeXMLStreamParser parser(this, fp, fpp);
+
+    bool parsed = parser.parseDocument();
+
+    fclose(fp);
+
+    if (!parsed) {
+        std::cout << "LoadFromFileXMLStream[error parsing]: " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 bool DataTree::SaveToFileXML(const std::string& filename) {
     TiXmlDocument doc;
     TiXmlDeclaration * decl = new TiXmlDeclaration("1.0", "", "");
@@ -1097,3 +1820,425 @@ bool DataTree::SaveToFileXML(const std::string& filename) {
 
 
 
+
+/* Binary format:
+ *   header: magic "CDTB", version byte, byte-order mark (uint32 0x01020304 as written)
+ *   node: name length (uint32), name bytes + NUL, element type byte, element payload, child count (uint32), children
+ *   payload: scalars, strings, voids: length (uint32) + bytes
+ *            vectors: item count (uint32), then length (uint32) + bytes per item
+ * Values are stored in native byte order, longs are always stored on 8 bytes
+ * so that files remain readable where sizeof(long) differs.
+ */
+
+#define DATATREE_BINARY_MAGIC "CDTB"
+#define DATATREE_BINARY_MAGIC_SIZE 4
+#define DATATREE_BINARY_VERSION 1
+#define DATATREE_BINARY_BOM 0x01020304
+#define DATATREE_BINARY_HEADER_SIZE (DATATREE_BINARY_MAGIC_SIZE + 1 + 4)
+//deeper than any tree we write, bounds the recursion on corrupt files.
+#define DATATREE_BINARY_MAX_DEPTH 64
+
+static void binaryPutU32(vector<unsigned char> &out, uint32_t val) {
+    unsigned char *val_ptr = reinterpret_cast<unsigned char *>(&val);
+    out.insert(out.end(), val_ptr, val_ptr + sizeof(uint32_t));
+}
+
+static bool binaryGetU32(const unsigned char *&pos, const unsigned char *end, uint32_t &val) {
+    if ((size_t)(end - pos) < sizeof(uint32_t)) {
+        return false;
+    }
+    memcpy(&val, pos, sizeof(uint32_t));
+    pos += sizeof(uint32_t);
+    return true;
+}
+
+static bool binaryIsLongType(DataElement::DataElementTypeEnum type_in) {
+    return (type_in == DataElement::DATA_LONG || type_in == DataElement::DATA_ULONG ||
+            type_in == DataElement::DATA_LONG_VECTOR || type_in == DataElement::DATA_ULONG_VECTOR);
+}
+
+static void binaryPutBuffer(vector<unsigned char> &out, const DataElement::DataElementBuffer &buf, bool isLong, bool isUnsigned) {
+
+    if (isLong && buf.size() == sizeof(long)) {
+        int64_t val;
+        if (isUnsigned) {
+            unsigned long native_val;
+            memcpy(&native_val, &buf[0], sizeof(long));
+            val = (int64_t)native_val;
+        } else {
+            long native_val;
+            memcpy(&native_val, &buf[0], sizeof(long));
+            val = native_val;
+        }
+        unsigned char *val_ptr = reinterpret_cast<unsigned char *>(&val);
+
+        binaryPutU32(out, sizeof(int64_t));
+        out.insert(out.end(), val_ptr, val_ptr + sizeof(int64_t));
+        return;
+    }
+
+    binaryPutU32(out, (uint32_t)buf.size());
+    out.insert(out.end(), buf.begin(), buf.end());
+}
+
+//stored size of a scalar or vector item of type_in, -1 if variable (strings, voids).
+static int binaryItemSize(DataElement::DataElementTypeEnum type_in) {
+    switch (type_in) {
+        case DataElement::DATA_NULL:
+            return 0;
+        case DataElement::DATA_CHAR:
+        case DataElement::DATA_UCHAR:
+        case DataElement::DATA_CHAR_VECTOR:
+        case DataElement::DATA_UCHAR_VECTOR:
+            return sizeof(char);
+        case DataElement::DATA_INT:
+        case DataElement::DATA_UINT:
+        case DataElement::DATA_INT_VECTOR:
+        case DataElement::DATA_UINT_VECTOR:
+            return sizeof(int);
+        case DataElement::DATA_FLOAT:
+        case DataElement::DATA_FLOAT_VECTOR:
+            return sizeof(float);
+        case DataElement::DATA_LONG:
+        case DataElement::DATA_ULONG:
+        case DataElement::DATA_LONG_VECTOR:
+        case DataElement::DATA_ULONG_VECTOR:
+            return sizeof(int64_t);
+        case DataElement::DATA_LONGLONG:
+        case DataElement::DATA_LONGLONG_VECTOR:
+            return sizeof(long long);
+        case DataElement::DATA_DOUBLE:
+        case DataElement::DATA_DOUBLE_VECTOR:
+            return sizeof(double);
+        default:
+            return -1;
+    }
+}
+
+//read one length-prefixed buffer in place: data points into the file buffer.
+static bool binaryGetBuffer(const unsigned char *&pos, const unsigned char *end, const unsigned char *&data, uint32_t &size) {
+    if (!binaryGetU32(pos, end, size) || (size_t)(end - pos) < size) {
+        return false;
+    }
+    data = pos;
+    pos += size;
+    return true;
+}
+
+//the native bytes of a stored long, only allocated when sizeof(long) is not 8.
+static const unsigned char *binaryNativeLong(const unsigned char *data, uint32_t &size, bool isUnsigned, unsigned char *native_out) {
+
+    if (size != sizeof(int64_t) || sizeof(long) == sizeof(int64_t)) {
+        return data;
+    }
+
+    int64_t val;
+    memcpy(&val, data, sizeof(int64_t));
+
+    if (isUnsigned) {
+        unsigned long native_val = (unsigned long)val;
+        memcpy(native_out, &native_val, sizeof(long));
+    } else {
+        long native_val = (long)val;
+        memcpy(native_out, &native_val, sizeof(long));
+    }
+    size = sizeof(long);
+
+    return native_out;
+}
+
+void DataTree::nodeToBinary(DataNode *elem, vector<unsigned char> &out) {
+
+    std::string name = elem->getName();
+
+    binaryPutU32(out, (uint32_t)name.length());
+    out.insert(out.end(), name.begin(), name.end());
+    out.push_back(0);
+
+    DataElement *element = elem->element();
+    DataElement::DataElementTypeEnum dataType = element->getDataType();
+
+    bool isLong = binaryIsLongType(dataType);
+    bool isUnsigned = (dataType == DataElement::DATA_ULONG || dataType == DataElement::DATA_ULONG_VECTOR);
+
+    out.push_back((unsigned char)dataType);
+
+    if (DataElement::isVectorType(dataType)) {
+        const DataElement::DataElementBufferVector &items = element->getDataVector();
+
+        binaryPutU32(out, (uint32_t)items.size());
+        for (const DataElement::DataElementBuffer &item : items) {
+            binaryPutBuffer(out, item, isLong, isUnsigned);
+        }
+    } else {
+        DataElement::DataElementBuffer empty;
+        char *data_ptr = element->getDataPointer();
+
+        if (data_ptr) {
+            DataElement::DataElementBuffer buf(data_ptr, data_ptr + element->getDataSize());
+            binaryPutBuffer(out, buf, isLong, isUnsigned);
+        } else {
+            binaryPutBuffer(out, empty, false, false);
+        }
+    }
+
+    size_t numChildren = elem->numChildren();
+
+    binaryPutU32(out, (uint32_t)numChildren);
+
+    for (size_t i = 0; i < numChildren; i++) {
+        nodeToBinary(elem->child((int)i), out);
+    }
+}
+
+bool DataTree::binaryToNode(DataNode *elem, const unsigned char *&pos, const unsigned char *end, int depth) {
+
+    uint32_t typeByte;
+
+    if (pos >= end || depth > DATATREE_BINARY_MAX_DEPTH) {
+        return false;
+    }
+    typeByte = *pos++;
+
+    if (typeByte > DataElement::DATA_WSTRING) {
+        return false;
+    }
+
+    DataElement::DataElementTypeEnum dataType = (DataElement::DataElementTypeEnum)typeByte;
+
+    bool isLong = binaryIsLongType(dataType);
+    bool isUnsigned = (dataType == DataElement::DATA_ULONG || dataType == DataElement::DATA_ULONG_VECTOR);
+    int itemSize = binaryItemSize(dataType);
+
+    const unsigned char *data;
+    uint32_t size;
+    unsigned char nativeLong[sizeof(long)];
+
+    if (DataElement::isVectorType(dataType)) {
+        uint32_t count;
+
+        //each item takes at least its length, a corrupt count must not size the vector.
+        if (!binaryGetU32(pos, end, count) || count > (size_t)(end - pos) / sizeof(uint32_t)) {
+            return false;
+        }
+
+        DataElement::DataElementBufferVector items(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (!binaryGetBuffer(pos, end, data, size) || (itemSize >= 0 && size != (uint32_t)itemSize)) {
+                return false;
+            }
+            if (isLong) {
+                data = binaryNativeLong(data, size, isUnsigned, nativeLong);
+            }
+            items[i].assign(data, data + size);
+        }
+
+        elem->element()->setRawVector(dataType, items);
+    } else {
+        //get<T>() reads a whole value from a non empty scalar, it must have exactly its size.
+        if (!binaryGetBuffer(pos, end, data, size) || (itemSize >= 0 && size != 0 && size != (uint32_t)itemSize)) {
+            return false;
+        }
+        if (isLong) {
+            data = binaryNativeLong(data, size, isUnsigned, nativeLong);
+        }
+        elem->element()->setRaw(dataType, data, size);
+    }
+
+    uint32_t numChildren;
+
+    if (!binaryGetU32(pos, end, numChildren)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numChildren; i++) {
+        uint32_t nameLength;
+
+        //names are stored NUL terminated, so they are used in place.
+        if (!binaryGetU32(pos, end, nameLength) || (size_t)(end - pos) < (size_t)nameLength + 1 || pos[nameLength] != 0) {
+            return false;
+        }
+
+        const char *name = (const char *)pos;
+        pos += nameLength + 1;
+
+        if (!binaryToNode(elem->newChild(name), pos, end, depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool binaryReadFile(const std::string& filename, vector<unsigned char> &buf) {
+
+    FILE *fp = fopen(filename.c_str(), "rb");
+
+    if (!fp) {
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long fileSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (fileSize < 0) {
+        fclose(fp);
+        return false;
+    }
+
+    //the whole file in a single read, parsed in place.
+    buf.resize((size_t)fileSize);
+
+    size_t nRead = fileSize ? fread(&buf[0], 1, (size_t)fileSize, fp) : 0;
+
+    fclose(fp);
+
+    return (nRead == (size_t)fileSize);
+}
+
+void DataTree::toBinary(vector<unsigned char> &out) {
+    nodeToBinary(rootNode(), out);
+}
+
+bool DataTree::fromBinary(const unsigned char *data, size_t size) {
+
+    const unsigned char *pos = data;
+    const unsigned char *end = data + size;
+    uint32_t nameLength;
+
+    if (!binaryGetU32(pos, end, nameLength) || (size_t)(end - pos) < (size_t)nameLength + 1 || pos[nameLength] != 0) {
+        return false;
+    }
+
+    rootNode()->setName((const char *)pos);
+    pos += nameLength + 1;
+
+    return binaryToNode(rootNode(), pos, end);
+}
+
+bool DataTree::LoadFromFileBinary(const std::string& filename) {
+
+    vector<unsigned char> buf;
+
+    if (!binaryReadFile(filename, buf)) {
+        std::cout << "LoadFromFileBinary[error loading]: " << filename << std::endl;
+        return false;
+    }
+
+    const unsigned char *pos = buf.empty() ? nullptr : &buf[0];
+    const unsigned char *end = pos + buf.size();
+    uint32_t bom;
+
+    if (buf.size() < DATATREE_BINARY_HEADER_SIZE || memcmp(pos, DATATREE_BINARY_MAGIC, DATATREE_BINARY_MAGIC_SIZE) != 0) {
+        std::cout << "LoadFromFileBinary[error not a binary tree]: " << filename << std::endl;
+        return false;
+    }
+    pos += DATATREE_BINARY_MAGIC_SIZE;
+
+    if (*pos++ != DATATREE_BINARY_VERSION || !binaryGetU32(pos, end, bom) || bom != DATATREE_BINARY_BOM) {
+        std::cout << "LoadFromFileBinary[error unsupported version or byte order]: " << filename << std::endl;
+        return false;
+    }
+
+    if (!fromBinary(pos, end - pos)) {
+        std::cout << "LoadFromFileBinary[error truncated or corrupt]: " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool DataTree::SaveToFileBinary(const std::string& filename) {
+
+    vector<unsigned char> out(DATATREE_BINARY_MAGIC, DATATREE_BINARY_MAGIC + DATATREE_BINARY_MAGIC_SIZE);
+
+    out.push_back(DATATREE_BINARY_VERSION);
+    binaryPutU32(out, DATATREE_BINARY_BOM);
+
+    toBinary(out);
+
+    FILE *fp = fopen(filename.c_str(), "wb");
+
+    if (!fp) {
+        std::cout << "SaveToFileBinary[error opening]: " << filename << std::endl;
+        return false;
+    }
+
+    size_t nWritten = fwrite(&out[0], 1, out.size(), fp);
+
+    //a failed close means a failed write as well.
+    if (fclose(fp) != 0 || nWritten != out.size()) {
+        std::cout << "SaveToFileBinary[error writing]: " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool DataTree::isBinaryFile(const std::string& filename) {
+
+    FILE *fp = fopen(filename.c_str(), "rb");
+
+    if (!fp) {
+        return false;
+    }
+
+    char magic[DATATREE_BINARY_MAGIC_SIZE];
+    size_t nRead = fread(magic, 1, DATATREE_BINARY_MAGIC_SIZE, fp);
+
+    fclose(fp);
+
+    return (nRead == DATATREE_BINARY_MAGIC_SIZE && memcmp(magic, DATATREE_BINARY_MAGIC, DATATREE_BINARY_MAGIC_SIZE) == 0);
+}
+
+bool DataTree::LoadFromFile(const std::string& filename, DT_FloatingPointPolicy fpp) {
+
+    if (isBinaryFile(filename)) {
+        return LoadFromFileBinary(filename);
+    }
+
+    return LoadFromFileXMLStream(filename, fpp);
+}
+
+static std::string nodeToXMLText(DataNode *elem) {
+
+    DataTree tmp;
+    string rootName = elem->getName();
+    TiXmlElement element(rootName.empty() ? "root" : rootName.c_str());
+
+    tmp.nodeToXML(elem, &element);
+
+    TiXmlPrinter printer;
+    element.Accept(&printer);
+
+    return printer.CStr();
+}
+
+bool DataTree::convertFile(const std::string& from, const std::string& to) {
+
+    DataTree source, converted;
+    bool toBinary = !isBinaryFile(from);
+
+    //keep doubles when reading XML, the binary form does not lose precision.
+    if (!source.LoadFromFile(from, USE_DOUBLE)) {
+        return false;
+    }
+
+    if (!(toBinary ? source.SaveToFileBinary(to) : source.SaveToFileXML(to))) {
+        return false;
+    }
+
+    if (!converted.LoadFromFile(to, USE_DOUBLE)) {
+        return false;
+    }
+
+    //round trip check: XML does not keep the value types, so both trees must give the same XML.
+    if (nodeToXMLText(source.rootNode()) != nodeToXMLText(converted.rootNode())) {
+        std::cout << "convertFile[error round trip mismatch]: " << from << " -> " << to << std::endl;
+        return false;
+    }
+
+    return true;
+}
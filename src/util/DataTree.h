@@ -484,6 +484,12 @@ public:
     //special versions:
     void get(DataElementBuffer& data_out); /* getting a void or string */
     void get(std::set<string> &strset_out);
+
+    /* raw access, for binary serialization: the bytes of scalars, strings and voids, or the items of vectors, as stored. */
+    void setRaw(DataElementTypeEnum type_in, const unsigned char *data_in, size_t size_in);
+    void setRawVector(DataElementTypeEnum type_in, DataElementBufferVector &vector_in); /* takes the content of vector_in */
+    const DataElementBufferVector &getDataVector();
+    static bool isVectorType(DataElementTypeEnum type_in);
        
     
     /* special get functions, saves creating unnecessary vars */
@@ -633,5 +639,28 @@ public:
     
     bool LoadFromFileXML(const std::string& filename, DT_FloatingPointPolicy fpp=USE_FLOAT);
     bool SaveToFileXML(const std::string& filename);
+
+    /* same result as LoadFromFileXML(), but the file is read by chunks and the nodes are filled
+       as elements are parsed, without building the whole TiXmlDocument first. */
+    bool LoadFromFileXMLStream(const std::string& filename, DT_FloatingPointPolicy fpp=USE_FLOAT);
+
+    /* compact binary form: typed values are stored as is, so loading involves no text conversion. */
+    void nodeToBinary(DataNode *elem, vector<unsigned char> &out);
+    bool binaryToNode(DataNode *elem, const unsigned char *&pos, const unsigned char *end, int depth = 0);
+
+    /* the whole tree as one binary block without file header, for records stored in other files. */
+    void toBinary(vector<unsigned char> &out);
+    bool fromBinary(const unsigned char *data, size_t size);
+
+    bool LoadFromFileBinary(const std::string& filename);
+    bool SaveToFileBinary(const std::string& filename);
+
+    static bool isBinaryFile(const std::string& filename);
+
+    /* load either format, detected from the file content; XML is streamed. */
+    bool LoadFromFile(const std::string& filename, DT_FloatingPointPolicy fpp=USE_FLOAT);
+
+    /* convert 'from' (XML or binary) into the other format, checking that the result reads back the same. */
+    static bool convertFile(const std::string& from, const std::string& to);
    
 };
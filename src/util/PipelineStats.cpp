@@ -0,0 +1,332 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "PipelineStats.h"
+
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+std::mutex PipelineStats::registryMutex;
+std::vector<std::weak_ptr<QueueStats>> PipelineStats::queues;
+std::vector<std::shared_ptr<LatencyStats>> PipelineStats::stages;
+
+static void storeMax(std::atomic_ullong& target, unsigned long long value) {
+    unsigned long long current = target.load(std::memory_order_relaxed);
+
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+QueueStats::QueueStats() : pushes(0), pops(0), pushFailures(0), depth(0), maxDepth(0), capacity(0) {
+}
+
+void QueueStats::setName(const std::string& name_in) {
+    std::lock_guard < std::mutex > lock(nameMutex);
+
+    if (name.empty()) {
+        name = name_in;
+    }
+}
+
+std::string QueueStats::getName() {
+    std::lock_guard < std::mutex > lock(nameMutex);
+
+    return name.empty() ? std::string("(unnamed)") : name;
+}
+
+void QueueStats::onPush(size_t depth_in) {
+    pushes.fetch_add(1, std::memory_order_relaxed);
+    depth.store(depth_in, std::memory_order_relaxed);
+    storeMax(maxDepth, depth_in);
+}
+
+void QueueStats::onPop(size_t depth_in) {
+    pops.fetch_add(1, std::memory_order_relaxed);
+    depth.store(depth_in, std::memory_order_relaxed);
+}
+
+void QueueStats::onPushFailure() {
+    pushFailures.fetch_add(1, std::memory_order_relaxed);
+}
+
+void QueueStats::setCapacity(size_t capacity_in) {
+    capacity.store(capacity_in, std::memory_order_relaxed);
+}
+
+LatencyStats::LatencyStats(const std::string& name) : name(name), count(0), sum(0), max(0) {
+    for (int i = 0; i < PIPELINE_LATENCY_BUCKETS; i++) {
+        buckets[i].store(0);
+    }
+}
+
+void LatencyStats::record(long long latencyMicros) {
+
+    unsigned long long latency = (latencyMicros > 0) ? (unsigned long long)latencyMicros : 0;
+
+    int bucket = 0;
+    while (bucket < PIPELINE_LATENCY_BUCKETS - 1 && latency >= (1ULL << bucket)) {
+        bucket++;
+    }
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(latency, std::memory_order_relaxed);
+    storeMax(max, latency);
+}
+
+void LatencyStats::recordSince(long long ingestTime) {
+    //no timestamp, nothing to measure.
+    if (ingestTime <= 0) {
+        return;
+    }
+    record(PipelineStats::now() - ingestTime);
+}
+
+std::shared_ptr<QueueStats> PipelineStats::addQueue() {
+    std::lock_guard < std::mutex > lock(registryMutex);
+
+    std::shared_ptr<QueueStats> stats = std::make_shared<QueueStats>();
+
+    //forget the queues gone since, so that the registry does not grow with the demodulators created.
+    for (auto i = queues.begin(); i != queues.end();) {
+        if (i->expired()) {
+            i = queues.erase(i);
+        } else {
+            i++;
+        }
+    }
+
+    queues.push_back(stats);
+    return stats;
+}
+
+std::shared_ptr<LatencyStats> PipelineStats::getStage(const std::string& name) {
+    std::lock_guard < std::mutex > lock(registryMutex);
+
+    for (auto stage : stages) {
+        if (stage->name == name) {
+            return stage;
+        }
+    }
+
+    std::shared_ptr<LatencyStats> stage = std::make_shared<LatencyStats>(name);
+    stages.push_back(stage);
+    return stage;
+}
+
+long long PipelineStats::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long long PipelineStats::threadCPUTime() {
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+
+    //100 ns units
+    unsigned long long kernel = ((unsigned long long)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+    unsigned long long user = ((unsigned long long)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+
+    return (long long)((kernel + user) / 10);
+#else
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+#endif
+}
+
+void PipelineStats::snapshot(std::vector<QueueStatsSnapshot>& queues_out, std::vector<LatencyStatsSnapshot>& stages_out) {
+
+    std::vector<std::shared_ptr<QueueStats>> liveQueues;
+    std::vector<std::shared_ptr<LatencyStats>> liveStages;
+
+    {
+        std::lock_guard < std::mutex > lock(registryMutex);
+
+        for (auto q : queues) {
+            std::shared_ptr<QueueStats> stats = q.lock();
+            if (stats) {
+                liveQueues.push_back(stats);
+            }
+        }
+        liveStages = stages;
+    }
+
+    std::map<std::string, QueueStatsSnapshot> byName;
+
+    for (auto stats : liveQueues) {
+        std::string name = stats->getName();
+        QueueStatsSnapshot& snap = byName[name];
+
+        snap.name = name;
+        snap.instances++;
+        snap.pushes += stats->pushes.load();
+        snap.pops += stats->pops.load();
+        snap.pushFailures += stats->pushFailures.load();
+        snap.depth += stats->depth.load();
+        snap.maxDepth = std::max(snap.maxDepth, stats->maxDepth.load());
+        snap.capacity = std::max(snap.capacity, stats->capacity.load());
+    }
+
+    queues_out.clear();
+    for (auto& snap : byName) {
+        queues_out.push_back(snap.second);
+    }
+
+    stages_out.clear();
+    for (auto stage : liveStages) {
+        LatencyStatsSnapshot snap;
+
+        snap.name = stage->name;
+        snap.count = stage->count.load();
+        snap.max = stage->max.load();
+        snap.mean = snap.count ? (double)stage->sum.load() / (double)snap.count : 0;
+
+        unsigned long long total = 0;
+        for (int i = 0; i < PIPELINE_LATENCY_BUCKETS; i++) {
+            snap.buckets.push_back(stage->buckets[i].load());
+            total += snap.buckets.back();
+        }
+
+        //the buckets may have moved on since count was read, use their own total.
+        unsigned long long cumulated = 0;
+        for (int i = 0; i < PIPELINE_LATENCY_BUCKETS; i++) {
+            unsigned long long previous = cumulated;
+            cumulated += snap.buckets[i];
+
+            unsigned long long upperBound = (i < PIPELINE_LATENCY_BUCKETS - 1) ? std::min(1ULL << i, snap.max) : snap.max;
+
+            if (total && previous * 2 < total && cumulated * 2 >= total) {
+                snap.p50 = upperBound;
+            }
+            if (total && previous * 100 < total * 99 && cumulated * 100 >= total * 99) {
+                snap.p99 = upperBound;
+            }
+        }
+
+        stages_out.push_back(snap);
+    }
+}
+
+static std::string jsonString(const std::string& str) {
+    std::string result("\"");
+
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            result.push_back('\\');
+            result.push_back(c);
+        } else if ((unsigned char)c < 0x20) {
+            result.push_back(' ');
+        } else {
+            result.push_back(c);
+        }
+    }
+
+    result.push_back('"');
+    return result;
+}
+
+std::string PipelineStats::toJSON() {
+
+    std::vector<QueueStatsSnapshot> queueSnaps;
+    std::vector<LatencyStatsSnapshot> stageSnaps;
+
+    snapshot(queueSnaps, stageSnaps);
+
+    std::stringstream out;
+
+    out << "{" << std::endl;
+    out << "  \"timestamp_us\": " << now() << "," << std::endl;
+
+    out << "  \"queues\": [";
+    for (size_t i = 0; i < queueSnaps.size(); i++) {
+        const QueueStatsSnapshot& q = queueSnaps[i];
+
+        out << (i ? "," : "") << std::endl << "    { \"name\": " << jsonString(q.name)
+            << ", \"instances\": " << q.instances
+            << ", \"pushes\": " << q.pushes
+            << ", \"pops\": " << q.pops
+            << ", \"push_failures\": " << q.pushFailures
+            << ", \"depth\": " << q.depth
+            << ", \"max_depth\": " << q.maxDepth
+            << ", \"capacity\": " << q.capacity << " }";
+    }
+    out << std::endl << "  ]," << std::endl;
+
+    out << "  \"stages\": [";
+    for (size_t i = 0; i < stageSnaps.size(); i++) {
+        const LatencyStatsSnapshot& s = stageSnaps[i];
+
+        out << (i ? "," : "") << std::endl << "    { \"name\": " << jsonString(s.name)
+            << ", \"count\": " << s.count
+            << ", \"mean_us\": " << (long long)s.mean
+            << ", \"p50_us\": " << s.p50
+            << ", \"p99_us\": " << s.p99
+            << ", \"max_us\": " << s.max
+            << ", \"histogram_us\": [";
+
+        for (size_t b = 0; b < s.buckets.size(); b++) {
+            out << (b ? ", " : "") << s.buckets[b];
+        }
+        out << "] }";
+    }
+    out << std::endl << "  ]" << std::endl;
+    out << "}" << std::endl;
+
+    return out.str();
+}
+
+bool PipelineStats::saveJSON(const std::string& path) {
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+
+    if (!file.is_open()) {
+        std::cout << "PipelineStats: unable to open '" << path << "' for writing." << std::endl;
+        return false;
+    }
+
+    file << toJSON();
+    return file.good();
+}
+
+void PipelineStats::reset() {
+    std::lock_guard < std::mutex > lock(registryMutex);
+
+    for (auto q : queues) {
+        std::shared_ptr<QueueStats> stats = q.lock();
+        if (stats) {
+            stats->pushes.store(0);
+            stats->pops.store(0);
+            stats->pushFailures.store(0);
+            stats->maxDepth.store(stats->depth.load());
+        }
+    }
+
+    for (auto stage : stages) {
+        stage->count.store(0);
+        stage->sum.store(0);
+        stage->max.store(0);
+        for (int i = 0; i < PIPELINE_LATENCY_BUCKETS; i++) {
+            stage->buckets[i].store(0);
+        }
+    }
+}
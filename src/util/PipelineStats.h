@@ -0,0 +1,122 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+//bucket i of a latency histogram counts the latencies below 2^i microseconds, the last bucket all the others.
+#define PIPELINE_LATENCY_BUCKETS 24
+
+/**
+ * Counters of one ThreadBlockingQueue. Updated by the queue itself, read by anyone.
+ */
+class QueueStats {
+public:
+    QueueStats();
+
+    //the first name given sticks: a queue shared by 2 threads is named by the first binding.
+    void setName(const std::string& name);
+    std::string getName();
+
+    void onPush(size_t depth);
+    void onPop(size_t depth);
+    void onPushFailure();
+    void setCapacity(size_t capacity);
+
+    std::atomic_ullong pushes;
+    std::atomic_ullong pops;
+    std::atomic_ullong pushFailures;
+    std::atomic_ullong depth;
+    std::atomic_ullong maxDepth;
+    std::atomic_ullong capacity;
+
+private:
+    std::mutex nameMutex;
+    std::string name;
+};
+
+/**
+ * Histogram of the latencies seen by one pipeline stage, in microseconds.
+ */
+class LatencyStats {
+public:
+    LatencyStats(const std::string& name);
+
+    void record(long long latencyMicros);
+
+    //the ingest timestamp of an item is PipelineStats::now() at ingest: record the time elapsed since.
+    void recordSince(long long ingestTime);
+
+    const std::string name;
+
+    std::atomic_ullong count;
+    std::atomic_ullong sum;
+    std::atomic_ullong max;
+    std::atomic_ullong buckets[PIPELINE_LATENCY_BUCKETS];
+};
+
+//values of all the queues of the same name
+class QueueStatsSnapshot {
+public:
+    QueueStatsSnapshot() : instances(0), pushes(0), pops(0), pushFailures(0), depth(0), maxDepth(0), capacity(0) {
+    }
+
+    std::string name;
+    int instances;
+    unsigned long long pushes, pops, pushFailures;
+    unsigned long long depth, maxDepth, capacity;
+};
+
+class LatencyStatsSnapshot {
+public:
+    LatencyStatsSnapshot() : count(0), mean(0), max(0), p50(0), p99(0) {
+    }
+
+    std::string name;
+    unsigned long long count;
+    double mean;
+    unsigned long long max;
+    //upper bound of the histogram bucket where the percentile falls.
+    unsigned long long p50, p99;
+    std::vector<unsigned long long> buckets;
+};
+
+/**
+ * Registry of the telemetry of the processing pipeline: every ThreadBlockingQueue,
+ * and the latency histograms of the stages, from the ingest timestamps carried by the data.
+ */
+class PipelineStats {
+public:
+    //for ThreadBlockingQueue: a new, unnamed, set of counters.
+    static std::shared_ptr<QueueStats> addQueue();
+
+    //the histogram of the stage 'name', shared by all the instances of that stage.
+    static std::shared_ptr<LatencyStats> getStage(const std::string& name);
+
+    //monotonic clock, in microseconds, to timestamp the data at ingest.
+    static long long now();
+
+    //CPU time used by the calling thread so far, in microseconds, or 0 if unknown.
+    static long long threadCPUTime();
+
+    //queues aggregated by name, in name order, then the stages in creation order.
+    static void snapshot(std::vector<QueueStatsSnapshot>& queues_out, std::vector<LatencyStatsSnapshot>& stages_out);
+
+    //the current snapshot as JSON.
+    static std::string toJSON();
+    static bool saveJSON(const std::string& path);
+
+    //restart every counter and histogram from 0.
+    static void reset();
+
+private:
+    static std::mutex registryMutex;
+    static std::vector<std::weak_ptr<QueueStats>> queues;
+    static std::vector<std::shared_ptr<LatencyStats>> stages;
+};
@@ -0,0 +1,119 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+
+/** A wait-free single-producer / single-consumer ring buffer of trivially copyable items.
+ * Exactly one thread may call the producer methods (write(), writeAvailable()) and exactly one
+ * other thread the consumer methods (read(), readRegions(), consume(), consumeAll(), readAvailable()).
+ * Storage is allocated once at construction, so no method allocates nor locks. */
+template<typename T>
+class SPSCRingBuffer {
+
+public:
+
+    /*! Create a ring able to hold at least 'capacity' items, rounded up to a power of 2. */
+    SPSCRingBuffer(size_t capacity) : m_write(0), m_read(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_buffer.resize(size);
+        m_mask = size - 1;
+    }
+
+    SPSCRingBuffer(const SPSCRingBuffer& other) = delete;
+
+    SPSCRingBuffer& operator=(const SPSCRingBuffer& other) = delete;
+
+    size_t capacity() const {
+        return m_buffer.size();
+    }
+
+    /*! Number of items that can be read right now. (consumer side) */
+    size_t readAvailable() const {
+        return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_relaxed);
+    }
+
+    /*! Number of items that can be written right now. (producer side) */
+    size_t writeAvailable() const {
+        return m_buffer.size() - (m_write.load(std::memory_order_relaxed) - m_read.load(std::memory_order_acquire));
+    }
+
+    /**
+     * Write at most n items from src, without waiting.
+     * \return the number of items actually written.
+     */
+    size_t write(const T *src, size_t n) {
+        size_t w = m_write.load(std::memory_order_relaxed);
+        n = std::min(n, writeAvailable());
+
+        size_t start = w & m_mask;
+        size_t first = std::min(n, m_buffer.size() - start);
+
+        std::memcpy(&m_buffer[start], src, first * sizeof(T));
+        if (n > first) {
+            std::memcpy(&m_buffer[0], src + first, (n - first) * sizeof(T));
+        }
+
+        m_write.store(w + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * Give direct access to at most n readable items, as up to 2 contiguous regions,
+     * without consuming them. Call consume() once done with them.
+     * \return n1 + n2, the number of items exposed.
+     */
+    size_t readRegions(size_t n, const T *&p1, size_t &n1, const T *&p2, size_t &n2) const {
+        size_t r = m_read.load(std::memory_order_relaxed);
+        n = std::min(n, readAvailable());
+
+        size_t start = r & m_mask;
+        n1 = std::min(n, m_buffer.size() - start);
+        n2 = n - n1;
+        p1 = &m_buffer[start];
+        p2 = &m_buffer[0];
+        return n;
+    }
+
+    /*! Read at most n items into dst. \return the number of items actually read. */
+    size_t read(T *dst, size_t n) {
+        const T *p1, *p2;
+        size_t n1, n2;
+
+        n = readRegions(n, p1, n1, p2, n2);
+
+        std::memcpy(dst, p1, n1 * sizeof(T));
+        if (n2) {
+            std::memcpy(dst + n1, p2, n2 * sizeof(T));
+        }
+        consume(n);
+        return n;
+    }
+
+    /*! Release n items previously exposed by readRegions(). */
+    void consume(size_t n) {
+        m_read.store(m_read.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    /*! Drop everything currently readable. (consumer side) */
+    void consumeAll() {
+        m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<T> m_buffer;
+    size_t m_mask;
+
+    //producer and consumer indices are free-running, kept on separate cache lines.
+    std::atomic<size_t> m_write;
+    char m_padding[64];
+    std::atomic<size_t> m_read;
+};
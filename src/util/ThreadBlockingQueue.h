@@ -3,7 +3,7 @@
 
 #pragma once 
 
-#include <deque>
+#include <vector>
 #include <mutex>
 #include <thread>
 #include <cstdint>
@@ -11,7 +11,9 @@
 #include <condition_variable>
 #include <typeinfo>
 #include <iostream>
+#include <memory>
 #include "SpinMutex.h"
+#include "PipelineStats.h"
 
 #define MIN_ITEM_NB (1)
 
@@ -24,16 +26,32 @@
 #define BLOCKING_INFINITE_TIMEOUT (0)
 
 class ThreadQueueBase {
+public:
+    ThreadQueueBase() : m_stats(PipelineStats::addQueue()) {
+    }
+
+    //name of the queue in the pipeline telemetry, the first one given is kept.
+    void set_stats_name(const std::string& name) {
+        m_stats->setName(name);
+    }
+
+    std::shared_ptr<QueueStats> get_stats() const {
+        return m_stats;
+    }
+
+protected:
+    std::shared_ptr<QueueStats> m_stats;
 };
 
 typedef std::shared_ptr<ThreadQueueBase> ThreadQueueBasePtr;
 
-/** A thread-safe asynchronous blocking queue */
+/** A thread-safe asynchronous blocking queue, over a ring of m_max_num_items slots
+ * allocated once by set_max_num_items(): pushing and popping never allocate. */
 template<typename T>
 class ThreadBlockingQueue : public ThreadQueueBase {
 
-    typedef typename std::deque<T>::value_type value_type;
-    typedef typename std::deque<T>::size_type size_type;
+    typedef T value_type;
+    typedef size_t size_type;
 
 public:
 
@@ -41,6 +59,8 @@ public:
     ThreadBlockingQueue() {
         //at least 1 (== Java SynchronizedQueue)
         m_max_num_items = MIN_ITEM_NB;
+        m_ring.resize(m_max_num_items);
+        m_stats->setCapacity(m_max_num_items);
     };
     
     //Forbid Copy construction.
@@ -65,7 +85,16 @@ public:
         if (max_num_items > m_max_num_items) {
             //Only raise the existing max size, never reduce it
             //for simplification sake at runtime.
+            std::vector<T> ring(max_num_items);
+
+            for (size_t i = 0; i < m_count; i++) {
+                ring[i] = std::move(m_ring[(m_head + i) % m_ring.size()]);
+            }
+
+            m_ring.swap(ring);
+            m_head = 0;
             m_max_num_items = max_num_items;
+            m_stats->setCapacity(m_max_num_items);
             m_cond_not_full.notify_all();
         }
     }
@@ -85,14 +114,17 @@ public:
         if (timeout == BLOCKING_INFINITE_TIMEOUT) {
             m_cond_not_full.wait(lock, [this]() // Lambda funct
             {
-                return m_queue.size() < m_max_num_items;
+                return m_count < m_max_num_items;
             });
-        } else if (timeout <= NON_BLOCKING_TIMEOUT && m_queue.size() >= m_max_num_items) {
+        } else if (timeout <= NON_BLOCKING_TIMEOUT && m_count >= m_max_num_items) {
             // if the value is below a threshold, consider it is a try_push()
+            m_stats->onPushFailure();
             return false;
         }
         else if (false == m_cond_not_full.wait_for(lock, std::chrono::microseconds(timeout),
-            [this]() { return m_queue.size() < m_max_num_items; })) {
+            [this]() { return m_count < m_max_num_items; })) {
+
+            m_stats->onPushFailure();
 
             if (errorMessage != nullptr) {
                 std::thread::id currentThreadId = std::this_thread::get_id();
@@ -103,7 +135,9 @@ public:
             return false;
         }
 
-        m_queue.push_back(item);
+        m_ring[(m_head + m_count) % m_ring.size()] = item;
+        m_count++;
+        m_stats->onPush(m_count);
         m_cond_not_empty.notify_all();
         return true;
     }
@@ -116,11 +150,14 @@ public:
     bool try_push(const value_type& item) {
         std::lock_guard < SpinMutex > lock(m_mutex);
 
-        if (m_queue.size() >= m_max_num_items) {
+        if (m_count >= m_max_num_items) {
+            m_stats->onPushFailure();
             return false;
         }
 
-        m_queue.push_back(item);
+        m_ring[(m_head + m_count) % m_ring.size()] = item;
+        m_count++;
+        m_stats->onPush(m_count);
         m_cond_not_empty.notify_all();
         return true;
     }
@@ -137,14 +174,14 @@ public:
         if (timeout == BLOCKING_INFINITE_TIMEOUT) {
             m_cond_not_empty.wait(lock, [this]() // Lambda funct
             {
-                return !m_queue.empty();
+                return m_count != 0;
             });
-        } else if (timeout <= NON_BLOCKING_TIMEOUT && m_queue.empty()) {
+        } else if (timeout <= NON_BLOCKING_TIMEOUT && m_count == 0) {
             // if the value is below a threshold, consider it is try_pop()
             return false;
         }
         else if (false == m_cond_not_empty.wait_for(lock, std::chrono::microseconds(timeout),
-            [this]() { return !m_queue.empty(); })) {
+            [this]() { return m_count != 0; })) {
 
             if (errorMessage != nullptr) {
                 std::thread::id currentThreadId = std::this_thread::get_id();
@@ -155,8 +192,8 @@ public:
             return false;
         }
 
-        item = m_queue.front();
-        m_queue.pop_front();
+        popFront(item);
+        m_stats->onPop(m_count);
         m_cond_not_full.notify_all();
         return true;
     }
@@ -169,12 +206,12 @@ public:
     bool try_pop(value_type& item) {
         std::lock_guard < SpinMutex > lock(m_mutex);
 
-        if (m_queue.empty()) {
+        if (m_count == 0) {
             return false;
         }
 
-        item = m_queue.front();
-        m_queue.pop_front();
+        popFront(item);
+        m_stats->onPop(m_count);
         m_cond_not_full.notify_all();
         return true;
     }
@@ -186,7 +223,7 @@ public:
      */
     size_type size() const {
         std::lock_guard < SpinMutex > lock(m_mutex);
-        return m_queue.size();
+        return m_count;
     }
 
     /**
@@ -195,7 +232,7 @@ public:
      */
     bool empty() const {
         std::lock_guard < SpinMutex > lock(m_mutex);
-        return m_queue.empty();
+        return (m_count == 0);
     }
 
     /**
@@ -204,7 +241,7 @@ public:
      */
     bool full() const {
         std::lock_guard < SpinMutex > lock(m_mutex);
-        return (m_queue.size() >= m_max_num_items);
+        return (m_count >= m_max_num_items);
     }
 
     /**
@@ -212,7 +249,14 @@ public:
      */
     void flush() {
         std::lock_guard < SpinMutex > lock(m_mutex);
-        m_queue.clear();
+
+        //release what the items hold, the slots stay.
+        while (m_count) {
+            T item;
+            popFront(item);
+        }
+        m_head = 0;
+        m_stats->depth.store(0);
         m_cond_not_full.notify_all();
     }
 
@@ -220,7 +264,17 @@ public:
 
 private:
 
-    std::deque<T> m_queue;
+    //move the front item out of its slot, which is left empty.
+    void popFront(value_type& item) {
+        item = std::move(m_ring[m_head]);
+        m_ring[m_head] = T();
+        m_head = (m_head + 1) % m_ring.size();
+        m_count--;
+    }
+
+    std::vector<T> m_ring;
+    size_t m_head = 0;
+    size_t m_count = 0;
 
     mutable SpinMutex m_mutex;
     std::condition_variable_any m_cond_not_empty;
@@ -20,7 +20,6 @@
 #include <cmath>
 
 wxBEGIN_EVENT_TABLE(GainCanvas, wxGLCanvas) EVT_PAINT(GainCanvas::OnPaint)
-EVT_IDLE(GainCanvas::OnIdle)
 EVT_MOTION(GainCanvas::OnMouseMoved)
 EVT_LEFT_DOWN(GainCanvas::OnMouseDown)
 EVT_LEFT_UP(GainCanvas::OnMouseReleased)
@@ -66,13 +65,7 @@ void GainCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
     SwapBuffers();
 }
 
-void GainCanvas::OnIdle(wxIdleEvent &event) {
-	if (mouseTracker.mouseInView()) {
-	    Refresh();
-	} else {
-		event.Skip();
-	}
-
+void GainCanvas::onFrame() {
 	bool areGainsChangedHere = false;
     
     for (auto gi : gainPanels) {
@@ -100,7 +93,7 @@ void GainCanvas::OnIdle(wxIdleEvent &event) {
 		if (!userGainAsChanged || (userGainAsChanged && userGainAsChangedDelayTimer.getMilliseconds() > 150)) {
 			
 			if (updateGainValues()) {
-				Refresh();
+				markDirty();
 			}
 
 			userGainAsChanged = false;
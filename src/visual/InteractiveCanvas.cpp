@@ -16,6 +16,7 @@
 #include "CubicSDR.h"
 #include "CubicSDRDefs.h"
 #include "AppFrame.h"
+#include "RenderScheduler.h"
 #include <algorithm>
 
 #include <wx/numformatter.h>
@@ -23,11 +24,33 @@
 InteractiveCanvas::InteractiveCanvas(wxWindow *parent, const wxGLAttributes& dispAttrs) :
         wxGLCanvas(parent, dispAttrs, wxID_ANY,  wxDefaultPosition, wxDefaultSize, wxFULL_REPAINT_ON_RESIZE), 
         parent(parent), shiftDown(false), altDown(false), ctrlDown(false), centerFreq(0), bandwidth(0), lastBandwidth(0), isView(
-        false) {
+        false), frameDirty(true), frameLinger(0) {
     mouseTracker.setTarget(this);
+
+    RenderScheduler::addCanvas(this);
 }
 
 InteractiveCanvas::~InteractiveCanvas() {
+    RenderScheduler::removeCanvas(this);
+}
+
+void InteractiveCanvas::markDirty() {
+    frameDirty.store(true);
+    RenderScheduler::wake();
+}
+
+void InteractiveCanvas::onFrame() {
+
+}
+
+bool InteractiveCanvas::takeFrameDirty() {
+    //evaluate both, so that the request is always cleared.
+    bool requested = frameDirty.exchange(false);
+    return isFrameDirty() || requested;
+}
+
+bool InteractiveCanvas::isFrameDirty() {
+    return mouseTracker.mouseInView();
 }
 
 void InteractiveCanvas::setView(long long center_freq_in, long long bandwidth_in) {
@@ -106,12 +129,16 @@ void InteractiveCanvas::OnKeyUp(wxKeyEvent& event) {
     shiftDown = event.ShiftDown();
     altDown = event.AltDown();
     ctrlDown = event.ControlDown();
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnKeyDown(wxKeyEvent& event) {
     shiftDown = event.ShiftDown();
     altDown = event.AltDown();
     ctrlDown = event.ControlDown();
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseMoved(wxMouseEvent& event) {
@@ -120,6 +147,8 @@ void InteractiveCanvas::OnMouseMoved(wxMouseEvent& event) {
     shiftDown = event.ShiftDown();
     altDown = event.AltDown();
     ctrlDown = event.ControlDown();
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseDown(wxMouseEvent& event) {
@@ -128,10 +157,14 @@ void InteractiveCanvas::OnMouseDown(wxMouseEvent& event) {
     shiftDown = event.ShiftDown();
     altDown = event.AltDown();
     ctrlDown = event.ControlDown();
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseWheelMoved(wxMouseEvent& event) {
     mouseTracker.OnMouseWheelMoved(event);
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseReleased(wxMouseEvent& event) {
@@ -140,6 +173,8 @@ void InteractiveCanvas::OnMouseReleased(wxMouseEvent& event) {
     shiftDown = event.ShiftDown();
     altDown = event.AltDown();
     ctrlDown = event.ControlDown();
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseLeftWindow(wxMouseEvent& event) {
@@ -148,6 +183,8 @@ void InteractiveCanvas::OnMouseLeftWindow(wxMouseEvent& event) {
     shiftDown = false;
     altDown = false;
     ctrlDown = false;
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseEnterWindow(wxMouseEvent& event) {
@@ -156,6 +193,8 @@ void InteractiveCanvas::OnMouseEnterWindow(wxMouseEvent& event) {
     shiftDown = event.ShiftDown();
     altDown = event.AltDown();
     ctrlDown = event.ControlDown();
+
+    markDirty();
 }
 
 void InteractiveCanvas::setStatusText(std::string statusText) {
@@ -170,10 +209,14 @@ void InteractiveCanvas::setStatusText(std::string statusText, int value) {
 
 void InteractiveCanvas::OnMouseRightDown(wxMouseEvent& event) {
     mouseTracker.OnMouseRightDown(event);
+
+    markDirty();
 }
 
 void InteractiveCanvas::OnMouseRightReleased(wxMouseEvent& event) {
     mouseTracker.OnMouseRightReleased(event);
+
+    markDirty();
 }
 
 bool InteractiveCanvas::isMouseInView() {
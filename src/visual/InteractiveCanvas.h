@@ -9,6 +9,7 @@
 #include "MouseTracker.h"
 #include <string>
 #include <vector>
+#include <atomic>
 
 class InteractiveCanvas: public wxGLCanvas {
 public:
@@ -36,7 +37,19 @@ public:
     bool isCtrlDown();
     bool isShiftDown();
 
+    //thread-safe: have this canvas redrawn on the next frame.
+    void markDirty();
+
+    //RenderScheduler: work to do on every frame, visible or not.
+    virtual void onFrame();
+
+    //RenderScheduler: true if the canvas must be redrawn this frame, clears the markDirty() request.
+    bool takeFrameDirty();
+
 protected:
+    //besides markDirty(), true when there is something new to show: by default while the mouse is over the canvas.
+    virtual bool isFrameDirty();
+
     void OnKeyDown(wxKeyEvent& event);
     void OnKeyUp(wxKeyEvent& event);
 
@@ -64,5 +77,13 @@ protected:
     long long lastBandwidth;
 
     bool isView;
+
+private:
+    friend class RenderScheduler;
+
+    std::atomic_bool frameDirty;
+
+    //remaining frames to redraw since the last dirty one, see RenderScheduler.
+    int frameLinger;
 };
 
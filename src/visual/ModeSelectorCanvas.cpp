@@ -19,7 +19,6 @@
 #include <algorithm>
 
 wxBEGIN_EVENT_TABLE(ModeSelectorCanvas, wxGLCanvas) EVT_PAINT(ModeSelectorCanvas::OnPaint)
-EVT_IDLE(ModeSelectorCanvas::OnIdle)
 EVT_MOTION(ModeSelectorCanvas::OnMouseMoved)
 EVT_LEFT_DOWN(ModeSelectorCanvas::OnMouseDown)
 EVT_LEFT_UP(ModeSelectorCanvas::OnMouseReleased)
@@ -81,14 +80,6 @@ void ModeSelectorCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
     SwapBuffers();
 }
 
-void ModeSelectorCanvas::OnIdle(wxIdleEvent &event) {
-	if (mouseTracker.mouseInView()) {
-		Refresh();
-	} else {
-		event.Skip();
-	}
-}
-
 void ModeSelectorCanvas::OnMouseMoved(wxMouseEvent& event) {
     InteractiveCanvas::OnMouseMoved(event);
 }
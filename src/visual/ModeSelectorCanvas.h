@@ -52,7 +52,6 @@ private:
     void setNumChoices(int numChoices_in);
 
     void OnPaint(wxPaintEvent& event);
-    void OnIdle(wxIdleEvent &event);
 
     void OnMouseMoved(wxMouseEvent& event);
     void OnMouseDown(wxMouseEvent& event);
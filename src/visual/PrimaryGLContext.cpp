@@ -178,6 +178,10 @@ void PrimaryGLContext::DrawDemodInfo(DemodulatorInstancePtr demod, RGBA4f color,
         demodPrefix.append("R");
     }
 
+    if (demod->isStreaming()) {
+        demodPrefix.append("N");
+    }
+
     if (demod->isMuted()) {
         demodPrefix.append("M");
     } else if (isSolo) {
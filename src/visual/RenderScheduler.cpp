@@ -0,0 +1,172 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#include "RenderScheduler.h"
+#include "InteractiveCanvas.h"
+#include "CubicSDR.h"
+#include "AppFrame.h"
+
+#include <algorithm>
+
+RenderScheduler *RenderScheduler::instance = nullptr;
+std::atomic_bool RenderScheduler::sleeping(false);
+std::vector<InteractiveCanvas *> RenderScheduler::canvases;
+
+RenderScheduler::RenderScheduler(AppFrame *appFrame) : wxTimer(), appFrame(appFrame), framePeriod(0), idleFrames(0),
+    anyFrame(false), fpsWindowFrames(0), framesPerSecond(0) {
+
+    frameTimeHistogram.resize(getFrameTimeBuckets().size() + 1, 0);
+    instance = this;
+}
+
+RenderScheduler::~RenderScheduler() {
+    Stop();
+    instance = nullptr;
+}
+
+void RenderScheduler::start() {
+    fpsWindowStart = std::chrono::steady_clock::now();
+    sleeping.store(false);
+    framePeriod = getFramePeriod();
+    Start(framePeriod);
+}
+
+void RenderScheduler::addCanvas(InteractiveCanvas *canvas) {
+    canvases.push_back(canvas);
+}
+
+void RenderScheduler::removeCanvas(InteractiveCanvas *canvas) {
+    auto i = std::find(canvases.begin(), canvases.end(), canvas);
+
+    if (i != canvases.end()) {
+        canvases.erase(i);
+    }
+}
+
+void RenderScheduler::wake() {
+    //only the first wake() after falling asleep posts anything.
+    if (!sleeping.load() || !sleeping.exchange(false)) {
+        return;
+    }
+
+    wxTheApp->CallAfter([]() {
+        if (instance) {
+            instance->resume();
+        }
+    });
+}
+
+void RenderScheduler::resume() {
+    sleeping.store(false);
+    idleFrames = 0;
+    framePeriod = getFramePeriod();
+    Start(framePeriod);
+
+    //no need to wait for the first frame
+    Notify();
+}
+
+int RenderScheduler::getFramePeriod() {
+    int fps = RENDER_SCHEDULER_FPS;
+
+    if (!appFrame->IsActive()) {
+        fps = RENDER_SCHEDULER_FPS_INACTIVE;
+    } else if (wxGetApp().getConfig()->getPerfMode() == AppConfig::PERF_LOW) {
+        fps = RENDER_SCHEDULER_FPS_LOW;
+    }
+
+    return 1000 / fps;
+}
+
+void RenderScheduler::Notify() {
+
+    appFrame->onRenderFrame();
+
+    bool drawn = false;
+
+    for (InteractiveCanvas *canvas : canvases) {
+
+        canvas->onFrame();
+
+        //always clear the request, even when not shown.
+        bool dirty = canvas->takeFrameDirty();
+
+        if (!canvas->IsShownOnScreen()) {
+            continue;
+        }
+
+        if (dirty) {
+            canvas->frameLinger = RENDER_SCHEDULER_LINGER_FRAMES;
+        } else if (canvas->frameLinger > 0) {
+            canvas->frameLinger--;
+        } else {
+            continue;
+        }
+
+        canvas->Refresh();
+        drawn = true;
+    }
+
+    if (drawn) {
+        recordFrame();
+        idleFrames = 0;
+    } else {
+        idleFrames++;
+    }
+
+    int period = getFramePeriod();
+
+    if (idleFrames >= RENDER_SCHEDULER_IDLE_FRAMES) {
+        //from now on, a wake() brings the full frame rate back.
+        sleeping.store(true);
+        period = RENDER_SCHEDULER_IDLE_PERIOD_MS;
+    }
+
+    //the active state or the performance mode may have changed.
+    if (period != framePeriod) {
+        framePeriod = period;
+        Start(framePeriod);
+    }
+}
+
+void RenderScheduler::recordFrame() {
+    auto now = std::chrono::steady_clock::now();
+
+    if (anyFrame) {
+        float frameTime = std::chrono::duration<float, std::milli>(now - lastFrameTime).count();
+        const std::vector<float>& buckets = getFrameTimeBuckets();
+
+        size_t bucket = std::lower_bound(buckets.begin(), buckets.end(), frameTime) - buckets.begin();
+        frameTimeHistogram[bucket]++;
+    }
+
+    lastFrameTime = now;
+    anyFrame = true;
+
+    fpsWindowFrames++;
+
+    float windowSeconds = std::chrono::duration<float>(now - fpsWindowStart).count();
+
+    if (windowSeconds >= 1.0f) {
+        framesPerSecond = (float)fpsWindowFrames / windowSeconds;
+        fpsWindowFrames = 0;
+        fpsWindowStart = now;
+    }
+}
+
+float RenderScheduler::getFramesPerSecond() {
+    //a second without any frame also counts.
+    if (std::chrono::steady_clock::now() - fpsWindowStart > std::chrono::seconds(2)) {
+        return 0;
+    }
+    return framesPerSecond;
+}
+
+const std::vector<float>& RenderScheduler::getFrameTimeBuckets() {
+    static const std::vector<float> buckets = { 8.4f, 16.7f, 25.0f, 33.4f, 50.0f, 100.0f, 250.0f };
+    return buckets;
+}
+
+const std::vector<unsigned long long>& RenderScheduler::getFrameTimeHistogram() {
+    return frameTimeHistogram;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+#pragma once
+
+#include "wx/timer.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+class AppFrame;
+class InteractiveCanvas;
+
+//frame rates, per performance mode, and when the application is not active.
+#define RENDER_SCHEDULER_FPS 60
+#define RENDER_SCHEDULER_FPS_LOW 30
+#define RENDER_SCHEDULER_FPS_INACTIVE 30
+
+//after that many frames without anything to draw, drop to the idle heartbeat until the next wake().
+#define RENDER_SCHEDULER_IDLE_FRAMES 30
+
+//the AppFrame pollers still run at that period when idle, for the state changes no one wakes us for.
+#define RENDER_SCHEDULER_IDLE_PERIOD_MS 250
+
+//frames a canvas keeps being redrawn after it was last dirty, to let its animations settle.
+#define RENDER_SCHEDULER_LINGER_FRAMES 15
+
+/**
+ * Paces the UI with a display-rate timer, in place of an idle loop spinning every millisecond.
+ * On each frame the AppFrame pollers run, then only the canvases with something new to show are refreshed.
+ * When nothing has been drawn for a while, the timer slows down to an idle heartbeat, until wake()
+ * is called: by the visual data threads on new data, by user input on a canvas, or by a device change.
+ * Except wake(), everything here is for the GUI thread only.
+ */
+class RenderScheduler : public wxTimer {
+public:
+    RenderScheduler(AppFrame *appFrame);
+    virtual ~RenderScheduler();
+
+    void start();
+
+    virtual void Notify();
+
+    //canvases register themselves on creation, and unregister on destruction.
+    static void addCanvas(InteractiveCanvas *canvas);
+    static void removeCanvas(InteractiveCanvas *canvas);
+
+    //thread-safe: go back to the full frame rate if idle.
+    static void wake();
+
+    //drawn frames per second, over the last second.
+    float getFramesPerSecond();
+
+    //upper bounds in milliseconds of the frame time histogram buckets, the last bucket having no upper bound.
+    static const std::vector<float>& getFrameTimeBuckets();
+
+    //number of drawn frames per interval since the previous drawn frame, counted since start().
+    const std::vector<unsigned long long>& getFrameTimeHistogram();
+
+private:
+    int getFramePeriod();
+    void resume();
+    void recordFrame();
+
+    AppFrame *appFrame;
+
+    int framePeriod;
+    int idleFrames;
+
+    std::chrono::steady_clock::time_point lastFrameTime;
+    std::chrono::steady_clock::time_point fpsWindowStart;
+    bool anyFrame;
+    int fpsWindowFrames;
+    float framesPerSecond;
+
+    std::vector<unsigned long long> frameTimeHistogram;
+
+    static RenderScheduler *instance;
+    static std::atomic_bool sleeping;
+    static std::vector<InteractiveCanvas *> canvases;
+};
@@ -21,7 +21,6 @@
 
 
 wxBEGIN_EVENT_TABLE(ScopeCanvas, wxGLCanvas) EVT_PAINT(ScopeCanvas::OnPaint)
-EVT_IDLE(ScopeCanvas::OnIdle)
 EVT_MOTION(ScopeCanvas::OnMouseMoved)
 EVT_LEFT_DOWN(ScopeCanvas::OnMouseDown)
 EVT_LEFT_UP(ScopeCanvas::OnMouseReleased)
@@ -35,6 +34,7 @@ ScopeCanvas::ScopeCanvas(wxWindow *parent, const wxGLAttributes& dispAttrs) : In
 
     glContext = new ScopeContext(this, &wxGetApp().GetContext(this), wxGetApp().GetContextAttributes());
     inputData->set_max_num_items(2);
+    inputData->set_stats_name("ScopeRenderData");
     bgPanel.setFill(GLPanel::GLPANEL_FILL_GRAD_Y);
     bgPanel.setSize(1.0, 0.5f);
     bgPanel.setPosition(0.0, -0.5f);
@@ -228,9 +228,8 @@ void ScopeCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
 }
 
 
-void ScopeCanvas::OnIdle(wxIdleEvent &event) {
-    Refresh();
-    event.RequestMore();
+bool ScopeCanvas::isFrameDirty() {
+    return InteractiveCanvas::isFrameDirty() || !inputData->empty();
 }
 
 ScopeRenderDataQueuePtr ScopeCanvas::getInputQueue() {
@@ -21,7 +21,6 @@
 #include "WaterfallCanvas.h"
 
 wxBEGIN_EVENT_TABLE(SpectrumCanvas, wxGLCanvas) EVT_PAINT(SpectrumCanvas::OnPaint)
-EVT_IDLE(SpectrumCanvas::OnIdle)
 EVT_MOTION(SpectrumCanvas::OnMouseMoved)
 EVT_LEFT_DOWN(SpectrumCanvas::OnMouseDown)
 EVT_LEFT_UP(SpectrumCanvas::OnMouseReleased)
@@ -38,6 +37,7 @@ SpectrumCanvas::SpectrumCanvas(wxWindow *parent, const wxGLAttributes& dispAttrs
     glContext = new PrimaryGLContext(this, &wxGetApp().GetContext(this), wxGetApp().GetContextAttributes());
 
     visualDataQueue->set_max_num_items(1);
+    visualDataQueue->set_stats_name("SpectrumCanvasVisualData");
             
     SetCursor(wxCURSOR_SIZEWE);
     scaleFactor = 1.0;
@@ -62,6 +62,14 @@ void SpectrumCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
             spectrumPanel.setPeakPoints(vData->spectrum_hold_points);
             spectrumPanel.setFloorValue(vData->fft_floor);
             spectrumPanel.setCeilValue(vData->fft_ceiling);
+
+            //stitched with the additional receivers, the frame spans more than the main device.
+            if (vData->stitched) {
+                stitchedFreq = vData->centerFreq;
+                stitchedBandwidth = vData->bandwidth;
+            } else {
+                stitchedBandwidth = 0;
+            }
         }
     }
     
@@ -82,8 +90,11 @@ void SpectrumCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
 
     glContext->BeginDraw(0,0,0);
 
-    spectrumPanel.setFreq(getCenterFrequency());
-    spectrumPanel.setBandwidth(getBandwidth());
+    long long displayFreq = getDisplayFrequency();
+    long long displayBandwidth = getDisplayBandwidth();
+
+    spectrumPanel.setFreq(displayFreq);
+    spectrumPanel.setBandwidth(displayBandwidth);
     
     spectrumPanel.calcTransform(CubicVR::mat4::identity());
     spectrumPanel.draw();
@@ -97,7 +108,7 @@ void SpectrumCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
         if (!demods[i]->isActive()) {
             continue;
         }
-        glContext->DrawDemodInfo(demods[i], ThemeMgr::mgr.currentTheme->fftHighlight, getCenterFrequency(), getBandwidth(), activeDemodulator==demods[i]);
+        glContext->DrawDemodInfo(demods[i], ThemeMgr::mgr.currentTheme->fftHighlight, displayFreq, displayBandwidth, activeDemodulator==demods[i]);
     }
 
     if (waterfallCanvas && !activeDemodulator) {
@@ -115,7 +126,7 @@ void SpectrumCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
 
             bool isNew = (((waterfallCanvas->isShiftDown() || (lastActiveDemodulator && !lastActiveDemodulator->isActive())) && lastActiveDemodulator) || (!lastActiveDemodulator));
             
-            glContext->DrawFreqBwInfo(freq, wxGetApp().getDemodMgr().getLastBandwidth(), isNew?ThemeMgr::mgr.currentTheme->waterfallNew:ThemeMgr::mgr.currentTheme->waterfallHover, getCenterFrequency(), getBandwidth(), true, true);
+            glContext->DrawFreqBwInfo(freq, wxGetApp().getDemodMgr().getLastBandwidth(), isNew?ThemeMgr::mgr.currentTheme->waterfallNew:ThemeMgr::mgr.currentTheme->waterfallHover, displayFreq, displayBandwidth, true, true);
         }
     }
     
@@ -127,9 +138,16 @@ void SpectrumCanvas::OnPaint(wxPaintEvent& WXUNUSED(event)) {
 }
 
 
-void SpectrumCanvas::OnIdle(wxIdleEvent &event) {
-    Refresh();
-    event.RequestMore();
+long long SpectrumCanvas::getDisplayFrequency() {
+    return (stitchedBandwidth && !isView) ? stitchedFreq : getCenterFrequency();
+}
+
+long long SpectrumCanvas::getDisplayBandwidth() {
+    return (stitchedBandwidth && !isView) ? stitchedBandwidth : getBandwidth();
+}
+
+bool SpectrumCanvas::isFrameDirty() {
+    return InteractiveCanvas::isFrameDirty() || !visualDataQueue->empty() || resetScaleFactor;
 }
 
 
@@ -233,7 +251,7 @@ void SpectrumCanvas::updateScaleFactorFromYMove(float yDeltaMouseMove) {
 void SpectrumCanvas::OnMouseMoved(wxMouseEvent& event) {
     InteractiveCanvas::OnMouseMoved(event);
     if (mouseTracker.mouseDown()) {
-        int freqChange = mouseTracker.getDeltaMouseX() * getBandwidth();
+        int freqChange = mouseTracker.getDeltaMouseX() * getDisplayBandwidth();
 
         if (freqChange != 0) {
             moveCenterFrequency(freqChange);
@@ -53,7 +53,11 @@ public:
 private:
     void OnPaint(wxPaintEvent& event);
 
-    void OnIdle(wxIdleEvent &event);
+    bool isFrameDirty();
+
+    //the span drawn: the stitched one of the main and additional receivers, if any.
+    long long getDisplayFrequency();
+    long long getDisplayBandwidth();
 
     void OnMouseMoved(wxMouseEvent& event);
     void OnMouseDown(wxMouseEvent& event);
@@ -72,6 +76,8 @@ private:
     float scaleFactor;
     int bwChange;
     bool resetScaleFactor, scaleFactorEnabled;
+    long long stitchedFreq = 0;
+    int stitchedBandwidth = 0;
     
     SpectrumVisualDataQueuePtr  visualDataQueue = std::make_shared<SpectrumVisualDataQueue>();
 
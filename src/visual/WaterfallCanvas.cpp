@@ -28,7 +28,6 @@
 
 wxBEGIN_EVENT_TABLE(WaterfallCanvas, wxGLCanvas)
 EVT_PAINT(WaterfallCanvas::OnPaint)
-EVT_IDLE(WaterfallCanvas::OnIdle)
 EVT_MOTION(WaterfallCanvas::OnMouseMoved)
 EVT_LEFT_DOWN(WaterfallCanvas::OnMouseDown)
 EVT_LEFT_UP(WaterfallCanvas::OnMouseReleased)
@@ -51,6 +50,7 @@ WaterfallCanvas::WaterfallCanvas(wxWindow *parent, const wxGLAttributes& dispAtt
     scaleMove = 0;
     minBandwidth = 30000;
     fft_size_changed.store(false);
+    visualDataQueue->set_stats_name("WaterfallCanvasVisualData");
 }
 
 WaterfallCanvas::~WaterfallCanvas() {
@@ -122,6 +122,8 @@ void WaterfallCanvas::processInputQueue() {
         wxClientDC(this);
         glContext->SetCurrent(*this);
         waterfallPanel.update();
+
+        markDirty();
     }
    
 }
@@ -483,9 +485,13 @@ void WaterfallCanvas::OnKeyDown(wxKeyEvent& event) {
     }
 
 }
-void WaterfallCanvas::OnIdle(wxIdleEvent & /* event */) {
+void WaterfallCanvas::onFrame() {
     processInputQueue();
-    Refresh();
+}
+
+bool WaterfallCanvas::isFrameDirty() {
+    //new lines are marked by processInputQueue(), then zoom and move animations
+    return InteractiveCanvas::isFrameDirty() || mouseZoom != 1 || zoom != 1 || scaleMove != 0 || freqMove != 0.0;
 }
 
 void WaterfallCanvas::updateHoverState() {
@@ -582,7 +588,7 @@ void WaterfallCanvas::updateHoverState() {
         }
         else {
             setStatusText(
-                "Click to set demodulator frequency or hold ALT to drag range; hold SHIFT to create new. Arrow keys or wheel to navigate/zoom bandwith, C to center. Right-drag or SHIFT+UP/DOWN to adjust visual gain. Shift-R record/stop all.");
+                "Click to set demodulator frequency or hold ALT to drag range; hold SHIFT to create new. Arrow keys or wheel to navigate/zoom bandwith, C to center. Right-drag or SHIFT+UP/DOWN to adjust visual gain. Shift-R record/stop all, N stream/stop the audio.");
         }
     }
 }
@@ -53,7 +53,8 @@ public:
     
 private:
     void OnPaint(wxPaintEvent& event);
-    void OnIdle(wxIdleEvent &event);
+    void onFrame();
+    bool isFrameDirty();
 
     void updateHoverState();
     
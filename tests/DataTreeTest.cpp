@@ -0,0 +1,333 @@
+// Copyright (c) Charles J. Cliffe
+// SPDX-License-Identifier: GPL-2.0+
+
+// DataTree binary format: XML -> binary -> XML round trip, and truncated or corrupt blocks rejected.
+// Streamed XML loading: same trees as the TinyXML loader, edge cases included.
+
+#include "DataTree.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    if (!(cond)) { \
+        std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; \
+        failures++; \
+    }
+
+static std::string readFile(const std::string& filename) {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void putU32(vector<unsigned char> &out, uint32_t val) {
+    unsigned char *val_ptr = reinterpret_cast<unsigned char *>(&val);
+    out.insert(out.end(), val_ptr, val_ptr + sizeof(uint32_t));
+}
+
+static void putName(vector<unsigned char> &out, const char *name) {
+    putU32(out, (uint32_t)strlen(name));
+    out.insert(out.end(), name, name + strlen(name) + 1);
+}
+
+static void fillTree(DataTree &dt) {
+    DataNode *root = dt.rootNode();
+
+    *root->newChild("version") = 5;
+    *root->newChild("center_freq") = 100500000LL;
+    *root->newChild("gain") = 12.5f;
+    *root->newChild("ppm") = -1.25;
+    *root->newChild("label") = std::string("FM 100.5");
+
+    DataNode *demods = root->newChild("demodulators");
+
+    for (int i = 0; i < 3; i++) {
+        DataNode *demod = demods->newChild("demodulator");
+
+        *demod->newChild("bandwidth") = 200000 + i;
+        *demod->newChild("frequency") = 100000000LL + i * 12500;
+        *demod->newChild("type") = std::string("FM");
+
+        vector<int> taps = { 1000, -2000, 3000, i };
+        *demod->newChild("taps") = taps;
+    }
+
+    vector<double> levels = { 0.5, -10.25, 3e9 };
+    *root->newChild("levels") = levels;
+
+    vector<string> names = { "a", "bc", "" };
+    root->newChild("names")->element()->set(names);
+
+    //deep enough to go through a few levels of recursion.
+    DataNode *deep = root->newChild("deep");
+    for (int i = 0; i < 10; i++) {
+        deep = deep->newChild("level");
+    }
+    *deep = 42;
+}
+
+static void testRoundTrip() {
+    const std::string xmlFile = "datatree_test.xml";
+    const std::string binFile = "datatree_test.bin";
+    const std::string xmlFile2 = "datatree_test2.xml";
+
+    DataTree src("root");
+    fillTree(src);
+
+    CHECK(src.SaveToFileXML(xmlFile));
+
+    //XML -> binary
+    DataTree fromXml;
+    CHECK(fromXml.LoadFromFileXML(xmlFile));
+    CHECK(fromXml.SaveToFileBinary(binFile));
+    CHECK(DataTree::isBinaryFile(binFile));
+
+    //binary -> XML
+    DataTree fromBin;
+    CHECK(fromBin.LoadFromFile(binFile));
+    CHECK(fromBin.SaveToFileXML(xmlFile2));
+
+    CHECK(readFile(xmlFile) == readFile(xmlFile2));
+
+    //the typed values read back as such.
+    DataNode *root = fromBin.rootNode();
+    long long centerFreq = 0;
+    float gain = 0;
+    std::string label;
+
+    root->getNext("center_freq")->element()->get(centerFreq);
+    root->getNext("gain")->element()->get(gain);
+    root->getNext("label")->element()->get(label);
+
+    CHECK(centerFreq == 100500000LL);
+    CHECK(gain == 12.5f);
+    CHECK(label == "FM 100.5");
+
+    CHECK(DataTree::convertFile(xmlFile, binFile));
+
+    remove(xmlFile.c_str());
+    remove(binFile.c_str());
+    remove(xmlFile2.c_str());
+}
+
+static void testTruncated() {
+    DataTree src("root");
+    fillTree(src);
+
+    vector<unsigned char> block;
+    src.toBinary(block);
+
+    DataTree whole;
+    CHECK(whole.fromBinary(&block[0], block.size()));
+
+    //every proper prefix is missing something and must fail, without reading past its end.
+    for (size_t len = 0; len < block.size(); len++) {
+        vector<unsigned char> prefix(block.begin(), block.begin() + len);
+        DataTree dt;
+
+        CHECK(!dt.fromBinary(prefix.empty() ? nullptr : &prefix[0], prefix.size()));
+    }
+}
+
+static void testCorrupt() {
+    //a vector claiming far more items than the block holds.
+    {
+        vector<unsigned char> block;
+        putName(block, "root");
+        block.push_back((unsigned char)DataElement::DATA_INT_VECTOR);
+        putU32(block, 0xFFFFFFF0);
+        putU32(block, sizeof(int));
+        putU32(block, 0);
+
+        DataTree dt;
+        CHECK(!dt.fromBinary(&block[0], block.size()));
+    }
+
+    //scalars whose size does not match their type.
+    {
+        vector<unsigned char> block;
+        putName(block, "root");
+        block.push_back((unsigned char)DataElement::DATA_DOUBLE);
+        putU32(block, 2);
+        block.push_back(0);
+        block.push_back(0);
+        putU32(block, 0);
+
+        DataTree dt;
+        CHECK(!dt.fromBinary(&block[0], block.size()));
+    }
+    {
+        vector<unsigned char> block;
+        putName(block, "root");
+        block.push_back((unsigned char)DataElement::DATA_INT_VECTOR);
+        putU32(block, 1);
+        putU32(block, 1);
+        block.push_back(0);
+        putU32(block, 0);
+
+        DataTree dt;
+        CHECK(!dt.fromBinary(&block[0], block.size()));
+    }
+
+    //unknown element type.
+    {
+        vector<unsigned char> block;
+        putName(block, "root");
+        block.push_back(0xFF);
+        putU32(block, 0);
+        putU32(block, 0);
+
+        DataTree dt;
+        CHECK(!dt.fromBinary(&block[0], block.size()));
+    }
+
+    //nesting far deeper than any real tree.
+    {
+        vector<unsigned char> block;
+        putName(block, "root");
+        for (int i = 0; i < 100000; i++) {
+            block.push_back((unsigned char)DataElement::DATA_NULL);
+            putU32(block, 0);
+            putU32(block, 1);
+            putName(block, "n");
+        }
+        block.push_back((unsigned char)DataElement::DATA_NULL);
+        putU32(block, 0);
+        putU32(block, 0);
+
+        DataTree dt;
+        CHECK(!dt.fromBinary(&block[0], block.size()));
+    }
+
+    //not a binary file at all.
+    {
+        const std::string badFile = "datatree_test_bad.bin";
+        FILE *fp = fopen(badFile.c_str(), "wb");
+        CHECK(fp != nullptr);
+        if (fp) {
+            fputs("CDTB garbage", fp);
+            fclose(fp);
+        }
+
+        DataTree dt;
+        CHECK(!dt.LoadFromFileBinary(badFile));
+        remove(badFile.c_str());
+    }
+}
+
+static void testXMLStream() {
+    const std::string xmlFile = "datatree_test_stream.xml";
+
+    const char *cases[] = {
+        "<a><b>1</b></a>",
+        //trailing elements and text after the root are ignored.
+        "<a><b>1</b></a><c/>",
+        "<a><b>1</b><b>2</b></a><!-- tail -->",
+        "<a/>junk",
+        "junk<a/>",
+        "",
+        "<a><b></a>",
+        //entities, known, unknown and numeric.
+        "<a>x&amp;y&lt;&gt;&quot;&apos;&#65;&#x42;</a>",
+        "<a>x&unknown;y</a>",
+        "<a>x&unknown</a>",
+        "<a>x & y</a>",
+        "<a>&#1234;</a>",
+        "<a>x&#;y</a>",
+        "<a>x&#xZZ;y</a>",
+        "<a>&#;/></a>",
+        //declarations, DOCTYPE, comments and CDATA.
+        "<?xml version=\"1.0\"?><!DOCTYPE a><a><!--c--><b><![CDATA[x<y]]></b></a>",
+        "<a>1<!--c-->2</a>",
+        //attributes.
+        "<a k=\"v&amp;w\" j='q'><b/></a>",
+        "<a k=v/>",
+        "<a k=\"x&unknown;y\"/>",
+        "<a k=\"1\" k=\"2\"/>",
+        //string vectors.
+        "<a><s><str>x</str><str/><str></str><str>y</str></s></a>",
+        "<a><s><str><x/>y</str><str>z</str></s></a>",
+        "<a><str>q</str><b>2</b></a>",
+        //text.
+        "<a>  hello   world  </a>",
+        "<a>\n  one\r\n  two\n</a>",
+        "<a><b/>text</a>",
+        "<a>3.5</a>",
+        "<a>1 2 3</a>",
+        "\xEF\xBB\xBF<a>1</a>",
+    };
+
+    for (const char *xml : cases) {
+        FILE *fp = fopen(xmlFile.c_str(), "wb");
+        CHECK(fp != nullptr);
+        if (!fp) {
+            return;
+        }
+        fputs(xml, fp);
+        fclose(fp);
+
+        DataTree fromTiny, fromStream;
+        bool tinyOk = fromTiny.LoadFromFileXML(xmlFile);
+        bool streamOk = fromStream.LoadFromFileXMLStream(xmlFile);
+
+        if (tinyOk != streamOk) {
+            std::cout << "streamed XML load differs for: " << xml << std::endl;
+        }
+        CHECK(tinyOk == streamOk);
+
+        if (tinyOk && streamOk) {
+            vector<unsigned char> tinyBlock, streamBlock;
+            fromTiny.toBinary(tinyBlock);
+            fromStream.toBinary(streamBlock);
+
+            if (tinyBlock != streamBlock) {
+                std::cout << "streamed XML tree differs for: " << xml << std::endl;
+            }
+            CHECK(tinyBlock == streamBlock);
+        }
+    }
+
+    //a file saved by SaveToFileXML, spanning several read chunks.
+    {
+        DataTree src("root");
+        fillTree(src);
+        DataNode *many = src.rootNode()->newChild("many");
+        for (int i = 0; i < 5000; i++) {
+            *many->newChild("item") = std::string("item &<> value ") + std::to_string(i);
+        }
+        CHECK(src.SaveToFileXML(xmlFile));
+
+        DataTree fromTiny, fromStream;
+        CHECK(fromTiny.LoadFromFileXML(xmlFile));
+        CHECK(fromStream.LoadFromFileXMLStream(xmlFile));
+
+        vector<unsigned char> tinyBlock, streamBlock;
+        fromTiny.toBinary(tinyBlock);
+        fromStream.toBinary(streamBlock);
+        CHECK(tinyBlock == streamBlock);
+    }
+
+    remove(xmlFile.c_str());
+}
+
+int main(int /* argc */, char ** /* argv */) {
+    testRoundTrip();
+    testTruncated();
+    testCorrupt();
+    testXMLStream();
+
+    if (failures) {
+        std::cout << failures << " check(s) failed." << std::endl;
+        return 1;
+    }
+
+    std::cout << "DataTree tests passed." << std::endl;
+    return 0;
+}